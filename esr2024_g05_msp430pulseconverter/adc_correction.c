@@ -0,0 +1,19 @@
+//***************************************************************************************
+//  Korrektur der ADC-Werte mit den Kalibrierwerten aus der Fertigung
+//***************************************************************************************
+
+#include "adc_correction.h"
+
+// (raw * gain / 2^15 + offset) * supply / 2^15, rounded, with both products taken ahead
+void adcCorrectionInit(AdcCorrection *c, uint16_t gain, int16_t offset, uint16_t supply) {
+    c->scale = (uint16_t)(((uint32_t)gain * supply + ADC_CORRECTION_ONE / 2) >> 15);
+    c->bias = (int32_t)offset * supply + ADC_CORRECTION_ONE / 2;
+}
+
+void adcCorrectBlock(const AdcCorrection *c, uint16_t *samples, uint16_t count) {
+    uint16_t i;
+
+    for (i = 0; i < count; i++) {
+        samples[i] = adcCorrect(c, samples[i]);
+    }
+}
@@ -0,0 +1,50 @@
+//***************************************************************************************
+//  Korrektur der ADC-Werte mit den Kalibrierwerten aus der Fertigung
+//
+//  Beschreibung: Die Geraetebeschreibung (TLV) enthaelt fuer den ADC einen Verstaerkungs-
+//  faktor (Q15) und einen Offset in LSB. Korrigiert wird gerundet, nicht abgeschnitten
+//  wie in TIs Beispielcode:
+//      korrigiert = ((roh * gain + 2^14) >> 15) + offset, begrenzt auf 0..4095.
+//  adcCorrectionInit() fasst beides vorab zu einem Faktor und einem 32-Bit-Summanden
+//  zusammen, in den Offset und Rundung eingehen. adcCorrect() braucht dann je Wert nur
+//  noch ein Multiplizieren mit Addieren (MPY32) und die Begrenzung auf 12 Bit.
+//  adcCorrectBlock() korrigiert einen Block an Ort und Stelle. Der Referenzfaktor der TLV
+//  wird nur bei interner Referenz gebraucht, gemessen wird gegen AVCC. Der Faktor
+//  'supply' (supply.h) rechnet die Werte auf die Nennversorgung um und geht in Faktor und
+//  Summand mit ein; mit ADC_CORRECTION_ONE gilt die Formel oben bitgenau fuer jeden
+//  12-Bit-Wert (tools/test_adc_correction.c), sonst auf 1 LSB. Frei von
+//  Hardwarezugriffen.
+//***************************************************************************************
+
+#ifndef ADC_CORRECTION_H_
+#define ADC_CORRECTION_H_
+
+#include <stdint.h>
+
+#define ADC_CORRECTION_MAX          4095    // 12-bit result
+#define ADC_CORRECTION_ONE          0x8000  // Gain 1.0 in Q15
+
+typedef struct {
+    uint16_t scale;                 // Q15
+    int32_t bias;                   // Offset and rounding, scaled by 2^15
+} AdcCorrection;
+
+// 'gain' and 'supply' in Q15, their product must stay below 2
+void adcCorrectionInit(AdcCorrection *c, uint16_t gain, int16_t offset, uint16_t supply);
+
+static inline uint16_t adcCorrect(const AdcCorrection *c, uint16_t raw) {
+    int32_t value = ((int32_t)((uint32_t)raw * c->scale) + c->bias) >> 15;
+
+    if (value < 0) {
+        return 0;
+    }
+    if (value > ADC_CORRECTION_MAX) {
+        return ADC_CORRECTION_MAX;
+    }
+    return (uint16_t)value;
+}
+
+// Correct 'count' raw values in place
+void adcCorrectBlock(const AdcCorrection *c, uint16_t *samples, uint16_t count);
+
+#endif /* ADC_CORRECTION_H_ */
@@ -0,0 +1,91 @@
+//***************************************************************************************
+//  Alarmzonen mit Hysterese und Mindestdauer
+//***************************************************************************************
+
+#include "alarm.h"
+
+#define BPM_LIMIT       0xFFFF
+
+// Output per zone, indexed by AlarmZone
+static const AlarmPattern patterns[ALARM_ZONES] = {
+    { ALARM_LED_BLUE, 0,              0, 0, 1000, 500  },   // No signal: blue blinking
+    { ALARM_LED_RED,  0,              1, 0, 2000, 300  },   // Bradycardia: slow red + beep
+    { ALARM_LED_BLUE, ALARM_LED_BLUE, 0, 1, 1000, 1000 },   // Normal: blue with the pulse
+    { ALARM_LED_RED,  0,              1, 0, 500,  150  }    // Tachycardia: fast red + beep
+};
+
+void alarmConfigure(AlarmState *a, uint16_t bradyBpm, uint16_t tachyBpm,
+                    uint8_t hysteresisBpm, uint8_t delayS) {
+    // No signal has no BPM range, it is selected by the valid flag only
+    a->lowBpm[ALARM_ZONE_NO_SIGNAL] = 0;
+    a->highBpm[ALARM_ZONE_NO_SIGNAL] = 0;
+    a->lowBpm[ALARM_ZONE_BRADY] = 0;
+    a->highBpm[ALARM_ZONE_BRADY] = bradyBpm - 1;
+    a->lowBpm[ALARM_ZONE_NORMAL] = bradyBpm;
+    a->highBpm[ALARM_ZONE_NORMAL] = tachyBpm;
+    a->lowBpm[ALARM_ZONE_TACHY] = tachyBpm + 1;
+    a->highBpm[ALARM_ZONE_TACHY] = BPM_LIMIT;
+
+    a->minDurationMs[ALARM_ZONE_NO_SIGNAL] = ALARM_NO_SIGNAL_MS;
+    a->minDurationMs[ALARM_ZONE_BRADY] = (uint32_t)delayS * 1000;
+    a->minDurationMs[ALARM_ZONE_NORMAL] = ALARM_CLEAR_MS;
+    a->minDurationMs[ALARM_ZONE_TACHY] = (uint32_t)delayS * 1000;
+
+    a->hysteresisBpm = hysteresisBpm;
+    a->zone = ALARM_ZONE_NO_SIGNAL;
+    a->candidate = ALARM_ZONE_NO_SIGNAL;
+    a->candidateSinceMs = 0;
+}
+
+// Zone the BPM points to, the current zone is kept within its limits widened by the
+// hysteresis
+static uint8_t classify(const AlarmState *a, uint8_t valid, uint16_t bpm) {
+    uint8_t zone = a->zone;
+    uint16_t low, high;
+
+    if (!valid) {
+        return ALARM_ZONE_NO_SIGNAL;
+    }
+    if (zone != ALARM_ZONE_NO_SIGNAL) {
+        low = a->lowBpm[zone];
+        high = a->highBpm[zone];
+        low = (low > a->hysteresisBpm) ? low - a->hysteresisBpm : 0;
+        high = (high < BPM_LIMIT - a->hysteresisBpm) ? high + a->hysteresisBpm : BPM_LIMIT;
+        if (bpm >= low && bpm <= high) {
+            return zone;
+        }
+    }
+    for (zone = ALARM_ZONE_BRADY; zone < ALARM_ZONES; zone++) {
+        if (bpm >= a->lowBpm[zone] && bpm <= a->highBpm[zone]) {
+            break;
+        }
+    }
+    return zone;
+}
+
+uint8_t alarmUpdate(AlarmState *a, uint8_t valid, uint16_t bpm, uint32_t nowMs) {
+    uint8_t target = classify(a, valid, bpm);
+
+    if (target == a->zone) {
+        a->candidate = target;
+        return 0;
+    }
+    if (target != a->candidate) {
+        // A different zone is pending, restart the minimum duration
+        a->candidate = target;
+        a->candidateSinceMs = nowMs;
+    }
+    if (nowMs - a->candidateSinceMs < a->minDurationMs[target]) {
+        return 0;
+    }
+    a->zone = target;
+    return 1;
+}
+
+const AlarmPattern *alarmPattern(uint8_t zone) {
+    return &patterns[zone];
+}
+
+uint8_t alarmIsActive(const AlarmState *a) {
+    return a->zone == ALARM_ZONE_BRADY || a->zone == ALARM_ZONE_TACHY;
+}
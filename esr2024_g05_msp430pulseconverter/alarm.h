@@ -0,0 +1,68 @@
+//***************************************************************************************
+//  Alarmzonen mit Hysterese und Mindestdauer
+//
+//  Beschreibung: Ordnet den Puls einer von vier Zonen zu (kein Signal, Bradykardie,
+//  normal, Tachykardie). Die Zonen stehen in einer Tabelle mit Pulsgrenzen, Mindestdauer
+//  und Ausgabemuster. Um die aktuelle Zone zu verlassen, muss der Puls ihre Grenze um die
+//  Hysterese ueberschreiten; die neue Zone wird erst uebernommen, wenn sie ihre
+//  Mindestdauer ohne Unterbrechung ansteht. Die Auswertung kostet pro Aufruf O(1) und
+//  ist frei von Hardwarezugriffen, die Muster spielt output.c ab.
+//***************************************************************************************
+
+#ifndef ALARM_H_
+#define ALARM_H_
+
+#include <stdint.h>
+
+#define ALARM_CLEAR_MS          3000    // Minimum duration before returning to normal
+#define ALARM_NO_SIGNAL_MS      2000    // Minimum duration without a valid BPM
+
+// LED bits of an output pattern
+#define ALARM_LED_RED           0x01
+#define ALARM_LED_BLUE          0x02
+
+typedef enum {
+    ALARM_ZONE_NO_SIGNAL = 0,
+    ALARM_ZONE_BRADY     = 1,
+    ALARM_ZONE_NORMAL    = 2,
+    ALARM_ZONE_TACHY     = 3,
+    ALARM_ZONES
+} AlarmZone;
+
+// Repeating output pattern: 'onLeds' (and the tone) for onMs, then 'offLeds' for the
+// rest of the period. With 'follow' the LEDs take their brightness from the pulse curve
+// (brightness.h), otherwise they are fully on.
+typedef struct {
+    uint8_t  onLeds;
+    uint8_t  offLeds;
+    uint8_t  tone;
+    uint8_t  follow;
+    uint16_t periodMs;
+    uint16_t onMs;
+} AlarmPattern;
+
+typedef struct {
+    uint16_t lowBpm[ALARM_ZONES];       // Zone limits, set by alarmConfigure()
+    uint16_t highBpm[ALARM_ZONES];
+    uint32_t minDurationMs[ALARM_ZONES];
+    uint8_t  hysteresisBpm;
+    uint8_t  zone;                      // Current AlarmZone
+    uint8_t  candidate;                 // Zone the input currently points to
+    uint32_t candidateSinceMs;
+} AlarmState;
+
+// Set the limits: bradycardia below bradyBpm, tachycardia above tachyBpm, alarm zones
+// entered after delayS seconds. Starts in ALARM_ZONE_NO_SIGNAL.
+void alarmConfigure(AlarmState *a, uint16_t bradyBpm, uint16_t tachyBpm,
+                    uint8_t hysteresisBpm, uint8_t delayS);
+
+// Evaluate the current BPM, returns 1 if the zone changed
+uint8_t alarmUpdate(AlarmState *a, uint8_t valid, uint16_t bpm, uint32_t nowMs);
+
+// Output pattern of a zone
+const AlarmPattern *alarmPattern(uint8_t zone);
+
+// Non-zero for the zones that count as an alarm
+uint8_t alarmIsActive(const AlarmState *a);
+
+#endif /* ALARM_H_ */
@@ -0,0 +1,35 @@
+//***************************************************************************************
+//  Biquad-Filter (Direct Form I) fuer die Pulskurve
+//***************************************************************************************
+
+#include "biquad.h"
+
+void biquadReset(BiquadState *state, int16_t level) {
+    state->x1 = level;
+    state->x2 = level;
+    state->y1 = level;
+    state->y2 = level;
+    state->rem = 0;
+}
+
+int16_t biquadStep(BiquadState *state, const int16_t coeffs[BIQUAD_NUM_COEFFS], int16_t x) {
+    int32_t acc;
+    int16_t y;
+
+    acc  = (int32_t)coeffs[0] * x;
+    acc += (int32_t)coeffs[1] * state->x1;
+    acc += (int32_t)coeffs[2] * state->x2;
+    acc -= (int32_t)coeffs[3] * state->y1;
+    acc -= (int32_t)coeffs[4] * state->y2;
+    acc += state->rem;              // Feed back the truncation error (no DC dead band)
+
+    y = (int16_t)(acc >> BIQUAD_Q);
+    state->rem = (uint16_t)(acc - ((int32_t)y << BIQUAD_Q));
+
+    state->x2 = state->x1;
+    state->x1 = x;
+    state->y2 = state->y1;
+    state->y1 = y;
+
+    return y;
+}
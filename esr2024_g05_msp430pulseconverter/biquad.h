@@ -0,0 +1,29 @@
+//***************************************************************************************
+//  Biquad-Filter (Direct Form I) fuer die Pulskurve
+//
+//  Beschreibung: Festkomma-IIR-Filter zweiter Ordnung. Die Koeffizienten liegen im
+//  Q14-Format vor (b0, b1, b2, a1, a2), a0 ist implizit 1. Das Modul ist frei von
+//  Hardwarezugriffen und kann auch auf dem Host uebersetzt werden.
+//***************************************************************************************
+
+#ifndef BIQUAD_H_
+#define BIQUAD_H_
+
+#include <stdint.h>
+
+#define BIQUAD_NUM_COEFFS   5       // b0, b1, b2, a1, a2
+#define BIQUAD_Q            14      // Coefficients are Q14 (1.0 == 16384)
+
+typedef struct {
+    int16_t x1, x2;                 // Previous inputs
+    int16_t y1, y2;                 // Previous outputs
+    uint16_t rem;                   // Fraction dropped from the last output
+} BiquadState;
+
+// Reset the delay line so that a constant input 'level' passes without a transient
+void biquadReset(BiquadState *state, int16_t level);
+
+// Filter one sample with the given Q14 coefficient set
+int16_t biquadStep(BiquadState *state, const int16_t coeffs[BIQUAD_NUM_COEFFS], int16_t x);
+
+#endif /* BIQUAD_H_ */
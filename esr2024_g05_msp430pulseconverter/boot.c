@@ -0,0 +1,22 @@
+//***************************************************************************************
+//  Startablauf: Zeitbasis ab Reset und Zeitstempel der Startstufen
+//***************************************************************************************
+
+#include "boot.h"
+
+uint16_t bootTicks[BOOT_STAGES];
+
+// Called by the C startup before cinit, returns 1 to let cinit run. Only registers are
+// touched here, every variable is still to be initialised.
+int _system_pre_init(void) {
+    // Stop the watchdog before cinit, so no amount of initialised data can trip it
+    WDTCTL = WDTPW | WDTHOLD;
+
+    // RTC counter from ACLK: XT1CLK selected, RTCCKSEL replaces it by ACLK (REFO).
+    // Free running over the full 16 bits, no interrupt.
+    CSCTL4 = SELMS__DCOCLKDIV | SELA__REFOCLK;
+    SYSCFG2 |= RTCCKSEL;
+    RTCMOD = 0xFFFF;
+    RTCCTL = RTCSS__XT1CLK | RTCPS__1 | RTCSR;
+    return 1;
+}
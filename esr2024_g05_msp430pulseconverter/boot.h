@@ -0,0 +1,46 @@
+//***************************************************************************************
+//  Startablauf: Zeitbasis ab Reset und Zeitstempel der Startstufen
+//
+//  Beschreibung: _system_pre_init() (boot.c) laeuft vor der C-Initialisierung (cinit),
+//  haelt den Watchdog an und startet den RTC-Zaehler an ACLK (REFO, 32768 Hz). Er ist ab
+//  dem Reset die Zeitbasis der Energiebilanz (power.h) und der Startzeiten: bootMark()
+//  haelt bei jeder Stufe den Zaehlerstand fest, CMD_GET_BOOT (uart_cmd.h) liest sie aus,
+//  tools/boot_report.py stellt sie der Rechnung aus der Linker-Map gegenueber.
+//
+//  Damit cinit wenig zu tun hat, liegen die grossen Puffer, deren Inhalt vor dem ersten
+//  Schreiben nie gelesen wird (Trace-Ring, Sample-Queue, UART-Ringe, Sensor- und
+//  I2C-FIFOs, SPI-Bloecke), mit #pragma NOINIT in .TI.noinit. Vor dem Freigeben der
+//  GPIOs wird nur der Abtastpfad eingerichtet: ADC, Abtasttimer, I2C zum Sensor und der
+//  SPI-Stream, den applyConfig() sofort starten kann. Ausgabe, Tracer, UART und
+//  I2C-Target folgen, wenn die Hauptschleife zum ersten Mal nichts zu tun hat; bis dahin
+//  erzeugt ein erkannter Schlag keinen Klick.
+//***************************************************************************************
+
+#ifndef BOOT_H_
+#define BOOT_H_
+
+#include <msp430.h>
+#include <stdint.h>
+#include "system.h"
+
+#define BOOT_TICK_HZ                ACLK_HZ
+
+// Stages, ticks since reset. The RTC wraps after 2 s, the boot is far shorter.
+#define BOOT_STAGE_MAIN             0   // cinit done
+#define BOOT_STAGE_CLOCK            1   // FLL locked at 8 MHz
+#define BOOT_STAGE_SAMPLING         2   // GPIOs unlocked, sampling started
+#define BOOT_STAGE_FIRST_SAMPLE     3   // First sample taken out of the queue
+#define BOOT_STAGE_DEFERRED         4   // Non-critical modules set up
+#define BOOT_STAGES                 5
+
+extern uint16_t bootTicks[BOOT_STAGES];
+
+// Keeps the first time of each stage. The counter is past zero once main() runs, so
+// zero marks a stage not reached yet.
+static inline void bootMark(uint8_t stage) {
+    if (bootTicks[stage] == 0) {
+        bootTicks[stage] = RTCCNT;
+    }
+}
+
+#endif /* BOOT_H_ */
@@ -0,0 +1,77 @@
+//***************************************************************************************
+//  LED-Helligkeit aus der Pulskurve
+//***************************************************************************************
+
+#include "brightness.h"
+
+#define DECAY_SHIFT     6       // Envelope moves 1/64 of its span per update towards the signal
+#define MIN_SPAN        16      // Smaller envelopes are treated as a flat signal
+
+// BRIGHTNESS_FULL * (i / 64)^2.2 for i = 0..64
+static const uint16_t gammaTable[65] = {
+       0,    0,    2,    5,    9,   15,   22,   31,   41,   53,   67,   83,  101,
+     120,  141,  164,  189,  216,  246,  277,  310,  345,  382,  421,  462,  506,
+     551,  599,  649,  701,  755,  812,  871,  932,  995, 1060, 1128, 1198, 1271,
+    1345, 1422, 1502, 1583, 1668, 1754, 1843, 1934, 2028, 2124, 2223, 2324, 2427,
+    2533, 2642, 2753, 2866, 2982, 3100, 3221, 3345, 3471, 3599, 3730, 3864, 4000
+};
+
+void brightnessInit(BrightnessTracker *b, uint16_t sampleRateHz) {
+    b->minValue = 0;
+    b->maxValue = 0;
+    b->envelopeValid = 0;
+    b->step = (sampleRateHz > BRIGHTNESS_RATE_HZ) ? (uint8_t)(sampleRateHz / BRIGHTNESS_RATE_HZ) : 1;
+    b->stepCount = b->step;
+    b->level = 255;
+}
+
+uint8_t brightnessPush(BrightnessTracker *b, int16_t value) {
+    int16_t span;
+    int16_t decay;
+
+    if (--b->stepCount != 0) {
+        return 0;
+    }
+    b->stepCount = b->step;
+
+    if (!b->envelopeValid) {
+        b->minValue = value;
+        b->maxValue = value;
+        b->envelopeValid = 1;
+    }
+
+    // Follow new extremes at once, let the other side creep in so the envelope adapts to
+    // a weaker signal
+    span = b->maxValue - b->minValue;
+    decay = (span >> DECAY_SHIFT) + 1;
+    if (value > b->maxValue) {
+        b->maxValue = value;
+    } else if (b->maxValue - decay > value) {
+        b->maxValue -= decay;
+    }
+    if (value < b->minValue) {
+        b->minValue = value;
+    } else if (b->minValue + decay < value) {
+        b->minValue += decay;
+    }
+
+    span = b->maxValue - b->minValue;
+    if (span < MIN_SPAN) {
+        b->level = 255;
+    } else {
+        b->level = (uint8_t)(BRIGHTNESS_LEVEL_MIN +
+                   ((int32_t)(value - b->minValue) * (255 - BRIGHTNESS_LEVEL_MIN)) / span);
+    }
+    return 1;
+}
+
+uint16_t brightnessDuty(uint8_t level) {
+    uint16_t pos = (uint16_t)level * 64;    // Table position in 1/255 steps
+    uint8_t i = (uint8_t)(pos / 255);
+    uint8_t frac = (uint8_t)(pos % 255);
+
+    if (frac == 0) {
+        return gammaTable[i];
+    }
+    return gammaTable[i] + (uint16_t)(((uint32_t)(gammaTable[i + 1] - gammaTable[i]) * frac) / 255);
+}
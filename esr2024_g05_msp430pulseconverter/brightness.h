@@ -0,0 +1,36 @@
+//***************************************************************************************
+//  LED-Helligkeit aus der Pulskurve
+//
+//  Beschreibung: Normiert das gefilterte Signal auf die laufende Huelle (Minimum und
+//  Maximum mit langsamem Abklingen) und liefert daraus mit ca. 50 Hz einen Pegel
+//  0..255. Eine Gamma-Tabelle (2,2) setzt den Pegel in PWM-Werte 0..BRIGHTNESS_FULL um,
+//  damit die LED fuer das Auge gleichmaessig heller wird. Frei von Hardwarezugriffen.
+//***************************************************************************************
+
+#ifndef BRIGHTNESS_H_
+#define BRIGHTNESS_H_
+
+#include <stdint.h>
+
+#define BRIGHTNESS_RATE_HZ      50      // Approximate level update rate
+#define BRIGHTNESS_FULL         4000    // PWM period in timer counts
+#define BRIGHTNESS_LEVEL_MIN    48      // Trough of the pulse, keeps the LED visible
+
+typedef struct {
+    int16_t  minValue;          // Envelope of the filtered signal
+    int16_t  maxValue;
+    uint8_t  envelopeValid;
+    uint8_t  step;              // Samples per level update
+    uint8_t  stepCount;
+    uint8_t  level;             // 0..255, BRIGHTNESS_LEVEL_MIN at the trough
+} BrightnessTracker;
+
+void brightnessInit(BrightnessTracker *b, uint16_t sampleRateHz);
+
+// Feed every filtered sample, returns 1 if 'level' was updated
+uint8_t brightnessPush(BrightnessTracker *b, int16_t value);
+
+// Gamma corrected PWM value 0..BRIGHTNESS_FULL for a level 0..255
+uint16_t brightnessDuty(uint8_t level);
+
+#endif /* BRIGHTNESS_H_ */
@@ -0,0 +1,44 @@
+//***************************************************************************************
+//  Kalibrierwerte aus der Geraetebeschreibung (TLV) des MSP430FR2355
+//***************************************************************************************
+
+#include <msp430.h>
+#include "calibration.h"
+
+TlvCalibration calibration;
+uint8_t calibrationFlags;
+AdcCorrection adcCorrection;
+SupplyMonitor supply;
+
+static TlvIndex descriptor;
+static AdcCorrection factory;           // Gain and offset only, for the reference code
+
+void calibrationInit(void) {
+    calibrationFlags = tlvIndexBuild(&descriptor, (const uint8_t *)TLV_START,
+                                     TLV_END - TLV_START + 1);
+    tlvResolveCalibration(&descriptor, &calibration);
+    adcCorrectionInit(&factory, calibration.adcGain, calibration.adcOffset,
+                      ADC_CORRECTION_ONE);
+    adcCorrection = factory;
+    supplyInit(&supply);
+}
+
+const uint8_t *calibrationFind(uint8_t tag, uint8_t instance, uint8_t *length) {
+    return tlvIndexFind(&descriptor, tag, instance, length);
+}
+
+void calibrationSupplyUpdate(uint16_t refCode) {
+    AdcCorrection next;
+    unsigned short state;
+
+    if (!supplyUpdate(&supply, adcCorrect(&factory, refCode), calibration.ref15Factor)) {
+        return;
+    }
+    adcCorrectionInit(&next, calibration.adcGain, calibration.adcOffset, supply.factor);
+
+    // The ADC ISR must not see half of the new coefficients
+    state = __get_interrupt_state();
+    __disable_interrupt();
+    adcCorrection = next;
+    __set_interrupt_state(state);
+}
@@ -0,0 +1,37 @@
+//***************************************************************************************
+//  Kalibrierwerte aus der Geraetebeschreibung (TLV) des MSP430FR2355
+//
+//  Beschreibung: calibrationInit() indiziert beim Start einmal die TLV-Struktur ab
+//  TLV_START (tlv_index.h) und legt die Kalibrierwerte in 'calibration' ab. Danach
+//  liefert calibrationFind() jeden weiteren Eintrag aus dem Index, ohne die Struktur
+//  erneut zu durchlaufen. Ist das Abbild beschaedigt, enthaelt calibrationFlags die
+//  TLV_INDEX_*-Bits und die Werte bleiben, soweit nicht gefunden, neutral. Aus Gain und
+//  Offset des ADC entsteht adcCorrection, mit der die ADC-ISR jeden Abtastwert vor der
+//  Sample-Queue korrigiert (adc_correction.h). calibrationSupplyUpdate() nimmt die
+//  gewandelte interne Referenz entgegen und rechnet den neuen Versorgungsfaktor
+//  (supply.h) in adcCorrection ein.
+//***************************************************************************************
+
+#ifndef CALIBRATION_H_
+#define CALIBRATION_H_
+
+#include <stdint.h>
+#include "tlv_index.h"
+#include "adc_correction.h"
+#include "supply.h"
+
+extern TlvCalibration calibration;
+extern uint8_t calibrationFlags;
+extern AdcCorrection adcCorrection;
+extern SupplyMonitor supply;
+
+// Index the device descriptor and resolve the calibration values, before sampling starts
+void calibrationInit(void);
+
+// Data of the 'instance'-th descriptor entry with 'tag', 0 if there is none
+const uint8_t *calibrationFind(uint8_t tag, uint8_t instance, uint8_t *length);
+
+// Raw ADC code of the internal reference against AVCC, main loop
+void calibrationSupplyUpdate(uint16_t refCode);
+
+#endif /* CALIBRATION_H_ */
@@ -0,0 +1,338 @@
+//***************************************************************************************
+//  Laufzeit-Konfiguration des Pulswandlers
+//***************************************************************************************
+
+#include <msp430.h>
+#include "driverlib/MSP430FR2xx_4xx/crc.h"
+#include "driverlib/MSP430FR2xx_4xx/sysctl.h"
+#include "config.h"
+#include "filter_tables.h"
+
+typedef struct {
+    uint16_t magic;                 // Written last by configSave(), cleared first on reuse
+    uint16_t version;
+    uint16_t sequence;              // The newer of two valid slots wins
+    PulseConfig config;
+    uint16_t crc;                   // CRC16-CCITT over version, sequence and config
+} ConfigBlock;
+
+// Two slots in INFO FRAM, the .info section is not initialised at startup
+#pragma DATA_SECTION(configSlots, ".info")
+static ConfigBlock configSlots[2];
+
+static const PulseConfig configDefaults = {
+    DEFAULT_SAMPLE_RATE_HZ,
+    DEFAULT_THRESHOLD_ON,
+    DEFAULT_THRESHOLD_OFF,
+    { 0 },                          // Not used while customFilter is 0
+    DEFAULT_TONE_HZ,
+    DEFAULT_OUTPUT_MODE,
+    DEFAULT_STREAM_ENABLE,
+    DEFAULT_SENSOR_SOURCE,
+    DEFAULT_QUALITY_MIN,
+    DEFAULT_BRADY_BPM,
+    DEFAULT_TACHY_BPM,
+    DEFAULT_ALARM_HYSTERESIS,
+    DEFAULT_ALARM_DELAY_S,
+    0
+};
+
+const PulseConfig *config = &configDefaults;
+volatile uint8_t configChanged;
+
+static const ConfigBlock *savedSlot;    // Newest valid slot, 0 if there is none
+static ConfigBlock *draftSlot;          // Slot with changes not yet saved, 0 if none
+
+static uint16_t readU16(const uint8_t *p) {
+    return (uint16_t)p[0] | ((uint16_t)p[1] << 8);
+}
+
+static void writeU16(uint8_t *p, uint16_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+}
+
+static uint16_t blockCrc(const ConfigBlock *block) {
+    const uint16_t *word = &block->version;
+    const uint16_t *end = &block->crc;
+
+    CRC_setSeed(CRC_BASE, 0xFFFF);
+    while (word < end) {
+        CRC_set16BitData(CRC_BASE, *word++);
+    }
+    return CRC_getResult(CRC_BASE);
+}
+
+static uint8_t slotValid(const ConfigBlock *slot) {
+    return slot->magic == CONFIG_MAGIC && slot->version == CONFIG_VERSION &&
+           slot->crc == blockCrc(slot);
+}
+
+// Writable config, call with INFO FRAM unlocked. The first change after a save copies
+// the config into the other slot and invalidates it, so the saved slot stays untouched.
+static PulseConfig *editConfig(void) {
+    if (draftSlot == 0) {
+        draftSlot = (savedSlot == &configSlots[0]) ? &configSlots[1] : &configSlots[0];
+        draftSlot->magic = 0;
+        draftSlot->version = CONFIG_VERSION;
+        draftSlot->sequence = savedSlot ? savedSlot->sequence + 1 : 0;
+        draftSlot->config = *config;
+        config = &draftSlot->config;
+    }
+    return &draftSlot->config;
+}
+
+void configLoadDefaults(void) {
+    // INFO FRAM is write protected (_INFO_FRWP_ENABLE), unlock it for the update
+    SysCtl_enableFRAMWrite(SYSCTL_FRAMWRITEPROTECTION_DATA);
+    *editConfig() = configDefaults;
+    SysCtl_protectFRAMWrite(SYSCTL_FRAMWRITEPROTECTION_DATA);
+
+    configChanged |= CONFIG_CHANGED_SAMPLE_RATE | CONFIG_CHANGED_FILTER | CONFIG_CHANGED_SENSOR |
+                     CONFIG_CHANGED_ALARM;
+}
+
+void configLoad(void) {
+    const ConfigBlock *slot0 = &configSlots[0];
+    const ConfigBlock *slot1 = &configSlots[1];
+
+    savedSlot = 0;
+    if (slotValid(slot0)) {
+        savedSlot = slot0;
+    }
+    if (slotValid(slot1) &&
+        (savedSlot == 0 || (int16_t)(slot1->sequence - slot0->sequence) > 0)) {
+        savedSlot = slot1;
+    }
+    draftSlot = 0;
+    config = savedSlot ? &savedSlot->config : &configDefaults;
+    configChanged |= CONFIG_CHANGED_SAMPLE_RATE | CONFIG_CHANGED_FILTER | CONFIG_CHANGED_SENSOR |
+                     CONFIG_CHANGED_ALARM;
+}
+
+void configSave(void) {
+    if (draftSlot == 0) {
+        return;                             // Nothing changed since the last save
+    }
+    SysCtl_enableFRAMWrite(SYSCTL_FRAMWRITEPROTECTION_DATA);
+    draftSlot->crc = blockCrc(draftSlot);
+    draftSlot->magic = CONFIG_MAGIC;        // A power cut before this leaves the old slot
+    SysCtl_protectFRAMWrite(SYSCTL_FRAMWRITEPROTECTION_DATA);
+
+    savedSlot = draftSlot;
+    draftSlot = 0;
+}
+
+const int16_t *configFilterCoeffs(uint16_t sampleRateHz) {
+    const FilterTable *table;
+
+    if (config->customFilter) {
+        return config->filterCoeffs;
+    }
+    table = filterTableForRate(sampleRateHz);
+    if (table == 0) {
+        table = filterTableForRate(DEFAULT_SAMPLE_RATE_HZ);
+    }
+    return table->coeffs;
+}
+
+uint8_t configGetParam(uint8_t id, uint8_t *value) {
+    const int16_t *coeffs;
+    uint8_t i;
+
+    switch (id) {
+    case PARAM_SAMPLE_RATE:
+        writeU16(value, config->sampleRateHz);
+        return 2;
+    case PARAM_THRESHOLD_ON:
+        writeU16(value, config->thresholdOn);
+        return 2;
+    case PARAM_THRESHOLD_OFF:
+        writeU16(value, config->thresholdOff);
+        return 2;
+    case PARAM_FILTER_COEFFS:
+        coeffs = configFilterCoeffs(config->sampleRateHz);
+        for (i = 0; i < BIQUAD_NUM_COEFFS; i++) {
+            writeU16(&value[2 * i], (uint16_t)coeffs[i]);
+        }
+        return 2 * BIQUAD_NUM_COEFFS;
+    case PARAM_TONE:
+        writeU16(value, config->toneHz);
+        return 2;
+    case PARAM_OUTPUT_MODE:
+        value[0] = config->outputMode;
+        return 1;
+    case PARAM_STREAM_ENABLE:
+        value[0] = config->streamEnable;
+        return 1;
+    case PARAM_SENSOR_SOURCE:
+        value[0] = config->sensorSource;
+        return 1;
+    case PARAM_QUALITY_MIN:
+        value[0] = config->qualityMin;
+        return 1;
+    case PARAM_BRADY_BPM:
+        writeU16(value, config->bradyBpm);
+        return 2;
+    case PARAM_TACHY_BPM:
+        writeU16(value, config->tachyBpm);
+        return 2;
+    case PARAM_ALARM_HYSTERESIS:
+        value[0] = config->alarmHysteresisBpm;
+        return 1;
+    case PARAM_ALARM_DELAY:
+        value[0] = config->alarmDelayS;
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+static uint8_t setParam(PulseConfig *c, uint8_t id, const uint8_t *value, uint8_t length) {
+    uint16_t v;
+    uint8_t i;
+
+    if (id == PARAM_FILTER_COEFFS) {
+        if (length != 2 * BIQUAD_NUM_COEFFS) {
+            return CONFIG_ERR_LENGTH;
+        }
+        for (i = 0; i < BIQUAD_NUM_COEFFS; i++) {
+            c->filterCoeffs[i] = (int16_t)readU16(&value[2 * i]);
+        }
+        c->customFilter = 1;
+        configChanged |= CONFIG_CHANGED_FILTER;
+        return CONFIG_OK;
+    }
+
+    if (id == PARAM_OUTPUT_MODE) {
+        if (length != 1) {
+            return CONFIG_ERR_LENGTH;
+        }
+        if (value[0] > OUTPUT_MODE_OFF) {
+            return CONFIG_ERR_RANGE;
+        }
+        c->outputMode = value[0];
+        return CONFIG_OK;
+    }
+
+    if (id == PARAM_STREAM_ENABLE) {
+        if (length != 1) {
+            return CONFIG_ERR_LENGTH;
+        }
+        if (value[0] > 1) {
+            return CONFIG_ERR_RANGE;
+        }
+        c->streamEnable = value[0];
+        configChanged |= CONFIG_CHANGED_SAMPLE_RATE;
+        return CONFIG_OK;
+    }
+
+    if (id == PARAM_SENSOR_SOURCE) {
+        if (length != 1) {
+            return CONFIG_ERR_LENGTH;
+        }
+        if (value[0] > SENSOR_SOURCE_I2C) {
+            return CONFIG_ERR_RANGE;
+        }
+        c->sensorSource = value[0];
+        configChanged |= CONFIG_CHANGED_SENSOR | CONFIG_CHANGED_SAMPLE_RATE;
+        return CONFIG_OK;
+    }
+
+    if (id == PARAM_QUALITY_MIN) {
+        if (length != 1) {
+            return CONFIG_ERR_LENGTH;
+        }
+        if (value[0] > QUALITY_MIN_MAX) {
+            return CONFIG_ERR_RANGE;
+        }
+        c->qualityMin = value[0];
+        return CONFIG_OK;
+    }
+
+    if (id == PARAM_ALARM_HYSTERESIS || id == PARAM_ALARM_DELAY) {
+        if (length != 1) {
+            return CONFIG_ERR_LENGTH;
+        }
+        if (id == PARAM_ALARM_HYSTERESIS) {
+            if (value[0] > ALARM_HYSTERESIS_MAX) {
+                return CONFIG_ERR_RANGE;
+            }
+            c->alarmHysteresisBpm = value[0];
+        } else {
+            if (value[0] > ALARM_DELAY_MAX_S) {
+                return CONFIG_ERR_RANGE;
+            }
+            c->alarmDelayS = value[0];
+        }
+        configChanged |= CONFIG_CHANGED_ALARM;
+        return CONFIG_OK;
+    }
+
+    if (length != 2) {
+        return ((id >= PARAM_SAMPLE_RATE && id <= PARAM_TONE) ||
+                id == PARAM_BRADY_BPM || id == PARAM_TACHY_BPM) ? CONFIG_ERR_LENGTH : CONFIG_ERR_PARAM;
+    }
+    v = readU16(value);
+
+    switch (id) {
+    case PARAM_SAMPLE_RATE:
+        if (filterTableForRate(v) == 0) {
+            return CONFIG_ERR_RANGE;
+        }
+        c->sampleRateHz = v;
+        c->customFilter = 0;            // A custom set was designed for the old rate
+        configChanged |= CONFIG_CHANGED_SAMPLE_RATE;
+        return CONFIG_OK;
+    case PARAM_THRESHOLD_ON:
+        if (v > ADC_MAX_CODE) {
+            return CONFIG_ERR_RANGE;
+        }
+        c->thresholdOn = v;
+        return CONFIG_OK;
+    case PARAM_THRESHOLD_OFF:
+        if (v > ADC_MAX_CODE) {
+            return CONFIG_ERR_RANGE;
+        }
+        c->thresholdOff = v;
+        return CONFIG_OK;
+    case PARAM_TONE:
+        if (v < TONE_MIN_HZ || v > TONE_MAX_HZ) {
+            return CONFIG_ERR_RANGE;
+        }
+        c->toneHz = v;
+        return CONFIG_OK;
+    case PARAM_BRADY_BPM:
+        if (v < ALARM_BPM_MIN || v >= c->tachyBpm) {
+            return CONFIG_ERR_RANGE;
+        }
+        c->bradyBpm = v;
+        configChanged |= CONFIG_CHANGED_ALARM;
+        return CONFIG_OK;
+    case PARAM_TACHY_BPM:
+        if (v > ALARM_BPM_MAX || v <= c->bradyBpm) {
+            return CONFIG_ERR_RANGE;
+        }
+        c->tachyBpm = v;
+        configChanged |= CONFIG_CHANGED_ALARM;
+        return CONFIG_OK;
+    default:
+        return CONFIG_ERR_PARAM;
+    }
+}
+
+// Validated on a copy: a rejected value must not open a draft, which would clear the
+// magic of the other slot
+uint8_t configSetParam(uint8_t id, const uint8_t *value, uint8_t length) {
+    PulseConfig next = *config;
+    uint8_t result;
+
+    result = setParam(&next, id, value, length);
+    if (result != CONFIG_OK) {
+        return result;
+    }
+    SysCtl_enableFRAMWrite(SYSCTL_FRAMWRITEPROTECTION_DATA);
+    *editConfig() = next;
+    SysCtl_protectFRAMWrite(SYSCTL_FRAMWRITEPROTECTION_DATA);
+    return CONFIG_OK;
+}
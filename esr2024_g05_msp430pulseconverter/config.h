@@ -0,0 +1,126 @@
+//***************************************************************************************
+//  Laufzeit-Konfiguration des Pulswandlers
+//
+//  Beschreibung: Haelt die zur Laufzeit einstellbaren Parameter (Abtastrate, Schwellen,
+//  Filterkoeffizienten, Tonfrequenz, Ausgabemodus, Alarmzonen). Es gibt keine Kopie im RAM:
+//  config zeigt direkt auf die Werte im FRAM, entweder auf die zur Uebersetzungszeit
+//  erzeugten Standardwerte oder auf einen von zwei Bloecken im INFO-FRAM (0x1800). Jeder
+//  Block traegt Kennung, Layout-Version, Folgenummer und CRC; beim Start gilt der neuere
+//  gueltige Block. Die erste Aenderung nach dem Speichern kopiert die Werte in den anderen
+//  Block und macht ihn bis configSave() ungueltig, Aenderungen wirken sofort, ueberstehen
+//  aber einen Neustart erst nach dem Speichern. Da die Kennung zuletzt geschrieben wird,
+//  bleibt bei einem Spannungsausfall immer der zuletzt gespeicherte Block gueltig.
+//***************************************************************************************
+
+#ifndef CONFIG_H_
+#define CONFIG_H_
+
+#include <stdint.h>
+#include "biquad.h"
+
+#define CONFIG_MAGIC                0x5043  // "PC"
+#define CONFIG_VERSION              6       // Layout of PulseConfig, other versions are ignored
+
+// Default values (formerly compile-time constants in the main file)
+#define DEFAULT_SAMPLE_RATE_HZ      250
+#define DEFAULT_THRESHOLD_ON        3000    // ~2V (3000/4095 * 3.3V reference = 2V)
+#define DEFAULT_THRESHOLD_OFF       3000    // Same as on-threshold: no hysteresis
+#define DEFAULT_TONE_HZ             2000
+#define DEFAULT_OUTPUT_MODE         OUTPUT_MODE_LED_PIEZO
+#define DEFAULT_STREAM_ENABLE       0
+#define DEFAULT_SENSOR_SOURCE       SENSOR_SOURCE_ANALOG
+#define DEFAULT_QUALITY_MIN         50      // Halves the time with a wrong BPM under motion
+                                            // artifacts (tools/test_signal_quality.c)
+#define DEFAULT_BRADY_BPM           50
+#define DEFAULT_TACHY_BPM           120
+#define DEFAULT_ALARM_HYSTERESIS    5       // BPM
+#define DEFAULT_ALARM_DELAY_S       5
+
+// Valid parameter ranges, the sample rate must have a filter table (filter_tables.h)
+#define ADC_MAX_CODE                4095
+#define TONE_MIN_HZ                 100
+#define TONE_MAX_HZ                 5000
+#define QUALITY_MIN_MAX             100
+#define ALARM_BPM_MIN               20
+#define ALARM_BPM_MAX               250
+#define ALARM_HYSTERESIS_MAX        20
+#define ALARM_DELAY_MAX_S           60
+
+// Parameter identifiers used by the command interface
+#define PARAM_SAMPLE_RATE           0x01    // uint16_t, Hz: 125, 250, 500 or 1000
+#define PARAM_THRESHOLD_ON          0x02    // uint16_t, ADC code
+#define PARAM_THRESHOLD_OFF         0x03    // uint16_t, ADC code
+#define PARAM_FILTER_COEFFS         0x04    // int16_t[5], Q14, custom set until the next rate change
+#define PARAM_TONE                  0x05    // uint16_t, Hz
+#define PARAM_OUTPUT_MODE           0x06    // uint8_t, OutputMode
+#define PARAM_STREAM_ENABLE         0x07    // uint8_t, 1 = raw SPI streaming (spi_stream.h)
+#define PARAM_SENSOR_SOURCE         0x08    // uint8_t, SensorSource
+#define PARAM_QUALITY_MIN           0x09    // uint8_t, 0..100, 0 accepts every beat
+#define PARAM_BRADY_BPM             0x0A    // uint16_t, bradycardia below, < PARAM_TACHY_BPM
+#define PARAM_TACHY_BPM             0x0B    // uint16_t, tachycardia above
+#define PARAM_ALARM_HYSTERESIS      0x0C    // uint8_t, BPM
+#define PARAM_ALARM_DELAY           0x0D    // uint8_t, s before an alarm zone is entered
+
+// Flags in configChanged, set when a parameter needs to be re-applied
+#define CONFIG_CHANGED_SAMPLE_RATE  0x01
+#define CONFIG_CHANGED_FILTER       0x02
+#define CONFIG_CHANGED_SENSOR       0x04
+#define CONFIG_CHANGED_ALARM        0x08
+
+// Result codes of the config functions
+#define CONFIG_OK                   0x00
+#define CONFIG_ERR_PARAM            0x01    // Unknown parameter
+#define CONFIG_ERR_LENGTH           0x02    // Wrong value length
+#define CONFIG_ERR_RANGE            0x03    // Value out of range
+
+typedef enum {
+    OUTPUT_MODE_LED_PIEZO = 0,      // LEDs and piezo tone
+    OUTPUT_MODE_LED_ONLY  = 1,      // LEDs only, piezo muted
+    OUTPUT_MODE_OFF       = 2       // All outputs off
+} OutputMode;
+
+typedef enum {
+    SENSOR_SOURCE_ANALOG  = 0,      // Analog sensor at P1.2 (ADC A2)
+    SENSOR_SOURCE_I2C     = 1       // Digital sensor on eUSCI_B0 (ppg_sensor.h)
+} SensorSource;
+
+typedef struct {
+    uint16_t sampleRateHz;
+    uint16_t thresholdOn;           // Beat detected when rising through this code
+    uint16_t thresholdOff;          // Detection re-armed below this code
+    int16_t  filterCoeffs[BIQUAD_NUM_COEFFS];   // Custom set, used if customFilter is set
+    uint16_t toneHz;
+    uint8_t  outputMode;
+    uint8_t  streamEnable;          // Sample at STREAM_RATE_HZ and stream raw data over SPI
+    uint8_t  sensorSource;
+    uint8_t  qualityMin;            // Minimum signal quality of a beat (signal_quality.h)
+    uint16_t bradyBpm;              // Alarm zone limits (alarm.h)
+    uint16_t tachyBpm;
+    uint8_t  alarmHysteresisBpm;
+    uint8_t  alarmDelayS;
+    uint8_t  customFilter;          // 0: coefficients from the table for the sample rate
+} PulseConfig;
+
+// Read only, changes go through configSetParam() and configLoadDefaults()
+extern const PulseConfig *config;
+extern volatile uint8_t configChanged;
+
+// Select the newest valid slot in INFO FRAM, falls back to the defaults if there is none
+void configLoad(void);
+
+// Restore the default values (unsaved, use configSave() to persist)
+void configLoadDefaults(void);
+
+// Make the changes since the last save the valid slot
+void configSave(void);
+
+// Coefficients of the pulse filter at the effective 'sampleRateHz'
+const int16_t *configFilterCoeffs(uint16_t sampleRateHz);
+
+// Serialise a parameter into 'value', returns the number of bytes or 0 if unknown
+uint8_t configGetParam(uint8_t id, uint8_t *value);
+
+// Validate and apply a parameter, returns one of the CONFIG_* result codes
+uint8_t configSetParam(uint8_t id, const uint8_t *value, uint8_t length);
+
+#endif /* CONFIG_H_ */
@@ -0,0 +1,138 @@
+//***************************************************************************************
+//  Energiebilanz: Verweildauer je Betriebsart und geschaetzte Ladung je Teilsystem
+//***************************************************************************************
+
+#include <string.h>
+#include "energy.h"
+#include "brightness.h"
+
+// Typical supply currents at 3 V (MSP430FR2355 datasheet), MCLK = SMCLK = 8 MHz, REFO on
+static const uint16_t modeUa[ENERGY_MODES] = {
+    1140,       // Active, FRAM execution: 142 uA/MHz
+    320,        // LPM0, clocks to the timers and eUSCIs keep running
+    16,         // LPM3 with REFO as ACLK source
+    1           // LPM4, RAM retention only
+};
+
+// Current while on in uA, charge per event in uA*ticks (1 nC = 32.8 uA*ticks)
+static const struct {
+    uint16_t onUa;
+    uint16_t eventCharge;
+} unitFigures[ENERGY_UNITS] = {
+    { 0,    0  },   // CPU: from the mode times
+    { 0,    34 },   // ADC: 175 uA for 30 ADCCLK (16 sample-and-hold + 14) at 5 MHz MODOSC
+    { 10,   0  },   // Timers: Timer_B0, B1 and B3 counting at 1 MHz
+    { 5,    0  },   // UART: eUSCI_A0 on SMCLK
+    { 5000, 0  },   // LED at full duty, set by the series resistor of the board
+    { 450,  0  }    // Piezo: SAC2 OA and DAC 170 uA, load 50 uA, tone ISR 20 % CPU 230 uA
+};
+
+void energyInit(EnergyAccount *e) {
+    memset(e, 0, sizeof(*e));
+}
+
+static void addCharge(EnergyAccount *e, EnergyUnit unit, uint32_t uaTicks) {
+    uaTicks += e->chargeRest[unit];
+    e->chargeUc[unit] += uaTicks / ENERGY_TICK_HZ;
+    e->chargeRest[unit] = (uint16_t)(uaTicks % ENERGY_TICK_HZ);
+}
+
+void energyFold(EnergyAccount *e) {
+    uint32_t cpu = 0;
+    uint32_t scaled;
+    uint32_t ticks;
+    uint8_t i;
+
+    for (i = 0; i < ENERGY_MODES; i++) {
+        cpu += (uint32_t)e->modeTicks[i] * modeUa[i];
+        scaled = (uint32_t)e->modeTicks[i] * 1000U + e->modeRest[i];
+        e->modeMs[i] += scaled / ENERGY_TICK_HZ;
+        e->modeRest[i] = (uint16_t)(scaled % ENERGY_TICK_HZ);
+        e->modeTicks[i] = 0;
+    }
+    addCharge(e, ENERGY_CPU, cpu);
+
+    for (i = 0; i < ENERGY_UNITS; i++) {
+        scaled = e->dutyTicks[i] + e->dutyRest[i];
+        ticks = e->unitTicks[i] + scaled / BRIGHTNESS_FULL;
+        e->dutyRest[i] = (uint16_t)(scaled % BRIGHTNESS_FULL);
+        addCharge(e, (EnergyUnit)i, ticks * unitFigures[i].onUa +
+                  (uint32_t)e->events[i] * unitFigures[i].eventCharge);
+        e->unitTicks[i] = 0;
+        e->dutyTicks[i] = 0;
+        e->events[i] = 0;
+    }
+    e->pendingTicks = 0;
+}
+
+uint8_t energyFoldDue(const EnergyAccount *e) {
+    return e->pendingTicks >= ENERGY_FOLD_TICKS;
+}
+
+void energyAddMode(EnergyAccount *e, EnergyMode mode, uint16_t ticks) {
+    if ((uint32_t)e->pendingTicks + ticks > 0xFFFF) {
+        energyFold(e);
+    }
+    e->modeTicks[mode] += ticks;
+    e->pendingTicks += ticks;
+}
+
+void energyAddOn(EnergyAccount *e, EnergyUnit unit, uint16_t ticks) {
+    e->unitTicks[unit] += ticks;
+}
+
+void energyAddDuty(EnergyAccount *e, EnergyUnit unit, uint16_t ticks, uint16_t duty) {
+    e->dutyTicks[unit] += (uint32_t)ticks * duty;
+}
+
+void energyAddEvents(EnergyAccount *e, EnergyUnit unit, uint16_t count) {
+    e->events[unit] += count;
+}
+
+// nA*h = uA*s / 3.6
+uint32_t energyChargeNah(const EnergyAccount *e, EnergyUnit unit) {
+    return e->chargeUc[unit] / 36U * 10U + e->chargeUc[unit] % 36U * 10U / 36U;
+}
+
+uint32_t energyTotalNah(const EnergyAccount *e) {
+    uint32_t total = 0;
+    uint8_t i;
+
+    for (i = 0; i < ENERGY_UNITS; i++) {
+        total += energyChargeNah(e, (EnergyUnit)i);
+    }
+    return total;
+}
+
+uint32_t energyAverageUa(const EnergyAccount *e) {
+    uint32_t charge = 0;
+    uint32_t ms = 0;
+    uint8_t i;
+
+    for (i = 0; i < ENERGY_UNITS; i++) {
+        charge += e->chargeUc[i];
+    }
+    for (i = 0; i < ENERGY_MODES; i++) {
+        ms += e->modeMs[i];
+    }
+    if (ms < 1000) {
+        return 0;
+    }
+    // Whole seconds, within 0.1 % after the first 10 minutes
+    return charge / ((ms + 500) / 1000);
+}
+
+uint8_t energyItem(const EnergyAccount *e, uint8_t item, uint32_t *value) {
+    if (item < ENERGY_ITEM_CHARGE) {
+        *value = e->modeMs[item - ENERGY_ITEM_MODE_MS];
+    } else if (item < ENERGY_ITEM_TOTAL) {
+        *value = energyChargeNah(e, (EnergyUnit)(item - ENERGY_ITEM_CHARGE));
+    } else if (item == ENERGY_ITEM_TOTAL) {
+        *value = energyTotalNah(e);
+    } else if (item == ENERGY_ITEM_AVERAGE) {
+        *value = energyAverageUa(e);
+    } else {
+        return 0;
+    }
+    return 1;
+}
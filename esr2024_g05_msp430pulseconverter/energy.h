@@ -0,0 +1,98 @@
+//***************************************************************************************
+//  Energiebilanz: Verweildauer je Betriebsart und geschaetzte Ladung je Teilsystem
+//
+//  Beschreibung: Zeiten werden in Takten der 32768-Hz-Zeitbasis gemeldet: die Dauer
+//  jeder Betriebsart (aktiv, LPM0, LPM3, LPM4), die Einschaltdauer der Peripherie (bei
+//  den LEDs mit dem PWM-Tastgrad gewichtet) und die Zahl der ADC-Wandlungen. Zusammen
+//  mit typischen Stromwerten aus dem Datenblatt (Tabelle in energy.c) ergibt sich eine
+//  fortlaufende Ladungsbilanz in uA*s je Teilsystem, abgefragt in nA*h. Die Rechnung
+//  ist frei von Hardwarezugriffen; power.c speist sie in der Firmware, tools/golden.c
+//  mit einem Modell derselben Zeiten auf dem Host.
+//
+//  Die gemeldeten Takte werden gesammelt und etwa einmal pro Sekunde mit energyFold()
+//  in die Summen umgerechnet, so bleiben alle Produkte in 32 Bit und die Divisionen
+//  fallen selten und ausserhalb zeitkritischer Abschnitte an.
+//***************************************************************************************
+
+#ifndef ENERGY_H_
+#define ENERGY_H_
+
+#include <stdint.h>
+
+#define ENERGY_TICK_HZ      32768UL
+#define ENERGY_FOLD_TICKS   32768U  // Pending time after which energyFoldDue() asks for a fold
+
+typedef enum {
+    ENERGY_MODE_ACTIVE = 0,
+    ENERGY_MODE_LPM0,
+    ENERGY_MODE_LPM3,
+    ENERGY_MODE_LPM4,
+    ENERGY_MODES
+} EnergyMode;
+
+// Subsystems with their own charge total. ENERGY_CPU is charged from the mode times.
+typedef enum {
+    ENERGY_CPU = 0,
+    ENERGY_ADC,                     // Per conversion
+    ENERGY_TIMERS,
+    ENERGY_UART,
+    ENERGY_LED,                     // On time weighted with the duty, both LEDs summed
+    ENERGY_PIEZO,                   // SAC2 DAC and amplifier plus the tone ISR
+    ENERGY_UNITS
+} EnergyUnit;
+
+// Telemetry items of energyItem()
+#define ENERGY_ITEM_MODE_MS     0                       // + EnergyMode, ms in that mode
+#define ENERGY_ITEM_CHARGE      ENERGY_MODES            // + EnergyUnit, nA*h
+#define ENERGY_ITEM_TOTAL       (ENERGY_ITEM_CHARGE + ENERGY_UNITS)     // nA*h
+#define ENERGY_ITEM_AVERAGE     (ENERGY_ITEM_TOTAL + 1) // uA since the start
+#define ENERGY_ITEMS            (ENERGY_ITEM_AVERAGE + 1)
+
+typedef struct {
+    // Pending since the last fold
+    uint16_t pendingTicks;
+    uint16_t modeTicks[ENERGY_MODES];
+    uint16_t unitTicks[ENERGY_UNITS];
+    uint32_t dutyTicks[ENERGY_UNITS];   // Ticks * duty (0..BRIGHTNESS_FULL)
+    uint16_t events[ENERGY_UNITS];
+
+    // Totals
+    uint32_t modeMs[ENERGY_MODES];
+    uint16_t modeRest[ENERGY_MODES];    // Ticks * 1000 below one ms
+    uint16_t dutyRest[ENERGY_UNITS];    // Ticks * duty below one tick
+    uint32_t chargeUc[ENERGY_UNITS];    // uA*s
+    uint16_t chargeRest[ENERGY_UNITS];  // uA*ticks below one uA*s
+} EnergyAccount;
+
+void energyInit(EnergyAccount *e);
+
+// Time spent in 'mode'. Peripheral times of the same span are reported before, a fold
+// is forced only if the pending time would overflow.
+void energyAddMode(EnergyAccount *e, EnergyMode mode, uint16_t ticks);
+
+// Peripheral on time, fully on
+void energyAddOn(EnergyAccount *e, EnergyUnit unit, uint16_t ticks);
+
+// Peripheral on time at a PWM duty of 0..BRIGHTNESS_FULL
+void energyAddDuty(EnergyAccount *e, EnergyUnit unit, uint16_t ticks, uint16_t duty);
+
+// Events with a fixed charge each, e.g. ADC conversions
+void energyAddEvents(EnergyAccount *e, EnergyUnit unit, uint16_t count);
+
+// Non-zero once ENERGY_FOLD_TICKS are pending
+uint8_t energyFoldDue(const EnergyAccount *e);
+
+// Convert the pending sums into the totals, a few thousand cycles
+void energyFold(EnergyAccount *e);
+
+uint32_t energyChargeNah(const EnergyAccount *e, EnergyUnit unit);
+
+uint32_t energyTotalNah(const EnergyAccount *e);
+
+// Mean current since energyInit() in uA, 0 before the first fold
+uint32_t energyAverageUa(const EnergyAccount *e);
+
+// Value of an ENERGY_ITEM_*, returns 0 for an unknown item
+uint8_t energyItem(const EnergyAccount *e, uint8_t item, uint32_t *value);
+
+#endif /* ENERGY_H_ */
@@ -0,0 +1,26 @@
+//***************************************************************************************
+//  Filterkoeffizienten je Abtastrate
+//
+//  Erzeugt von tools/gen_filter_tables.py, nicht von Hand aendern.
+//***************************************************************************************
+
+#include "filter_tables.h"
+
+// 10 Hz Butterworth low pass, b1 trimmed for a DC gain of exactly 1
+const FilterTable filterTables[FILTER_TABLE_COUNT] = {
+    {  125, { 756, 1511, 756, -21419, 8058 } }, // -3 dB at 10.00 Hz, -43.2 dB at 50 Hz
+    {  250, { 219, 437, 219, -26992, 11483 } }, // -3 dB at 9.99 Hz, -30.4 dB at 50 Hz
+    {  500, { 59, 119, 59, -29863, 13716 } },   // -3 dB at 9.98 Hz, -28.5 dB at 50 Hz
+    { 1000, { 15, 32, 15, -31313, 14991 } }     // -3 dB at 10.01 Hz, -28.1 dB at 50 Hz
+};
+
+const FilterTable *filterTableForRate(uint16_t sampleRateHz) {
+    uint8_t i;
+
+    for (i = 0; i < FILTER_TABLE_COUNT; i++) {
+        if (filterTables[i].sampleRateHz == sampleRateHz) {
+            return &filterTables[i];
+        }
+    }
+    return 0;
+}
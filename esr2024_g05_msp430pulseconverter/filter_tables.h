@@ -0,0 +1,28 @@
+//***************************************************************************************
+//  Filterkoeffizienten je Abtastrate
+//
+//  Beschreibung: Fuer jede unterstuetzte Abtastrate liegt ein fertiger Koeffizientensatz
+//  des Puls-Tiefpasses (10 Hz Butterworth, Q14) als Konstante im FRAM. Die Tabelle wird
+//  von tools/gen_filter_tables.py erzeugt, das den Frequenzgang jedes quantisierten
+//  Satzes gegen die Vorgaben prueft. Frei von Hardwarezugriffen.
+//***************************************************************************************
+
+#ifndef FILTER_TABLES_H_
+#define FILTER_TABLES_H_
+
+#include <stdint.h>
+#include "biquad.h"
+
+#define FILTER_TABLE_COUNT  4       // 125, 250, 500 and 1000 Hz
+
+typedef struct {
+    uint16_t sampleRateHz;
+    int16_t  coeffs[BIQUAD_NUM_COEFFS];
+} FilterTable;
+
+extern const FilterTable filterTables[FILTER_TABLE_COUNT];
+
+// Coefficient set for 'sampleRateHz', 0 if the rate is not supported
+const FilterTable *filterTableForRate(uint16_t sampleRateHz);
+
+#endif /* FILTER_TABLES_H_ */
@@ -0,0 +1,127 @@
+//***************************************************************************************
+//  Herzratenvariabilitaet (HRV) aus den Schlagabstaenden
+//***************************************************************************************
+
+#include "hrv.h"
+
+static void startWindow(HrvWindow *w) {
+    w->elapsedMs = 0;
+    w->count = 0;
+    w->originMs = 0;
+    w->sumDev = 0;
+    w->sumSqDev = 0;
+    w->sumSqDiff = 0;
+    w->diffCount = 0;
+    w->nn50Count = 0;
+}
+
+// Integer square root, only used when a window completes
+static uint32_t isqrt64(uint64_t x) {
+    uint64_t root = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+
+    while (bit > x) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (x >= root + bit) {
+            x -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)root;
+}
+
+// Square root of a Q16 value, rounded to an integer
+static uint16_t sqrtQ16(uint64_t valueQ16) {
+    uint32_t rootQ8 = isqrt64(valueQ16);
+    return (uint16_t)((rootQ8 + 128) >> 8);
+}
+
+// Division rounded to the nearest integer, halves away from zero
+static int32_t divRound(int32_t value, uint16_t divisor) {
+    if (value >= 0) {
+        return (value + divisor / 2) / divisor;
+    }
+    return -((-value + divisor / 2) / divisor);
+}
+
+static void finishWindow(HrvWindow *w) {
+    HrvResult *r = &w->result;
+    uint32_t n = w->count;
+    uint64_t m2n;                // Sum of squared deviations from the mean, times n
+    uint64_t den;
+
+    r->meanIbiMs = (uint16_t)(w->originMs + divRound(w->sumDev, w->count));
+
+    // Variance with n - 1 in Q16, split so the shift cannot overflow
+    m2n = w->sumSqDev * n - (uint64_t)((int64_t)w->sumDev * w->sumDev);
+    den = n * (n - 1);
+    r->sdnnMs = sqrtQ16(((m2n / den) << 16) + ((m2n % den) << 16) / den);
+    if (w->diffCount != 0) {
+        r->rmssdMs = sqrtQ16(((uint64_t)w->sumSqDiff << 16) / w->diffCount);
+        r->pnn50 = (uint8_t)(((uint32_t)w->nn50Count * 100 + w->diffCount / 2) / w->diffCount);
+    } else {
+        r->rmssdMs = 0;
+        r->pnn50 = 0;
+    }
+    r->valid = 1;
+}
+
+void hrvInit(HrvWindow *w, uint16_t lengthS) {
+    w->lengthMs = (uint32_t)lengthS * 1000;
+    w->lastIbiMs = 0;
+    w->result.valid = 0;
+    w->result.pnn50 = 0;
+    w->result.meanIbiMs = 0;
+    w->result.sdnnMs = 0;
+    w->result.rmssdMs = 0;
+    startWindow(w);
+}
+
+uint8_t hrvAddIbi(HrvWindow *w, uint16_t ibiMs) {
+    uint16_t dev;
+    uint16_t diff;
+
+    // Sums relative to the first interval keep the products at 16 x 16 bit, the mean and
+    // the variance are only divided out when the window completes
+    if (w->count == 0) {
+        w->originMs = ibiMs;
+    }
+    w->count++;
+    if (ibiMs >= w->originMs) {
+        dev = ibiMs - w->originMs;
+        w->sumDev += dev;
+    } else {
+        dev = w->originMs - ibiMs;
+        w->sumDev -= dev;
+    }
+    w->sumSqDev += (uint32_t)dev * dev;
+
+    if (w->lastIbiMs != 0) {
+        diff = (ibiMs > w->lastIbiMs) ? ibiMs - w->lastIbiMs : w->lastIbiMs - ibiMs;
+        w->sumSqDiff += (uint32_t)diff * diff;
+        w->diffCount++;
+        if (diff > HRV_NN50_MS) {
+            w->nn50Count++;
+        }
+    }
+    w->lastIbiMs = ibiMs;
+
+    w->elapsedMs += ibiMs;
+    if (w->elapsedMs < w->lengthMs) {
+        return 0;
+    }
+    if (w->count >= 2) {
+        finishWindow(w);
+    }
+    startWindow(w);
+    return 1;
+}
+
+void hrvBreak(HrvWindow *w) {
+    w->lastIbiMs = 0;
+}
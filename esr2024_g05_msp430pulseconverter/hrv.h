@@ -0,0 +1,54 @@
+//***************************************************************************************
+//  Herzratenvariabilitaet (HRV) aus den Schlagabstaenden
+//
+//  Beschreibung: Berechnet fuer ein Zeitfenster (z.B. 1 oder 5 Minuten) den mittleren
+//  Schlagabstand, SDNN, RMSSD und pNN50. Jeder gueltige Schlagabstand wird in O(1) in
+//  ganzzahlige Summen eingerechnet: Abweichung und quadrierte Abweichung vom ersten
+//  Abstand des Fensters sowie die quadrierten Differenzen aufeinanderfolgender Abstaende.
+//  Pro Schlag sind das nur Additionen und 16x16-Bit-Produkte (MPY32), ohne Division; es
+//  werden keine Abstaende gespeichert. Ist das Fenster mit gueltigen Abstaenden gefuellt,
+//  werden Mittelwert und Varianz exakt aus den Summen berechnet und das naechste Fenster
+//  beginnt. Wie pulse.c frei von Hardwarezugriffen.
+//***************************************************************************************
+
+#ifndef HRV_H_
+#define HRV_H_
+
+#include <stdint.h>
+
+#define HRV_SHORT_WINDOW_S      60
+#define HRV_LONG_WINDOW_S       300
+#define HRV_NN50_MS             50
+
+typedef struct {
+    uint8_t  valid;             // Set once a window has been completed
+    uint8_t  pnn50;             // Percent of successive differences above 50 ms
+    uint16_t meanIbiMs;
+    uint16_t sdnnMs;
+    uint16_t rmssdMs;
+} HrvResult;
+
+typedef struct {
+    uint32_t lengthMs;          // Window length in accumulated NN intervals
+    uint32_t elapsedMs;
+    uint16_t count;             // Intervals in the window
+    uint16_t originMs;          // First interval of the window, the sums are relative to it
+    int32_t  sumDev;            // Sum of deviations from originMs, ms
+    uint64_t sumSqDev;          // Sum of squared deviations, ms^2
+    uint32_t sumSqDiff;         // Sum of squared successive differences, ms^2
+    uint16_t diffCount;
+    uint16_t nn50Count;
+    uint16_t lastIbiMs;         // 0 if the next interval does not follow a valid one
+    HrvResult result;           // Last completed window
+} HrvWindow;
+
+void hrvInit(HrvWindow *w, uint16_t lengthS);
+
+// Add a valid inter-beat interval, returns 1 if a window was completed and 'result'
+// was updated
+uint8_t hrvAddIbi(HrvWindow *w, uint16_t ibiMs);
+
+// An invalid beat or lost signal: the next interval is not a successive difference
+void hrvBreak(HrvWindow *w);
+
+#endif /* HRV_H_ */
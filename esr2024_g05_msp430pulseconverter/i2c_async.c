@@ -0,0 +1,305 @@
+//***************************************************************************************
+//  Asynchrone I2C-Transaktionen ueber eUSCI_B0 (Master)
+//***************************************************************************************
+
+#include <msp430.h>
+#include "driverlib/MSP430FR2xx_4xx/eusci_b_i2c.h"
+#include "i2c_async.h"
+#include "system.h"
+#include "trace.h"
+
+#define QUEUE_MASK      (I2C_QUEUE_SIZE - 1)
+
+#define INTERRUPTS      (EUSCI_B_I2C_RECEIVE_INTERRUPT0 | \
+                         EUSCI_B_I2C_TRANSMIT_INTERRUPT0 | \
+                         EUSCI_B_I2C_STOP_INTERRUPT | \
+                         EUSCI_B_I2C_NAK_INTERRUPT | \
+                         EUSCI_B_I2C_ARBITRATIONLOST_INTERRUPT | \
+                         EUSCI_B_I2C_CLOCK_LOW_TIMEOUT_INTERRUPT)
+
+// Transactions waiting to be started, modified with interrupts disabled only
+static I2cTransaction *queue[I2C_QUEUE_SIZE];
+static uint8_t queueHead;
+static uint8_t queueTail;
+
+static I2cTransaction *current;         // On the bus
+static I2cTransaction *chained;         // Started with a repeated start, not yet current
+static I2cTransaction *finishing;       // Last byte written and chained, its ACK not seen yet
+static uint8_t position;
+static uint8_t reading;                 // Current transaction is in its read phase
+
+static I2cStats stats;
+
+static I2cTransaction *dequeue(void) {
+    I2cTransaction *xfer;
+
+    if (queueHead == queueTail) {
+        return 0;
+    }
+    xfer = queue[queueTail & QUEUE_MASK];
+    queueTail++;
+    return xfer;
+}
+
+static void pushFront(I2cTransaction *xfer) {
+    queueTail--;
+    queue[queueTail & QUEUE_MASK] = xfer;
+}
+
+// Generate a (repeated) start for 'xfer'
+static void issueStart(I2cTransaction *xfer) {
+    UCB0I2CSA = xfer->address;
+    if (xfer->writeLength != 0) {
+        UCB0CTLW0 |= UCTR | UCTXSTT;
+    } else {
+        UCB0CTLW0 &= ~UCTR;
+        UCB0CTLW0 |= UCTXSTT;
+    }
+}
+
+static void makeCurrent(I2cTransaction *xfer) {
+    current = xfer;
+    position = 0;
+    reading = (xfer->writeLength == 0);
+}
+
+static uint8_t finish(I2cTransaction *xfer, uint8_t status) {
+    xfer->status = status;
+    if (status == I2C_XFER_OK) {
+        stats.completed++;
+    }
+    return xfer->callback ? xfer->callback(xfer) : 0;
+}
+
+static uint8_t complete(uint8_t status) {
+    I2cTransaction *xfer = current;
+
+    current = 0;
+    return finish(xfer, status);
+}
+
+// The chained transaction got onto the bus, so the last byte before it was acknowledged
+static uint8_t finishWrite(void) {
+    I2cTransaction *xfer = finishing;
+
+    if (xfer == 0) {
+        return 0;
+    }
+    finishing = 0;
+    return finish(xfer, I2C_XFER_OK);
+}
+
+// Called while the last byte of the current transaction is on the bus: either chain the
+// next transaction with a repeated start or end with a stop
+static void endTransfer(void) {
+    I2cTransaction *next = 0;
+
+    if (current->flags & I2C_FLAG_REPEATED_START) {
+        next = dequeue();
+    }
+    if (next) {
+        chained = next;
+        issueStart(next);
+    } else {
+        UCB0CTLW0 |= UCTXSTP;
+    }
+}
+
+// Single byte reads must set the stop while the byte is received, which per the user's
+// guide is right after the start condition went out. This is the only place that waits.
+static void endSingleByteRead(void) {
+    while (UCB0CTLW0 & UCTXSTT);
+    endTransfer();
+}
+
+// Continue with the chained transaction after the current one completed
+static void switchToChained(void) {
+    makeCurrent(chained);
+    chained = 0;
+    if (reading && current->readLength == 1) {
+        endSingleByteRead();
+    }
+}
+
+static void startNext(void) {
+    I2cTransaction *next = dequeue();
+
+    if (next) {
+        makeCurrent(next);
+        issueStart(next);
+        if (reading && next->readLength == 1) {
+            endSingleByteRead();
+        }
+    }
+}
+
+// Recover the module after a timeout or lost arbitration
+static void resetModule(void) {
+    UCB0CTLW0 |= UCSWRST;
+    UCB0CTLW0 |= UCMST;
+    UCB0CTLW0 &= ~UCSWRST;
+    UCB0IE |= INTERRUPTS;
+}
+
+// Abort the current transfer after a bus error, the chained one is put back. With the
+// last byte of a write still unconfirmed that write fails, and the transaction chained
+// to it has not reached the bus.
+static uint8_t abortTransfer(uint8_t status) {
+    if (chained) {
+        pushFront(chained);
+        chained = 0;
+    }
+    if (finishing) {
+        pushFront(current);
+        current = finishing;
+        finishing = 0;
+    }
+    return current ? complete(status) : 0;
+}
+
+void i2cAsyncInit(uint32_t dataRate) {
+    EUSCI_B_I2C_initMasterParam param = {0};
+
+    param.selectClockSource = EUSCI_B_I2C_CLOCKSOURCE_SMCLK;
+    param.i2cClk = SMCLK_HZ;
+    param.dataRate = dataRate;
+    param.byteCounterThreshold = 0;
+    param.autoSTOPGeneration = EUSCI_B_I2C_NO_AUTO_STOP;
+    EUSCI_B_I2C_initMaster(EUSCI_B0_BASE, &param);
+    EUSCI_B_I2C_setTimeout(EUSCI_B0_BASE, EUSCI_B_I2C_TIMEOUT_28_MS);
+    EUSCI_B_I2C_enable(EUSCI_B0_BASE);
+
+    EUSCI_B_I2C_clearInterrupt(EUSCI_B0_BASE, INTERRUPTS);
+    EUSCI_B_I2C_enableInterrupt(EUSCI_B0_BASE, INTERRUPTS);
+}
+
+uint8_t i2cAsyncSubmit(I2cTransaction *xfer) {
+    unsigned short state = __get_interrupt_state();
+    uint8_t accepted = 0;
+
+    xfer->status = I2C_XFER_PENDING;
+
+    __disable_interrupt();
+    if ((uint8_t)(queueHead - queueTail) < I2C_QUEUE_SIZE) {
+        queue[queueHead & QUEUE_MASK] = xfer;
+        queueHead++;
+        accepted = 1;
+        if (current == 0) {
+            startNext();
+        }
+    }
+    __set_interrupt_state(state);
+
+    return accepted;
+}
+
+uint8_t i2cAsyncBusy(void) {
+    return current != 0 || queueHead != queueTail;
+}
+
+void i2cAsyncGetStats(I2cStats *out) {
+    unsigned short state = __get_interrupt_state();
+
+    __disable_interrupt();
+    *out = stats;
+    __set_interrupt_state(state);
+}
+
+#pragma vector=EUSCI_B0_VECTOR
+__interrupt void USCI_B0_ISR(void) {
+    uint8_t wake = 0;
+
+    TRACE_ISR_BEGIN(TRACE_ISR_I2C);
+    switch (__even_in_range(UCB0IV, USCI_I2C_UCBIT9IFG)) {
+    case USCI_I2C_UCALIFG:
+        // Another master won, the module dropped to slave mode
+        stats.arbitrationLost++;
+        resetModule();
+        wake = abortTransfer(I2C_XFER_ARB_LOST);
+        startNext();
+        break;
+    case USCI_I2C_UCNACKIFG:
+        // Address or data not acknowledged
+        stats.nacks++;
+        UCB0CTLW0 |= UCTXSTP;
+        if (chained) {
+            pushFront(chained);
+            chained = 0;
+        }
+        if (finishing) {
+            if (UCB0CTLW0 & UCTXSTT) {
+                // The repeated start is still pending, so the NACK is for the last byte of
+                // the write before it. The chained transaction goes back to the queue.
+                pushFront(current);
+                current = finishing;
+                finishing = 0;
+            } else {
+                // The write was acknowledged, the address of the chained one was not
+                wake = finishWrite();
+            }
+        }
+        if (current) {
+            current->status = I2C_XFER_NACK;
+        }
+        break;
+    case USCI_I2C_UCSTPIFG:
+        wake = finishWrite();
+        if (current) {
+            wake |= complete(current->status == I2C_XFER_NACK ? I2C_XFER_NACK : I2C_XFER_OK);
+        }
+        startNext();
+        break;
+    case USCI_I2C_UCRXIFG0:
+        wake = finishWrite();
+        current->readData[position++] = UCB0RXBUF;
+        if (position == current->readLength) {
+            // Last byte in, the stop or repeated start is already on its way
+            if (chained) {
+                wake |= complete(I2C_XFER_OK);
+                switchToChained();
+            }
+        } else if (current->readLength - position == 1) {
+            endTransfer();                  // NACK the next byte, then stop or restart
+        }
+        break;
+    case USCI_I2C_UCTXIFG0:
+        if (reading) {
+            break;                          // Stale flag from the write phase
+        }
+        wake = finishWrite();
+        if (position < current->writeLength) {
+            UCB0TXBUF = current->writeData[position++];
+        } else if (current->readLength != 0) {
+            // Write phase done, turn around with a repeated start
+            reading = 1;
+            position = 0;
+            UCB0CTLW0 &= ~UCTR;
+            UCB0CTLW0 |= UCTXSTT;
+            if (current->readLength == 1) {
+                endSingleByteRead();
+            }
+        } else {
+            endTransfer();
+            if (chained) {
+                // Completed once the chained transaction shows its byte was acknowledged
+                finishing = current;
+                switchToChained();
+            }
+        }
+        break;
+    case USCI_I2C_UCCLTOIFG:
+        // SCL held low too long, reset the module and drop the transfer
+        stats.timeouts++;
+        resetModule();
+        wake = abortTransfer(I2C_XFER_TIMEOUT);
+        startNext();
+        break;
+    default:
+        break;
+    }
+
+    if (wake) {
+        __bic_SR_register_on_exit(LPM0_bits);
+    }
+    TRACE_ISR_END(TRACE_ISR_I2C);
+}
@@ -0,0 +1,68 @@
+//***************************************************************************************
+//  Asynchrone I2C-Transaktionen ueber eUSCI_B0 (Master)
+//
+//  Beschreibung: Aufrufer legen Transaktionsbeschreibungen (Adresse, Schreibpuffer,
+//  Lesepuffer, Flags, Callback) in eine Warteschlange. Die eUSCI_B0-ISR arbeitet sie
+//  nacheinander ohne Warteschleifen ab: Schreib- und Lesephase einer Transaktion sind
+//  immer per Repeated Start verbunden; mit I2C_FLAG_REPEATED_START folgt auch die naechste
+//  Transaktion der Warteschlange ohne STOP. Busfehler (NACK, Arbitrierungsverlust) und
+//  Timeouts (SCL laenger als 28 ms low, EUSCI_B_I2C_setTimeout) werden im Status der
+//  Transaktion und in Zaehlern festgehalten.
+//
+//  Jede Transaktion muss mindestens ein Byte schreiben oder lesen. Die Beschreibungen
+//  gehoeren dem Aufrufer und muessen bis zum Callback gueltig bleiben.
+//  Der Callback laeuft im Interrupt und darf neue Transaktionen einreihen.
+//***************************************************************************************
+
+#ifndef I2C_ASYNC_H_
+#define I2C_ASYNC_H_
+
+#include <stdint.h>
+
+#define I2C_QUEUE_SIZE          16      // Power of two
+
+// Transaction flags
+#define I2C_FLAG_REPEATED_START 0x01    // Start the next queued transaction without STOP
+
+// Transaction status
+#define I2C_XFER_PENDING        0
+#define I2C_XFER_OK             1
+#define I2C_XFER_NACK           2
+#define I2C_XFER_TIMEOUT        3
+#define I2C_XFER_ARB_LOST       4
+
+typedef struct I2cTransaction I2cTransaction;
+
+// Completion callback (interrupt context), return non-zero to wake the main loop
+typedef uint8_t (*I2cCallback)(I2cTransaction *xfer);
+
+struct I2cTransaction {
+    uint8_t address;
+    uint8_t flags;
+    const uint8_t *writeData;           // Sent first, may be 0 if writeLength is 0
+    uint8_t writeLength;
+    uint8_t readLength;                 // Read after a repeated start if non-zero
+    uint8_t *readData;
+    I2cCallback callback;               // May be 0
+    volatile uint8_t status;            // I2C_XFER_*
+};
+
+typedef struct {
+    uint16_t completed;
+    uint16_t nacks;
+    uint16_t timeouts;
+    uint16_t arbitrationLost;
+} I2cStats;
+
+// Configure eUSCI_B0 as master with the clock low timeout enabled
+void i2cAsyncInit(uint32_t dataRate);
+
+// Queue a transaction, returns 0 if the queue is full. Safe from interrupts.
+uint8_t i2cAsyncSubmit(I2cTransaction *xfer);
+
+// Returns non-zero while a transaction is running or queued
+uint8_t i2cAsyncBusy(void);
+
+void i2cAsyncGetStats(I2cStats *stats);
+
+#endif /* I2C_ASYNC_H_ */
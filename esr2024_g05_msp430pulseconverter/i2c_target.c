@@ -0,0 +1,241 @@
+//***************************************************************************************
+//  I2C-Target (Slave) mit Registerkarte fuer den Puls
+//***************************************************************************************
+
+#include <msp430.h>
+#include "driverlib/MSP430FR2xx_4xx/eusci_b_i2c.h"
+#include "i2c_target.h"
+#include "trace.h"
+
+#define SNAPSHOT_SIZE   0x20    // Registers 0x00..0x1F are served from the snapshot
+#define FIFO_SIZE       32      // Must be a power of two
+#define FIFO_MASK       (FIFO_SIZE - 1)
+
+// Two pre-serialised register images. The main loop only writes the back buffer
+// (1 - frontSnapshot) and then flips frontSnapshot, the ISR latches the front buffer
+// at every (repeated) start condition and serves the whole transfer from it.
+static uint8_t snapshot[2][SNAPSHOT_SIZE];
+static volatile uint8_t frontSnapshot;
+static volatile uint8_t readSnapshot;       // Buffer latched by the ISR
+static volatile uint8_t transferActive;     // Between start and stop condition
+
+static uint16_t publishedBeatCount;
+static uint16_t publishedRejected;
+static uint16_t publishedSpectralUpdates;
+static uint8_t publishedStatus = 0xFF;      // Forces the first publish
+
+#pragma NOINIT(fifo)
+static uint16_t fifo[FIFO_SIZE];
+static volatile uint8_t fifoHead;           // Written by the main loop only (free running)
+static volatile uint8_t fifoTail;           // Written by the ISR only (free running)
+static volatile uint16_t fifoOverflows;     // Dropped samples, written by the main loop only
+static uint16_t overflowsReported;          // fifoOverflows the host has seen in STATUS
+
+// ISR state of the current transfer
+static uint8_t regPointer;
+static uint8_t pointerPending;              // Next received byte is the register address
+static uint8_t fifoHighByte;                // Next FIFO_DATA read returns the high byte
+static uint16_t fifoLatch;
+static uint8_t fifoPopped;                  // fifoLatch was taken out of the FIFO
+static uint8_t prefetchPending;             // A byte sits in TXBUF and may not be sent
+static uint8_t prefetchPointer;             // regPointer before that byte was loaded
+static uint8_t statusPending;               // That byte is STATUS with FIFO_OVERFLOW set
+static uint16_t overflowsPending;           // fifoOverflows reported by that byte
+
+void i2cTargetInit(void) {
+    EUSCI_B_I2C_initSlaveParam param = {0};
+
+    // Configure I2C pins (P4.6 SDA, P4.7 SCL)
+    P4SEL0 |= BIT6 | BIT7;
+
+    param.slaveAddress = I2C_TARGET_ADDRESS;
+    param.slaveAddressOffset = EUSCI_B_I2C_OWN_ADDRESS_OFFSET0;
+    param.slaveOwnAddressEnable = EUSCI_B_I2C_OWN_ADDRESS_ENABLE;
+    EUSCI_B_I2C_initSlave(EUSCI_B1_BASE, &param);
+    EUSCI_B_I2C_enable(EUSCI_B1_BASE);
+
+    EUSCI_B_I2C_clearInterrupt(EUSCI_B1_BASE,
+                               EUSCI_B_I2C_RECEIVE_INTERRUPT0 |
+                               EUSCI_B_I2C_TRANSMIT_INTERRUPT0 |
+                               EUSCI_B_I2C_START_INTERRUPT |
+                               EUSCI_B_I2C_STOP_INTERRUPT);
+    EUSCI_B_I2C_enableInterrupt(EUSCI_B1_BASE,
+                                EUSCI_B_I2C_RECEIVE_INTERRUPT0 |
+                                EUSCI_B_I2C_TRANSMIT_INTERRUPT0 |
+                                EUSCI_B_I2C_START_INTERRUPT |
+                                EUSCI_B_I2C_STOP_INTERRUPT);
+}
+
+static void putHrv(uint8_t *block, const HrvResult *hrv) {
+    block[I2C_HRV_MEAN_IBI] = (uint8_t)hrv->meanIbiMs;
+    block[I2C_HRV_MEAN_IBI + 1] = (uint8_t)(hrv->meanIbiMs >> 8);
+    block[I2C_HRV_SDNN] = (uint8_t)hrv->sdnnMs;
+    block[I2C_HRV_SDNN + 1] = (uint8_t)(hrv->sdnnMs >> 8);
+    block[I2C_HRV_RMSSD] = (uint8_t)hrv->rmssdMs;
+    block[I2C_HRV_RMSSD + 1] = (uint8_t)(hrv->rmssdMs >> 8);
+    block[I2C_HRV_PNN50] = hrv->pnn50;
+}
+
+void i2cTargetUpdate(const PulseDetector *pulse, const SignalQuality *quality,
+                     const SpectralEstimator *spectral, const HrvResult *hrvShort,
+                     const HrvResult *hrvLong, uint8_t alarm) {
+    uint8_t status;
+    uint8_t back;
+    uint8_t *regs;
+
+    // Quality and HRV results only change on a beat, which the beat and reject counts
+    // already cover, the spectral estimate has its own update count
+    status = (pulse->valid ? I2C_STATUS_VALID : 0) | (alarm ? I2C_STATUS_ALARM : 0) |
+             (hrvShort->valid ? I2C_STATUS_HRV_SHORT : 0) |
+             (hrvLong->valid ? I2C_STATUS_HRV_LONG : 0) |
+             (spectral->valid ? I2C_STATUS_SPECTRAL : 0) |
+             (spectralAgrees(spectral, pulse->valid ? pulse->bpm : 0) ? I2C_STATUS_BPM_AGREE : 0);
+    if (status == publishedStatus && pulse->beatCount == publishedBeatCount &&
+        quality->rejected == publishedRejected && spectral->updates == publishedSpectralUpdates) {
+        return;
+    }
+
+    // The ISR may still be serving the back buffer from before the last flip,
+    // keep it intact and retry with the next sample
+    back = 1 - frontSnapshot;
+    if (transferActive && readSnapshot == back) {
+        return;
+    }
+
+    regs = snapshot[back];
+    regs[I2C_REG_STATUS] = status;
+    regs[I2C_REG_BPM] = (uint8_t)pulse->bpm;
+    regs[I2C_REG_BPM + 1] = (uint8_t)(pulse->bpm >> 8);
+    regs[I2C_REG_CONFIDENCE] = pulse->confidence;
+    regs[I2C_REG_IBI_MS] = (uint8_t)pulse->ibiMs;
+    regs[I2C_REG_IBI_MS + 1] = (uint8_t)(pulse->ibiMs >> 8);
+    regs[I2C_REG_BEAT_COUNT] = (uint8_t)pulse->beatCount;
+    regs[I2C_REG_BEAT_COUNT + 1] = (uint8_t)(pulse->beatCount >> 8);
+    regs[I2C_REG_QUALITY] = quality->quality;
+    regs[I2C_REG_REJECTED] = (uint8_t)quality->rejected;
+    regs[I2C_REG_REJECTED + 1] = (uint8_t)(quality->rejected >> 8);
+    regs[I2C_REG_SPECTRAL_BPM] = (uint8_t)spectral->bpm;
+    regs[I2C_REG_SPECTRAL_BPM + 1] = (uint8_t)(spectral->bpm >> 8);
+    putHrv(&regs[I2C_REG_HRV_SHORT], hrvShort);
+    putHrv(&regs[I2C_REG_HRV_LONG], hrvLong);
+    frontSnapshot = back;
+
+    publishedStatus = status;
+    publishedBeatCount = pulse->beatCount;
+    publishedRejected = quality->rejected;
+    publishedSpectralUpdates = spectral->updates;
+}
+
+void i2cTargetPushSample(uint16_t sample) {
+    if ((uint8_t)(fifoHead - fifoTail) >= FIFO_SIZE) {
+        fifoOverflows++;
+        return;
+    }
+    fifo[fifoHead & FIFO_MASK] = sample;
+    fifoHead++;
+}
+
+// Next byte for the host, called from the TX interrupt
+static uint8_t readRegister(void) {
+    uint8_t value;
+
+    switch (regPointer) {
+    case I2C_REG_STATUS:
+        // Only counts as read once the byte has left TXBUF, see confirmPrefetch()
+        value = snapshot[readSnapshot][I2C_REG_STATUS];
+        overflowsPending = fifoOverflows;
+        if (overflowsPending != overflowsReported) {
+            value |= I2C_STATUS_FIFO_OVERFLOW;
+            statusPending = 1;
+        }
+        break;
+    case I2C_REG_FIFO_COUNT:
+        value = (uint8_t)(fifoHead - fifoTail);
+        break;
+    case I2C_REG_FIFO_DATA:
+        // Stays on FIFO_DATA so a burst read drains consecutive samples
+        if (fifoHighByte) {
+            fifoHighByte = 0;
+            return (uint8_t)(fifoLatch >> 8);
+        }
+        fifoPopped = (fifoHead != fifoTail);
+        if (fifoPopped) {
+            fifoLatch = fifo[fifoTail & FIFO_MASK];
+            fifoTail++;
+        } else {
+            fifoLatch = 0xFFFF;
+        }
+        fifoHighByte = 1;
+        return (uint8_t)fifoLatch;
+    case I2C_REG_WHO_AM_I:
+        value = I2C_WHO_AM_I_VALUE;
+        break;
+    default:
+        value = (regPointer < SNAPSHOT_SIZE) ? snapshot[readSnapshot][regPointer] : 0x00;
+        break;
+    }
+
+    regPointer++;
+    return value;
+}
+
+// The eUSCI requests the next TX byte while the current one is still shifted out, so
+// the byte in TXBUF has been sent once another one is requested. A STATUS byte that
+// reported an overflow acknowledges it only then.
+static void confirmPrefetch(void) {
+    if (statusPending) {
+        overflowsReported = overflowsPending;
+        statusPending = 0;
+    }
+}
+
+// At the end of a read the host NACKs one byte that was loaded but never sent. Rewind
+// the register pointer to it, keep a reported overflow pending and, if it was the low
+// byte of a FIFO sample, put the sample back for the next read.
+static void releasePrefetch(void) {
+    if (prefetchPending) {
+        regPointer = prefetchPointer;
+        prefetchPending = 0;
+    }
+    statusPending = 0;
+    if (fifoHighByte && fifoPopped && (uint8_t)(fifoHead - fifoTail) < FIFO_SIZE) {
+        fifoTail--;
+    }
+    fifoHighByte = 0;
+    fifoPopped = 0;
+}
+
+#pragma vector=EUSCI_B1_VECTOR
+__interrupt void USCI_B1_ISR(void) {
+    TRACE_ISR_BEGIN(TRACE_ISR_I2C_TARGET);
+    switch (__even_in_range(UCB1IV, USCI_I2C_UCBIT9IFG)) {
+    case USCI_I2C_UCSTTIFG:
+        releasePrefetch();
+        readSnapshot = frontSnapshot;
+        transferActive = 1;
+        pointerPending = 1;
+        break;
+    case USCI_I2C_UCSTPIFG:
+        releasePrefetch();
+        transferActive = 0;
+        break;
+    case USCI_I2C_UCRXIFG0:
+        // The map is read-only, only the register address is taken from a write
+        if (pointerPending) {
+            regPointer = EUSCI_B_I2C_slaveGetData(EUSCI_B1_BASE);
+            pointerPending = 0;
+        } else {
+            (void)EUSCI_B_I2C_slaveGetData(EUSCI_B1_BASE);
+        }
+        break;
+    case USCI_I2C_UCTXIFG0:
+        confirmPrefetch();
+        prefetchPointer = regPointer;
+        prefetchPending = 1;
+        EUSCI_B_I2C_slavePutData(EUSCI_B1_BASE, readRegister());
+        break;
+    default:
+        break;
+    }
+    TRACE_ISR_END(TRACE_ISR_I2C_TARGET);
+}
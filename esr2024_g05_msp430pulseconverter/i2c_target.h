@@ -0,0 +1,82 @@
+//***************************************************************************************
+//  I2C-Target (Slave) mit Registerkarte fuer den Puls, eUSCI_B1 (P4.6 SDA / P4.7 SCL)
+//
+//  Beschreibung: Ein Host-Controller kann Puls, Konfidenz, letzten Schlagabstand, Status
+//  und eine Sample-FIFO abfragen. Der Host schreibt zuerst die Registeradresse und liest
+//  dann mit automatischem Inkrement. Alle Anfragen werden vollstaendig in der ISR aus
+//  einem vorab serialisierten, doppelt gepufferten Abbild beantwortet; ein Lesezugriff
+//  sieht immer ein konsistentes Abbild und bremst den Abtastpfad nie aus. Das Byte, das
+//  der eUSCI am Ende eines Lesezugriffs schon geladen, aber nicht mehr gesendet hat, gilt
+//  als ungelesen: der naechste Lesezugriff ohne neue Registeradresse beginnt dort.
+//
+//  Registerkarte:
+//      0x00  STATUS        I2C_STATUS_* Bits, FIFO_OVERFLOW wird geloescht, sobald der
+//                          Host das Byte erhalten hat
+//      0x01  BPM           uint16_t, Little Endian
+//      0x03  CONFIDENCE    0..100
+//      0x04  IBI_MS        uint16_t, letzter gueltiger Schlagabstand in ms
+//      0x06  BEAT_COUNT    uint16_t, Anzahl erkannter Schlaege
+//      0x08  FIFO_COUNT    Anzahl Samples in der FIFO
+//      0x09  FIFO_DATA     Liest ein Sample (uint16_t, LE), kein Auto-Inkrement,
+//                          0xFFFF wenn die FIFO leer ist
+//      0x0A  QUALITY       Signalqualitaet des letzten Schlags, 0..100
+//      0x0B  REJECTED      uint16_t, wegen geringer Qualitaet verworfene Schlaege
+//      0x0D  SPECTRAL_BPM  uint16_t, spektrale Schaetzung, gueltig mit I2C_STATUS_SPECTRAL
+//      0x0F  WHO_AM_I      0xB5
+//      0x10  HRV 1 Minute  Block aus MEAN_IBI, SDNN, RMSSD (je uint16_t in ms), PNN50 (%)
+//      0x18  HRV 5 Minuten Block wie 0x10, gueltig wenn I2C_STATUS_HRV_* gesetzt ist
+//***************************************************************************************
+
+#ifndef I2C_TARGET_H_
+#define I2C_TARGET_H_
+
+#include <stdint.h>
+#include "pulse.h"
+#include "hrv.h"
+#include "signal_quality.h"
+#include "spectral.h"
+
+#define I2C_TARGET_ADDRESS      0x48
+
+#define I2C_REG_STATUS          0x00
+#define I2C_REG_BPM             0x01
+#define I2C_REG_CONFIDENCE      0x03
+#define I2C_REG_IBI_MS          0x04
+#define I2C_REG_BEAT_COUNT      0x06
+#define I2C_REG_FIFO_COUNT      0x08
+#define I2C_REG_FIFO_DATA       0x09
+#define I2C_REG_QUALITY         0x0A
+#define I2C_REG_REJECTED        0x0B
+#define I2C_REG_SPECTRAL_BPM    0x0D
+#define I2C_REG_WHO_AM_I        0x0F
+#define I2C_REG_HRV_SHORT       0x10
+#define I2C_REG_HRV_LONG        0x18
+
+// Offsets within an HRV block
+#define I2C_HRV_MEAN_IBI        0
+#define I2C_HRV_SDNN            2
+#define I2C_HRV_RMSSD           4
+#define I2C_HRV_PNN50           6
+
+#define I2C_WHO_AM_I_VALUE      0xB5
+
+#define I2C_STATUS_VALID        0x01    // BPM is valid
+#define I2C_STATUS_ALARM        0x02    // Red LED / tone active
+#define I2C_STATUS_FIFO_OVERFLOW 0x04   // Samples were dropped since the last STATUS read
+#define I2C_STATUS_HRV_SHORT    0x08    // 1 minute HRV block is valid
+#define I2C_STATUS_HRV_LONG     0x10    // 5 minute HRV block is valid
+#define I2C_STATUS_SPECTRAL     0x20    // SPECTRAL_BPM is valid
+#define I2C_STATUS_BPM_AGREE    0x40    // BPM and SPECTRAL_BPM agree
+
+// Configure eUSCI_B1 as I2C target and enable its interrupts
+void i2cTargetInit(void);
+
+// Serialise a new snapshot if the pulse data or status changed, call once per sample
+void i2cTargetUpdate(const PulseDetector *pulse, const SignalQuality *quality,
+                     const SpectralEstimator *spectral, const HrvResult *hrvShort,
+                     const HrvResult *hrvLong, uint8_t alarm);
+
+// Append a sample to the FIFO, sets I2C_STATUS_FIFO_OVERFLOW if it is full
+void i2cTargetPushSample(uint16_t sample);
+
+#endif /* I2C_TARGET_H_ */
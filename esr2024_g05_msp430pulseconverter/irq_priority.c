@@ -0,0 +1,65 @@
+//***************************************************************************************
+//  Interruptprioritaeten ueber den ICC und Messung der ISR-Latenz
+//***************************************************************************************
+
+#include <msp430.h>
+#include <string.h>
+#include "driverlib/MSP430FR2xx_4xx/icc.h"
+#include "irq_priority.h"
+
+// Level 3 is served first. Unused sources keep their reset level.
+static const struct {
+    uint32_t sources;
+    uint8_t level;
+} priorities[] = {
+    // Sampling: the sample timer starts the conversion in software, its delay is jitter
+    { ICC_ILSR_TIMER0_B0 | ICC_ILSR_ADC,                                    ICC_LEVEL_3 },
+    // Communication: command UART, SPI stream, sensor bus and data ready, I2C target
+    { ICC_ILSR_EUSCI_A0 | ICC_ILSR_EUSCI_A1 | ICC_ILSR_EUSCI_B0 | ICC_ILSR_P2 |
+      ICC_ILSR_EUSCI_B1,                                                    ICC_LEVEL_2 },
+    // Output: tone samples and LED PWM
+    { ICC_ILSR_TIMER2_B0 | ICC_ILSR_TIMER3_B0 | ICC_ILSR_TIMER3_B1,         ICC_LEVEL_1 },
+    // Housekeeping: 10 ms tick and trace wrap, RTC, watchdog
+    { ICC_ILSR_TIMER1_B1 | ICC_ILSR_RTC_COUNTER | ICC_ILSR_WDT_INT,         ICC_LEVEL_0 }
+};
+
+#if IRQ_LATENCY_ENABLE
+IrqLatency irqLatency[IRQ_LATENCY_SOURCES];
+#endif
+
+void irqPriorityInit(void) {
+    uint8_t i;
+
+    for (i = 0; i < sizeof(priorities) / sizeof(priorities[0]); i++) {
+        ICC_setInterruptLevel(priorities[i].sources, priorities[i].level);
+    }
+    ICC_enable();
+}
+
+uint8_t irqLatencyGet(uint8_t source, IrqLatency *latency) {
+#if IRQ_LATENCY_ENABLE
+    unsigned short state = __get_interrupt_state();
+#endif
+
+    if (source >= IRQ_LATENCY_SOURCES) {
+        return 0;
+    }
+#if IRQ_LATENCY_ENABLE
+    __disable_interrupt();
+    *latency = irqLatency[source];
+    __set_interrupt_state(state);
+#else
+    memset(latency, 0, sizeof(*latency));
+#endif
+    return 1;
+}
+
+void irqLatencyClear(void) {
+#if IRQ_LATENCY_ENABLE
+    unsigned short state = __get_interrupt_state();
+
+    __disable_interrupt();
+    memset(irqLatency, 0, sizeof(irqLatency));
+    __set_interrupt_state(state);
+#endif
+}
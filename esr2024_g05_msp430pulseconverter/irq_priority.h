@@ -0,0 +1,84 @@
+//***************************************************************************************
+//  Interruptprioritaeten ueber den ICC und Messung der ISR-Latenz
+//
+//  Beschreibung: irqPriorityInit() weist allen benutzten Interruptquellen aus einer
+//  Tabelle (irq_priority.c) eine Stufe des Interrupt Compare Controllers zu und schaltet
+//  ihn ein: Abtast-Timer und ADC auf Stufe 3, UART, I2C, SPI und der Sensor-Interrupt
+//  auf Stufe 2, Ton und LED-PWM auf Stufe 1, der 10-ms-Takt, RTC und Watchdog auf
+//  Stufe 0. Stehen mehrere Anforderungen an, gewinnt die hoechste Stufe, bei gleicher
+//  Stufe die feste Reihenfolge der Vektoren. Ohne ICC kaeme der ADC nach allen Timern
+//  und eUSCIs an die Reihe. Die ISRs setzen GIE nicht wieder, eine laufende ISR wird
+//  also nicht unterbrochen; die Wartezeit einer Anforderung der Stufe 3 ist damit durch
+//  die laengste ISR und die gesperrten Abschnitte der Hauptschleife begrenzt.
+//
+//  Mit IRQ_LATENCY_ENABLE 1 misst jede Timer-ISR beim Eintritt die Zeit seit dem
+//  Vergleichsereignis, das sie ausgeloest hat, und zaehlt sie in ein Histogramm je Quelle
+//  (uart_cmd.h: CMD_GET_LATENCY, CMD_CLEAR_LATENCY; tools/latency.py). Beim ADC ist es
+//  die Zeit seit dem Vergleich des Abtast-Timers, also einschliesslich der Wandlung.
+//  Kosten: etwa 40 Zyklen je ISR.
+//***************************************************************************************
+
+#ifndef IRQ_PRIORITY_H_
+#define IRQ_PRIORITY_H_
+
+#include <stdint.h>
+
+#ifndef IRQ_LATENCY_ENABLE
+#define IRQ_LATENCY_ENABLE      0
+#endif
+
+// Measured sources
+#define IRQ_LATENCY_SAMPLE_TIMER    0   // Timer_B0 CCR0
+#define IRQ_LATENCY_ADC             1   // Since the Timer_B0 CCR0 compare
+#define IRQ_LATENCY_TICK            2   // Timer_B1 CCR1
+#define IRQ_LATENCY_PWM             3   // Timer_B3 CCR0
+#define IRQ_LATENCY_SOURCES         4
+
+// Bin n counts latencies below 2^(n+1) timer ticks (1 us), the last bin everything above
+#define IRQ_LATENCY_BINS        6
+
+typedef struct {
+    uint16_t bins[IRQ_LATENCY_BINS];    // Saturate at 0xFFFF
+    uint16_t max;                       // Timer ticks
+} IrqLatency;
+
+// Assign the ICC levels and enable the ICC, call with interrupts disabled
+void irqPriorityInit(void);
+
+#if IRQ_LATENCY_ENABLE
+extern IrqLatency irqLatency[IRQ_LATENCY_SOURCES];
+
+// Called from the ISRs with interrupts disabled
+static inline void irqLatencyRecord(uint8_t source, uint16_t ticks) {
+    IrqLatency *h = &irqLatency[source];
+    uint8_t bin = 0;
+
+    if (ticks > h->max) {
+        h->max = ticks;
+    }
+    while (ticks > 1 && bin < IRQ_LATENCY_BINS - 1) {
+        ticks >>= 1;
+        bin++;
+    }
+    if (h->bins[bin] != 0xFFFF) {
+        h->bins[bin]++;
+    }
+}
+#define IRQ_LATENCY(source, ticks)  irqLatencyRecord((source), (ticks))
+#else
+#define IRQ_LATENCY(source, ticks)
+#endif
+
+// Ticks since the CCR0 compare of a timer in up mode: the flag is set when the counter
+// reaches CCR0, one tick later it restarts at zero
+static inline uint16_t irqUpElapsed(uint16_t count, uint16_t period) {
+    return count >= period ? count - period : count + 1;
+}
+
+// Copy the histogram of a source, returns 0 for an unknown source. All zero if the
+// measurement is not built in.
+uint8_t irqLatencyGet(uint8_t source, IrqLatency *latency);
+
+void irqLatencyClear(void);
+
+#endif /* IRQ_PRIORITY_H_ */
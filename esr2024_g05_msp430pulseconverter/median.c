@@ -0,0 +1,72 @@
+//***************************************************************************************
+//  Gleitender Median ueber die letzten Werte
+//***************************************************************************************
+
+#include "median.h"
+
+// First index in sorted[0..count) whose value is >= 'value'
+static uint8_t lowerBound(const MedianWindow *m, uint8_t count, uint16_t value) {
+    uint8_t low = 0;
+    uint8_t high = count;
+    uint8_t mid;
+
+    while (low < high) {
+        mid = (uint8_t)((low + high) >> 1);
+        if (m->sorted[mid] < value) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+void medianInit(MedianWindow *m) {
+    m->head = 0;
+    m->count = 0;
+}
+
+void medianAdd(MedianWindow *m, uint16_t value) {
+    uint8_t count = m->count;
+    uint8_t old;
+    uint8_t pos;
+    uint8_t i;
+
+    pos = lowerBound(m, count, value);
+    if (count < MEDIAN_WINDOW) {
+        for (i = count; i > pos; i--) {
+            m->sorted[i] = m->sorted[i - 1];
+        }
+        m->count++;
+    } else {
+        // The new value takes the place of the oldest one, only the values in between move
+        old = lowerBound(m, count, m->ring[m->head]);
+        if (pos > old) {
+            pos--;
+            for (i = old; i < pos; i++) {
+                m->sorted[i] = m->sorted[i + 1];
+            }
+        } else {
+            for (i = old; i > pos; i--) {
+                m->sorted[i] = m->sorted[i - 1];
+            }
+        }
+    }
+    m->sorted[pos] = value;
+
+    m->ring[m->head] = value;
+    if (++m->head == MEDIAN_WINDOW) {
+        m->head = 0;
+    }
+}
+
+uint16_t medianGet(const MedianWindow *m) {
+    return (m->count != 0) ? m->sorted[(m->count - 1) >> 1] : 0;
+}
+
+uint16_t medianPercentile(const MedianWindow *m, uint8_t percent) {
+    if (m->count == 0) {
+        return 0;
+    }
+    return m->sorted[((uint16_t)(m->count - 1) * percent + 50) / 100];
+}
@@ -0,0 +1,47 @@
+//***************************************************************************************
+//  Gleitender Median ueber die letzten Werte
+//
+//  Beschreibung: Haelt die letzten MEDIAN_WINDOW Werte in Eingangsreihenfolge (Ring) und
+//  zusaetzlich sortiert. Beim Einfuegen wird der verdraengte aelteste Wert per binaerer
+//  Suche im sortierten Feld gefunden und die Einfuegeposition ebenso bestimmt; der neue
+//  Wert ersetzt den alten an Ort und Stelle, verschoben wird nur der Bereich zwischen
+//  beiden Positionen. Median und Perzentile sind direkte Zugriffe. Die Groesse steht zur
+//  Uebersetzungszeit fest und laesst sich mit -DMEDIAN_WINDOW=n aendern (1..255, fuer
+//  pulse.c mehr als PULSE_MEDIAN_MIN_COUNT); bei gerader Groesse liefert medianGet() den
+//  unteren der beiden mittleren Werte. tools/cycles/run.py --median-windows misst
+//  Einfuegen und Median fuer mehrere Groessen gegen Sortieren bei jedem Wert.
+//  Frei von Hardwarezugriffen.
+//***************************************************************************************
+
+#ifndef MEDIAN_H_
+#define MEDIAN_H_
+
+#include <stdint.h>
+
+#ifndef MEDIAN_WINDOW
+#define MEDIAN_WINDOW           9       // Odd, so the median is a single value
+#endif
+
+#if MEDIAN_WINDOW < 1 || MEDIAN_WINDOW > 255
+#error "MEDIAN_WINDOW must fit the uint8_t positions"
+#endif
+
+typedef struct {
+    uint16_t ring[MEDIAN_WINDOW];       // Insertion order, ring[head] is the oldest when full
+    uint16_t sorted[MEDIAN_WINDOW];     // Same values, ascending
+    uint8_t  head;
+    uint8_t  count;
+} MedianWindow;
+
+void medianInit(MedianWindow *m);
+
+// Add a value, the oldest one is dropped once the window is full
+void medianAdd(MedianWindow *m, uint16_t value);
+
+// Median of the values in the window, 0 if it is empty
+uint16_t medianGet(const MedianWindow *m);
+
+// Value at 'percent' (0..100) of the sorted window, 0 if it is empty
+uint16_t medianPercentile(const MedianWindow *m, uint8_t percent);
+
+#endif /* MEDIAN_H_ */
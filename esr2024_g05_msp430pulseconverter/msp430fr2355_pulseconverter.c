@@ -1,9 +1,15 @@
 //***************************************************************************************
 //  MSP430 ADC und LED Steuerungs-Demo - Schalte rote und blaue LEDs mit Piezo-Lautsprecher
 //
-//  Beschreibung: Dieses Programm verwendet den ADC, um einen Sensorwert an P1.2 zu lesen 
-//  und schaltet eine rote LED an P3.0 und eine blaue LED an P3.2 basierend auf dem ADC-Wert. 
-//  Ein Piezo-Lautsprecher, der an P3.4 angeschlossen ist, piept mit 2 kHz, wenn die rote LED leuchtet.
+//  Beschreibung: Dieses Programm verwendet den ADC, um einen Sensorwert an P1.2 zu lesen,
+//  erkennt daraus die Herzschlaege und berechnet den Puls. Eine rote LED an P3.0, eine
+//  blaue LED an P3.2 und ein Piezo-Lautsprecher an P3.1 zeigen die Alarmzone (alarm.h:
+//  kein Signal, Bradykardie, normal, Tachykardie) mit Mustern ohne Warteschleifen; im
+//  Normalbereich folgt die Helligkeit der blauen LED der Pulskurve. Der Piezo wird ueber
+//  den DAC mit geformten Toenen angesteuert und klickt bei jedem Schlag.
+//  Timer_B0 taktet die ADC-Wandlungen, die Werte laufen durch ein Biquad-Tiefpassfilter.
+//  Schwellen, Abtastrate, Filter, Tonfrequenz und Ausgabemodus lassen sich zur Laufzeit
+//  ueber das UART-Kommandointerface (uart_cmd.h) einstellen und im FRAM speichern.
 //
 //                MSP430FR2355
 //             -----------------
@@ -11,16 +17,24 @@
 //          | |                 |
 //          --|RST          XOUT|-
 //            |                 |
-//            |             P1.2|<-- Sensor Input (ADC)
+//            |             P1.2|<-- Sensor Input (ADC) / I2C SDA (digital sensor)
+//            |             P1.3|--> I2C SCL (digital sensor)
+//            |             P2.1|<-- Digital sensor INT
 //            |                 |
 //            |             P3.0|--> Red LED
 //            |                 |
 //            |             P3.2|--> Blue LED
 //            |                 |
-//            |             P3.4|--> Piezo Speaker
+//            |             P3.1|--> Piezo Speaker (SAC2 DAC)
 //            |                 |
+//            |             P1.6|<-- UART RXD (Commands)
+//            |             P1.7|--> UART TXD
 //            |                 |
+//            |             P4.6|<-> I2C SDA (Target)
+//            |             P4.7|<-- I2C SCL
 //            |                 |
+//            |             P4.1|--> SPI CLK (Stream)
+//            |             P4.3|--> SPI SIMO
 //            |                 |
 //            |                 |
 //            |                 |
@@ -29,23 +43,64 @@
 //***************************************************************************************
 
 #include <msp430.h>
+#include <stdint.h>
+#include "system.h"
+#include "config.h"
+#include "uart_cmd.h"
+#include "pipeline.h"
+#include "alarm.h"
+#include "output.h"
+#include "i2c_target.h"
+#include "spi_stream.h"
+#include "i2c_async.h"
+#include "ppg_sensor.h"
+#include "sample_queue.h"
+#include "power.h"
+#include "trace.h"
+#include "irq_priority.h"
+#include "boot.h"
+#include "calibration.h"
+#include "driverlib/MSP430FR2xx_4xx/pmm.h"
  
-#define THRESHOLD_VOLTAGE   3000  // ~2V (3000/4095 * 3.3V reference = 2V)
-#define PIEZO_PIN           BIT4  // Assuming Piezo is connected to P3.4
- 
-void configureGPIO(void) {
-    // Configure Red LED (P3.0) as output
-    P3DIR |= BIT0;     // Set P3.0 output direction
-    P3OUT &= ~BIT0;    // Initialize P3.0 to off
- 
-    // Configure Blue LED (P3.2) as output
-    P3DIR |= BIT2;     // Set P3.2 output direction
-    P3OUT |= BIT2;     // Initialize P3.2 to on
+static volatile uint8_t streaming;    // Raw samples go to the SPI stream
+static uint8_t decimation = 1;        // ADC samples per processed sample
+static uint8_t decimationCount = 1;
+static Pipeline pipeline;             // Filter, beat detection, quality, HRV (pipeline.h)
+static AlarmState alarm;
+static uint32_t lastSampleMs;         // outputMillis() of the last processed sample
+static uint8_t deferredDone;          // deferredInit() ran
+
+// Supply measurement: the main loop switches the internal reference on, the sample timer
+// lets it settle for a period and converts it in the next slot instead of the sensor
+#define SUPPLY_IDLE         0
+#define SUPPLY_SETTLING     1
+#define SUPPLY_READY        2
+#define SUPPLY_CONVERTING   3
+#define SUPPLY_DONE         4
+#define SUPPLY_ADC_INPUT    ADCINCH_13      // Internal 1.5 V reference
+static volatile uint8_t supplyState;
+static volatile uint16_t supplyRefCode;
+static uint16_t heldSample;           // Stands in for the slot that converted the reference
+static uint32_t supplyMs;             // outputMillis() of the last measurement
+static uint8_t supplyMeasured;
  
-    // Configure Piezo Speaker (P3.4) as output
-    P3DIR |= PIEZO_PIN; // Set P3.4 output direction
-    P3OUT &= ~PIEZO_PIN; // Initialize P3.4 to off
+void configureClock(void) {
+    // DCO at 8 MHz, FLL referenced to the internal 32768 Hz REFO
+    __bis_SR_register(SCG0);                // Disable FLL
+    CSCTL3 |= SELREF__REFOCLK;              // REFO as FLL reference
+    CSCTL0 = 0;                             // Clear DCO and MOD registers
+    CSCTL1 = DCORSEL_3;                     // DCO range 8 MHz
+    CSCTL2 = FLLD_0 + 243;                  // DCODIV = (243 + 1) * 32768 Hz = 8 MHz
+    __delay_cycles(3);
+    __bic_SR_register(SCG0);                // Enable FLL
+    while (CSCTL7 & (FLLUNLOCK0 | FLLUNLOCK1)); // Wait for the FLL to lock
+
+    CSCTL4 = SELMS__DCOCLKDIV | SELA__REFOCLK;  // MCLK = SMCLK = 8 MHz, ACLK = REFO
+}
  
+void configureGPIO(void) {
+    // LEDs and piezo are set up by outputInit()
+
     // Configure ADC input (P1.2)
     P1SEL0 |= BIT2;    // Set P1.2 for ADC function
     P1SEL1 |= BIT2;
@@ -57,57 +112,284 @@ void configureADC(void) {
     ADCCTL1 = ADCSHP;                       // ADC sample-and-hold pulse mode
     ADCCTL2 = ADCRES_2;                     // 12-bit conversion results
     ADCMCTL0 = ADCINCH_2 | ADCSREF_0;       // A2 input channel, Vcc/Vss reference
+    ADCIE = ADCIE0;                         // Interrupt when a conversion is done
+}
+
+void configureTimer(void) {
+    // Timer_B0 in up mode triggers one ADC conversion per period, the period is set
+    // by applyConfig()
+    TB0CCTL0 = CCIE;
+    TB0CTL = TBSSEL__SMCLK | ID__8 | TBCLR;
 }
  
-void delayMicroseconds(unsigned int us) {
-    while (us--) {
-        __delay_cycles(1); // 1 cycle per microsecond for 1 MHz clock
+// Drop a running supply measurement, the reference is switched off and A2 selected again
+void supplyAbort(void) {
+    unsigned short state = __get_interrupt_state();
+
+    __disable_interrupt();
+    if (supplyState == SUPPLY_CONVERTING) {
+        ADCCTL0 &= ~ADCENC;                 // Stops the conversion, its result is dropped
+        ADCMCTL0 = ADCINCH_2 | ADCSREF_0;
+        ADCIFG &= ~ADCIFG0;
     }
+    supplyState = SUPPLY_IDLE;
+    __set_interrupt_state(state);
+    PMM_disableInternalReference();
 }
- 
-void togglePiezo(unsigned int frequency) {
-    unsigned int delayTime = 500000 / frequency; // Calculate half period for given frequency in microseconds
-    P3OUT ^= PIEZO_PIN;   // Toggle Piezo pin
-    delayMicroseconds(delayTime); // Half period delay
+
+// Measure the supply at start and every SUPPLY_PERIOD_MS after, analog source without
+// streaming only: the stream must not carry reference codes
+void supplyTask(uint32_t now) {
+    if (supplyState == SUPPLY_DONE) {
+        PMM_disableInternalReference();
+        supplyState = SUPPLY_IDLE;
+        calibrationSupplyUpdate(supplyRefCode);
+        supplyMeasured = 1;
+        supplyMs = now;
+    } else if (supplyState == SUPPLY_IDLE && config->sensorSource == SENSOR_SOURCE_ANALOG &&
+               !streaming && (!supplyMeasured || now - supplyMs >= SUPPLY_PERIOD_MS)) {
+        PMM_selectVoltageReference(REFVSEL_0);
+        PMM_enableInternalReference();
+        supplyState = SUPPLY_SETTLING;
+    }
 }
- 
+
+// Re-apply parameters changed over the command interface
+void applyConfig(void) {
+    uint8_t changed = configChanged;
+
+    if (changed == 0) {
+        return;
+    }
+    configChanged = 0;
+    TRACE_EVENT(TRACE_EVENT_CONFIG, changed);
+
+    if (changed & CONFIG_CHANGED_SENSOR) {
+        if (config->sensorSource == SENSOR_SOURCE_I2C) {
+            ppgSensorStart();
+        } else {
+            ppgSensorStop();
+            // P1.2 back to the ADC input, release P1.3
+            P1SEL0 &= ~BIT3;
+            P1SEL0 |= BIT2;
+            P1SEL1 |= BIT2;
+        }
+        sampleQueueClear();
+    }
+
+    if (changed & CONFIG_CHANGED_SAMPLE_RATE) {
+        // Stop the timer so the new period cannot be overrun by the running counter
+        TB0CTL &= ~MC_3;
+        supplyAbort();
+        sampleQueueClear();                 // Samples of the old rate must not meet the new filter
+        streaming = 0;
+        spiStreamStop();
+        decimation = 1;
+
+        if (config->sensorSource == SENSOR_SOURCE_I2C) {
+            // The digital sensor paces itself, the ADC timer stays off
+            pipelineSetRate(&pipeline, PPG_SENSOR_RATE_HZ);
+        } else if (config->streamEnable) {
+            // Sample at the stream rate, every n-th sample goes to the detection
+            decimation = (uint8_t)(STREAM_RATE_HZ / config->sampleRateHz);
+            TB0CCR0 = (uint16_t)(TIMER_CLK_HZ / STREAM_RATE_HZ) - 1;
+            spiStreamStart(ADCINCH_2);
+            streaming = 1;
+            pipelineSetRate(&pipeline, (uint16_t)(STREAM_RATE_HZ / decimation));
+        } else {
+            TB0CCR0 = (uint16_t)(TIMER_CLK_HZ / config->sampleRateHz) - 1;
+            pipelineSetRate(&pipeline, config->sampleRateHz);
+        }
+
+        decimationCount = decimation;
+        if (config->sensorSource == SENSOR_SOURCE_ANALOG) {
+            TB0CTL |= TBCLR | MC__UP;
+        }
+    }
+    if (changed & (CONFIG_CHANGED_SAMPLE_RATE | CONFIG_CHANGED_FILTER)) {
+        // The filter only runs in takeSample(), so the set is swapped between two samples
+        pipelineSetFilter(&pipeline, configFilterCoeffs(pipeline.pulse.sampleRateHz));
+    }
+    if (changed & CONFIG_CHANGED_ALARM) {
+        alarmConfigure(&alarm, config->bradyBpm, config->tachyBpm, config->alarmHysteresisBpm,
+                       config->alarmDelayS);
+        outputSetPattern(alarmPattern(alarm.zone));
+    }
+}
+
+// Filter the next queued sample and run the beat detection, returns 0 if none is waiting
+uint8_t takeSample(void) {
+    uint16_t sample;
+    uint8_t events;
+    int16_t filtered;
+
+    if (!sampleQueuePop(&sample)) {
+        return 0;
+    }
+    bootMark(BOOT_STAGE_FIRST_SAMPLE);
+    events = pipelineStep(&pipeline, sample, (int16_t)config->thresholdOn,
+                          (int16_t)config->thresholdOff, config->qualityMin);
+    if (events & PIPELINE_LEVEL) {
+        outputSetLevel(pipeline.brightness.level);
+    }
+    if (events & PIPELINE_BEAT) {
+        TRACE_EVENT(TRACE_EVENT_BEAT, pipeline.pulse.bpm > 255 ? 255 : pipeline.pulse.bpm);
+        if (deferredDone) {
+            outputBeat();                   // Starts Timer_B2, set up by outputInit()
+        }
+    }
+
+    // Publish to the I2C host
+    filtered = pipeline.filtered;
+    if (filtered < 0) {
+        i2cTargetPushSample(0);
+    } else if (filtered > ADC_MAX_CODE) {
+        i2cTargetPushSample(ADC_MAX_CODE);
+    } else {
+        i2cTargetPushSample((uint16_t)filtered);
+    }
+    return 1;
+}
+
+// Modules the sampling does not depend on, set up in place of the first sleep. Until
+// then their calls from the main loop only touch RAM.
+void deferredInit(void) {
+    outputInit();
+    traceInit();
+    uartCmdInit();
+    i2cTargetInit();
+    deferredDone = 1;
+    bootMark(BOOT_STAGE_DEFERRED);
+}
+
+// Sleep in LPM0 until a new sample or command byte arrives
+void waitForEvent(void) {
+    __disable_interrupt();
+    if (sampleQueueEmpty() && !uartCmdPending()) {
+        if (!deferredDone) {
+            __enable_interrupt();
+            deferredInit();
+            return;
+        }
+        TRACE_BEGIN(TRACE_TASK_SLEEP);
+        powerSleep();
+        TRACE_END(TRACE_TASK_SLEEP);
+    } else {
+        __enable_interrupt();
+        powerBusy();
+    }
+}
+
 int main(void) {
-    WDTCTL = WDTPW | WDTHOLD; // Stop WDT
- 
+    uint32_t now;
+    uint16_t alarmBpm;
+    uint8_t valid;
+
+    // Watchdog stopped and RTC started by _system_pre_init() (boot.c)
+    bootMark(BOOT_STAGE_MAIN);
+    configureClock();
+    bootMark(BOOT_STAGE_CLOCK);
+
+    // Sampling path only, the rest follows in deferredInit()
+    powerInit();
+    configLoad();
+    calibrationInit();
+    pipelineInit(&pipeline, config->sampleRateHz, configFilterCoeffs(config->sampleRateHz));
     configureGPIO();
     configureADC();
+    configureTimer();
+    spiStreamInit();                        // applyConfig() may start the stream right away
+    i2cAsyncInit(PPG_I2C_RATE_HZ);
+    ppgSensorInit();
+    irqPriorityInit();
  
     // Disable the GPIO power-on default high-impedance mode
     PM5CTL0 &= ~LOCKLPM5;
+
+    __enable_interrupt();
+    applyConfig();                          // Start sampling from the configured source
+    bootMark(BOOT_STAGE_SAMPLING);
  
     while (1) {
-        // Start ADC conversion
-        ADCCTL0 |= ADCENC | ADCSC;
- 
-        // Wait for ADC conversion to complete
-        while (ADCCTL1 & ADCBUSY);
- 
-        // Check if ADC value is above the threshold
-        if (ADCMEM0 >= THRESHOLD_VOLTAGE) {
-            // Turn on Red LED and turn off Blue LED
-            P3OUT |= BIT0;
-            P3OUT &= ~BIT2;
- 
-            // Toggle Piezo as long as the red LED is on
-            while (ADCMEM0 >= THRESHOLD_VOLTAGE) {
-                togglePiezo(2000); // Toggle Piezo at 2 kHz
-                ADCCTL0 |= ADCENC | ADCSC;
-                while (ADCCTL1 & ADCBUSY);
-            }
- 
-            // Ensure Piezo is off after the loop
-            P3OUT &= ~PIEZO_PIN;
- 
+        waitForEvent();
+        TRACE_BEGIN(TRACE_TASK_COMMANDS);
+        uartCmdProcess();
+        TRACE_END(TRACE_TASK_COMMANDS);
+        TRACE_BEGIN(TRACE_TASK_CONFIG);
+        applyConfig();
+        TRACE_END(TRACE_TASK_CONFIG);
+        now = outputMillis();
+        supplyTask(now);
+        TRACE_BEGIN(TRACE_TASK_SAMPLE);
+        if (takeSample()) {
+            lastSampleMs = now;
+        }
+        TRACE_END(TRACE_TASK_SAMPLE);
+
+        // Woken at least every OUTPUT_WAKE_MS, so a sensor that stopped delivering samples
+        // is noticed as a lost signal too
+        TRACE_BEGIN(TRACE_TASK_PUBLISH);
+        alarmBpm = pipelineAlarmBpm(&pipeline);
+        valid = alarmBpm != 0 && (now - lastSampleMs) < PULSE_TIMEOUT_MS;
+        if (alarmUpdate(&alarm, valid, alarmBpm, now)) {
+            TRACE_EVENT(TRACE_EVENT_ZONE, alarm.zone);
+            outputSetPattern(alarmPattern(alarm.zone));
+        }
+        i2cTargetUpdate(&pipeline.pulse, &pipeline.quality, &pipeline.spectral,
+                        &pipeline.hrvShort.result, &pipeline.hrvLong.result, alarmIsActive(&alarm));
+        TRACE_END(TRACE_TASK_PUBLISH);
+    }
+}
+
+#pragma vector=TIMER0_B0_VECTOR
+__interrupt void TIMER0_B0_ISR(void) {
+    IRQ_LATENCY(IRQ_LATENCY_SAMPLE_TIMER, irqUpElapsed(TB0R, TB0CCR0));
+    TRACE_ISR_BEGIN(TRACE_ISR_SAMPLE_TIMER);
+    if (supplyState == SUPPLY_SETTLING) {
+        supplyState = SUPPLY_READY;
+    } else if (supplyState == SUPPLY_READY) {
+        // The input can only change with ADCENC cleared, the ADC ISR switches back
+        ADCCTL0 &= ~ADCENC;
+        ADCMCTL0 = SUPPLY_ADC_INPUT | ADCSREF_0;
+        supplyState = SUPPLY_CONVERTING;
+    }
+    ADCCTL0 |= ADCENC | ADCSC;              // Start the next conversion
+    TRACE_ISR_END(TRACE_ISR_SAMPLE_TIMER);
+}
+
+#pragma vector=ADC_VECTOR
+__interrupt void ADC_ISR(void) {
+    uint16_t sample;
+
+    IRQ_LATENCY(IRQ_LATENCY_ADC, irqUpElapsed(TB0R, TB0CCR0));
+    TRACE_ISR_BEGIN(TRACE_ISR_ADC);
+    switch (__even_in_range(ADCIV, ADCIV_ADCIFG)) {
+    case ADCIV_ADCIFG:
+        sample = ADCMEM0;
+        powerAdcConversions++;
+        if (supplyState == SUPPLY_CONVERTING) {
+            ADCCTL0 &= ~ADCENC;
+            ADCMCTL0 = ADCINCH_2 | ADCSREF_0;
+            supplyRefCode = sample;
+            supplyState = SUPPLY_DONE;
+            sample = heldSample;            // Repeat the last sensor value for this slot
         } else {
-            // Ensure Blue LED is on and Red LED is off
-            P3OUT |= BIT2;
-            P3OUT &= ~BIT0;
+            heldSample = sample;
+        }
+        if (streaming) {
+            spiStreamPut(sample);
+        }
+        if (--decimationCount == 0) {
+            decimationCount = decimation;
+            // The stream keeps the raw values, the pipeline gets corrected ones
+            if (!sampleQueuePush(adcCorrect(&adcCorrection, sample))) {
+                TRACE_EVENT(TRACE_EVENT_QUEUE_FULL, 0);
+            }
+            __bic_SR_register_on_exit(LPM0_bits);   // Wake the main loop
         }
+        break;
+    default:
+        break;
     }
+    TRACE_ISR_END(TRACE_ISR_ADC);
 }
-hat Kontextmenü
@@ -0,0 +1,236 @@
+//***************************************************************************************
+//  LED- und Piezo-Ausgabe ueber Timer_B1, LED-PWM ueber Timer_B3 und Ton ueber den SAC-DAC
+//***************************************************************************************
+
+#include <msp430.h>
+#include "driverlib/MSP430FR2xx_4xx/sac.h"
+#include "output.h"
+#include "config.h"
+#include "system.h"
+#include "trace.h"
+#include "irq_priority.h"
+
+#define RED_LED_PIN     BIT0    // P3.0
+#define BLUE_LED_PIN    BIT2    // P3.2
+#define PIEZO_PIN       BIT1    // P3.1, OA2O
+
+#define TICK_COUNTS     ((uint16_t)(TIMER_CLK_HZ / 1000UL * OUTPUT_TICK_MS))
+#define SYNTH_COUNTS    ((uint16_t)(SMCLK_HZ / SYNTH_RATE_HZ))
+
+static const AlarmPattern *pattern;
+static uint16_t phaseMs;
+static uint8_t wakeCount;
+static uint8_t toneOn;
+static Synth synth;
+static volatile uint32_t millis;
+static volatile uint8_t level = 255;
+static volatile uint16_t redDuty;           // PWM values taken over at the next period
+static volatile uint16_t blueDuty;
+
+void outputInit(void) {
+    P3OUT &= ~(RED_LED_PIN | BLUE_LED_PIN);
+    P3DIR |= RED_LED_PIN | BLUE_LED_PIN;
+
+    // Piezo on the SAC2 amplifier as buffer for its DAC, idle at mid scale
+    P3SEL0 |= PIEZO_PIN;
+    P3SEL1 |= PIEZO_PIN;
+    synthInit(&synth, SYNTH_RATE_HZ);
+    SAC_OA_init(SAC2_BASE, SAC_OA_POSITIVE_INPUT_SOURCE_DAC, SAC_OA_NEGATIVE_INPUT_SOURCE_PGA);
+    SAC_OA_selectPowerMode(SAC2_BASE, SAC_OA_POWER_MODE_LOW_SPEED_LOW_POWER);
+    SAC_PGA_setMode(SAC2_BASE, SAC_PGA_MODE_BUFFER);
+    SAC_DAC_selectRefVoltage(SAC2_BASE, SAC_DAC_PRIMARY_REFERENCE);     // AVCC
+    SAC_DAC_selectLoad(SAC2_BASE, SAC_DAC_LOAD_DEVICE_SPECIFIC_0);      // TB2.1 rising edge
+    SAC_DAC_setData(SAC2_BASE, SYNTH_MIDSCALE);
+    SAC_DAC_enable(SAC2_BASE);
+    SAC_OA_enable(SAC2_BASE);
+    SAC_enable(SAC2_BASE);
+
+    // Synthesis clock: 8 MHz up mode, started while a tone sounds. TB2.1 rises at the
+    // period start and loads the sample written in the previous period, so the ISR
+    // latency does not show up as jitter in the output.
+    TB2CCR0 = SYNTH_COUNTS - 1;
+    TB2CCR1 = SYNTH_COUNTS / 2;
+    TB2CCTL1 = OUTMOD_7;
+    TB2CCTL0 = CCIE;
+    TB2CTL = TBSSEL__SMCLK | MC__STOP | TBCLR;
+
+    // 1 MHz continuous, CCR1 is the tick
+    TB1CCR1 = TICK_COUNTS;
+    TB1CCTL1 = CCIE;
+    TB1CTL = TBSSEL__SMCLK | ID__8 | MC__CONTINUOUS | TBCLR;
+
+    // LED PWM: 1 MHz up mode, period BRIGHTNESS_FULL counts (250 Hz)
+    TB3CCR0 = BRIGHTNESS_FULL - 1;
+    TB3CCTL0 = CCIE;
+    TB3CCTL1 = 0;
+    TB3CCTL2 = 0;
+    TB3CTL = TBSSEL__SMCLK | ID__8 | MC__UP | TBCLR;
+}
+
+void outputSetLevel(uint8_t newLevel) {
+    level = newLevel;
+}
+
+void outputSetPattern(const AlarmPattern *newPattern) {
+    unsigned short state = __get_interrupt_state();
+
+    __disable_interrupt();
+    pattern = newPattern;
+    phaseMs = 0;
+    __set_interrupt_state(state);
+}
+
+uint32_t outputMillis(void) {
+    unsigned short state = __get_interrupt_state();
+    uint32_t now;
+
+    __disable_interrupt();
+    now = millis;
+    __set_interrupt_state(state);
+    return now;
+}
+
+uint16_t outputLedDuty(void) {
+    return redDuty + blueDuty;
+}
+
+uint8_t outputToneActive(void) {
+    return (TB2CTL & MC__UPDOWN) != MC__STOP;
+}
+
+static void startSynth(void) {
+    if ((TB2CTL & MC__UPDOWN) == MC__STOP) {
+        TB2CTL |= TBCLR | MC__UP;
+    }
+}
+
+static void setTone(uint8_t on) {
+    if (on == toneOn) {
+        return;
+    }
+    toneOn = on;
+    if (on) {
+        synthNoteOn(&synth, config->toneHz, TONE_ATTACK_MS);
+        startSynth();
+    } else {
+        synthNoteOff(&synth, TONE_RELEASE_MS);
+    }
+}
+
+void outputBeat(void) {
+    unsigned short state = __get_interrupt_state();
+
+    __disable_interrupt();
+    if (!toneOn && config->outputMode == OUTPUT_MODE_LED_PIEZO) {
+        synthClick(&synth, config->toneHz, CLICK_ATTACK_MS, CLICK_DECAY_MS);
+        startSynth();
+    }
+    __set_interrupt_state(state);
+}
+
+// Advance the pattern by one tick
+static void playPattern(void) {
+    uint8_t leds = 0;
+    uint8_t tone = 0;
+    uint8_t on;
+    uint16_t duty = BRIGHTNESS_FULL;
+
+    if (pattern != 0 && config->outputMode != OUTPUT_MODE_OFF) {
+        on = (phaseMs < pattern->onMs);
+        leds = on ? pattern->onLeds : pattern->offLeds;
+        tone = on && pattern->tone && config->outputMode == OUTPUT_MODE_LED_PIEZO;
+        if (pattern->follow) {
+            duty = brightnessDuty(level);
+        }
+
+        phaseMs += OUTPUT_TICK_MS;
+        if (phaseMs >= pattern->periodMs) {
+            phaseMs = 0;
+        }
+    }
+
+    redDuty = (leds & ALARM_LED_RED) ? duty : 0;
+    blueDuty = (leds & ALARM_LED_BLUE) ? duty : 0;
+    setTone(tone);
+}
+
+// One sample per period, a fixed path without loops. The timer stops once the tone
+// has faded out.
+#pragma vector=TIMER2_B0_VECTOR
+__interrupt void TIMER2_B0_ISR(void) {
+    SAC_DAC_setData(SAC2_BASE, synthNext(&synth));
+    if (!synthActive(&synth)) {
+        TB2CTL &= ~MC__UPDOWN;
+    }
+}
+
+#pragma vector=TIMER1_B1_VECTOR
+__interrupt void TIMER1_B1_ISR(void) {
+    switch (__even_in_range(TB1IV, TBIV__TBIFG)) {
+    case TBIV__TBCCR1:
+        IRQ_LATENCY(IRQ_LATENCY_TICK, (uint16_t)(TB1R - TB1CCR1));
+        TRACE_ISR_BEGIN(TRACE_ISR_TICK);
+        TB1CCR1 += TICK_COUNTS;
+        millis += OUTPUT_TICK_MS;
+        playPattern();
+        if (++wakeCount >= OUTPUT_WAKE_MS / OUTPUT_TICK_MS) {
+            wakeCount = 0;
+            __bic_SR_register_on_exit(LPM0_bits);   // Let the alarm zones be evaluated
+        }
+        TRACE_ISR_END(TRACE_ISR_TICK);
+        break;
+    case TBIV__TBIFG:
+        TRACE_WRAP();                       // Only enabled by traceInit()
+        break;
+    default:
+        break;
+    }
+}
+
+// Start of a PWM period: switch the LEDs with a non-zero duty on and arm their off compare,
+// a full duty needs no compare. At level 1 this ISR waits behind the ADC and eUSCI ISRs;
+// if the counter already passed a short duty, its compare would only come in the next
+// period and leave the LED on at full brightness, so the LED goes off here instead.
+#pragma vector=TIMER3_B0_VECTOR
+__interrupt void TIMER3_B0_ISR(void) {
+    uint16_t red = redDuty;
+    uint16_t blue = blueDuty;
+    uint16_t now;
+
+    IRQ_LATENCY(IRQ_LATENCY_PWM, irqUpElapsed(TB3R, TB3CCR0));
+    TRACE_ISR_BEGIN(TRACE_ISR_PWM);
+    TB3CCR1 = red;
+    TB3CCTL1 = (red > 0 && red < BRIGHTNESS_FULL) ? CCIE : 0;
+    TB3CCR2 = blue;
+    TB3CCTL2 = (blue > 0 && blue < BRIGHTNESS_FULL) ? CCIE : 0;
+    P3OUT = (P3OUT & ~(RED_LED_PIN | BLUE_LED_PIN)) |
+            (red ? RED_LED_PIN : 0) | (blue ? BLUE_LED_PIN : 0);
+    // Read after the compares are armed: a count below the duty still meets its compare.
+    // The count of CCR0 itself means the period has not restarted yet.
+    now = TB3R;
+    if (now < BRIGHTNESS_FULL - 1) {
+        if (now >= red) {
+            P3OUT &= ~RED_LED_PIN;
+        }
+        if (now >= blue) {
+            P3OUT &= ~BLUE_LED_PIN;
+        }
+    }
+    TRACE_ISR_END(TRACE_ISR_PWM);
+}
+
+#pragma vector=TIMER3_B1_VECTOR
+__interrupt void TIMER3_B1_ISR(void) {
+    TRACE_ISR_BEGIN(TRACE_ISR_PWM_OFF);
+    switch (__even_in_range(TB3IV, TBIV__TBIFG)) {
+    case TBIV__TBCCR1:
+        P3OUT &= ~RED_LED_PIN;
+        break;
+    case TBIV__TBCCR2:
+        P3OUT &= ~BLUE_LED_PIN;
+        break;
+    default:
+        break;
+    }
+    TRACE_ISR_END(TRACE_ISR_PWM_OFF);
+}
@@ -0,0 +1,60 @@
+//***************************************************************************************
+//  LED- und Piezo-Ausgabe ueber Timer_B1, LED-PWM ueber Timer_B3 und Ton ueber den SAC-DAC
+//  (rote LED P3.0, blaue LED P3.2, Piezo P3.1)
+//
+//  Beschreibung: Timer_B1 laeuft im Continuous-Modus mit 1 MHz. CCR1 erzeugt einen
+//  10-ms-Takt, der das aktuelle Muster (alarm.h) abspielt, die Millisekundenzeit
+//  fortschreibt und die Hauptschleife alle 100 ms weckt. Der Ausgabemodus der
+//  Konfiguration (LED+Piezo, nur LED, aus) wird bei jedem Takt beachtet.
+//  Toene entstehen in synth.c als Sinus mit Huellkurve und gehen mit 16 kHz ueber den
+//  DAC von SAC2 und dessen Verstaerker (OA2O, P3.1) an den Piezo. Timer_B2 laedt die
+//  Werte per TB2.1 in den DAC, die ISR berechnet nur den naechsten Wert. Der Timer
+//  laeuft nur, solange ein Ton klingt.
+//  Die Helligkeit der LEDs wird per PWM mit 250 Hz aus Timer_B3 (Up-Modus) gesteuert.
+//  P3.0 und P3.2 haben keine Timer-Ausgangsfunktion, daher schalten die CCR-Interrupts
+//  die Pins: CCR0 zu Periodenbeginn ein und uebernimmt die neuen Tastgrade, CCR1 (rot)
+//  und CCR2 (blau) schalten aus. Die Flanken liegen damit um die Wartezeit der ISRs
+//  (Stufe 1, irq_priority.h) hinter den Vergleichszeitpunkten. Hat der Zaehler einen
+//  kurzen Tastgrad schon ueberschritten, wenn die CCR0-ISR drankommt, schaltet sie die
+//  LED selbst gleich wieder aus, statt sie eine Periode voll leuchten zu lassen.
+//***************************************************************************************
+
+#ifndef OUTPUT_H_
+#define OUTPUT_H_
+
+#include <stdint.h>
+#include "alarm.h"
+#include "brightness.h"
+#include "synth.h"
+
+#define OUTPUT_TICK_MS          10
+#define OUTPUT_WAKE_MS          100     // Main loop wake up interval
+#define SYNTH_RATE_HZ           16000   // DAC update rate while a tone sounds
+
+#define TONE_ATTACK_MS          5       // Soft edges, no click at the start and end of alarm tones
+#define TONE_RELEASE_MS         10
+#define CLICK_ATTACK_MS         1       // Beat click
+#define CLICK_DECAY_MS          40
+
+// Configure the pins, timers and the DAC, starts with all outputs off
+void outputInit(void);
+
+// Play 'pattern' from its start
+void outputSetPattern(const AlarmPattern *pattern);
+
+// Brightness level 0..255 for patterns that follow the pulse, from brightness.h
+void outputSetLevel(uint8_t level);
+
+// Short click for an accepted beat, unless an alarm tone is sounding or the piezo is muted
+void outputBeat(void);
+
+// Milliseconds since outputInit(), in OUTPUT_TICK_MS steps
+uint32_t outputMillis(void);
+
+// Sum of the current PWM duties of both LEDs, 0..2 * BRIGHTNESS_FULL
+uint16_t outputLedDuty(void);
+
+// Non-zero while the tone synthesis (Timer_B2, DAC) runs
+uint8_t outputToneActive(void);
+
+#endif /* OUTPUT_H_ */
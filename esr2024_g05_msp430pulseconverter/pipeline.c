@@ -0,0 +1,73 @@
+//***************************************************************************************
+//  Verarbeitungskette pro Abtastwert
+//***************************************************************************************
+
+#include "pipeline.h"
+
+void pipelineInit(Pipeline *pp, uint16_t sampleRateHz, const int16_t *filterCoeffs) {
+    pp->filterCoeffs = filterCoeffs;
+    pp->filtered = 0;
+    biquadReset(&pp->filterState, 0);
+    pulseInit(&pp->pulse, sampleRateHz);
+    signalQualityInit(&pp->quality, sampleRateHz);
+    spectralInit(&pp->spectral, sampleRateHz);
+    brightnessInit(&pp->brightness, sampleRateHz);
+    hrvInit(&pp->hrvShort, HRV_SHORT_WINDOW_S);
+    hrvInit(&pp->hrvLong, HRV_LONG_WINDOW_S);
+}
+
+void pipelineSetRate(Pipeline *pp, uint16_t sampleRateHz) {
+    pulseSetSampleRate(&pp->pulse, sampleRateHz);
+    signalQualityInit(&pp->quality, sampleRateHz);      // Point spacing changed
+    spectralInit(&pp->spectral, sampleRateHz);
+    brightnessInit(&pp->brightness, sampleRateHz);
+}
+
+void pipelineSetFilter(Pipeline *pp, const int16_t *filterCoeffs) {
+    pp->filterCoeffs = filterCoeffs;
+    biquadReset(&pp->filterState, pp->filtered);
+}
+
+uint8_t pipelineStep(Pipeline *pp, uint16_t sample, int16_t thresholdOn, int16_t thresholdOff,
+                     uint8_t qualityMin) {
+    uint8_t events = 0;
+    int16_t filtered;
+
+    filtered = biquadStep(&pp->filterState, pp->filterCoeffs, (int16_t)sample);
+    pp->filtered = filtered;
+    signalQualityPush(&pp->quality, filtered);
+    if (spectralProcess(&pp->spectral, filtered)) {
+        events |= PIPELINE_SPECTRAL;
+    }
+    if (brightnessPush(&pp->brightness, filtered)) {
+        events |= PIPELINE_LEVEL;
+    }
+    // Only candidates ahead of the expected beat can be dropped: one where the beat is due
+    // is the beat, however distorted, and dropping it would stretch the next interval
+    if (pulseProcess(&pp->pulse, filtered, thresholdOn, thresholdOff) &&
+        signalQualityCheckBeat(&pp->quality, pulseBeatDue(&pp->pulse) ? 0 : qualityMin)) {
+        events |= PIPELINE_BEAT;
+        if (pulseAcceptBeat(&pp->pulse)) {
+            events |= PIPELINE_IBI;
+            hrvAddIbi(&pp->hrvShort, pp->pulse.ibiMs);
+            hrvAddIbi(&pp->hrvLong, pp->pulse.ibiMs);
+        } else {
+            hrvBreak(&pp->hrvShort);
+            hrvBreak(&pp->hrvLong);
+        }
+    }
+    return events;
+}
+
+uint16_t pipelineAlarmBpm(const Pipeline *pp) {
+    const PulseDetector *pulse = &pp->pulse;
+
+    if (!pulse->valid) {
+        return pp->spectral.valid ? pp->spectral.bpm : 0;
+    }
+    if (pulse->confidence < PIPELINE_CONFIDENCE_MIN && pp->spectral.valid &&
+        !spectralAgrees(&pp->spectral, pulse->bpm)) {
+        return pp->spectral.bpm;
+    }
+    return pulse->bpm;
+}
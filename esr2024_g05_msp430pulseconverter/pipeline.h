@@ -0,0 +1,60 @@
+//***************************************************************************************
+//  Verarbeitungskette pro Abtastwert
+//
+//  Beschreibung: Fasst Filter, Signalqualitaet, spektrale Schaetzung, Helligkeit,
+//  Schlagerkennung und HRV zu einer Kette zusammen, die jeden Abtastwert in der
+//  Reihenfolge der Firmware verarbeitet. Die Firmware und das Host-Werkzeug
+//  tools/replay.c verwenden denselben Code. Frei von Hardwarezugriffen.
+//***************************************************************************************
+
+#ifndef PIPELINE_H_
+#define PIPELINE_H_
+
+#include <stdint.h>
+#include "biquad.h"
+#include "pulse.h"
+#include "signal_quality.h"
+#include "spectral.h"
+#include "brightness.h"
+#include "hrv.h"
+
+// Events returned by pipelineStep()
+#define PIPELINE_BEAT       0x01    // Beat candidate passed the quality check
+#define PIPELINE_IBI        0x02    // Its interval went into BPM and HRV (pulse.ibiMs)
+#define PIPELINE_LEVEL      0x04    // brightness.level was updated
+#define PIPELINE_SPECTRAL   0x08    // spectral.bpm was updated
+
+#define PIPELINE_CONFIDENCE_MIN 50  // Below this a BPM that disagrees with the spectral
+                                    // estimate gives way to it
+
+typedef struct {
+    BiquadState filterState;
+    const int16_t *filterCoeffs;    // Q14 set for the current sample rate
+    int16_t  filtered;              // Last filter output
+    PulseDetector pulse;
+    SignalQuality quality;
+    SpectralEstimator spectral;     // Cross-check of the BPM in the frequency domain
+    BrightnessTracker brightness;   // LED brightness following the pulse curve
+    HrvWindow hrvShort;
+    HrvWindow hrvLong;
+} Pipeline;
+
+void pipelineInit(Pipeline *pp, uint16_t sampleRateHz, const int16_t *filterCoeffs);
+
+// Restart the rate dependent stages, HRV and the filter delay line are kept
+void pipelineSetRate(Pipeline *pp, uint16_t sampleRateHz);
+
+// Switch to a new coefficient set, the delay line restarts at the current level
+void pipelineSetFilter(Pipeline *pp, const int16_t *filterCoeffs);
+
+// Process one raw sample, returns a combination of the PIPELINE_* events
+uint8_t pipelineStep(Pipeline *pp, uint16_t sample, int16_t thresholdOn, int16_t thresholdOff,
+                     uint8_t qualityMin);
+
+// BPM for the alarm zones, 0 if there is none. The time domain BPM while it is valid,
+// the spectral estimate when it is not, or when both disagree and the last two intervals
+// did too (confidence below PIPELINE_CONFIDENCE_MIN). A regular BPM keeps precedence:
+// on a late dicrotic notch the spectral peak can sit on a harmonic.
+uint16_t pipelineAlarmBpm(const Pipeline *pp);
+
+#endif /* PIPELINE_H_ */
@@ -0,0 +1,59 @@
+//***************************************************************************************
+//  Energiebilanz der Firmware
+//***************************************************************************************
+
+#include <msp430.h>
+#include "power.h"
+#include "output.h"
+
+volatile uint16_t powerAdcConversions;
+
+static EnergyAccount energy;
+static uint16_t mark;                   // RTCCNT at the last booking
+static uint16_t conversionsBooked;
+
+// The RTC counts from zero since _system_pre_init(), with mark still zero the first
+// booking covers the boot. Spans are far below the 2 s wrap.
+void powerInit(void) {
+    energyInit(&energy);
+    mark = 0;
+}
+
+static void book(EnergyMode mode) {
+    uint16_t now = RTCCNT;
+    uint16_t ticks = now - mark;
+    uint16_t conversions = powerAdcConversions;
+
+    mark = now;
+    energyAddOn(&energy, ENERGY_TIMERS, ticks);
+    energyAddOn(&energy, ENERGY_UART, ticks);
+    energyAddDuty(&energy, ENERGY_LED, ticks, outputLedDuty());
+    if (outputToneActive()) {
+        energyAddOn(&energy, ENERGY_PIEZO, ticks);
+    }
+    energyAddEvents(&energy, ENERGY_ADC, conversions - conversionsBooked);
+    conversionsBooked = conversions;
+    energyAddMode(&energy, mode, ticks);
+}
+
+void powerSleep(void) {
+    book(ENERGY_MODE_ACTIVE);
+    __bis_SR_register(LPM0_bits | GIE);
+
+    // Main loop only from here, the interrupts stay enabled
+    book(ENERGY_MODE_LPM0);
+    if (energyFoldDue(&energy)) {
+        energyFold(&energy);
+    }
+}
+
+void powerBusy(void) {
+    book(ENERGY_MODE_ACTIVE);
+    if (energyFoldDue(&energy)) {
+        energyFold(&energy);
+    }
+}
+
+uint8_t powerGetItem(uint8_t item, uint32_t *value) {
+    return energyItem(&energy, item, value);
+}
@@ -0,0 +1,38 @@
+//***************************************************************************************
+//  Energiebilanz der Firmware (Zeitbasis RTC an ACLK, Betriebsarten, Peripherie)
+//
+//  Beschreibung: Der RTC-Zaehler laeuft ab dem Reset mit ACLK (REFO, 32768 Hz) frei durch
+//  (boot.h) und ist die Zeitbasis der Energiebilanz (energy.h). powerSleep() legt die Hauptschleife in LPM0
+//  und bucht die Zeit davor als aktiv, die Zeit bis zum Aufwachen als LPM0. Bei jedem
+//  Wechsel wird die Peripherie mit ihrem Zustand ueber die abgelaufene Spanne gebucht:
+//  Timer und UART laufen immer, die LEDs mit ihrem PWM-Tastgrad, der Piezo solange die
+//  Tonerzeugung laeuft, der ADC mit der Zahl seiner Wandlungen. ISRs, die waehrend des
+//  Schlafs laufen, zaehlen als LPM0; der Anteil der 16-kHz-Ton-ISR steckt im Stromwert
+//  des Piezos. LPM3 und LPM4 nutzt die Firmware nicht, da die Timer SMCLK brauchen.
+//***************************************************************************************
+
+#ifndef POWER_H_
+#define POWER_H_
+
+#include <stdint.h>
+#include "energy.h"
+
+// Incremented by the ADC ISR for every conversion
+extern volatile uint16_t powerAdcConversions;
+
+// Clear the account, the time since reset is booked as active
+void powerInit(void);
+
+// Enter LPM0 with interrupts enabled, call with interrupts disabled. Books the time since
+// the last call as active and the sleep as LPM0, folds the totals about once a second
+// after waking up.
+void powerSleep(void);
+
+// Book the time since the last call as active, for main loop passes that do not sleep.
+// Interrupts enabled.
+void powerBusy(void);
+
+// Telemetry item ENERGY_ITEM_*, returns 0 for an unknown item
+uint8_t powerGetItem(uint8_t item, uint32_t *value);
+
+#endif /* POWER_H_ */
@@ -0,0 +1,22 @@
+//***************************************************************************************
+//  Auswertung der Sensor-FIFO des digitalen Pulssensors
+//***************************************************************************************
+
+#include "ppg_fifo.h"
+
+uint8_t ppgFifoCount(const uint8_t *burst, uint8_t *lost) {
+    uint8_t wrPtr = burst[PPG_REG_FIFO_WR_PTR] & (PPG_FIFO_DEPTH - 1);
+    uint8_t rdPtr = burst[PPG_REG_FIFO_RD_PTR] & (PPG_FIFO_DEPTH - 1);
+    uint8_t count = (wrPtr - rdPtr) & (PPG_FIFO_DEPTH - 1);
+
+    *lost = burst[PPG_REG_OVF_COUNTER] & (PPG_FIFO_DEPTH - 1);
+    if (*lost != 0) {
+        // The FIFO wrapped (rollover), it is full and the oldest samples are gone
+        return PPG_FIFO_DEPTH;
+    }
+    if (count == 0 && (burst[PPG_REG_INT_STATUS1] & PPG_INT_A_FULL)) {
+        // Equal pointers with the almost full flag set: exactly full, nothing lost yet
+        return PPG_FIFO_DEPTH;
+    }
+    return count;
+}
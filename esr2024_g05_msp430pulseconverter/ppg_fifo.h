@@ -0,0 +1,31 @@
+//***************************************************************************************
+//  Auswertung der Sensor-FIFO des digitalen Pulssensors (ppg_sensor.h)
+//
+//  Beschreibung: ppgFifoCount() bestimmt aus dem Burst INT_STATUS1..FIFO_RD_PTR, wie
+//  viele Samples in der FIFO warten. Sind Schreib- und Lesezeiger gleich, ist die FIFO
+//  leer oder genau voll; unterschieden wird das am A_FULL-Bit aus demselben Burst bzw.
+//  am Overflow-Zaehler, der verlorene Samples zaehlt (die FIFO laeuft dann ueber,
+//  rollover). ppgFifoSample() skaliert ein 18-Bit-Sample auf 12 Bit. Frei von
+//  Hardwarezugriffen.
+//***************************************************************************************
+
+#ifndef PPG_FIFO_H_
+#define PPG_FIFO_H_
+
+#include <stdint.h>
+#include "ppg_sensor.h"
+
+// Burst from INT_STATUS1 up to FIFO_RD_PTR, reading INT_STATUS1 releases INT
+#define PPG_POINTER_BURST       (PPG_REG_FIFO_RD_PTR - PPG_REG_INT_STATUS1 + 1)
+
+// Samples waiting in the FIFO, 0..PPG_FIFO_DEPTH. '*lost' gets the samples the sensor
+// dropped since the last read.
+uint8_t ppgFifoCount(const uint8_t *burst, uint8_t *lost);
+
+static inline uint16_t ppgFifoSample(const uint8_t *p) {
+    uint32_t raw = ((uint32_t)(p[0] & 0x03) << 16) | ((uint16_t)p[1] << 8) | p[2];
+
+    return (uint16_t)(raw >> 6);
+}
+
+#endif /* PPG_FIFO_H_ */
@@ -0,0 +1,219 @@
+//***************************************************************************************
+//  Treiber fuer einen digitalen optischen Pulssensor am I2C-Bus
+//***************************************************************************************
+
+#include <msp430.h>
+#include "i2c_async.h"
+#include "ppg_fifo.h"
+#include "sample_queue.h"
+#include "trace.h"
+
+#define INT_PIN             BIT1    // P2.1, open drain from the sensor
+
+typedef enum {
+    STATE_IDLE,
+    STATE_CONFIG,                   // Register setup queued
+    STATE_READING                   // Pointer or FIFO read queued
+} SensorState;
+
+// Register setup, register address followed by the value
+static const uint8_t configTable[][2] = {
+    { PPG_REG_FIFO_WR_PTR, 0x00 },
+    { PPG_REG_OVF_COUNTER, 0x00 },
+    { PPG_REG_FIFO_RD_PTR, 0x00 },
+    { PPG_REG_FIFO_CONFIG, 0x7F },  // 8x averaging, rollover on, INT at 17 samples
+    { PPG_REG_MODE_CONFIG, 0x02 },  // Heart rate mode, LED1 only
+    { PPG_REG_SPO2_CONFIG, 0x35 },  // 4096 nA range, 1000 Hz, 118 us pulses
+    { PPG_REG_LED1_PA,     0x24 },  // ~7 mA
+    { PPG_REG_INT_ENABLE1, PPG_INT_A_FULL }
+};
+#define CONFIG_ENTRIES      (sizeof(configTable) / sizeof(configTable[0]))
+
+static const uint8_t pointerRegister = PPG_REG_INT_STATUS1;
+static const uint8_t fifoRegister = PPG_REG_FIFO_DATA;
+
+static volatile SensorState state;
+static volatile uint8_t enabled;
+static uint8_t configFailed;
+
+static I2cTransaction configXfer[CONFIG_ENTRIES];
+static I2cTransaction pointerXfer;
+static I2cTransaction fifoXfer;
+
+// Filled by the I2C reads before they are parsed, not cleared by cinit
+#pragma NOINIT(pointerBuffer)
+static uint8_t pointerBuffer[PPG_POINTER_BURST];
+#pragma NOINIT(fifoBuffer)
+static uint8_t fifoBuffer[PPG_FIFO_DEPTH * PPG_BYTES_PER_SAMPLE];
+
+static volatile uint16_t samplesDelivered;
+static volatile uint16_t fifoOverflows;
+static volatile uint16_t busErrors;
+
+static uint8_t pointersRead(I2cTransaction *xfer);
+static uint8_t fifoRead(I2cTransaction *xfer);
+static uint8_t configWritten(I2cTransaction *xfer);
+
+static void setupTransaction(I2cTransaction *xfer, const uint8_t *reg, uint8_t writeLength,
+                             uint8_t *rx, I2cCallback callback) {
+    xfer->address = PPG_SENSOR_ADDRESS;
+    xfer->flags = 0;
+    xfer->writeData = reg;
+    xfer->writeLength = writeLength;
+    xfer->readData = rx;
+    xfer->readLength = 0;
+    xfer->callback = callback;
+}
+
+static void startPointerRead(void) {
+    state = STATE_READING;
+    if (!i2cAsyncSubmit(&pointerXfer)) {
+        state = STATE_IDLE;
+    }
+}
+
+// Read the next burst if INT is still asserted, otherwise wait for the next edge
+static void nextOrIdle(void) {
+    if (enabled && !(P2IN & INT_PIN)) {
+        startPointerRead();
+    } else {
+        state = STATE_IDLE;
+    }
+}
+
+// Convert the FIFO burst to 12 bit samples, returns non-zero if samples were queued
+static uint8_t deliverSamples(uint8_t count) {
+    const uint8_t *p = fifoBuffer;
+    uint8_t i;
+
+    for (i = 0; i < count; i++) {
+        sampleQueuePush(ppgFifoSample(p));
+        p += PPG_BYTES_PER_SAMPLE;
+    }
+    samplesDelivered += count;
+    return count != 0;
+}
+
+// The setup writes run back to back with repeated starts. A sensor that does not answer
+// during setup is given up.
+static uint8_t configWritten(I2cTransaction *xfer) {
+    if (xfer->status != I2C_XFER_OK) {
+        busErrors++;
+        configFailed = 1;
+    }
+    if (xfer == &configXfer[CONFIG_ENTRIES - 1]) {
+        if (configFailed) {
+            state = STATE_IDLE;
+        } else {
+            // Sensor is set up, from now on INT drives the reading
+            P2IFG &= ~INT_PIN;
+            P2IE |= INT_PIN;
+            nextOrIdle();
+        }
+    }
+    return 0;
+}
+
+static uint8_t pointersRead(I2cTransaction *xfer) {
+    uint8_t lost, count;
+
+    if (xfer->status != I2C_XFER_OK) {
+        // Retried as long as INT stays asserted
+        busErrors++;
+        nextOrIdle();
+        return 0;
+    }
+
+    count = ppgFifoCount(pointerBuffer, &lost);
+    fifoOverflows += lost;
+    if (count == 0) {
+        nextOrIdle();
+        return 0;
+    }
+    // FIFO_DATA does not auto-increment, the whole FIFO comes in one burst
+    fifoXfer.readLength = count * PPG_BYTES_PER_SAMPLE;
+    if (!i2cAsyncSubmit(&fifoXfer)) {
+        nextOrIdle();
+    }
+    return 0;
+}
+
+static uint8_t fifoRead(I2cTransaction *xfer) {
+    if (xfer->status != I2C_XFER_OK) {
+        busErrors++;
+        nextOrIdle();
+        return 0;
+    }
+    nextOrIdle();
+    return deliverSamples(xfer->readLength / PPG_BYTES_PER_SAMPLE);
+}
+
+void ppgSensorInit(void) {
+    uint8_t i;
+
+    for (i = 0; i < CONFIG_ENTRIES; i++) {
+        setupTransaction(&configXfer[i], configTable[i], 2, 0, configWritten);
+        configXfer[i].flags = I2C_FLAG_REPEATED_START;
+    }
+    configXfer[CONFIG_ENTRIES - 1].flags = 0;
+
+    setupTransaction(&pointerXfer, &pointerRegister, 1, pointerBuffer, pointersRead);
+    pointerXfer.readLength = PPG_POINTER_BURST;
+    setupTransaction(&fifoXfer, &fifoRegister, 1, fifoBuffer, fifoRead);
+
+    // INT input (P2.1) with pull-up, falling edge
+    P2DIR &= ~INT_PIN;
+    P2REN |= INT_PIN;
+    P2OUT |= INT_PIN;
+    P2IES |= INT_PIN;
+    P2IE &= ~INT_PIN;
+}
+
+void ppgSensorStart(void) {
+    // P1.2 UCB0SDA, P1.3 UCB0SCL (primary function)
+    P1SEL1 &= ~(BIT2 | BIT3);
+    P1SEL0 |= BIT2 | BIT3;
+
+    enabled = 1;
+    if (state == STATE_IDLE) {
+        uint8_t i;
+
+        state = STATE_CONFIG;
+        configFailed = 0;
+        for (i = 0; i < CONFIG_ENTRIES; i++) {
+            i2cAsyncSubmit(&configXfer[i]);
+        }
+    }
+}
+
+void ppgSensorStop(void) {
+    enabled = 0;
+    P2IE &= ~INT_PIN;
+}
+
+void ppgSensorGetStatus(uint16_t *samples, uint16_t *overflows, uint16_t *errors) {
+    unsigned short interruptState = __get_interrupt_state();
+
+    __disable_interrupt();
+    *samples = samplesDelivered;
+    *overflows = fifoOverflows;
+    *errors = busErrors;
+    __set_interrupt_state(interruptState);
+}
+
+#pragma vector=PORT2_VECTOR
+__interrupt void PORT2_ISR(void) {
+    TRACE_ISR_BEGIN(TRACE_ISR_SENSOR);
+    switch (__even_in_range(P2IV, P2IV_P2IFG7)) {
+    case P2IV_P2IFG1:
+        // Data ready: start the burst unless a transfer is still running, in that case
+        // nextOrIdle() sees INT still low when it completes
+        if (enabled && state == STATE_IDLE) {
+            startPointerRead();
+        }
+        break;
+    default:
+        break;
+    }
+    TRACE_ISR_END(TRACE_ISR_SENSOR);
+}
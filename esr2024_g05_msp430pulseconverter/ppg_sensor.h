@@ -0,0 +1,55 @@
+//***************************************************************************************
+//  Treiber fuer einen digitalen optischen Pulssensor am I2C-Bus, eUSCI_B0
+//  (P1.2 SDA / P1.3 SCL, Data-Ready/INT an P2.1, aktiv low)
+//
+//  Beschreibung: Ersetzt bei Geraeten mit digitalem Sensor den Analogeingang an P1.2.
+//  Die Registerbelegung entspricht der verbreiteten MAX3010x-Familie (32 Eintraege tiefe
+//  FIFO mit Schreib-/Lesezeiger und Overflow-Zaehler, 3 Byte pro Sample).
+//  Der Treiber arbeitet vollstaendig in den Interrupts ueber die asynchronen I2C-Transaktionen
+//  (i2c_async): Die fallende Flanke an INT startet einen Burst-Lesezugriff auf die
+//  Statusregister und Zeiger, im Callback wird der gesamte FIFO-Inhalt in einer einzigen
+//  Transaktion angefordert. Die Samples werden auf 12 Bit skaliert und in die
+//  Sample-Warteschlange gelegt, wie die ADC-Werte.
+//***************************************************************************************
+
+#ifndef PPG_SENSOR_H_
+#define PPG_SENSOR_H_
+
+#include <stdint.h>
+
+#define PPG_SENSOR_ADDRESS      0x57
+#define PPG_SENSOR_RATE_HZ      125     // 1000 Hz internal rate, averaged over 8 samples
+#define PPG_I2C_RATE_HZ         400000UL
+
+#define PPG_FIFO_DEPTH          32
+#define PPG_BYTES_PER_SAMPLE    3       // One LED channel, 18 bit left aligned
+
+// Sensor registers
+#define PPG_REG_INT_STATUS1     0x00
+#define PPG_REG_INT_ENABLE1     0x02
+#define PPG_REG_FIFO_WR_PTR     0x04
+#define PPG_REG_OVF_COUNTER     0x05
+#define PPG_REG_FIFO_RD_PTR     0x06
+#define PPG_REG_FIFO_DATA       0x07
+#define PPG_REG_FIFO_CONFIG     0x08
+#define PPG_REG_MODE_CONFIG     0x09
+#define PPG_REG_SPO2_CONFIG     0x0A
+#define PPG_REG_LED1_PA         0x0C
+
+#define PPG_INT_A_FULL          0x80    // INT_STATUS1 / INT_ENABLE1: FIFO almost full
+
+// Prepare the transactions and the INT input, the sensor is not touched yet.
+// i2cAsyncInit() must have been called.
+void ppgSensorInit(void);
+
+// Switch P1.2/P1.3 to I2C, program the sensor and start interrupt driven reading.
+// Needs interrupts enabled, returns immediately.
+void ppgSensorStart(void);
+
+// Stop reading after the current transfer, P1.2/P1.3 are left to the caller
+void ppgSensorStop(void);
+
+// Samples delivered, samples lost in the sensor FIFO, and bus errors (NACK)
+void ppgSensorGetStatus(uint16_t *samples, uint16_t *fifoOverflows, uint16_t *busErrors);
+
+#endif /* PPG_SENSOR_H_ */
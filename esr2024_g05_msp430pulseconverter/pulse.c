@@ -0,0 +1,127 @@
+//***************************************************************************************
+//  Schlagerkennung und Pulsberechnung
+//***************************************************************************************
+
+#include "pulse.h"
+
+void pulseInit(PulseDetector *p, uint16_t sampleRateHz) {
+    p->sampleRateHz = sampleRateHz;
+    p->sampleCount = 0;
+    p->lastBeatSample = 0;
+    p->armed = 0;
+    p->lastValue = 0;
+    p->rise = 0;
+    p->valid = 0;
+    p->ibiMs = 0;
+    p->bpm = 0;
+    p->confidence = 0;
+    p->beatCount = 0;
+    p->outliers = 0;
+    medianInit(&p->ibiWindow);
+}
+
+void pulseSetSampleRate(PulseDetector *p, uint16_t sampleRateHz) {
+    // Sample counts taken at the old rate cannot be converted, start a new interval
+    p->sampleRateHz = sampleRateHz;
+    p->sampleCount = 0;
+    p->lastBeatSample = 0;
+    p->rise = 0;                // Per sample, so it scales with the rate
+    p->valid = 0;
+}
+
+static uint16_t samplesToMs(const PulseDetector *p, uint32_t samples) {
+    uint32_t ms = (samples * 1000UL) / p->sampleRateHz;
+    return (ms > 0xFFFF) ? 0xFFFF : (uint16_t)ms;
+}
+
+uint8_t pulseProcess(PulseDetector *p, int16_t value, int16_t thresholdOn, int16_t thresholdOff) {
+    int16_t rise = value - p->lastValue;
+
+    p->sampleCount++;
+    p->lastValue = value;
+
+    if (value < thresholdOff) {
+        p->armed = 1;
+    }
+
+    if (!p->armed || value < thresholdOn) {
+        // Drop the BPM once the pulse has been missing for too long
+        if (p->valid && samplesToMs(p, p->sampleCount - p->lastBeatSample) > PULSE_TIMEOUT_MS) {
+            p->valid = 0;
+            p->bpm = 0;
+            p->confidence = 0;
+        }
+        return 0;
+    }
+
+    // Rising edge through the on-threshold. A much slower rise than the recent beats is
+    // the diastolic wave after a late notch, which crosses the threshold as well.
+    p->armed = 0;
+    if (p->rise != 0 && (int32_t)rise * 100 < (int32_t)p->rise * PULSE_RISE_PERCENT) {
+        if (samplesToMs(p, p->sampleCount - p->lastBeatSample) <= PULSE_TIMEOUT_MS) {
+            return 0;
+        }
+        p->rise = 0;            // No beat for too long: the signal changed, learn it anew
+    }
+    // Average over ~4 beats, an artifact moves it by at most a quarter
+    if (p->rise == 0) {
+        p->rise = (rise > 0) ? rise : 1;
+    } else {
+        if (rise > 2 * p->rise) {
+            rise = 2 * p->rise;
+        }
+        p->rise += (rise - p->rise) / 4;
+    }
+    return 1;
+}
+
+uint8_t pulseAcceptBeat(PulseDetector *p) {
+    uint16_t ibi;
+    uint16_t diff;
+    uint16_t penalty;
+    uint16_t median;
+    uint8_t firstBeat;
+
+    p->beatCount++;
+    firstBeat = (p->lastBeatSample == 0);
+    ibi = samplesToMs(p, p->sampleCount - p->lastBeatSample);
+    p->lastBeatSample = p->sampleCount;
+
+    if (firstBeat || ibi < PULSE_IBI_MIN_MS || ibi > PULSE_IBI_MAX_MS) {
+        p->valid = 0;
+        p->confidence = 0;
+        return 0;
+    }
+
+    // Every plausible interval enters the window so the median follows real changes,
+    // but one far off the recent ones does not move the BPM
+    median = medianGet(&p->ibiWindow);
+    medianAdd(&p->ibiWindow, ibi);
+    if (p->ibiWindow.count > PULSE_MEDIAN_MIN_COUNT) {
+        diff = (ibi > median) ? ibi - median : median - ibi;
+        if ((uint32_t)diff * 100 > (uint32_t)median * PULSE_OUTLIER_PERCENT) {
+            p->outliers++;
+            return 0;
+        }
+    }
+
+    // Confidence drops by 2 points per percent of IBI change
+    if (p->ibiMs != 0) {
+        diff = (ibi > p->ibiMs) ? ibi - p->ibiMs : p->ibiMs - ibi;
+        penalty = (uint16_t)(((uint32_t)diff * 200) / p->ibiMs);
+        p->confidence = (penalty >= 100) ? 0 : (uint8_t)(100 - penalty);
+    }
+
+    p->ibiMs = ibi;
+    p->bpm = (uint16_t)((60000UL + ibi / 2) / ibi);
+    p->valid = 1;
+    return 1;
+}
+
+uint8_t pulseBeatDue(const PulseDetector *p) {
+    if (!p->valid) {
+        return 0;
+    }
+    return (uint32_t)samplesToMs(p, p->sampleCount - p->lastBeatSample) * 100 >=
+           (uint32_t)p->ibiMs * PULSE_DUE_PERCENT;
+}
@@ -0,0 +1,69 @@
+//***************************************************************************************
+//  Schlagerkennung und Pulsberechnung
+//
+//  Beschreibung: Erkennt Herzschlaege als steigende Flanke des gefilterten Signals ueber
+//  die Einschaltschwelle (mit Hysterese ueber die Ausschaltschwelle) und berechnet daraus
+//  Schlagabstand (IBI), Puls (BPM) und eine einfache Konfidenz. Steigt das Signal an der
+//  Schwelle deutlich langsamer als bei den letzten Schlaegen, ist es die diastolische
+//  Welle hinter einer spaeten Kerbe und kein neuer Schlag; nach PULSE_TIMEOUT_MS ohne
+//  Schlag wird der Anstieg neu gelernt. Erkannte Schlaege zaehlen
+//  erst nach pulseAcceptBeat(), davor kann die Signalqualitaet sie verwerfen. Abstaende,
+//  die mehr als PULSE_OUTLIER_PERCENT vom gleitenden Median der letzten Abstaende
+//  abweichen (verpasster oder doppelt gezaehlter Schlag), gehen nicht in den Puls ein.
+//  Das Modul ist frei von Hardwarezugriffen und kann auch auf dem Host uebersetzt werden.
+//***************************************************************************************
+
+#ifndef PULSE_H_
+#define PULSE_H_
+
+#include <stdint.h>
+#include "median.h"
+
+#define PULSE_IBI_MIN_MS        250     // 240 BPM
+#define PULSE_IBI_MAX_MS        2000    // 30 BPM
+#define PULSE_TIMEOUT_MS        3000    // No beat for this long: signal lost
+#define PULSE_OUTLIER_PERCENT   25      // IBIs further off the median are outliers
+#define PULSE_MEDIAN_MIN_COUNT  5       // IBIs needed before outliers are rejected
+#define PULSE_RISE_PERCENT      60      // Candidates rising slower than this share of the
+                                        // recent beats are a second wave of the same beat
+#define PULSE_DUE_PERCENT       85      // Share of the last IBI after which a beat is due
+
+#if MEDIAN_WINDOW <= PULSE_MEDIAN_MIN_COUNT
+#error "MEDIAN_WINDOW must exceed PULSE_MEDIAN_MIN_COUNT, or outliers are never rejected"
+#endif
+
+typedef struct {
+    uint16_t sampleRateHz;
+    uint32_t sampleCount;       // Samples processed since pulseInit()
+    uint32_t lastBeatSample;    // sampleCount at the last detected beat
+    uint8_t  armed;             // Signal fell below the off-threshold since the last beat
+    int16_t  lastValue;
+    int16_t  rise;              // Average rise per sample at the on-threshold, 0 if none yet
+    uint8_t  valid;             // BPM is based on a recent, plausible IBI
+    uint16_t ibiMs;             // Last inter-beat interval
+    uint16_t bpm;               // Beats per minute from the last IBI
+    uint8_t  confidence;        // 0..100, agreement of the last two IBIs
+    uint16_t beatCount;         // Number of detected beats (wraps)
+    uint16_t outliers;          // IBIs rejected against the median (wraps)
+    MedianWindow ibiWindow;     // Recent plausible IBIs, outliers included
+} PulseDetector;
+
+void pulseInit(PulseDetector *p, uint16_t sampleRateHz);
+
+// Change the sample rate, the running interval measurement is restarted
+void pulseSetSampleRate(PulseDetector *p, uint16_t sampleRateHz);
+
+// Process one filtered sample, returns 1 if a beat candidate was detected
+uint8_t pulseProcess(PulseDetector *p, int16_t value, int16_t thresholdOn, int16_t thresholdOff);
+
+// Count the candidate as a beat and update IBI, BPM and confidence. Rejected candidates
+// are simply not passed on, the next interval then starts at the last accepted beat.
+// Returns 1 if the interval was used, 0 if it was implausible or an outlier against the
+// median of the recent intervals (missed or doubled beat).
+uint8_t pulseAcceptBeat(PulseDetector *p);
+
+// Returns 1 if PULSE_DUE_PERCENT of the last IBI have passed since the last accepted
+// beat, a candidate now is where the next beat is expected. 0 without a valid BPM.
+uint8_t pulseBeatDue(const PulseDetector *p);
+
+#endif /* PULSE_H_ */
@@ -0,0 +1,44 @@
+//***************************************************************************************
+//  Sample-Warteschlange zwischen Erfassung (ISR) und Verarbeitung (Hauptschleife)
+//***************************************************************************************
+
+#include "sample_queue.h"
+
+#define SAMPLE_QUEUE_MASK   (SAMPLE_QUEUE_SIZE - 1)
+
+#pragma NOINIT(queue)
+static uint16_t queue[SAMPLE_QUEUE_SIZE];   // Only read behind head, not cleared by cinit
+static volatile uint8_t head;           // Written by the producer only (free running)
+static volatile uint8_t tail;           // Written by the consumer only (free running)
+static volatile uint16_t overflows;
+
+uint8_t sampleQueuePush(uint16_t sample) {
+    if ((uint8_t)(head - tail) >= SAMPLE_QUEUE_SIZE) {
+        overflows++;
+        return 0;
+    }
+    queue[head & SAMPLE_QUEUE_MASK] = sample;
+    head++;
+    return 1;
+}
+
+uint8_t sampleQueuePop(uint16_t *sample) {
+    if (head == tail) {
+        return 0;
+    }
+    *sample = queue[tail & SAMPLE_QUEUE_MASK];
+    tail++;
+    return 1;
+}
+
+uint8_t sampleQueueEmpty(void) {
+    return head == tail;
+}
+
+void sampleQueueClear(void) {
+    tail = head;
+}
+
+uint16_t sampleQueueOverflows(void) {
+    return overflows;
+}
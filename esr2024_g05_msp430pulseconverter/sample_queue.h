@@ -0,0 +1,29 @@
+//***************************************************************************************
+//  Sample-Warteschlange zwischen Erfassung (ISR) und Verarbeitung (Hauptschleife)
+//
+//  Beschreibung: Ringpuffer mit einem Schreiber (ADC- bzw. Sensor-ISR) und einem Leser
+//  (Hauptschleife). Beide Signalquellen speisen ueber diese Warteschlange dieselbe
+//  Verarbeitungskette.
+//***************************************************************************************
+
+#ifndef SAMPLE_QUEUE_H_
+#define SAMPLE_QUEUE_H_
+
+#include <stdint.h>
+
+#define SAMPLE_QUEUE_SIZE   64      // Power of two, holds a full sensor FIFO burst
+
+// Append a sample, ISR context. Returns 0 and counts an overflow if the queue is full
+uint8_t sampleQueuePush(uint16_t sample);
+
+// Take the oldest sample, main loop. Returns 0 if the queue is empty
+uint8_t sampleQueuePop(uint16_t *sample);
+
+uint8_t sampleQueueEmpty(void);
+
+// Drop all queued samples, e.g. after the signal source changed
+void sampleQueueClear(void);
+
+uint16_t sampleQueueOverflows(void);
+
+#endif /* SAMPLE_QUEUE_H_ */
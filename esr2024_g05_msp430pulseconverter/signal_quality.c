@@ -0,0 +1,197 @@
+//***************************************************************************************
+//  Signalqualitaet pro Schlag und Unterdrueckung von Bewegungsartefakten
+//***************************************************************************************
+
+#include "signal_quality.h"
+
+#define SEGMENT_MASK        (QUALITY_SEGMENT_POINTS - 1)
+#define TEMPLATE_SHIFT      3       // Template follows accepted beats with weight 1/8
+#define AMPLITUDE_SHIFT     3
+
+static uint16_t isqrt32(uint32_t x) {
+    uint32_t root = 0;
+    uint32_t bit = 1UL << 30;
+
+    while (bit > x) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (x >= root + bit) {
+            x -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint16_t)root;
+}
+
+// Normalised cross correlation of two mean free segments as 0..100, negative is 0
+static uint8_t correlation(const int16_t *x, const int16_t *y) {
+    int32_t sxy = 0, sxx = 0, syy = 0;
+    uint64_t r2;
+    uint8_t i;
+
+    for (i = 0; i < QUALITY_SEGMENT_POINTS; i++) {
+        sxy += (int32_t)x[i] * y[i];
+        sxx += (int32_t)x[i] * x[i];
+        syy += (int32_t)y[i] * y[i];
+    }
+
+    // corr^2 * 10000, the sums are scaled down so the products fit 64 bit
+    sxy >>= 8;
+    sxx >>= 8;
+    syy >>= 8;
+    if (sxy <= 0 || sxx <= 0 || syy <= 0) {
+        return 0;
+    }
+    r2 = ((uint64_t)((int64_t)sxy * sxy) * 10000) / ((uint64_t)sxx * syy);
+    return (r2 >= 10000) ? 100 : (uint8_t)isqrt32((uint32_t)r2);
+}
+
+// Amplitude score: 100 at the reference, 0 at half or double of it
+static uint8_t amplitudeScore(uint16_t amplitude, uint16_t reference) {
+    uint32_t penalty;
+
+    if (reference == 0) {
+        return 0;
+    }
+    if (amplitude >= reference) {
+        penalty = ((uint32_t)(amplitude - reference) * 100) / reference;
+    } else {
+        penalty = ((uint32_t)(reference - amplitude) * 200) / reference;
+    }
+    return (penalty >= 100) ? 0 : (uint8_t)(100 - penalty);
+}
+
+void signalQualityInit(SignalQuality *q, uint16_t sampleRateHz) {
+    uint8_t i;
+
+    for (i = 0; i < QUALITY_SEGMENT_POINTS; i++) {
+        q->segment[i] = 0;
+        q->template[i] = 0;
+        q->candidate[i] = 0;
+    }
+    q->latest = 0;
+    q->cycleMax = INT16_MIN;
+    q->cycleMin = INT16_MAX;
+    q->head = 0;
+    q->filled = 0;
+    q->step = (sampleRateHz > QUALITY_POINT_RATE_HZ) ? (uint8_t)(sampleRateHz / QUALITY_POINT_RATE_HZ) : 1;
+    q->stepCount = q->step;
+    q->candidateRun = 0;
+    q->candidateAmplitude = 0;
+    q->meanAmplitude = 0;
+    q->quality = 0;
+    q->rejected = 0;
+}
+
+void signalQualityPush(SignalQuality *q, int16_t value) {
+    q->latest = value;
+    if (value > q->cycleMax) {
+        q->cycleMax = value;
+    }
+    if (value < q->cycleMin) {
+        q->cycleMin = value;
+    }
+    if (--q->stepCount != 0) {
+        return;
+    }
+    q->stepCount = q->step;
+    q->segment[q->head & SEGMENT_MASK] = value;
+    q->head++;
+    if (q->filled < QUALITY_SEGMENT_POINTS) {
+        q->filled++;
+    }
+}
+
+// A rejected (or not yet judged) beat that looks like the previous one extends the
+// candidate run. A long enough run means the waveform changed for good (new finger
+// position, start up) and the candidate becomes the template. Irregular artifacts never
+// get there.
+static void trackCandidate(SignalQuality *q, const int16_t *seg, uint16_t amplitude) {
+    uint8_t i;
+
+    if (correlation(seg, q->candidate) >= QUALITY_ADOPT_CORRELATION &&
+        amplitudeScore(amplitude, q->candidateAmplitude) >= QUALITY_ADOPT_AMPLITUDE) {
+        q->candidateRun++;
+    } else {
+        q->candidateRun = 0;
+    }
+    for (i = 0; i < QUALITY_SEGMENT_POINTS; i++) {
+        q->candidate[i] = seg[i];
+    }
+    q->candidateAmplitude = amplitude;
+
+    if (q->candidateRun >= QUALITY_ADOPT_BEATS) {
+        for (i = 0; i < QUALITY_SEGMENT_POINTS; i++) {
+            q->template[i] = seg[i];
+        }
+        q->meanAmplitude = amplitude;
+        q->candidateRun = 0;
+    }
+}
+
+uint8_t signalQualityCheckBeat(SignalQuality *q, uint8_t minQuality) {
+    int16_t *seg = q->work;
+    int32_t sum = 0;
+    int16_t mean;
+    uint16_t amplitude;
+    uint16_t weight;
+    uint8_t i;
+
+    // Peak to peak over the last cycle: from the previous candidate, just before its peak,
+    // to this one, just after its foot. Where on the upstroke the threshold is crossed does
+    // not enter, so baseline wander moving the foot against the threshold does not either.
+    amplitude = (q->cycleMax > q->cycleMin) ? (uint16_t)(q->cycleMax - q->cycleMin) : 0;
+    q->cycleMax = q->latest;
+    q->cycleMin = q->latest;
+
+    if (q->filled < QUALITY_SEGMENT_POINTS) {
+        // Segment still contains the start up state, nothing to judge
+        q->quality = 0;
+        return 1;
+    }
+
+    // Oldest point first, ending with the sample of the beat itself. The last stored point
+    // may be up to a step older, on the steep upstroke that would make the shape jump from
+    // beat to beat.
+    for (i = 0; i < QUALITY_SEGMENT_POINTS; i++) {
+        seg[i] = (i < QUALITY_SEGMENT_POINTS - 1) ?
+                 q->segment[(q->head + i + 1) & SEGMENT_MASK] : q->latest;
+        sum += seg[i];
+    }
+    mean = (int16_t)(sum / QUALITY_SEGMENT_POINTS);
+    for (i = 0; i < QUALITY_SEGMENT_POINTS; i++) {
+        seg[i] -= mean;
+    }
+
+    // Without a template nothing can be judged either, the beats pass until a run of
+    // similar ones has formed it
+    if (q->meanAmplitude == 0) {
+        q->quality = 0;
+        trackCandidate(q, seg, amplitude);
+        return 1;
+    }
+
+    // An artifact on top of the previous beat distorts the amplitude of this one as well,
+    // so the amplitude only takes QUALITY_AMPLITUDE_WEIGHT % of the score
+    weight = amplitudeScore(amplitude, q->meanAmplitude);
+    weight = (100 - QUALITY_AMPLITUDE_WEIGHT) + weight * QUALITY_AMPLITUDE_WEIGHT / 100;
+    q->quality = (uint8_t)((weight * correlation(seg, q->template) + 50) / 100);
+
+    if (q->quality < minQuality) {
+        q->rejected++;
+        trackCandidate(q, seg, amplitude);
+        return 0;
+    }
+
+    q->candidateRun = 0;
+    for (i = 0; i < QUALITY_SEGMENT_POINTS; i++) {
+        q->template[i] += (seg[i] - q->template[i]) >> TEMPLATE_SHIFT;
+    }
+    q->meanAmplitude = (uint16_t)((int16_t)q->meanAmplitude +
+                       (((int16_t)amplitude - (int16_t)q->meanAmplitude) >> AMPLITUDE_SHIFT));
+    return 1;
+}
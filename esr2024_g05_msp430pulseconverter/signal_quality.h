@@ -0,0 +1,66 @@
+//***************************************************************************************
+//  Signalqualitaet pro Schlag und Unterdrueckung von Bewegungsartefakten
+//
+//  Beschreibung: Haelt die letzten QUALITY_SEGMENT_POINTS Werte des gefilterten Signals
+//  (auf ca. 50 Hz ausgeduennt) vor, der letzte Punkt ist immer der aktuelle Wert, damit
+//  der Ausschnitt genau am Schlag endet. Bei jedem erkannten Schlag wird dieser Ausschnitt
+//  mit einer laufend gemittelten Schlagvorlage verglichen:
+//    - Amplitudenkonsistenz: Spitze-Spitze-Wert seit dem letzten Kandidaten (Spitze des
+//      vorigen Schlags bis Fuss dieses Schlags) gegenueber dem gleitenden Mittel. Wo die
+//      Schwelle die Flanke schneidet, geht nicht ein, Grundlinienschwankung kaum.
+//    - Formkorrelation: normierte Kreuzkorrelation mit der Vorlage
+//  Die Formkorrelation, zu QUALITY_AMPLITUDE_WEIGHT % mit der Amplitude gewichtet, ergibt
+//  die Qualitaet 0..100. Schlaege unter der Schwelle (PARAM_QUALITY_MIN) werden verworfen,
+//  bevor sie Puls und Alarm erreichen; pipeline.c legt die Schwelle nur an Kandidaten vor
+//  dem erwarteten Schlag an. Solange der Ausschnitt noch den Startzustand enthaelt oder
+//  keine Vorlage besteht, gibt es nichts zu beurteilen und jeder Schlag passiert. Folgen
+//  mehrere Schlaege gleicher Form aufeinander, die nicht zur Vorlage passen (Start, neue
+//  Fingerposition), werden sie zur neuen Vorlage; unregelmaessige Artefakte erreichen das
+//  nicht. Der Aufwand pro Schlag ist fest (QUALITY_SEGMENT_POINTS Punkte). Frei von
+//  Hardwarezugriffen.
+//***************************************************************************************
+
+#ifndef SIGNAL_QUALITY_H_
+#define SIGNAL_QUALITY_H_
+
+#include <stdint.h>
+
+#define QUALITY_SEGMENT_POINTS  32      // Power of two
+#define QUALITY_POINT_RATE_HZ   50      // Approximate rate of the stored points
+#define QUALITY_AMPLITUDE_WEIGHT 50     // Share of the score set by the amplitude, %
+#define QUALITY_ADOPT_BEATS     6       // Consecutive similar rejected beats that replace
+                                        // the template (also builds it after start up)
+#define QUALITY_ADOPT_CORRELATION 80    // Shape similarity of two beats for the run above
+#define QUALITY_ADOPT_AMPLITUDE 60      // Amplitude score of two beats for the run, lower
+                                        // than the shape: wander changes the swing by
+                                        // 10..20 % from beat to beat
+
+typedef struct {
+    int16_t  segment[QUALITY_SEGMENT_POINTS];   // Ring of recent points
+    int16_t  template[QUALITY_SEGMENT_POINTS];  // Mean removed beat shape
+    int16_t  candidate[QUALITY_SEGMENT_POINTS]; // Last rejected beat, mean removed
+    int16_t  work[QUALITY_SEGMENT_POINTS];      // Current beat, kept off the small stack
+    int16_t  latest;                // Newest sample, closes the segment at the beat
+    int16_t  cycleMax;              // Range of the samples since the last beat candidate
+    int16_t  cycleMin;
+    uint8_t  head;                  // Next write position (free running)
+    uint8_t  filled;                // Points stored so far, up to QUALITY_SEGMENT_POINTS
+    uint8_t  step;                  // Samples per stored point
+    uint8_t  stepCount;
+    uint8_t  candidateRun;          // Consecutive rejected beats resembling each other
+    uint16_t candidateAmplitude;
+    uint16_t meanAmplitude;         // Running peak to peak amplitude
+    uint8_t  quality;               // Score of the last beat, 0..100 (0 until a template exists)
+    uint16_t rejected;              // Rejected beats (wraps)
+} SignalQuality;
+
+void signalQualityInit(SignalQuality *q, uint16_t sampleRateHz);
+
+// Feed every filtered sample, cheap except on every step-th sample
+void signalQualityPush(SignalQuality *q, int16_t value);
+
+// Score the beat that was just detected and update the template, returns 1 if the beat
+// reaches 'minQuality' or cannot be judged yet. With 'minQuality' 0 every beat passes.
+uint8_t signalQualityCheckBeat(SignalQuality *q, uint8_t minQuality);
+
+#endif /* SIGNAL_QUALITY_H_ */
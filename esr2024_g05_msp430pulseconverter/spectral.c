@@ -0,0 +1,201 @@
+//***************************************************************************************
+//  Spektrale Pulsschaetzung mit einer Goertzel-Filterbank
+//***************************************************************************************
+
+#include "spectral.h"
+
+#define Q14_ONE             16384
+#define TWO_PI_Q14          102944L     // 2 pi in Q14
+#define DC_SHIFT            5           // Running mean over ~32 values (1.3 s)
+
+// cos(x) for 0 <= x <= pi/2 in Q14 (Taylor series to x^8, error below one LSB), only
+// used when the coefficients are set up
+static int32_t cosQ14(int32_t x) {
+    int32_t x2 = (x * x) >> 14;
+    int32_t term = Q14_ONE;
+    int32_t result = Q14_ONE;
+    int32_t n;
+
+    for (n = 1; n <= 4; n++) {
+        term = -((term * x2) >> 14) / ((2 * n - 1) * (2 * n));
+        result += term;
+    }
+    return result;
+}
+
+// (coeff * s) >> 14 from two 16 x 16 bit products, one MPYS each on the MPY32. s is split
+// into signed halves, s = hi * 65536 + lo, and coeff * hi * 65536 is a multiple of 2^14,
+// so the result is bit exact with the 64 bit product. Needs |s| < 2^29; the state stays
+// below N * |x| / sin(w) = 200 * 4096 / 0.125 < 2^23 for the lowest bin.
+static int32_t mulQ14(int16_t coeff, int32_t s) {
+    int16_t lo = (int16_t)(uint16_t)s;
+    int16_t hi = (int16_t)((s - lo) >> 16);
+
+    return (int32_t)coeff * hi * 4 + (((int32_t)coeff * lo) >> 14);
+}
+
+static void startBank(GoertzelBank *bank, int16_t count) {
+    uint8_t k;
+
+    for (k = 0; k < SPECTRAL_BINS; k++) {
+        bank->s1[k] = 0;
+        bank->s2[k] = 0;
+    }
+    bank->count = count;
+}
+
+void spectralInit(SpectralEstimator *e, uint16_t sampleRateHz) {
+    uint16_t rate;
+    uint16_t bpm;
+    uint8_t b, k;
+
+    e->step = (sampleRateHz > SPECTRAL_RATE_HZ) ? (uint8_t)(sampleRateHz / SPECTRAL_RATE_HZ) : 1;
+    e->stepCount = e->step;
+    e->sum = 0;
+    e->dcQ8 = 0;
+    e->dcValid = 0;
+    e->valid = 0;
+    e->bpm = 0;
+    e->updates = 0;
+
+    // Bin frequencies for the actual averaged rate, w = 2 pi bpm / (60 rate)
+    rate = sampleRateHz / e->step;
+    for (k = 0, bpm = SPECTRAL_BPM_MIN; k < SPECTRAL_BINS; k++, bpm += SPECTRAL_BPM_STEP) {
+        e->coeff[k] = (int16_t)(2 * cosQ14((int32_t)((TWO_PI_Q14 * bpm) / (60L * rate))));
+    }
+
+    for (b = 0; b < SPECTRAL_BANKS; b++) {
+        startBank(&e->bank[b], -(int16_t)(b * (SPECTRAL_WINDOW / SPECTRAL_BANKS)));
+    }
+}
+
+// Power of bin k at the end of the window
+static int64_t binPower(const SpectralEstimator *e, const GoertzelBank *bank, uint8_t k) {
+    int64_t s1 = bank->s1[k];
+    int64_t s2 = bank->s2[k];
+
+    return s1 * s1 + s2 * s2 - mulQ14(e->coeff[k], bank->s1[k]) * s2;
+}
+
+// Pick the peak bin and interpolate the BPM. The powers are recomputed for the few bins
+// needed after the first pass, a table of all of them would not fit the stack.
+static void evaluate(SpectralEstimator *e, const GoertzelBank *bank) {
+    int64_t total = 0;
+    int64_t peakPower = 0;
+    int64_t power, left, right;
+    int64_t num, den;
+    uint8_t peak = 0;
+    uint8_t k;
+    uint16_t half;
+    int32_t bpm10;
+
+    for (k = 0; k < SPECTRAL_BINS; k++) {
+        power = binPower(e, bank, k);
+        total += power;
+        if (power > peakPower) {
+            peakPower = power;
+            peak = k;
+        }
+    }
+
+    // Narrow pulses have a strong second harmonic. If there is a clear peak at half the
+    // frequency, that is the pulse.
+    half = (SPECTRAL_BPM_MIN + peak * SPECTRAL_BPM_STEP) / 2;
+    if (half >= SPECTRAL_BPM_MIN + SPECTRAL_BPM_STEP) {
+        k = (uint8_t)((half - SPECTRAL_BPM_MIN + SPECTRAL_BPM_STEP / 2) / SPECTRAL_BPM_STEP);
+        left = binPower(e, bank, k - 1);
+        power = binPower(e, bank, k);
+        right = binPower(e, bank, k + 1);
+        if (left > power && left > right && k >= 2) {
+            k--;
+            right = power;
+            power = left;
+            left = binPower(e, bank, k - 1);
+        } else if (right > power && right > left) {
+            k++;
+            left = power;
+            power = right;
+            right = binPower(e, bank, k + 1);
+        }
+        if (power * 2 >= peakPower && power >= left && power >= right) {
+            peak = k;
+            peakPower = power;
+        }
+    }
+
+    e->updates++;
+    if (peakPower * SPECTRAL_BINS < total * SPECTRAL_PEAK_RATIO || peak == 0 ||
+        peak == SPECTRAL_BINS - 1) {
+        // Flat spectrum, or the peak is at the edge of the range
+        e->valid = 0;
+        e->bpm = 0;
+        return;
+    }
+
+    // Parabolic interpolation between the neighbours, the vertex lies at
+    // (left - right) / (2 (left - 2 peak + right)) bins from the peak, towards the
+    // larger neighbour. Offset in tenths of a BPM.
+    left = binPower(e, bank, peak - 1);
+    right = binPower(e, bank, peak + 1);
+    num = left - right;
+    den = 2 * (left - 2 * peakPower + right);
+    bpm10 = (int32_t)(SPECTRAL_BPM_MIN + peak * SPECTRAL_BPM_STEP) * 10;
+    if (den != 0) {
+        bpm10 += (int32_t)((num * SPECTRAL_BPM_STEP * 10) / den);
+    }
+    e->bpm = (uint16_t)((bpm10 + 5) / 10);
+    e->valid = 1;
+}
+
+uint8_t spectralProcess(SpectralEstimator *e, int16_t value) {
+    GoertzelBank *bank;
+    int32_t x;
+    int32_t s0;
+    uint8_t done = 0;
+    uint8_t b, k;
+
+    e->sum += value;
+    if (--e->stepCount != 0) {
+        return 0;
+    }
+    e->stepCount = e->step;
+    x = e->sum / e->step;
+    e->sum = 0;
+
+    // Remove the DC level, it would leak into the lowest bins
+    if (!e->dcValid) {
+        e->dcQ8 = x << 8;
+        e->dcValid = 1;
+    }
+    e->dcQ8 += ((x << 8) - e->dcQ8) >> DC_SHIFT;
+    x -= e->dcQ8 >> 8;
+
+    for (b = 0; b < SPECTRAL_BANKS; b++) {
+        bank = &e->bank[b];
+        if (bank->count < 0) {
+            bank->count++;
+            continue;
+        }
+        for (k = 0; k < SPECTRAL_BINS; k++) {
+            s0 = x + mulQ14(e->coeff[k], bank->s1[k]) - bank->s2[k];
+            bank->s2[k] = bank->s1[k];
+            bank->s1[k] = s0;
+        }
+        if (++bank->count == SPECTRAL_WINDOW) {
+            evaluate(e, bank);
+            startBank(bank, 0);
+            done = 1;
+        }
+    }
+    return done;
+}
+
+uint8_t spectralAgrees(const SpectralEstimator *e, uint16_t bpm) {
+    uint16_t diff;
+
+    if (!e->valid || bpm == 0) {
+        return 0;
+    }
+    diff = (bpm > e->bpm) ? bpm - e->bpm : e->bpm - bpm;
+    return (uint32_t)diff * 100 <= (uint32_t)e->bpm * SPECTRAL_AGREE_PERCENT;
+}
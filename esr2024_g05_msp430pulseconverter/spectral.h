@@ -0,0 +1,59 @@
+//***************************************************************************************
+//  Spektrale Pulsschaetzung mit einer Goertzel-Filterbank
+//
+//  Beschreibung: Gegenprobe zur Schlagerkennung im Zeitbereich, die bei verrauschtem
+//  Signal versagt. Das gefilterte Signal wird auf ca. 25 Hz gemittelt und vom
+//  Gleichanteil befreit. Eine Bank von Goertzel-Filtern im Abstand von 5 BPM deckt
+//  30..220 BPM ab und wird mit jedem Wert fortgeschrieben: je Bin zwei 16x16-Bit-
+//  Produkte, auf dem MSP430FR2355 je ein MPYS im MPY32, bitgleich mit dem 64-Bit-
+//  Produkt; in 64 Bit rechnet nur die Auswertung alle 4 s. Zwei um ein halbes Fenster
+//  versetzte Baenke liefern alle 4 s ein Ergebnis ueber die letzten 8 s, ohne dass das
+//  Fenster neu gerechnet werden muss. Das staerkste Bin wird parabolisch interpoliert;
+//  gueltig ist das Ergebnis nur, wenn es deutlich ueber der mittleren Leistung liegt.
+//  tools/bench_spectral.c vergleicht die Bank mit einer FFT ueber dasselbe Fenster.
+//  Frei von Hardwarezugriffen.
+//***************************************************************************************
+
+#ifndef SPECTRAL_H_
+#define SPECTRAL_H_
+
+#include <stdint.h>
+
+#define SPECTRAL_RATE_HZ        25      // Target rate after averaging
+#define SPECTRAL_WINDOW         200     // Values per bank, 8 s at 25 Hz
+#define SPECTRAL_BPM_MIN        30
+#define SPECTRAL_BPM_MAX        220
+#define SPECTRAL_BPM_STEP       5
+#define SPECTRAL_BINS           ((SPECTRAL_BPM_MAX - SPECTRAL_BPM_MIN) / SPECTRAL_BPM_STEP + 1)
+#define SPECTRAL_BANKS          2
+#define SPECTRAL_PEAK_RATIO     4       // Peak power over mean bin power for a valid result
+#define SPECTRAL_AGREE_PERCENT  10      // Time and frequency domain BPM agree within this
+
+typedef struct {
+    int32_t s1[SPECTRAL_BINS];
+    int32_t s2[SPECTRAL_BINS];
+    int16_t count;              // Values in the window, negative while waiting to start
+} GoertzelBank;
+
+typedef struct {
+    int16_t  coeff[SPECTRAL_BINS];  // 2 cos(w), Q14
+    GoertzelBank bank[SPECTRAL_BANKS];
+    uint8_t  step;              // Input samples per averaged value
+    uint8_t  stepCount;
+    int32_t  sum;
+    int32_t  dcQ8;              // Running mean, removed before the filters
+    uint8_t  dcValid;
+    uint8_t  valid;             // Last window had a clear peak
+    uint16_t bpm;               // Last estimate, 0 if not valid
+    uint16_t updates;           // Completed windows (wraps)
+} SpectralEstimator;
+
+void spectralInit(SpectralEstimator *e, uint16_t sampleRateHz);
+
+// Feed every filtered sample, returns 1 if a window completed and 'bpm' was updated
+uint8_t spectralProcess(SpectralEstimator *e, int16_t value);
+
+// Returns 1 if both estimates are valid and within SPECTRAL_AGREE_PERCENT
+uint8_t spectralAgrees(const SpectralEstimator *e, uint16_t bpm);
+
+#endif /* SPECTRAL_H_ */
@@ -0,0 +1,87 @@
+//***************************************************************************************
+//  Rohdaten-Streaming ueber eUSCI_A1 im SPI-Master-Modus
+//***************************************************************************************
+
+#include <msp430.h>
+#include "driverlib/MSP430FR2xx_4xx/eusci_a_spi.h"
+#include "spi_stream.h"
+#include "system.h"
+
+#pragma NOINIT(blocks)
+static StreamBlocks blocks;                 // Written by spiStreamStart(), not by cinit
+static uint8_t active;
+
+static const uint8_t *txPtr;
+static uint8_t txRemaining;
+static volatile uint8_t txBusy;             // The other half is still being sent
+static volatile uint16_t blocksSent;
+
+void spiStreamInit(void) {
+    EUSCI_A_SPI_initMasterParam param = {0};
+
+    // Configure SPI pins (P4.1 UCA1CLK, P4.3 UCA1SIMO)
+    P4SEL0 |= BIT1 | BIT3;
+
+    param.selectClockSource = EUSCI_A_SPI_CLOCKSOURCE_SMCLK;
+    param.clockSourceFrequency = SMCLK_HZ;
+    param.desiredSpiClock = STREAM_SPI_CLOCK_HZ;
+    param.msbFirst = EUSCI_A_SPI_MSB_FIRST;
+    param.clockPhase = EUSCI_A_SPI_PHASE_DATA_CHANGED_ONFIRST_CAPTURED_ON_NEXT;
+    param.clockPolarity = EUSCI_A_SPI_CLOCKPOLARITY_INACTIVITY_LOW;
+    param.spiMode = EUSCI_A_SPI_3PIN;
+    EUSCI_A_SPI_initMaster(EUSCI_A1_BASE, &param);
+    EUSCI_A_SPI_enable(EUSCI_A1_BASE);
+}
+
+void spiStreamStart(uint8_t channel) {
+    active = 0;
+    streamBlockStart(&blocks, channel);
+    blocksSent = 0;
+    active = 1;
+}
+
+void spiStreamStop(void) {
+    active = 0;
+}
+
+void spiStreamPut(uint16_t sample) {
+    const uint8_t *b;
+
+    if (!active) {
+        return;
+    }
+    b = streamBlockPut(&blocks, sample, txBusy);
+    if (b) {
+        txPtr = b;
+        txRemaining = STREAM_BLOCK_BYTES;
+        txBusy = 1;
+        UCA1IE |= UCTXIE;                   // TXIFG is already set, sending starts now
+    }
+}
+
+void spiStreamGetStatus(uint16_t *sent, uint16_t *dropped) {
+    unsigned short state = __get_interrupt_state();
+
+    __disable_interrupt();
+    *sent = blocksSent;
+    *dropped = blocks.overruns;
+    __set_interrupt_state(state);
+}
+
+#pragma vector=EUSCI_A1_VECTOR
+__interrupt void USCI_A1_ISR(void) {
+    switch (__even_in_range(UCA1IV, USCI_SPI_UCTXIFG)) {
+    case USCI_SPI_UCTXIFG:
+        if (txRemaining) {
+            UCA1TXBUF = *txPtr++;
+            txRemaining--;
+        } else {
+            UCA1IE &= ~UCTXIE;
+            txBusy = 0;
+            blocksSent++;
+        }
+        break;
+    default:
+        break;
+    }
+}
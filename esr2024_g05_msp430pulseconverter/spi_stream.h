@@ -0,0 +1,34 @@
+//***************************************************************************************
+//  Rohdaten-Streaming ueber eUSCI_A1 im SPI-Master-Modus (P4.1 CLK / P4.3 SIMO)
+//
+//  Beschreibung: Im Streaming-Modus wird der ADC mit STREAM_RATE_HZ abgetastet und jedes
+//  Rohsample in Bloecke fester Groesse gepackt (Format und Overrun-Verhalten in
+//  stream_block.h). Die ADC-ISR fuellt den einen Blockpuffer, waehrend die TX-ISR den
+//  anderen sendet.
+//***************************************************************************************
+
+#ifndef SPI_STREAM_H_
+#define SPI_STREAM_H_
+
+#include <stdint.h>
+#include "stream_block.h"
+
+#define STREAM_RATE_HZ          8000
+#define STREAM_SPI_CLOCK_HZ     1000000UL
+
+// Configure eUSCI_A1 as SPI master
+void spiStreamInit(void);
+
+// Reset sequence number and buffers, samples for 'channel' are accepted afterwards
+void spiStreamStart(uint8_t channel);
+
+// Stop accepting samples, a block already being sent is finished
+void spiStreamStop(void);
+
+// Add one raw sample, called from the ADC ISR
+void spiStreamPut(uint16_t sample);
+
+// Number of blocks sent and dropped since spiStreamStart()
+void spiStreamGetStatus(uint16_t *sent, uint16_t *dropped);
+
+#endif /* SPI_STREAM_H_ */
@@ -0,0 +1,48 @@
+//***************************************************************************************
+//  Bloecke des SPI-Rohdatenstroms: Rahmen, Sequenznummer und Overrun-Zaehler
+//***************************************************************************************
+
+#include "stream_block.h"
+
+static void writeHeader(uint8_t *b, uint8_t channel) {
+    b[0] = STREAM_SYNC0;
+    b[1] = STREAM_SYNC1;
+    b[6] = STREAM_BLOCK_SAMPLES;
+    b[7] = channel;
+}
+
+void streamBlockStart(StreamBlocks *s, uint8_t channel) {
+    writeHeader(s->block[0], channel);
+    writeHeader(s->block[1], channel);
+    s->fillBlock = 0;
+    s->fillCount = 0;
+    s->sequence = 0;
+    s->overruns = 0;
+}
+
+const uint8_t *streamBlockPut(StreamBlocks *s, uint16_t sample, uint8_t txBusy) {
+    uint8_t *b = &s->block[s->fillBlock][STREAM_HEADER_BYTES + 2 * s->fillCount];
+
+    b[0] = (uint8_t)sample;
+    b[1] = (uint8_t)(sample >> 8);
+    if (++s->fillCount < STREAM_BLOCK_SAMPLES) {
+        return 0;
+    }
+    s->fillCount = 0;
+
+    b = s->block[s->fillBlock];
+    b[2] = (uint8_t)s->sequence;
+    b[3] = (uint8_t)(s->sequence >> 8);
+    s->sequence++;
+
+    if (txBusy) {
+        // Previous block still on the wire: drop this one and refill the same half
+        s->overruns++;
+        return 0;
+    }
+
+    b[4] = (uint8_t)s->overruns;
+    b[5] = (uint8_t)(s->overruns >> 8);
+    s->fillBlock ^= 1;
+    return b;
+}
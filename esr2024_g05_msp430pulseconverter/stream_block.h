@@ -0,0 +1,46 @@
+//***************************************************************************************
+//  Bloecke des SPI-Rohdatenstroms: Rahmen, Sequenznummer und Overrun-Zaehler
+//
+//  Beschreibung: Zwei Blockpuffer im Wechsel (Ping-Pong). streamBlockPut() fuellt den
+//  einen; ist er voll, erhaelt er seine Sequenznummer und wird zum Senden zurueck-
+//  gegeben, der andere wird gefuellt. Ist der Sender beim Blockwechsel noch belegt,
+//  wird der volle Block verworfen, als Overrun gezaehlt und derselbe Puffer neu
+//  gefuellt; die Sequenznummer zaehlt trotzdem weiter, so dass der Empfaenger die Luecke
+//  erkennt. Frei von Hardwarezugriffen, der Treiber steckt in spi_stream.c.
+//
+//  Blockformat (STREAM_BLOCK_BYTES):
+//      0   0xA5, 0x5A          Sync
+//      2   uint16_t seq        Sequenznummer (LE)
+//      4   uint16_t overruns   Bisher verworfene Bloecke (LE)
+//      6   uint8_t  count      Samples pro Block
+//      7   uint8_t  channel    ADC-Kanal
+//      8   uint16_t sample[]   12-Bit-Rohwerte (LE)
+//***************************************************************************************
+
+#ifndef STREAM_BLOCK_H_
+#define STREAM_BLOCK_H_
+
+#include <stdint.h>
+
+#define STREAM_BLOCK_SAMPLES    32
+#define STREAM_HEADER_BYTES     8
+#define STREAM_BLOCK_BYTES      (STREAM_HEADER_BYTES + 2 * STREAM_BLOCK_SAMPLES)
+#define STREAM_SYNC0            0xA5
+#define STREAM_SYNC1            0x5A
+
+typedef struct {
+    uint8_t block[2][STREAM_BLOCK_BYTES];
+    uint8_t fillBlock;                      // Half currently being filled
+    uint8_t fillCount;                      // Samples in the fill half
+    uint16_t sequence;
+    volatile uint16_t overruns;
+} StreamBlocks;
+
+// Write both headers and reset the counters
+void streamBlockStart(StreamBlocks *s, uint8_t channel);
+
+// Add one sample. Returns the completed block to send, or 0 if the fill half is not full
+// yet or was dropped because 'txBusy' says the other half is still on the wire.
+const uint8_t *streamBlockPut(StreamBlocks *s, uint16_t sample, uint8_t txBusy);
+
+#endif /* STREAM_BLOCK_H_ */
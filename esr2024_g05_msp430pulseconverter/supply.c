@@ -0,0 +1,31 @@
+//***************************************************************************************
+//  Ausgleich der Versorgungsspannung ueber die interne 1,5-V-Referenz
+//***************************************************************************************
+
+#include "supply.h"
+
+void supplyInit(SupplyMonitor *s) {
+    s->average = 0;
+    s->mv = SUPPLY_NOMINAL_MV;
+    s->factor = SUPPLY_FACTOR_ONE;
+}
+
+uint8_t supplyUpdate(SupplyMonitor *s, uint16_t refCode, uint16_t refFactor) {
+    uint16_t code;
+
+    if (refCode < SUPPLY_CODE_MIN || refCode > SUPPLY_CODE_MAX) {
+        return 0;
+    }
+    code = refCode << 4;
+    if (s->average == 0) {
+        s->average = code;
+    } else {
+        s->average = (uint16_t)(s->average + (((int32_t)code - s->average) >> SUPPLY_AVERAGE_SHIFT));
+    }
+
+    // code = 4096 * Vref / Vcc with Vref = SUPPLY_REF_MV * refFactor / 2^15, the average
+    // carries another 2^4
+    s->mv = (uint16_t)((uint32_t)SUPPLY_REF_MV * refFactor * 2 / s->average);
+    s->factor = (uint16_t)(((uint32_t)s->mv << 15) / SUPPLY_NOMINAL_MV);
+    return 1;
+}
@@ -0,0 +1,41 @@
+//***************************************************************************************
+//  Ausgleich der Versorgungsspannung ueber die interne 1,5-V-Referenz
+//
+//  Beschreibung: Der ADC misst gegen AVCC, jeder Wert haengt also von der Versorgung ab.
+//  Alle SUPPLY_PERIOD_MS wird statt eines Sensorwerts die interne Referenz gewandelt;
+//  supplyUpdate() mittelt diese Werte, rechnet mit dem Referenzfaktor der TLV die
+//  Versorgung in mV aus und daraus den Faktor Versorgung / SUPPLY_NOMINAL_MV (Q15). In
+//  die ADC-Korrektur eingerechnet (adc_correction.h) bringt er jeden Abtastwert auf die
+//  Nennversorgung, ohne Kosten je Wert. Schwellen und Helligkeit vergleichen danach
+//  Werte in Einheiten der Nennversorgung und bleiben ueber die Entladung der Batterie
+//  gleich. Unplausible Werte werden verworfen. Frei von Hardwarezugriffen.
+//***************************************************************************************
+
+#ifndef SUPPLY_H_
+#define SUPPLY_H_
+
+#include <stdint.h>
+
+#define SUPPLY_PERIOD_MS            4000
+#define SUPPLY_NOMINAL_MV           3300
+#define SUPPLY_REF_MV               1500
+#define SUPPLY_AVERAGE_SHIFT        2       // Exponential average over about 4 measurements
+#define SUPPLY_FACTOR_ONE           0x8000  // Q15
+
+// Reference codes beyond 1.7..3.7 V supply are taken as failed measurements
+#define SUPPLY_CODE_MIN             1660
+#define SUPPLY_CODE_MAX             3610
+
+typedef struct {
+    uint16_t average;               // Reference code, Q4, 0 before the first measurement
+    uint16_t mv;                    // Supply voltage
+    uint16_t factor;                // Supply over nominal, Q15
+} SupplyMonitor;
+
+void supplyInit(SupplyMonitor *s);
+
+// Fold in the corrected ADC code of the reference, 'refFactor' from the TLV (Q15).
+// Returns 1 if the factor was updated.
+uint8_t supplyUpdate(SupplyMonitor *s, uint16_t refCode, uint16_t refFactor);
+
+#endif /* SUPPLY_H_ */
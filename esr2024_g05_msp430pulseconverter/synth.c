@@ -0,0 +1,113 @@
+//***************************************************************************************
+//  Wavetable-Tonsynthese fuer den Piezo
+//***************************************************************************************
+
+#include "synth.h"
+
+// 2047 * sin(i * pi / 128) for i = 0..64, the other quadrants follow by symmetry
+static const int16_t quarterSine[65] = {
+       0,   50,  100,  151,  201,  251,  300,  350,  399,  449,  497,  546,  594,
+     642,  690,  737,  783,  830,  875,  920,  965, 1009, 1052, 1095, 1137, 1179,
+    1219, 1259, 1299, 1337, 1375, 1411, 1447, 1483, 1517, 1550, 1582, 1614, 1644,
+    1674, 1702, 1729, 1756, 1781, 1805, 1828, 1850, 1871, 1891, 1910, 1927, 1944,
+    1959, 1973, 1986, 1997, 2008, 2017, 2025, 2032, 2037, 2041, 2045, 2046, 2047
+};
+
+// Envelope step that covers the full level in 'ms', at least one sample
+static uint16_t envelopeStep(const Synth *s, uint16_t ms) {
+    uint32_t samples = (uint32_t)ms * s->sampleRateHz / 1000;
+
+    if (samples <= 1) {
+        return SYNTH_LEVEL_FULL;
+    }
+    return (uint16_t)(SYNTH_LEVEL_FULL / samples);
+}
+
+static void setFrequency(Synth *s, uint16_t freqHz) {
+    s->increment = (uint16_t)(((uint32_t)freqHz << 16) / s->sampleRateHz);
+}
+
+void synthInit(Synth *s, uint16_t sampleRateHz) {
+    s->sampleRateHz = sampleRateHz;
+    s->phase = 0;
+    s->increment = 0;
+    s->level = 0;
+    s->attackStep = SYNTH_LEVEL_FULL;
+    s->releaseStep = SYNTH_LEVEL_FULL;
+    s->autoRelease = 0;
+    s->stage = SYNTH_IDLE;
+}
+
+void synthNoteOn(Synth *s, uint16_t freqHz, uint16_t attackMs) {
+    setFrequency(s, freqHz);
+    s->attackStep = envelopeStep(s, attackMs);
+    s->autoRelease = 0;
+    s->stage = SYNTH_ATTACK;    // Rises from the current level, no restart click
+}
+
+void synthNoteOff(Synth *s, uint16_t releaseMs) {
+    if (s->stage != SYNTH_IDLE) {
+        s->releaseStep = envelopeStep(s, releaseMs);
+        s->stage = SYNTH_RELEASE;
+    }
+}
+
+void synthClick(Synth *s, uint16_t freqHz, uint16_t attackMs, uint16_t decayMs) {
+    setFrequency(s, freqHz);
+    s->attackStep = envelopeStep(s, attackMs);
+    s->releaseStep = envelopeStep(s, decayMs);
+    s->autoRelease = 1;
+    s->stage = SYNTH_ATTACK;
+}
+
+uint16_t synthNext(Synth *s) {
+    uint8_t index;
+    uint8_t i;
+    int16_t wave;
+
+    switch (s->stage) {
+    case SYNTH_ATTACK:
+        if (s->level > SYNTH_LEVEL_FULL - s->attackStep) {
+            s->level = SYNTH_LEVEL_FULL;
+            s->stage = s->autoRelease ? SYNTH_RELEASE : SYNTH_SUSTAIN;
+        } else {
+            s->level += s->attackStep;
+        }
+        break;
+    case SYNTH_RELEASE:
+        if (s->level <= s->releaseStep) {
+            s->level = 0;
+            s->stage = SYNTH_IDLE;
+        } else {
+            s->level -= s->releaseStep;
+        }
+        break;
+    case SYNTH_SUSTAIN:
+        break;
+    default:
+        return SYNTH_MIDSCALE;
+    }
+
+    index = (uint8_t)(s->phase >> 8);
+    s->phase += s->increment;
+    i = index & 0x3F;
+    switch (index >> 6) {
+    case 0:
+        wave = quarterSine[i];
+        break;
+    case 1:
+        wave = quarterSine[64 - i];
+        break;
+    case 2:
+        wave = -quarterSine[i];
+        break;
+    default:
+        wave = -quarterSine[64 - i];
+        break;
+    }
+    return (uint16_t)(SYNTH_MIDSCALE + (int16_t)(((int32_t)wave * s->level) >> 16));
+}
+
+uint8_t synthActive(const Synth *s) {
+    return s->stage != SYNTH_IDLE;
+}
@@ -0,0 +1,55 @@
+//***************************************************************************************
+//  Wavetable-Tonsynthese fuer den Piezo
+//
+//  Beschreibung: Phasenakkumulator (16 Bit) ueber eine Viertelwellen-Sinustabelle mit
+//  Huellkurve aus Anstieg, Halten und Abklingen. synthNext() liefert pro Abtastwert
+//  einen 12-Bit-DAC-Wert um die Mitte des Bereichs, ohne Schleifen und mit einer
+//  einzigen Multiplikation. Noten und Klicks werden aus dem Hauptprogramm gestartet,
+//  die Aufrufer sorgen dafuer, dass synthNext() dabei nicht dazwischenlaeuft.
+//  Frei von Hardwarezugriffen.
+//***************************************************************************************
+
+#ifndef SYNTH_H_
+#define SYNTH_H_
+
+#include <stdint.h>
+
+#define SYNTH_MIDSCALE      2048    // DAC code of the idle output
+#define SYNTH_LEVEL_FULL    0xFFFF  // Envelope level, Q16
+
+typedef enum {
+    SYNTH_IDLE = 0,
+    SYNTH_ATTACK,
+    SYNTH_SUSTAIN,
+    SYNTH_RELEASE
+} SynthStage;
+
+typedef struct {
+    uint16_t sampleRateHz;
+    uint16_t phase;             // Full turn = 65536
+    uint16_t increment;         // Phase step per sample, sets the frequency
+    uint16_t level;             // Envelope, Q16
+    uint16_t attackStep;
+    uint16_t releaseStep;
+    uint8_t  autoRelease;       // Release right after the attack (click)
+    volatile uint8_t stage;     // SynthStage
+} Synth;
+
+void synthInit(Synth *s, uint16_t sampleRateHz);
+
+// Start a tone that is held until synthNoteOff()
+void synthNoteOn(Synth *s, uint16_t freqHz, uint16_t attackMs);
+
+// Let the current tone fade out
+void synthNoteOff(Synth *s, uint16_t releaseMs);
+
+// Short tone that fades out on its own, for beat clicks
+void synthClick(Synth *s, uint16_t freqHz, uint16_t attackMs, uint16_t decayMs);
+
+// Next DAC code 0..4095, SYNTH_MIDSCALE when idle
+uint16_t synthNext(Synth *s);
+
+// 0 once the envelope has faded out
+uint8_t synthActive(const Synth *s);
+
+#endif /* SYNTH_H_ */
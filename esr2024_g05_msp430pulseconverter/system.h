@@ -0,0 +1,16 @@
+//***************************************************************************************
+//  Systemtakt des Pulswandlers
+//
+//  Beschreibung: MCLK und SMCLK laufen mit 8 MHz aus dem DCO (FLL auf REFO), ACLK mit
+//  32768 Hz aus REFO. Die Timer fuer die Abtastung zaehlen mit SMCLK / 8 = 1 MHz.
+//***************************************************************************************
+
+#ifndef SYSTEM_H_
+#define SYSTEM_H_
+
+#define MCLK_HZ             8000000UL
+#define SMCLK_HZ            MCLK_HZ
+#define ACLK_HZ             32768UL
+#define TIMER_CLK_HZ        (SMCLK_HZ / 8)  // Timer_B input divider ID__8
+
+#endif /* SYSTEM_H_ */
@@ -0,0 +1,91 @@
+//***************************************************************************************
+//  Index der Geraetebeschreibung (TLV) und Kalibrierwerte
+//***************************************************************************************
+
+#include "tlv_index.h"
+
+uint8_t tlvIndexBuild(TlvIndex *ix, const uint8_t *image, uint16_t length) {
+    uint16_t pos = 0;
+    uint8_t entryLength;
+
+    ix->count = 0;
+    ix->flags = 0;
+    while (1) {
+        if (pos >= length) {
+            ix->flags |= TLV_INDEX_NO_END;
+            break;
+        }
+        if (image[pos] == TLV_INDEX_TAG_END) {
+            break;
+        }
+        if (pos + 2 > length || (uint16_t)(length - pos - 2) < image[pos + 1]) {
+            ix->flags |= TLV_INDEX_OVERRUN;
+            break;
+        }
+        entryLength = image[pos + 1];
+        if (ix->count == TLV_INDEX_SIZE) {
+            ix->flags |= TLV_INDEX_FULL;
+            break;
+        }
+        ix->entries[ix->count].data = &image[pos + 2];
+        ix->entries[ix->count].tag = image[pos];
+        ix->entries[ix->count].length = entryLength;
+        ix->count++;
+        pos += 2 + entryLength;
+    }
+    return ix->flags;
+}
+
+const uint8_t *tlvIndexFind(const TlvIndex *ix, uint8_t tag, uint8_t instance,
+                            uint8_t *length) {
+    uint8_t i;
+
+    for (i = 0; i < ix->count; i++) {
+        if (ix->entries[i].tag == tag && instance-- == 0) {
+            *length = ix->entries[i].length;
+            return ix->entries[i].data;
+        }
+    }
+    *length = 0;
+    return 0;
+}
+
+// Little endian word, byte wise as a damaged image may leave the data unaligned
+static uint16_t word(const uint8_t *data, uint8_t index) {
+    return (uint16_t)data[2 * index] | ((uint16_t)data[2 * index + 1] << 8);
+}
+
+static uint8_t plausibleFactor(uint16_t factor) {
+    return factor >= TLV_FACTOR_ONE - TLV_FACTOR_SPAN && factor <= TLV_FACTOR_ONE + TLV_FACTOR_SPAN;
+}
+
+void tlvResolveCalibration(const TlvIndex *ix, TlvCalibration *cal) {
+    const uint8_t *data;
+    uint8_t length;
+
+    cal->adcGain = TLV_FACTOR_ONE;
+    cal->adcOffset = 0;
+    cal->tempCode30 = 0;
+    cal->tempCode105 = 0;
+    cal->ref15Factor = TLV_FACTOR_ONE;
+    cal->present = 0;
+
+    data = tlvIndexFind(ix, TLV_INDEX_TAG_ADCCAL, 0, &length);
+    if (length >= 4 && plausibleFactor(word(data, 0)) &&
+        (int16_t)word(data, 1) >= -TLV_OFFSET_MAX && (int16_t)word(data, 1) <= TLV_OFFSET_MAX) {
+        cal->adcGain = word(data, 0);
+        cal->adcOffset = (int16_t)word(data, 1);
+        cal->present |= TLV_CAL_ADC;
+    }
+    if (length >= 8) {
+        cal->tempCode30 = word(data, 2);
+        cal->tempCode105 = word(data, 3);
+        cal->present |= TLV_CAL_TEMP;
+    }
+
+    data = tlvIndexFind(ix, TLV_INDEX_TAG_REFCAL, 0, &length);
+    if (length >= 2 && plausibleFactor(word(data, 0))) {
+        cal->ref15Factor = word(data, 0);
+        cal->present |= TLV_CAL_REF;
+    }
+}
@@ -0,0 +1,75 @@
+//***************************************************************************************
+//  Index der Geraetebeschreibung (TLV) und Kalibrierwerte
+//
+//  Beschreibung: tlvIndexBuild() durchlaeuft die TLV-Struktur einmal beim Start und legt
+//  fuer jeden Eintrag Kennung, Laenge und Adresse der Daten in einer kleinen Tabelle ab.
+//  Spaetere Abfragen durchsuchen nur noch diese Tabelle statt der ganzen Struktur wie
+//  TLV_getInfo(). tlvResolveCalibration() holt daraus einmal die Kalibrierwerte von ADC,
+//  Temperatursensor und Referenz; fehlt ein Eintrag oder ist er zu kurz, gelten neutrale
+//  Werte (Faktor 1, Offset 0) und das Bit in 'present' bleibt geloescht, ebenso bei
+//  unplausiblen Werten.
+//
+//  Fehlerhafte Abbilder werden nicht blind gelesen: ein Eintrag, dessen Laenge ueber das
+//  Ende hinausreicht, beendet die Suche und wird nicht aufgenommen (TLV_INDEX_OVERRUN),
+//  ebenso ein fehlendes Endekennzeichen (TLV_INDEX_NO_END) oder eine volle Tabelle
+//  (TLV_INDEX_FULL). Frei von Hardwarezugriffen, das Abbild wird als Zeiger uebergeben.
+//***************************************************************************************
+
+#ifndef TLV_INDEX_H_
+#define TLV_INDEX_H_
+
+#include <stdint.h>
+
+// Tags of the MSP430FR2xx device descriptor
+#define TLV_INDEX_TAG_DIE           0x08
+#define TLV_INDEX_TAG_ADCCAL        0x11    // Gain, offset, temperature sensor at 1.5 V ref
+#define TLV_INDEX_TAG_REFCAL        0x12    // 1.5 V reference factor
+#define TLV_INDEX_TAG_END           0xFF
+
+#define TLV_INDEX_SIZE              8       // The FR2355 descriptor has 5 entries
+
+// Flags returned by tlvIndexBuild()
+#define TLV_INDEX_OVERRUN           0x01    // An entry reached past the image
+#define TLV_INDEX_NO_END            0x02    // No end tag within the image
+#define TLV_INDEX_FULL              0x04    // More entries than TLV_INDEX_SIZE
+
+// Bits of TlvCalibration.present
+#define TLV_CAL_ADC                 0x01
+#define TLV_CAL_TEMP                0x02
+#define TLV_CAL_REF                 0x04
+
+#define TLV_FACTOR_ONE              0x8000  // Gain and reference factors, 1.0 in Q15
+#define TLV_FACTOR_SPAN             0x0800  // Factors beyond 1.0 +- 6 % are taken as damaged
+#define TLV_OFFSET_MAX              128     // Likewise ADC offsets beyond +- 128 codes
+
+typedef struct {
+    const uint8_t *data;
+    uint8_t tag;
+    uint8_t length;
+} TlvEntry;
+
+typedef struct {
+    TlvEntry entries[TLV_INDEX_SIZE];
+    uint8_t count;
+    uint8_t flags;
+} TlvIndex;
+
+typedef struct {
+    uint16_t adcGain;               // Q15
+    int16_t  adcOffset;             // ADC codes
+    uint16_t tempCode30;            // ADC code of the sensor at 30 C, 1.5 V reference
+    uint16_t tempCode105;           // ADC code at 105 C
+    uint16_t ref15Factor;           // Q15
+    uint8_t  present;               // TLV_CAL_* found in the descriptor
+} TlvCalibration;
+
+// Index the entries of 'image' (first tag at image[0]), returns TLV_INDEX_* flags
+uint8_t tlvIndexBuild(TlvIndex *ix, const uint8_t *image, uint16_t length);
+
+// Data of the 'instance'-th entry with 'tag', 0 if there is none
+const uint8_t *tlvIndexFind(const TlvIndex *ix, uint8_t tag, uint8_t instance,
+                            uint8_t *length);
+
+void tlvResolveCalibration(const TlvIndex *ix, TlvCalibration *cal);
+
+#endif /* TLV_INDEX_H_ */
@@ -0,0 +1,213 @@
+//***************************************************************************************
+//  Vergleich der spektralen Pulsschaetzung: Goertzel-Bank (spectral.c) gegen FFT
+//  (tools/spectral_fft.c)
+//
+//  Beschreibung: Kurven aus ppg_synth.c laufen durch den 10-Hz-Tiefpass der Firmware
+//  und dann durch beide Schaetzer, die gleichzeitig alle 4 s ein Ergebnis ueber die
+//  letzten 8 s liefern. Referenz ist der mittlere Puls der Schlaege in diesem Fenster.
+//  Je Kurve und Verfahren werden der Anteil gueltiger Ergebnisse, der mittlere
+//  absolute Fehler der gueltigen und der Anteil innerhalb von SPECTRAL_AGREE_PERCENT
+//  ausgegeben, dazu die Host-Laufzeit je Ergebnis. Die MSP430-Zyklen je Wert und je
+//  Auswertung misst tools/cycles/run.py (spectral_point/spectral_eval gegen
+//  fft_point/fft_eval).
+//
+//  Uebersetzen (Linux, im Projektverzeichnis):
+//    gcc -O2 -std=c99 -Wall -I. -Itools -o bench_spectral tools/bench_spectral.c
+//        tools/spectral_fft.c tools/ppg_synth.c spectral.c biquad.c filter_tables.c -lm
+//***************************************************************************************
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "biquad.h"
+#include "filter_tables.h"
+#include "ppg_synth.h"
+#include "spectral.h"
+#include "tools/spectral_fft.h"
+
+#define TRACE_S             300
+#define RATE_HZ             250
+#define WINDOW_S            ((double)SPECTRAL_WINDOW / SPECTRAL_RATE_HZ)
+#define MAX_BEATS           2048
+#define MAX_RESULTS         (TRACE_S / 2)
+
+typedef struct {
+    const char *name;
+    double bpm, hrv, rsa, noise, wander, artifacts;
+} Case;
+
+typedef struct {
+    size_t sample;                      // Input sample that completed the window
+    uint8_t valid;
+    uint16_t bpm;
+} Result;
+
+typedef struct {
+    unsigned updates, valid, agree;
+    double errorSum;
+    double seconds;
+} Score;
+
+static const Case cases[] = {
+    // name           bpm    hrv   rsa  noise wander artifacts/min
+    {"rest_48",       48.0,  30.0, 40.0,  0.0,   0.0,  0.0},
+    {"clean_72",      72.0,  20.0, 30.0,  0.0,   0.0,  0.0},
+    {"walk_104",     104.0,  10.0, 15.0,  0.0,   0.0,  0.0},
+    {"tachy_150",    150.0,   8.0, 10.0,  0.0,   0.0,  0.0},
+    {"tachy_200",    200.0,   5.0,  5.0,  0.0,   0.0,  0.0},
+    {"hrv_high",      68.0,  80.0, 60.0,  0.0,   0.0,  0.0},
+    {"noise",         72.0,  20.0, 30.0, 80.0,   0.0,  0.0},
+    {"wander",        72.0,  20.0, 30.0,  0.0, 300.0,  0.0},
+    {"motion",        88.0,  20.0, 30.0, 15.0,   0.0,  8.0},
+};
+
+static PpgSynth synth;
+static uint16_t samples[TRACE_S * RATE_HZ];
+static PpgBeat beats[MAX_BEATS];
+static size_t beatCount;
+
+static double now(void) {
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+// Mean rate of the beats in the window that ends at 'endS', 0 without two beats
+static double truthBpm(double endS) {
+    double first = -1.0, last = 0.0;
+    unsigned n = 0;
+    size_t i;
+
+    for (i = 0; i < beatCount; i++) {
+        if (beats[i].timeS > endS - WINDOW_S && beats[i].timeS <= endS) {
+            if (n == 0) {
+                first = beats[i].timeS;
+            }
+            last = beats[i].timeS;
+            n++;
+        }
+    }
+    return (n >= 2) ? 60.0 * (n - 1) / (last - first) : 0.0;
+}
+
+static void score(Score *s, const Result *r) {
+    double truth = truthBpm((double)(r->sample + 1) / RATE_HZ);
+    double error;
+
+    if (truth == 0.0) {
+        return;
+    }
+    s->updates++;
+    if (!r->valid) {
+        return;
+    }
+    error = fabs(r->bpm - truth);
+    s->valid++;
+    s->errorSum += error;
+    if (error * 100 <= truth * SPECTRAL_AGREE_PERCENT) {
+        s->agree++;
+    }
+}
+
+static void print(const char *name, const char *method, const Score *s) {
+    printf("%-11s %-8s %4u %6.1f %% %7.2f %6.1f %% %8.0f\n", name, method, s->updates,
+           s->updates ? 100.0 * s->valid / s->updates : 0.0,
+           s->valid ? s->errorSum / s->valid : 0.0,
+           s->updates ? 100.0 * s->agree / s->updates : 0.0,
+           s->updates ? s->seconds * 1e9 / s->updates : 0.0);
+}
+
+static void run(const Case *c, Score *goertzel, Score *fft) {
+    static SpectralEstimator spectral;
+    static FftEstimator fftEstimator;
+    static int16_t filtered[TRACE_S * RATE_HZ];
+    static Result results[MAX_RESULTS];
+    const int16_t *coeffs = filterTableForRate(RATE_HZ)->coeffs;
+    BiquadState filter;
+    PpgSynthParams p;
+    Score g = {0}, f = {0};
+    double start;
+    size_t i, n, count;
+
+    ppgSynthDefaults(&p);
+    p.sampleRateHz = RATE_HZ;
+    p.bpm = c->bpm;
+    p.hrvSdMs = c->hrv;
+    p.rsaMs = c->rsa;
+    p.noiseSd = c->noise;
+    p.wanderAmplitude = c->wander;
+    p.artifactsPerMin = c->artifacts;
+    p.artifactAmplitude = 1500.0;
+    ppgSynthInit(&synth, &p);
+    beatCount = ppgSynthGenerate(&synth, samples, TRACE_S * RATE_HZ, beats, MAX_BEATS);
+
+    biquadReset(&filter, (int16_t)samples[0]);
+    for (i = 0; i < TRACE_S * RATE_HZ; i++) {
+        filtered[i] = biquadStep(&filter, coeffs, (int16_t)samples[i]);
+    }
+
+    // Each estimator timed over the whole trace, the results are scored afterwards
+    spectralInit(&spectral, RATE_HZ);
+    count = 0;
+    start = now();
+    for (i = 0; i < TRACE_S * RATE_HZ; i++) {
+        if (spectralProcess(&spectral, filtered[i])) {
+            results[count].sample = i;
+            results[count].valid = spectral.valid;
+            results[count++].bpm = spectral.bpm;
+        }
+    }
+    g.seconds = now() - start;
+    for (n = 0; n < count; n++) {
+        score(&g, &results[n]);
+    }
+
+    fftEstimatorInit(&fftEstimator, RATE_HZ);
+    count = 0;
+    start = now();
+    for (i = 0; i < TRACE_S * RATE_HZ; i++) {
+        if (fftEstimatorProcess(&fftEstimator, filtered[i])) {
+            results[count].sample = i;
+            results[count].valid = fftEstimator.valid;
+            results[count++].bpm = fftEstimator.bpm;
+        }
+    }
+    f.seconds = now() - start;
+    for (n = 0; n < count; n++) {
+        score(&f, &results[n]);
+    }
+    print(c->name, "goertzel", &g);
+    print("", "fft", &f);
+
+    goertzel->updates += g.updates;
+    goertzel->valid += g.valid;
+    goertzel->agree += g.agree;
+    goertzel->errorSum += g.errorSum;
+    goertzel->seconds += g.seconds;
+    fft->updates += f.updates;
+    fft->valid += f.valid;
+    fft->agree += f.agree;
+    fft->errorSum += f.errorSum;
+    fft->seconds += f.seconds;
+}
+
+int main(void) {
+    Score goertzel = {0}, fft = {0};
+    size_t i;
+
+    printf("%-11s %-8s %4s %8s %7s %8s %8s\n", "trace", "method", "upd", "valid", "mae",
+           "agree", "ns/upd");
+    for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        run(&cases[i], &goertzel, &fft);
+    }
+    print("all", "goertzel", &goertzel);
+    print("", "fft", &fft);
+    printf("state: goertzel %u bytes, fft %u bytes\n", (unsigned)sizeof(SpectralEstimator),
+           (unsigned)sizeof(FftEstimator));
+    return 0;
+}
@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+# Boot budget of the firmware: how many bytes cinit zeroes or copies before main(), taken
+# from the copy tables in the linker map, the time that costs at the reset clock and,
+# with --port, the stage times measured by the firmware (boot.h, CMD_GET_BOOT).
+#
+#   python3 tools/boot_report.py Debug/esr2024_g05_msp430pulseconverter.map
+#   python3 tools/boot_report.py Debug/esr2024_g05_msp430pulseconverter.map --port /dev/ttyUSB0
+#
+# The cycle costs per byte are estimates from the loops of the TI RTS (memset for
+# zero_init, the lzss and rle decoders, a plain copy otherwise); the measured time of the
+# main stage shows how close they are.
+
+import argparse
+import re
+import struct
+
+from trace_export import transact
+
+RESET_MCLK_HZ = 1000000             # DCOCLKDIV after reset, configureClock() runs later
+BOOT_TICK_HZ = 32768                # RTC on ACLK
+PRE_INIT_CYCLES = 40                # _c_int00 up to cinit and _system_pre_init()
+CYCLES_PER_BYTE = {"zero_init": 2, "lzss": 20, "rle": 8, "none": 4}
+
+CMD_GET_BOOT = 0x0D
+STAGES = ["main", "clock", "sampling", "first_sample", "deferred"]
+
+COPY_RECORD = re.compile(r"\s*(\S+): load addr=\w+, load size=(\w+) bytes, run addr=\w+, "
+                         r"run size=(\w+) bytes, compression=(\w+)")
+SECTION = re.compile(r"(\S+)?\s+0\s+([0-9a-f]{8})\s+([0-9a-f]{8})\s*(UNINITIALIZED)?\s*$")
+
+
+def parse_map(path):
+    records = []
+    sections = {}
+    name = None
+    with open(path) as f:
+        for line in f:
+            match = COPY_RECORD.match(line)
+            if match:
+                section, load, run, compression = match.groups()
+                records.append((section, int(load, 16), int(run, 16), compression))
+                continue
+            if re.match(r"^\.\S+\s*$", line):
+                name = line.strip()     # Long section name, the sizes follow on the next line
+                continue
+            match = SECTION.match(line)
+            if match and (match.group(1) or name):
+                section = match.group(1) if match.group(1) not in (None, "*") else name
+                if section and section.startswith("."):
+                    sections[section] = int(match.group(3), 16)
+            name = None
+    return records, sections
+
+
+def read_stages(port_name):
+    import serial
+
+    with serial.Serial(port_name, 9600, timeout=2) as port:
+        payload = transact(port, CMD_GET_BOOT, [])
+    return struct.unpack("<%dH" % len(STAGES), payload[:2 * len(STAGES)])
+
+
+def ms(cycles, hz):
+    return cycles * 1000.0 / hz
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("map", help="linker map file")
+    parser.add_argument("--port", help="read the stage times measured by the firmware")
+    args = parser.parse_args()
+
+    records, sections = parse_map(args.map)
+    print("%-12s %8s %8s  %s" % ("section", "bytes", "cycles", "cinit"))
+    cycles = PRE_INIT_CYCLES
+    zeroed = copied = 0
+    for section, load, run, compression in records:
+        cost = run * CYCLES_PER_BYTE.get(compression, CYCLES_PER_BYTE["none"])
+        cycles += cost
+        if compression == "zero_init":
+            zeroed += run
+        else:
+            copied += run
+        print("%-12s %8d %8d  %s, %d bytes stored" % (section, run, cost, compression, load))
+    noinit = sections.get(".TI.noinit", 0)
+    print("%-12s %8d %8d  left as found" % (".TI.noinit", noinit, 0))
+    print()
+    print("zeroed %d bytes, copied %d bytes, %d bytes skipped" % (zeroed, copied, noinit))
+    print("cinit model: %d cycles, %.2f ms at %.0f MHz (zeroing .TI.noinit would add %.2f ms)"
+          % (cycles, ms(cycles, RESET_MCLK_HZ), RESET_MCLK_HZ / 1e6,
+             ms(noinit * CYCLES_PER_BYTE["zero_init"], RESET_MCLK_HZ)))
+
+    if args.port:
+        ticks = read_stages(args.port)
+        print()
+        print("%-14s %10s %10s" % ("stage", "since reset", "step"))
+        last = 0
+        for name, tick in zip(STAGES, ticks):
+            if tick == 0:
+                print("%-14s %10s" % (name, "not reached"))
+                continue
+            print("%-14s %7.2f ms %7.2f ms" % (name, ms(tick, BOOT_TICK_HZ),
+                                               ms(tick - last, BOOT_TICK_HZ)))
+            last = tick
+
+
+if __name__ == "__main__":
+    main()
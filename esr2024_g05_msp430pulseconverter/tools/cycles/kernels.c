@@ -0,0 +1,357 @@
+//***************************************************************************************
+//  Zyklenmessung der Rechenkerne fuer den Befehlssatzsimulator (MSP430, msp430-gcc)
+//
+//  Beschreibung: Ruft die Rechenkerne der Firmware mit einem synthetischen Pulssignal
+//  auf und misst jeden Aufruf mit Timer_B0, der im Dauerlauf MCLK zaehlt. Im Simulator
+//  (mspdebug sim mit simuliertem Timer an der Adresse von TB0) sind das exakte
+//  Befehlszyklen, auf der Hardware laeuft dasselbe Programm unveraendert. Je Kern
+//  stehen Anzahl, Minimum, Maximum und Summe der Zyklen in kernelCycles[]; am Ende wird
+//  benchFinished() aufgerufen, auf das tools/cycles/run.py einen Haltepunkt setzt.
+//  Die Messung selbst (Timer lesen, Ueberlauf pruefen) wird vorab bestimmt und
+//  abgezogen.
+//***************************************************************************************
+
+#include <msp430.h>
+#include <stdint.h>
+
+#include "adc_correction.h"
+#include "biquad.h"
+#include "brightness.h"
+#include "config.h"
+#include "filter_tables.h"
+#include "hrv.h"
+#include "median.h"
+#include "pipeline.h"
+#include "pulse.h"
+#include "sample_queue.h"
+#include "signal_quality.h"
+#include "spectral.h"
+#include "synth.h"
+#include "tools/spectral_fft.h"
+
+#define BENCH_RATE_HZ       250
+#define BENCH_SAMPLES       3000        // 12 s: every spectral bank completes a window
+#define BEAT_SAMPLES        208         // 72 BPM at 250 Hz
+#define RISE_SAMPLES        30
+#define BASELINE            2200
+#define PULSE_AMPLITUDE     1400
+#define SYNTH_CALLS         1000
+#define MEDIAN_CALLS        500
+#define BLOCK_SAMPLES       32          // One SPI stream block
+#define BENCH_ADC_GAIN      0x8123      // Calibration values of a typical descriptor
+#define BENCH_ADC_OFFSET    (-3)
+#define BENCH_SUPPLY        0x7C20      // 3.2 V supply
+
+// Keep in sync with KERNELS in tools/cycles/run.py
+typedef enum {
+    KERNEL_SAMPLE_QUEUE = 0,        // ADC ISR: hand the sample to the main loop
+    KERNEL_ADC_CORRECT,             // ADC ISR: calibration of one sample
+    KERNEL_ADC_CORRECT_BLOCK,       // BLOCK_SAMPLES samples in place
+    KERNEL_BIQUAD,
+    KERNEL_PIPELINE,                // Whole per-sample path of takeSample()
+    KERNEL_SPECTRAL_POINT,          // Decimated value through the Goertzel banks
+    KERNEL_SPECTRAL_EVAL,           // Same, with a completed window evaluated
+    KERNEL_FFT_POINT,               // Decimated value into the ring of tools/spectral_fft.c
+    KERNEL_FFT_EVAL,                // Same, with the window transformed and evaluated
+    KERNEL_QUALITY_CHECK,
+    KERNEL_BRIGHTNESS,              // Envelope update
+    KERNEL_ACCEPT_BEAT,             // Interval and BPM divisions, median
+    KERNEL_HRV,
+    KERNEL_MEDIAN,                  // medianAdd() and medianGet() with MEDIAN_WINDOW values
+    KERNEL_MEDIAN_SORT,             // Same result by sorting a copy of the window
+    KERNEL_SYNTH,                   // Tone ISR: one DAC value
+    KERNEL_COUNT
+} Kernel;
+
+typedef struct {
+    uint32_t total;
+    uint16_t calls;
+    uint16_t min;
+    uint16_t max;
+} KernelCycles;
+
+volatile KernelCycles kernelCycles[KERNEL_COUNT];
+volatile uint16_t medianSink;           // Keeps the results of the median kernels alive
+
+static uint16_t overhead;
+static uint16_t lcg = 1;
+
+// Kept out of line so the debugger can stop on it
+void __attribute__((noinline)) benchFinished(void) {
+    __no_operation();
+}
+
+static void startTimer(void) {
+    TB0CTL = TBSSEL__SMCLK | ID__1 | MC__CONTINUOUS | TBCLR;
+}
+
+// Cycles since 'start', one counter wrap is detected through TBIFG
+static uint32_t elapsed(uint16_t start) {
+    uint16_t now = TB0R;
+    uint32_t cycles = (uint16_t)(now - start);
+
+    if (TB0CTL & TBIFG) {
+        TB0CTL &= ~TBIFG;
+        if (now >= start) {
+            cycles += 0x10000UL;
+        }
+    }
+    return cycles;
+}
+
+static void record(Kernel k, uint32_t cycles) {
+    volatile KernelCycles *c = &kernelCycles[k];
+
+    cycles = (cycles > overhead) ? cycles - overhead : 0;
+    if (cycles > 0xFFFF) {
+        cycles = 0xFFFF;
+    }
+    if (c->calls == 0 || cycles < c->min) {
+        c->min = (uint16_t)cycles;
+    }
+    if (cycles > c->max) {
+        c->max = (uint16_t)cycles;
+    }
+    c->total += cycles;
+    c->calls++;
+}
+
+// Sawtooth-like pulse: fast rise, slow fall, a little noise
+static uint16_t nextSample(uint16_t n) {
+    uint16_t phase = n % BEAT_SAMPLES;
+    int16_t value;
+
+    if (phase < RISE_SAMPLES) {
+        value = BASELINE + (int16_t)((int32_t)PULSE_AMPLITUDE * phase / RISE_SAMPLES);
+    } else {
+        value = BASELINE + PULSE_AMPLITUDE - (int16_t)((int32_t)PULSE_AMPLITUDE *
+                (phase - RISE_SAMPLES) / (BEAT_SAMPLES - RISE_SAMPLES));
+    }
+    lcg = lcg * 25173 + 13849;
+    return (uint16_t)(value + (int16_t)(lcg >> 12) - 8);
+}
+
+static void measureOverhead(void) {
+    uint16_t start = TB0R;
+
+    overhead = 0;
+    overhead = (uint16_t)elapsed(start);
+}
+
+// takeSample() as a whole, as the main loop runs it
+static void benchPipeline(const int16_t *coeffs) {
+    static Pipeline pp;
+    AdcCorrection correction;
+    uint16_t sample;
+    uint16_t start;
+    uint16_t n;
+
+    pipelineInit(&pp, BENCH_RATE_HZ, coeffs);
+    adcCorrectionInit(&correction, BENCH_ADC_GAIN, BENCH_ADC_OFFSET, BENCH_SUPPLY);
+    for (n = 0; n < BENCH_SAMPLES; n++) {
+        sample = nextSample(n);
+        start = TB0R;
+        sample = adcCorrect(&correction, sample);
+        record(KERNEL_ADC_CORRECT, elapsed(start));
+
+        start = TB0R;
+        sampleQueuePush(sample);
+        record(KERNEL_SAMPLE_QUEUE, elapsed(start));
+        sampleQueuePop(&sample);
+
+        start = TB0R;
+        pipelineStep(&pp, sample, DEFAULT_THRESHOLD_ON, DEFAULT_THRESHOLD_OFF,
+                     DEFAULT_QUALITY_MIN);
+        record(KERNEL_PIPELINE, elapsed(start));
+    }
+}
+
+// The stages of pipelineStep() one by one, in its order and with its state
+static void benchStages(const int16_t *coeffs) {
+    static BiquadState filter;
+    static SignalQuality quality;
+    static SpectralEstimator spectral;
+    static BrightnessTracker brightness;
+    static PulseDetector pulse;
+    static HrvWindow hrv;
+    uint16_t start;
+    uint32_t cycles;
+    int16_t filtered;
+    uint8_t done;
+    uint16_t n;
+
+    biquadReset(&filter, BASELINE);
+    signalQualityInit(&quality, BENCH_RATE_HZ);
+    spectralInit(&spectral, BENCH_RATE_HZ);
+    brightnessInit(&brightness, BENCH_RATE_HZ);
+    pulseInit(&pulse, BENCH_RATE_HZ);
+    hrvInit(&hrv, HRV_SHORT_WINDOW_S);
+
+    for (n = 0; n < BENCH_SAMPLES; n++) {
+        start = TB0R;
+        filtered = biquadStep(&filter, coeffs, (int16_t)nextSample(n));
+        record(KERNEL_BIQUAD, elapsed(start));
+
+        signalQualityPush(&quality, filtered);
+
+        start = TB0R;
+        done = spectralProcess(&spectral, filtered);
+        cycles = elapsed(start);
+        if (done) {
+            record(KERNEL_SPECTRAL_EVAL, cycles);
+        } else if (spectral.stepCount == spectral.step) {
+            record(KERNEL_SPECTRAL_POINT, cycles);
+        }
+
+        start = TB0R;
+        done = brightnessPush(&brightness, filtered);
+        cycles = elapsed(start);
+        if (done) {
+            record(KERNEL_BRIGHTNESS, cycles);
+        }
+
+        if (!pulseProcess(&pulse, filtered, DEFAULT_THRESHOLD_ON, DEFAULT_THRESHOLD_OFF)) {
+            continue;
+        }
+        start = TB0R;
+        done = signalQualityCheckBeat(&quality, DEFAULT_QUALITY_MIN);
+        record(KERNEL_QUALITY_CHECK, elapsed(start));
+        if (!done) {
+            continue;
+        }
+        start = TB0R;
+        done = pulseAcceptBeat(&pulse);
+        record(KERNEL_ACCEPT_BEAT, elapsed(start));
+        if (done) {
+            start = TB0R;
+            hrvAddIbi(&hrv, pulse.ibiMs);
+            record(KERNEL_HRV, elapsed(start));
+        }
+    }
+}
+
+// The FFT variant of the spectral estimator on the same filtered signal, for comparison
+static void benchSpectralFft(const int16_t *coeffs) {
+    static BiquadState filter;
+    static FftEstimator fft;
+    uint16_t start;
+    uint32_t cycles;
+    int16_t filtered;
+    uint8_t done;
+    uint16_t n;
+
+    biquadReset(&filter, BASELINE);
+    fftEstimatorInit(&fft, BENCH_RATE_HZ);
+    for (n = 0; n < BENCH_SAMPLES; n++) {
+        filtered = biquadStep(&filter, coeffs, (int16_t)nextSample(n));
+        start = TB0R;
+        done = fftEstimatorProcess(&fft, filtered);
+        cycles = elapsed(start);
+        if (done) {
+            record(KERNEL_FFT_EVAL, cycles);
+        } else if (fft.stepCount == fft.step) {
+            record(KERNEL_FFT_POINT, cycles);
+        }
+    }
+}
+
+// Insertion sort of a copy of the window on every value, the simple alternative to
+// median.c
+static uint16_t sortedMedian(const uint16_t *ring, uint8_t count) {
+    static uint16_t work[MEDIAN_WINDOW];
+    uint16_t value;
+    uint8_t i, j;
+
+    for (i = 0; i < count; i++) {
+        value = ring[i];
+        for (j = i; j > 0 && work[j - 1] > value; j--) {
+            work[j] = work[j - 1];
+        }
+        work[j] = value;
+    }
+    return work[(count - 1) >> 1];
+}
+
+// Intervals of 600..1111 ms in random order, the window is full after MEDIAN_WINDOW calls
+static void benchMedian(void) {
+    static MedianWindow window;
+    static uint16_t ring[MEDIAN_WINDOW];
+    uint8_t head = 0;
+    uint8_t count = 0;
+    uint16_t start;
+    uint16_t value;
+    uint16_t n;
+
+    medianInit(&window);
+    for (n = 0; n < MEDIAN_CALLS; n++) {
+        lcg = lcg * 25173 + 13849;
+        value = 600 + (lcg >> 7);
+
+        start = TB0R;
+        medianAdd(&window, value);
+        medianSink = medianGet(&window);
+        record(KERNEL_MEDIAN, elapsed(start));
+
+        start = TB0R;
+        ring[head] = value;
+        if (++head == MEDIAN_WINDOW) {
+            head = 0;
+        }
+        if (count < MEDIAN_WINDOW) {
+            count++;
+        }
+        medianSink = sortedMedian(ring, count);
+        record(KERNEL_MEDIAN_SORT, elapsed(start));
+    }
+}
+
+static void benchCorrectBlock(void) {
+    static uint16_t block[BLOCK_SAMPLES];
+    AdcCorrection correction;
+    uint16_t start;
+    uint16_t n;
+    uint16_t i;
+
+    adcCorrectionInit(&correction, BENCH_ADC_GAIN, BENCH_ADC_OFFSET, BENCH_SUPPLY);
+    for (n = 0; n < BENCH_SAMPLES; n += BLOCK_SAMPLES) {
+        for (i = 0; i < BLOCK_SAMPLES; i++) {
+            block[i] = nextSample(n + i);
+        }
+        start = TB0R;
+        adcCorrectBlock(&correction, block, BLOCK_SAMPLES);
+        record(KERNEL_ADC_CORRECT_BLOCK, elapsed(start));
+    }
+}
+
+static void benchSynth(void) {
+    static Synth synth;
+    uint16_t start;
+    uint16_t n;
+
+    synthInit(&synth, 16000);
+    synthNoteOn(&synth, 2000, 5);
+    for (n = 0; n < SYNTH_CALLS; n++) {
+        start = TB0R;
+        synthNext(&synth);
+        record(KERNEL_SYNTH, elapsed(start));
+    }
+}
+
+int main(void) {
+    const int16_t *coeffs = filterTableForRate(BENCH_RATE_HZ)->coeffs;
+
+    WDTCTL = WDTPW | WDTHOLD;
+    startTimer();
+    measureOverhead();
+
+    benchPipeline(coeffs);
+    benchStages(coeffs);
+    benchSpectralFft(coeffs);
+    benchMedian();
+    benchCorrectBlock();
+    benchSynth();
+
+    benchFinished();
+    for (;;) {
+    }
+}
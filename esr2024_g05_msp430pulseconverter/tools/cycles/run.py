@@ -0,0 +1,188 @@
+#!/usr/bin/env python3
+# Cycle counts of the firmware kernels in an MSP430 instruction set simulator.
+# Cross-compiles tools/cycles/kernels.c together with the processing modules with
+# msp430-elf-gcc, runs it in mspdebug's simulator up to benchFinished() and reads
+# kernelCycles[] back. Prints cycles per call, the time at 1, 8 and 24 MHz and the CPU
+# share of the per-sample path at every supported sample rate. With --costs it prints
+# the cost lines for tools/golden/manifest.txt instead. With --median-windows it builds
+# once per window size (-DMEDIAN_WINDOW) and compares median.c with sorting the window.
+#
+#   python3 tools/cycles/run.py [--support DIR] [--hwmult f5series|none] [--costs]
+#   python3 tools/cycles/run.py [--support DIR] --median-windows 8,16,32,64
+#
+# Run from the project directory. The simulated Timer_A of mspdebug is mapped onto the
+# address of TB0 and counts MCLK, which is the instruction cycle count of the simulator.
+
+import argparse
+import os
+import re
+import struct
+import subprocess
+import sys
+import tempfile
+
+SOURCES = ("tools/cycles/kernels.c", "pipeline.c", "biquad.c", "pulse.c", "median.c",
+           "signal_quality.c", "spectral.c", "brightness.c", "hrv.c", "filter_tables.c",
+           "sample_queue.c", "synth.c", "adc_correction.c", "tools/spectral_fft.c")
+
+# Same order as the Kernel enum in kernels.c
+KERNELS = ("sample_queue", "adc_correct", "adc_correct_block", "biquad", "pipeline", "spectral_point", "spectral_eval",
+           "fft_point", "fft_eval", "quality_check", "brightness", "accept_beat", "hrv", "median", "median_sort", "synth")
+ENTRY = struct.Struct("<IHHH")      # KernelCycles: total, calls, min, max
+
+CLOCKS_HZ = (1000000, 8000000, 24000000)
+SAMPLE_RATES_HZ = (125, 250, 500, 1000)
+SYNTH_RATE_HZ = 16000
+BLOCK_SAMPLES = 32                  # Same as in kernels.c
+SPECTRAL_WINDOW = 200               # Same as in spectral.h
+ISR_OVERHEAD = 11                   # Interrupt acceptance (6) and RETI (5), MSP430X CPU
+
+SIM_COMMANDS = (
+    "simio add timer tb0",
+    "simio config tb0 base 0x0380",
+    "prog {elf}",
+    "setbreak benchFinished",
+    "run",
+    "md kernelCycles %d" % (len(KERNELS) * ENTRY.size),
+)
+
+
+def build(args, elf, defines=()):
+    cmd = [args.cc, "-mmcu=msp430fr2355", "-mhwmult=" + args.hwmult, "-O2", "-I."]
+    cmd += ["-D" + d for d in defines]
+    if args.support:
+        cmd += ["-I" + args.support, "-L" + args.support]
+    cmd += ["-o", elf] + list(SOURCES)
+    subprocess.run(cmd, check=True)
+
+
+def simulate(args, elf):
+    commands = [c.format(elf=elf) for c in SIM_COMMANDS]
+    result = subprocess.run([args.mspdebug, "-q", "sim"] + commands, check=True,
+                            stdout=subprocess.PIPE, universal_newlines=True)
+    return result.stdout
+
+
+def parse_dump(text):
+    # md lines: "    02000: 12 34 56 ... |ascii|"
+    data = bytearray()
+    for line in text.splitlines():
+        match = re.match(r"\s*[0-9a-fA-F]+:\s+((?:[0-9a-fA-F]{2}\s+)+)", line)
+        if match:
+            data += bytes(int(b, 16) for b in match.group(1).split())
+    if len(data) < len(KERNELS) * ENTRY.size:
+        sys.exit("no kernelCycles dump in the simulator output:\n" + text)
+    results = {}
+    for i, name in enumerate(KERNELS):
+        total, calls, low, high = ENTRY.unpack_from(data, i * ENTRY.size)
+        if calls:
+            results[name] = (calls, low, total / calls, high)
+    return results
+
+
+def report(results):
+    print("%-16s %6s %7s %9s %7s   %s" % ("kernel", "calls", "min", "mean", "max",
+                                           "us at " + "/".join("%d" % (c // 1000000)
+                                                              for c in CLOCKS_HZ) + " MHz"))
+    for name in KERNELS:
+        if name not in results:
+            print("%-16s      0" % name)
+            continue
+        calls, low, mean, high = results[name]
+        times = "/".join("%.1f" % (mean * 1e6 / c) for c in CLOCKS_HZ)
+        print("%-16s %6d %7d %9.1f %7d   %s" % (name, calls, low, mean, high, times))
+
+    if "adc_correct_block" in results:
+        print("%-16s %16.1f cycles per sample in blocks of %d" %
+              ("", results["adc_correct_block"][2] / BLOCK_SAMPLES, BLOCK_SAMPLES))
+
+    if "spectral_eval" in results and "fft_eval" in results:
+        # One spectral result every half window, one of those values completes it
+        values = SPECTRAL_WINDOW // 2
+        goertzel = (values - 1) * results["spectral_point"][2] + results["spectral_eval"][2]
+        fft = (values - 1) * results["fft_point"][2] + results["fft_eval"][2]
+        print("%-16s %16.0f cycles per result, fft %.0f" % ("spectral", goertzel, fft))
+
+    # Per-sample budget: the main loop runs the pipeline once per sample, the ADC ISR
+    # corrects and queues it; the synth ISR runs at its own rate while a tone sounds
+    isr = results["sample_queue"][2] + results["adc_correct"][2] + ISR_OVERHEAD
+    sample = results["pipeline"][2] + isr
+    worst = (results["pipeline"][3] + results["sample_queue"][3] + results["adc_correct"][3] +
+             ISR_OVERHEAD)
+    synth = results["synth"][2] + ISR_OVERHEAD
+    print()
+    print("CPU share of sampling and processing (mean), worst sample against one period")
+    for clock in CLOCKS_HZ:
+        shares = []
+        for rate in SAMPLE_RATES_HZ:
+            budget = clock / rate
+            shares.append("%d Hz %5.1f %% (worst %5.1f %%)" %
+                          (rate, 100 * sample / budget, 100 * worst / budget))
+        print("%2d MHz: %s" % (clock // 1000000, ", ".join(shares)))
+        print("        tone: %.1f %%" % (100 * synth * SYNTH_RATE_HZ / clock))
+
+
+def costs(results):
+    mean = {name: r[2] for name, r in results.items()}
+    lines = (
+        # Quiet sample: fastest pipeline pass plus the ADC ISR that corrected and queued it
+        ("sample", results["pipeline"][1] + mean["sample_queue"] + mean["adc_correct"] +
+         ISR_OVERHEAD),
+        ("spectral_point", mean.get("spectral_point", 0)),
+        ("spectral_eval", mean.get("spectral_eval", 0) - mean.get("spectral_point", 0)),
+        ("quality_check", mean.get("quality_check", 0)),
+        ("level", mean.get("brightness", 0)),
+        ("beat", mean.get("accept_beat", 0) + 2 * mean.get("hrv", 0)),
+    )
+    for name, cycles in lines:
+        print("cost %-16s %d" % (name, round(cycles)))
+
+
+def median_windows(args, sizes):
+    print("%6s %12s %12s %7s" % ("window", "median.c", "sort", "ratio"))
+    with tempfile.TemporaryDirectory() as tmp:
+        for size in sizes:
+            elf = os.path.join(tmp, "kernels_%d.elf" % size)
+            build(args, elf, ["MEDIAN_WINDOW=%d" % size])
+            results = parse_dump(simulate(args, elf))
+            median = results["median"][2]
+            naive = results["median_sort"][2]
+            print("%6d %12.1f %12.1f %6.1fx" % (size, median, naive, naive / median))
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--cc", default="msp430-elf-gcc")
+    parser.add_argument("--mspdebug", default="mspdebug")
+    parser.add_argument("--support", help="directory with msp430fr2355.h and .ld")
+    parser.add_argument("--hwmult", default="f5series",
+                        help="f5series (MPY32 as on the device) or none (upper bound if "
+                             "the simulator has no MPY32 model)")
+    parser.add_argument("--costs", action="store_true",
+                        help="print cost lines for tools/golden/manifest.txt")
+    parser.add_argument("--median-windows", metavar="N,N,...",
+                        help="cycles of median.c against sorting for these window sizes")
+    args = parser.parse_args()
+
+    if args.median_windows:
+        try:
+            median_windows(args, [int(n) for n in args.median_windows.split(",")])
+        except FileNotFoundError as e:
+            sys.exit("%s not found, see --cc and --mspdebug" % e.filename)
+        return
+
+    with tempfile.TemporaryDirectory() as tmp:
+        elf = os.path.join(tmp, "kernels.elf")
+        try:
+            build(args, elf)
+            results = parse_dump(simulate(args, elf))
+        except FileNotFoundError as e:
+            sys.exit("%s not found, see --cc and --mspdebug" % e.filename)
+    if args.costs:
+        costs(results)
+    else:
+        report(results)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,118 @@
+#!/usr/bin/env python3
+# Generates filter_tables.c: the Q14 biquad coefficients of the pulse filter for every
+# supported sample rate. Each quantised set is checked against the specification before
+# anything is written, a violation aborts the generator.
+#
+#   python3 tools/gen_filter_tables.py > filter_tables.c
+
+import cmath
+import math
+import sys
+
+RATES_HZ = (125, 250, 500, 1000)      # Keep FILTER_TABLE_COUNT in filter_tables.h in sync
+CUTOFF_HZ = 10.0
+Q14 = 1 << 14
+
+# Specification of the quantised filter
+CUTOFF_TOLERANCE = 0.05         # -3 dB point within 5 % of CUTOFF_HZ
+STOPBAND_HZ = 50.0              # Mains hum
+STOPBAND_MIN_DB = 25.0
+MAX_POLE_RADIUS = 0.999
+
+
+def butterworth(rate):
+    # Second order Butterworth low pass by the bilinear transform
+    k = math.tan(math.pi * CUTOFF_HZ / rate)
+    q = 1.0 / math.sqrt(2.0)
+    norm = 1.0 / (1.0 + k / q + k * k)
+    b0 = k * k * norm
+    a1 = 2.0 * (k * k - 1.0) * norm
+    a2 = (1.0 - k / q + k * k) * norm
+    return b0, 2.0 * b0, b0, a1, a2
+
+
+def quantise(coeffs):
+    b0, _, b2, a1, a2 = [int(round(c * Q14)) for c in coeffs]
+    # Trim b1 so the DC gain is exactly 1 and the thresholds keep their meaning
+    b1 = Q14 + a1 + a2 - b0 - b2
+    return b0, b1, b2, a1, a2
+
+
+def gain_db(q, rate, freq):
+    b0, b1, b2, a1, a2 = [c / Q14 for c in q]
+    z = cmath.exp(-2j * math.pi * freq / rate)
+    h = (b0 + b1 * z + b2 * z * z) / (1.0 + a1 * z + a2 * z * z)
+    return 20.0 * math.log10(abs(h))
+
+
+def cutoff_hz(q, rate):
+    lo, hi = 0.0, rate / 2.0
+    for _ in range(60):
+        mid = (lo + hi) / 2.0
+        if gain_db(q, rate, mid) > -3.0103:
+            lo = mid
+        else:
+            hi = mid
+    return lo
+
+
+def check(q, rate):
+    errors = []
+    b0, b1, b2, a1, a2 = q
+    if any(c < -32768 or c > 32767 for c in q):
+        errors.append("coefficient out of int16 range")
+    if b0 + b1 + b2 != Q14 + a1 + a2:
+        errors.append("DC gain is not 1")
+    disc = (a1 / Q14) ** 2 - 4.0 * (a2 / Q14)
+    roots = [(-(a1 / Q14) + s * cmath.sqrt(disc)) / 2.0 for s in (1, -1)]
+    if max(abs(r) for r in roots) > MAX_POLE_RADIUS:
+        errors.append("pole radius above %.3f" % MAX_POLE_RADIUS)
+    fc = cutoff_hz(q, rate)
+    if abs(fc - CUTOFF_HZ) > CUTOFF_TOLERANCE * CUTOFF_HZ:
+        errors.append("cutoff %.2f Hz" % fc)
+    stop = -gain_db(q, rate, STOPBAND_HZ)
+    if stop < STOPBAND_MIN_DB:
+        errors.append("%.1f dB at %.0f Hz" % (stop, STOPBAND_HZ))
+    for e in errors:
+        sys.stderr.write("%d Hz: %s\n" % (rate, e))
+    return not errors, fc, stop
+
+
+def main():
+    rows = []
+    ok = True
+    for rate in RATES_HZ:
+        q = quantise(butterworth(rate))
+        passed, fc, stop = check(q, rate)
+        ok = ok and passed
+        rows.append((rate, q, fc, stop))
+    if not ok:
+        sys.exit(1)
+
+    out = sys.stdout
+    out.write("//" + "*" * 87 + "\n")
+    out.write("//  Filterkoeffizienten je Abtastrate\n")
+    out.write("//\n")
+    out.write("//  Erzeugt von tools/gen_filter_tables.py, nicht von Hand aendern.\n")
+    out.write("//" + "*" * 87 + "\n\n")
+    out.write('#include "filter_tables.h"\n\n')
+    out.write("// %.0f Hz Butterworth low pass, b1 trimmed for a DC gain of exactly 1\n" % CUTOFF_HZ)
+    out.write("const FilterTable filterTables[FILTER_TABLE_COUNT] = {\n")
+    for i, (rate, q, fc, stop) in enumerate(rows):
+        sep = "," if i < len(rows) - 1 else " "
+        entry = "    { %4d, { %s } }%s" % (rate, ", ".join("%d" % c for c in q), sep)
+        out.write("%-48s// -3 dB at %.2f Hz, -%.1f dB at %.0f Hz\n" % (entry, fc, stop, STOPBAND_HZ))
+    out.write("};\n\n")
+    out.write("const FilterTable *filterTableForRate(uint16_t sampleRateHz) {\n")
+    out.write("    uint8_t i;\n\n")
+    out.write("    for (i = 0; i < FILTER_TABLE_COUNT; i++) {\n")
+    out.write("        if (filterTables[i].sampleRateHz == sampleRateHz) {\n")
+    out.write("            return &filterTables[i];\n")
+    out.write("        }\n")
+    out.write("    }\n")
+    out.write("    return 0;\n")
+    out.write("}\n")
+
+
+if __name__ == "__main__":
+    main()
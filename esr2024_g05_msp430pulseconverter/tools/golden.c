@@ -0,0 +1,847 @@
+//***************************************************************************************
+//  Referenzdatensatz: Genauigkeit und Aufwand der Verarbeitungskette (Host)
+//
+//  Beschreibung: Schickt die Referenzkurven aus tools/golden/manifest.txt (synthetische
+//  Kurven aus ppg_synth.c und Aufzeichnungen mit annotierten Schlaegen) durch
+//  pipeline.c, also genau den Code der Firmware, und bestimmt je Kurve Sensitivitaet und
+//  positiven Vorhersagewert der Schlagerkennung, mittleren absoluten BPM-Fehler, Host-
+//  Laufzeit in ns pro Abtastwert, geschaetzte MSP430-Zyklen pro Abtastwert und die
+//  mittlere Stromaufnahme. Die Zyklen ergeben sich aus den gezaehlten
+//  Verarbeitungsschritten und den Kosten je Schritt im Manifest. Diese Kosten sind aus
+//  dem Code geschaetzt, solange tools/cycles/run.py ohne Simulator nicht messen kann;
+//  Zyklen und der daraus folgende Strom heissen deshalb im Bericht, in der Referenz und
+//  in der Ausgabe est_cycles_per_sample und est_avg_ua. Der Strom kommt aus
+//  energy.c, gespeist mit den Zeiten, die power.c auf dem Geraet bucht: aktiv fuer die
+//  Zyklen, sonst LPM0, ADC je Abtastwert, LEDs und Piezo nach dem Muster der Alarmzone
+//  (alarm.c) und den Klicks je Schlag. Der Bericht ist eine CSV-Datei; mit -b wird er
+//  gegen einen frueheren Bericht geprueft und das Programm endet mit 1, wenn eine
+//  Kennzahl um mehr als ihre Toleranz schlechter geworden ist. Unabhaengig davon endet
+//  es mit 1, wenn eine Kurve unter einem Mindestwert aus dem Manifest liegt.
+//
+//  Uebersetzen (Linux, im Projektverzeichnis):
+//    gcc -O2 -std=c99 -I. -o golden tools/golden.c tools/ppg_synth.c tools/trace_io.c
+//        pipeline.c biquad.c pulse.c median.c signal_quality.c spectral.c brightness.c
+//        hrv.c filter_tables.c alarm.c energy.c -lm
+//
+//  Aufruf:
+//    golden [-m manifest] [-b baseline.csv] [-o report.csv] [-t name=toleranz]...
+//***************************************************************************************
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "alarm.h"
+#include "config.h"
+#include "energy.h"
+#include "filter_tables.h"
+#include "output.h"
+#include "pipeline.h"
+#include "ppg_synth.h"
+#include "system.h"
+#include "trace_io.h"
+
+#define DEFAULT_MANIFEST    "tools/golden/manifest.txt"
+#define MAX_TRACES          64
+#define MAX_LINE            1024
+#define MATCH_WINDOW_S      0.15    // Detection within this of the annotation (as EC57)
+#define LAG_SEARCH_S        0.5     // Detector lag is estimated from offsets below this
+#define TIMING_MIN_S        0.2     // Host timing: repeat until this much time is spent
+#define TIMING_MIN_RUNS     3
+
+typedef enum {
+    TRACE_SYNTH = 0,
+    TRACE_FILE
+} TraceKind;
+
+typedef struct {
+    char           name[64];
+    TraceKind      kind;
+    double         durationS;       // Synthetic traces
+    PpgSynthParams params;
+    char          *path;            // Recordings: samples and annotated beat times
+    char          *truthPath;
+    uint16_t       sampleRateHz;
+} TraceSpec;
+
+// Processing steps counted for the cycle estimate
+typedef enum {
+    COST_SAMPLE = 0,                // pipelineStep() without the steps below
+    COST_SPECTRAL_POINT,            // Decimated value through the Goertzel banks
+    COST_SPECTRAL_EVAL,             // Spectrum evaluation at the end of a window
+    COST_QUALITY_CHECK,             // Beat candidate compared with the template
+    COST_LEVEL,                     // Brightness envelope update
+    COST_BEAT,                      // Accepted beat: interval, median, HRV
+    COST_COUNT
+} CostStep;
+
+static const char *const costNames[COST_COUNT] = {
+    "sample", "spectral_point", "spectral_eval", "quality_check", "level", "beat"
+};
+
+typedef struct {
+    char     name[64];
+    uint16_t sampleRateHz;
+    uint64_t samples;
+    uint32_t truthBeats;
+    uint32_t detected;
+    uint32_t matched;
+    double   sensitivity;
+    double   ppv;
+    double   bpmMae;
+    double   bpmCoverage;           // Share of seconds with a valid BPM
+    double   nsPerSample;
+    double   cyclesPerSample;       // From the estimated costs in the manifest
+    double   averageUa;             // Modelled mean supply current, from the same costs
+} Result;
+
+// Report columns that can be held to a tolerance against the baseline
+typedef enum {
+    WORSE_IF_LOWER = 0,             // Absolute drop
+    WORSE_IF_HIGHER,                // Absolute rise
+    WORSE_IF_GROWS                  // Relative rise
+} Direction;
+
+static struct {
+    const char *name;
+    size_t      offset;
+    Direction   direction;
+    double      tolerance;          // Negative: not checked
+    double      minimum;            // Floor for every trace, negative: none
+} metrics[] = {
+    { "sensitivity",           offsetof(Result, sensitivity),     WORSE_IF_LOWER,  -1.0, -1.0 },
+    { "ppv",                   offsetof(Result, ppv),             WORSE_IF_LOWER,  -1.0, -1.0 },
+    { "bpm_mae",               offsetof(Result, bpmMae),          WORSE_IF_HIGHER, -1.0, -1.0 },
+    { "bpm_coverage",          offsetof(Result, bpmCoverage),     WORSE_IF_LOWER,  -1.0, -1.0 },
+    { "ns_per_sample",         offsetof(Result, nsPerSample),     WORSE_IF_GROWS,  -1.0, -1.0 },
+    { "est_cycles_per_sample", offsetof(Result, cyclesPerSample), WORSE_IF_GROWS,  -1.0, -1.0 },
+    { "est_avg_ua",            offsetof(Result, averageUa),       WORSE_IF_GROWS,  -1.0, -1.0 },
+};
+
+#define METRIC_COUNT    (sizeof(metrics) / sizeof(metrics[0]))
+
+static TraceSpec traces[MAX_TRACES];
+static size_t traceCount;
+static double costCycles[COST_COUNT];
+static Result results[MAX_TRACES];
+
+static double seconds(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double *metricOf(Result *r, size_t m) {
+    return (double *)((char *)r + metrics[m].offset);
+}
+
+static int setTolerance(const char *name, double value) {
+    size_t m;
+
+    for (m = 0; m < METRIC_COUNT; m++) {
+        if (strcmp(name, metrics[m].name) == 0) {
+            metrics[m].tolerance = value;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Only for the metrics where lower is worse
+static int setMinimum(const char *name, double value) {
+    size_t m;
+
+    for (m = 0; m < METRIC_COUNT; m++) {
+        if (strcmp(name, metrics[m].name) == 0 && metrics[m].direction == WORSE_IF_LOWER) {
+            metrics[m].minimum = value;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Relative paths in the manifest are taken from its directory
+static char *resolvePath(const char *manifest, const char *path) {
+    const char *slash = strrchr(manifest, '/');
+    size_t dirLength = (slash != NULL) ? (size_t)(slash - manifest) + 1 : 0;
+    char *full;
+
+    if (path[0] == '/' || dirLength == 0) {
+        return strdup(path);
+    }
+    full = malloc(dirLength + strlen(path) + 1);
+    if (full != NULL) {
+        memcpy(full, manifest, dirLength);
+        strcpy(full + dirLength, path);
+    }
+    return full;
+}
+
+// Manifest lines (# starts a comment):
+//   synth <name> <seconds> [key=value]...       ppg_synth parameters, see ppg_synth.c
+//   file <name> <samples> <beats.csv> <rate>    recording, beat times in s in column 1
+//   cost <step> <cycles>                        estimated MSP430 cycles per step
+//   tolerance <metric> <value>                  allowed change against the baseline
+//   minimum <metric> <value>                    floor for every trace, baseline or not
+static int readManifest(const char *path) {
+    FILE *f = fopen(path, "r");
+    const char *error = NULL;
+    char text[MAX_LINE];
+    char *word[32];
+    unsigned line = 0;
+    unsigned words;
+    unsigned i;
+    TraceSpec *t;
+    char *equals;
+    char *hash;
+
+    if (f == NULL) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return 0;
+    }
+    while (error == NULL && fgets(text, sizeof(text), f) != NULL) {
+        line++;
+        hash = strchr(text, '#');
+        if (hash != NULL) {
+            *hash = '\0';
+        }
+        words = 0;
+        for (word[0] = strtok(text, " \t\r\n"); word[words] != NULL && words < 31;
+             word[words] = strtok(NULL, " \t\r\n")) {
+            words++;
+        }
+        if (words == 0) {
+            continue;
+        }
+
+        if (strcmp(word[0], "cost") == 0 && words == 3) {
+            for (i = 0; i < COST_COUNT && strcmp(word[1], costNames[i]) != 0; i++) {
+            }
+            if (i == COST_COUNT) {
+                error = "unknown cost step";
+            } else {
+                costCycles[i] = atof(word[2]);
+            }
+        } else if (strcmp(word[0], "tolerance") == 0 && words == 3) {
+            if (!setTolerance(word[1], atof(word[2]))) {
+                error = "unknown metric";
+            }
+        } else if (strcmp(word[0], "minimum") == 0 && words == 3) {
+            if (!setMinimum(word[1], atof(word[2]))) {
+                error = "no minimum for this metric";
+            }
+        } else if ((strcmp(word[0], "synth") == 0 && words >= 3) ||
+                   (strcmp(word[0], "file") == 0 && words == 5)) {
+            if (traceCount == MAX_TRACES) {
+                error = "too many traces";
+                break;
+            }
+            t = &traces[traceCount];
+            memset(t, 0, sizeof(*t));
+            snprintf(t->name, sizeof(t->name), "%s", word[1]);
+            if (word[0][0] == 's') {
+                t->kind = TRACE_SYNTH;
+                t->durationS = atof(word[2]);
+                ppgSynthDefaults(&t->params);
+                for (i = 3; i < words && error == NULL; i++) {
+                    equals = strchr(word[i], '=');
+                    if (equals == NULL) {
+                        error = "expected key=value";
+                    } else {
+                        *equals = '\0';
+                        if (!ppgSynthSetParam(&t->params, word[i], atof(equals + 1))) {
+                            error = "unknown synth parameter";
+                        }
+                    }
+                }
+                t->sampleRateHz = (uint16_t)t->params.sampleRateHz;
+            } else {
+                t->kind = TRACE_FILE;
+                t->path = resolvePath(path, word[2]);
+                t->truthPath = resolvePath(path, word[3]);
+                t->sampleRateHz = (uint16_t)atoi(word[4]);
+            }
+            if (error == NULL && filterTableForRate(t->sampleRateHz) == 0) {
+                error = "unsupported sample rate";
+            }
+            traceCount++;
+        } else {
+            error = "syntax error";
+        }
+    }
+    fclose(f);
+    if (error != NULL) {
+        fprintf(stderr, "%s:%u: %s\n", path, line, error);
+        return 0;
+    }
+    return 1;
+}
+
+// Beat times in seconds from the first column of a CSV, lines without a number skipped
+static int readTruth(const char *path, double **times, size_t *count) {
+    FILE *f = fopen(path, "r");
+    char text[MAX_LINE];
+    double *list = NULL;
+    double *grown;
+    size_t capacity = 0;
+    size_t n = 0;
+    char *end;
+    double t;
+
+    if (f == NULL) {
+        return 0;
+    }
+    while (fgets(text, sizeof(text), f) != NULL) {
+        t = strtod(text, &end);
+        if (end == text) {
+            continue;
+        }
+        if (n == capacity) {
+            capacity = capacity ? 2 * capacity : 1024;
+            grown = realloc(list, capacity * sizeof(double));
+            if (grown == NULL) {
+                free(list);
+                fclose(f);
+                errno = ENOMEM;
+                return 0;
+            }
+            list = grown;
+        }
+        list[n++] = t;
+    }
+    fclose(f);
+    *times = list;
+    *count = n;
+    return 1;
+}
+
+static int loadSynth(const TraceSpec *t, uint16_t **samples, size_t *count, double **times,
+                     size_t *beatCount) {
+    static PpgSynth gen;
+    size_t n = (size_t)(t->durationS * t->sampleRateHz);
+    // At most one peak per MIN_BEAT_S (0.25 s) of ppg_synth, with room to spare
+    size_t maxBeats = (size_t)(t->durationS * 4.0) + 16;
+    PpgBeat *beats = malloc(maxBeats * sizeof(PpgBeat));
+    size_t i;
+
+    *samples = malloc((n + 1) * sizeof(uint16_t));
+    *times = malloc(maxBeats * sizeof(double));
+    if (beats == NULL || *samples == NULL || *times == NULL) {
+        free(beats);
+        free(*samples);
+        free(*times);
+        errno = ENOMEM;
+        return 0;
+    }
+    ppgSynthInit(&gen, &t->params);
+    *beatCount = ppgSynthGenerate(&gen, *samples, n, beats, maxBeats);
+    for (i = 0; i < *beatCount; i++) {
+        (*times)[i] = beats[i].timeS;
+    }
+    *count = n;
+    free(beats);
+    return 1;
+}
+
+static int compareDoubles(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+// The detector fires on the rising edge behind the filter, some time before or after the
+// annotated peak. That offset is constant for a trace, it is taken as the median offset
+// to the nearest annotation so only the beat to beat jitter counts against the window.
+static double detectorLag(const double *detected, size_t n, const double *truth, size_t m) {
+    double *offsets = malloc((n + 1) * sizeof(double));
+    size_t used = 0;
+    size_t j = 0;
+    size_t i;
+    double d, lag = 0.0;
+
+    if (offsets == NULL || m == 0) {
+        free(offsets);
+        return 0.0;
+    }
+    for (i = 0; i < n; i++) {
+        while (j + 1 < m && fabs(truth[j + 1] - detected[i]) <= fabs(truth[j] - detected[i])) {
+            j++;
+        }
+        d = detected[i] - truth[j];
+        if (fabs(d) < LAG_SEARCH_S) {
+            offsets[used++] = d;
+        }
+    }
+    if (used > 0) {
+        qsort(offsets, used, sizeof(double), compareDoubles);
+        lag = offsets[used / 2];
+    }
+    free(offsets);
+    return lag;
+}
+
+// One to one matching in time order within MATCH_WINDOW_S
+static uint32_t matchBeats(const double *detected, size_t n, const double *truth, size_t m,
+                           double lag) {
+    uint32_t matched = 0;
+    size_t i = 0;
+    size_t j = 0;
+    double d;
+
+    while (i < n && j < m) {
+        d = detected[i] - lag - truth[j];
+        if (d < -MATCH_WINDOW_S) {
+            i++;                    // False positive
+        } else if (d > MATCH_WINDOW_S) {
+            j++;                    // Missed beat
+        } else {
+            matched++;
+            i++;
+            j++;
+        }
+    }
+    return matched;
+}
+
+static double costOf(const uint64_t *counts) {
+    double cycles = 0.0;
+    size_t s;
+
+    for (s = 0; s < COST_COUNT; s++) {
+        cycles += costCycles[s] * (double)counts[s];
+    }
+    return cycles;
+}
+
+// One second of the device as power.c books it. The main loop is active for the
+// processing cycles and sleeps in LPM0 otherwise; LEDs and tone follow the pattern of
+// the alarm zone, each beat clicks unless the pattern sounds a tone.
+static void bookSecond(EnergyAccount *e, AlarmState *alarm, const Pipeline *pp,
+                       uint32_t second, uint16_t sampleRateHz, double cycles, uint32_t beats) {
+    const AlarmPattern *pattern;
+    uint16_t active, on, duty, bpm;
+    uint32_t click;
+
+    bpm = pipelineAlarmBpm(pp);
+    alarmUpdate(alarm, bpm != 0, bpm, second * 1000UL);
+    pattern = alarmPattern(alarm->zone);
+    on = (uint16_t)(ENERGY_TICK_HZ * pattern->onMs / pattern->periodMs);
+    duty = pattern->follow ? brightnessDuty(pp->brightness.level) : BRIGHTNESS_FULL;
+    energyAddDuty(e, ENERGY_LED, on, duty * (uint16_t)(!!(pattern->onLeds & ALARM_LED_RED) +
+                                                        !!(pattern->onLeds & ALARM_LED_BLUE)));
+    energyAddDuty(e, ENERGY_LED, (uint16_t)(ENERGY_TICK_HZ - on),
+                  duty * (uint16_t)(!!(pattern->offLeds & ALARM_LED_RED) +
+                                    !!(pattern->offLeds & ALARM_LED_BLUE)));
+    if (pattern->tone) {
+        energyAddOn(e, ENERGY_PIEZO, on);
+    } else {
+        click = beats * (CLICK_ATTACK_MS + CLICK_DECAY_MS) * ENERGY_TICK_HZ / 1000UL;
+        energyAddOn(e, ENERGY_PIEZO, (uint16_t)(click < ENERGY_TICK_HZ ? click : ENERGY_TICK_HZ));
+    }
+    energyAddOn(e, ENERGY_TIMERS, (uint16_t)ENERGY_TICK_HZ);
+    energyAddOn(e, ENERGY_UART, (uint16_t)ENERGY_TICK_HZ);
+    energyAddEvents(e, ENERGY_ADC, sampleRateHz);
+
+    active = (uint16_t)fmin(cycles * ENERGY_TICK_HZ / MCLK_HZ + 0.5, ENERGY_TICK_HZ);
+    energyAddMode(e, ENERGY_MODE_ACTIVE, active);
+    energyAddMode(e, ENERGY_MODE_LPM0, (uint16_t)(ENERGY_TICK_HZ - active));
+    energyFold(e);
+}
+
+static double averageUa(const EnergyAccount *e) {
+    double charge = 0.0;
+    double ms = 0.0;
+    size_t i;
+
+    for (i = 0; i < ENERGY_UNITS; i++) {
+        charge += e->chargeUc[i];
+    }
+    for (i = 0; i < ENERGY_MODES; i++) {
+        ms += e->modeMs[i];
+    }
+    return ms > 0.0 ? charge * 1000.0 / ms : 0.0;
+}
+
+// Host time per sample of the bare pipeline, the fastest of several runs
+static double timePipeline(const uint16_t *samples, size_t count, uint16_t sampleRateHz,
+                           const int16_t *coeffs) {
+    static Pipeline pp;
+    volatile uint8_t sink = 0;
+    double best = 0.0;
+    double spent = 0.0;
+    double start, elapsed;
+    unsigned runs = 0;
+    size_t i;
+
+    while (runs < TIMING_MIN_RUNS || spent < TIMING_MIN_S) {
+        memset(&pp, 0, sizeof(pp));
+        pipelineInit(&pp, sampleRateHz, coeffs);
+        start = seconds();
+        for (i = 0; i < count; i++) {
+            sink ^= pipelineStep(&pp, samples[i], DEFAULT_THRESHOLD_ON, DEFAULT_THRESHOLD_OFF,
+                                 DEFAULT_QUALITY_MIN);
+        }
+        elapsed = seconds() - start;
+        spent += elapsed;
+        if (runs == 0 || elapsed < best) {
+            best = elapsed;
+        }
+        runs++;
+    }
+    (void)sink;
+    return best * 1e9 / count;
+}
+
+static int runTrace(const TraceSpec *t, Result *r) {
+    static Pipeline pp;
+    static EnergyAccount energy;
+    static AlarmState alarm;
+    const int16_t *coeffs = filterTableForRate(t->sampleRateHz)->coeffs;
+    uint16_t *samples = NULL;
+    double *truth = NULL;
+    double *detected = NULL;
+    size_t count = 0;
+    size_t truthCount = 0;
+    size_t detectedCount = 0;
+    uint64_t counts[COST_COUNT] = { 0 };
+    double bookedCycles = 0.0;
+    uint32_t beatsBooked = 0;
+    uint16_t rejected = 0;
+    uint32_t bpmSeconds = 0;
+    uint32_t validSeconds = 0;
+    double errorSum = 0.0;
+    double lag, now, reference;
+    size_t next = 0;
+    size_t i;
+    uint8_t events;
+    int loaded;
+
+    if (t->kind == TRACE_SYNTH) {
+        loaded = loadSynth(t, &samples, &count, &truth, &truthCount);
+    } else {
+        loaded = traceLoad(t->path, (TraceFormat)traceFormatOf(t->path), &samples, &count);
+        if (loaded && !readTruth(t->truthPath, &truth, &truthCount)) {
+            fprintf(stderr, "%s: %s\n", t->truthPath, strerror(errno));
+            free(samples);
+            return 0;
+        }
+    }
+    if (!loaded) {
+        fprintf(stderr, "%s: %s\n", (t->kind == TRACE_FILE) ? t->path : t->name,
+                strerror(errno));
+        return 0;
+    }
+    detected = malloc((count / 2 + 1) * sizeof(double));
+    if (detected == NULL) {
+        fprintf(stderr, "%s: out of memory\n", t->name);
+        free(samples);
+        free(truth);
+        return 0;
+    }
+
+    memset(&pp, 0, sizeof(pp));
+    pipelineInit(&pp, t->sampleRateHz, coeffs);
+    energyInit(&energy);
+    alarmConfigure(&alarm, DEFAULT_BRADY_BPM, DEFAULT_TACHY_BPM, DEFAULT_ALARM_HYSTERESIS,
+                   DEFAULT_ALARM_DELAY_S);
+    for (i = 0; i < count; i++) {
+        events = pipelineStep(&pp, samples[i], DEFAULT_THRESHOLD_ON, DEFAULT_THRESHOLD_OFF,
+                              DEFAULT_QUALITY_MIN);
+        counts[COST_SAMPLE]++;
+        if (pp.spectral.stepCount == pp.spectral.step) {
+            counts[COST_SPECTRAL_POINT]++;
+        }
+        if (events & PIPELINE_SPECTRAL) {
+            counts[COST_SPECTRAL_EVAL]++;
+        }
+        if (events & PIPELINE_LEVEL) {
+            counts[COST_LEVEL]++;
+        }
+        // Every candidate is either passed on as a beat or counted as rejected
+        counts[COST_QUALITY_CHECK] += (uint16_t)(pp.quality.rejected - rejected);
+        rejected = pp.quality.rejected;
+        if (events & PIPELINE_BEAT) {
+            counts[COST_QUALITY_CHECK]++;
+            counts[COST_BEAT]++;
+            detected[detectedCount++] = (double)i / t->sampleRateHz;
+        }
+        if ((i + 1) % t->sampleRateHz == 0) {
+            now = costOf(counts);
+            bookSecond(&energy, &alarm, &pp, (uint32_t)((i + 1) / t->sampleRateHz),
+                       t->sampleRateHz, now - bookedCycles, (uint32_t)detectedCount - beatsBooked);
+            bookedCycles = now;
+            beatsBooked = (uint32_t)detectedCount;
+        }
+    }
+
+    lag = detectorLag(detected, detectedCount, truth, truthCount);
+
+    // BPM once per second against the interval of the last annotated beat the detector
+    // can have seen. The firmware BPM is per interval, so is the reference.
+    memset(&pp, 0, sizeof(pp));
+    pipelineInit(&pp, t->sampleRateHz, coeffs);
+    for (i = 0; i < count; i++) {
+        pipelineStep(&pp, samples[i], DEFAULT_THRESHOLD_ON, DEFAULT_THRESHOLD_OFF,
+                     DEFAULT_QUALITY_MIN);
+        if ((i + 1) % t->sampleRateHz != 0) {
+            continue;
+        }
+        now = (double)i / t->sampleRateHz - lag;
+        while (next < truthCount && truth[next] <= now) {
+            next++;
+        }
+        if (next < 2) {
+            continue;
+        }
+        reference = 60.0 / (truth[next - 1] - truth[next - 2]);
+        bpmSeconds++;
+        if (pp.pulse.valid) {
+            validSeconds++;
+            errorSum += fabs(pp.pulse.bpm - reference);
+        }
+    }
+
+    memset(r, 0, sizeof(*r));
+    memcpy(r->name, t->name, sizeof(r->name));
+    r->sampleRateHz = t->sampleRateHz;
+    r->samples = count;
+    r->truthBeats = (uint32_t)truthCount;
+    r->detected = (uint32_t)detectedCount;
+    r->matched = matchBeats(detected, detectedCount, truth, truthCount, lag);
+    r->sensitivity = truthCount ? (double)r->matched / truthCount : 0.0;
+    r->ppv = detectedCount ? (double)r->matched / detectedCount : 0.0;
+    r->bpmMae = validSeconds ? errorSum / validSeconds : 0.0;
+    r->bpmCoverage = bpmSeconds ? (double)validSeconds / bpmSeconds : 0.0;
+    r->cyclesPerSample = count ? costOf(counts) / count : 0.0;
+    r->averageUa = averageUa(&energy);
+    r->nsPerSample = count ? timePipeline(samples, count, t->sampleRateHz, coeffs) : 0.0;
+
+    free(samples);
+    free(truth);
+    free(detected);
+    return 1;
+}
+
+static void writeReport(FILE *out) {
+    size_t i;
+    Result *r;
+
+    fputs("name,rate,samples,truth_beats,detected,matched,sensitivity,ppv,bpm_mae,"
+          "bpm_coverage,ns_per_sample,est_cycles_per_sample,est_avg_ua\n", out);
+    for (i = 0; i < traceCount; i++) {
+        r = &results[i];
+        fprintf(out, "%s,%u,%llu,%u,%u,%u,%.4f,%.4f,%.2f,%.4f,%.2f,%.1f,%.1f\n", r->name,
+                r->sampleRateHz, (unsigned long long)r->samples, r->truthBeats, r->detected,
+                r->matched, r->sensitivity, r->ppv, r->bpmMae, r->bpmCoverage, r->nsPerSample,
+                r->cyclesPerSample, r->averageUa);
+    }
+}
+
+// Compare with an earlier report, columns are found by their header names. Returns the
+// number of regressions, -1 if the baseline cannot be read.
+static int checkBaseline(const char *path) {
+    FILE *f = fopen(path, "r");
+    char text[MAX_LINE];
+    char *field[32];
+    int column[METRIC_COUNT];
+    int nameColumn = -1;
+    unsigned fields;
+    unsigned lineNo = 0;
+    int failures = 0;
+    size_t i, m;
+    double old, now, limit;
+    int worse;
+
+    if (f == NULL) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    for (m = 0; m < METRIC_COUNT; m++) {
+        column[m] = -1;
+    }
+    while (fgets(text, sizeof(text), f) != NULL) {
+        fields = 0;
+        for (field[0] = strtok(text, ",\r\n"); field[fields] != NULL && fields < 31;
+             field[fields] = strtok(NULL, ",\r\n")) {
+            fields++;
+        }
+        if (lineNo++ == 0) {
+            for (i = 0; i < fields; i++) {
+                if (strcmp(field[i], "name") == 0) {
+                    nameColumn = (int)i;
+                }
+                for (m = 0; m < METRIC_COUNT; m++) {
+                    if (strcmp(field[i], metrics[m].name) == 0) {
+                        column[m] = (int)i;
+                    }
+                }
+            }
+            if (nameColumn < 0) {
+                fprintf(stderr, "%s: no name column\n", path);
+                fclose(f);
+                return -1;
+            }
+            continue;
+        }
+        if ((int)fields <= nameColumn) {
+            continue;
+        }
+        for (i = 0; i < traceCount && strcmp(results[i].name, field[nameColumn]) != 0; i++) {
+        }
+        if (i == traceCount) {
+            continue;               // Trace no longer in the manifest
+        }
+        for (m = 0; m < METRIC_COUNT; m++) {
+            if (metrics[m].tolerance < 0.0 || column[m] < 0 || column[m] >= (int)fields) {
+                continue;
+            }
+            old = atof(field[column[m]]);
+            now = *metricOf(&results[i], m);
+            switch (metrics[m].direction) {
+            case WORSE_IF_LOWER:
+                limit = old - metrics[m].tolerance;
+                worse = now < limit;
+                break;
+            case WORSE_IF_HIGHER:
+                limit = old + metrics[m].tolerance;
+                worse = now > limit;
+                break;
+            default:
+                limit = old * (1.0 + metrics[m].tolerance);
+                worse = now > limit;
+                break;
+            }
+            if (worse) {
+                fprintf(stderr, "REGRESSION %s %s: %.4f, baseline %.4f, limit %.4f\n",
+                        results[i].name, metrics[m].name, now, old, limit);
+                failures++;
+            }
+        }
+    }
+    fclose(f);
+    return failures;
+}
+
+// A baseline taken from a broken detector would hold it to its own results, so the
+// floors are checked on every run. Returns the number of traces and metrics below.
+static int checkMinimums(void) {
+    int failures = 0;
+    size_t i, m;
+    double now;
+
+    for (i = 0; i < traceCount; i++) {
+        for (m = 0; m < METRIC_COUNT; m++) {
+            now = *metricOf(&results[i], m);
+            if (metrics[m].minimum >= 0.0 && now < metrics[m].minimum) {
+                fprintf(stderr, "BELOW MINIMUM %s %s: %.4f, minimum %.4f\n",
+                        results[i].name, metrics[m].name, now, metrics[m].minimum);
+                failures++;
+            }
+        }
+    }
+    return failures;
+}
+
+static void usage(void) {
+    fprintf(stderr,
+            "usage: golden [-m manifest] [-b baseline.csv] [-o report.csv] [-t name=tol]...\n"
+            "  -m  trace list, cycle costs, tolerances and minimums,\n"
+            "      default " DEFAULT_MANIFEST "\n"
+            "  -b  compare with an earlier report, exit 1 on a regression\n"
+            "  -o  write the report to a file instead of stdout\n"
+            "  -t  set a tolerance, e.g. ns_per_sample=0.3 (negative: not checked)\n");
+    exit(2);
+}
+
+int main(int argc, char **argv) {
+    const char *manifest = DEFAULT_MANIFEST;
+    const char *baseline = NULL;
+    const char *reportPath = NULL;
+    const char *overrides[16];
+    unsigned overrideCount = 0;
+    FILE *out = stdout;
+    char name[64];
+    const char *equals;
+    int failures = 0;
+    unsigned u;
+    size_t i;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "m:b:o:t:h")) != -1) {
+        switch (opt) {
+        case 'm': manifest = optarg; break;
+        case 'b': baseline = optarg; break;
+        case 'o': reportPath = optarg; break;
+        case 't':
+            if (overrideCount == sizeof(overrides) / sizeof(overrides[0])) {
+                usage();
+            }
+            overrides[overrideCount++] = optarg;
+            break;
+        default: usage();
+        }
+    }
+    if (optind != argc || !readManifest(manifest)) {
+        usage();
+    }
+    // Command line tolerances win over the manifest
+    for (u = 0; u < overrideCount; u++) {
+        equals = strchr(overrides[u], '=');
+        if (equals == NULL || (size_t)(equals - overrides[u]) >= sizeof(name)) {
+            usage();
+        }
+        memcpy(name, overrides[u], (size_t)(equals - overrides[u]));
+        name[equals - overrides[u]] = '\0';
+        if (!setTolerance(name, atof(equals + 1))) {
+            usage();
+        }
+    }
+
+    for (i = 0; i < traceCount; i++) {
+        if (!runTrace(&traces[i], &results[i])) {
+            return 1;
+        }
+        fprintf(stderr, "%-16s sens %.3f  ppv %.3f  mae %5.2f  %6.1f ns  %7.1f est. cycles  "
+                "%6.1f est. uA\n", results[i].name, results[i].sensitivity, results[i].ppv,
+                results[i].bpmMae, results[i].nsPerSample, results[i].cyclesPerSample,
+                results[i].averageUa);
+    }
+
+    if (reportPath != NULL) {
+        out = fopen(reportPath, "w");
+        if (out == NULL) {
+            fprintf(stderr, "%s: %s\n", reportPath, strerror(errno));
+            return 1;
+        }
+    }
+    writeReport(out);
+    if (out != stdout) {
+        fclose(out);
+    }
+
+    failures = checkMinimums();
+    if (failures != 0) {
+        fprintf(stderr, "%d result(s) below the manifest minimums\n", failures);
+        return 1;
+    }
+    if (baseline != NULL) {
+        failures = checkBaseline(baseline);
+        if (failures != 0) {
+            fprintf(stderr, "%d regression(s) against %s\n", failures < 0 ? 0 : failures,
+                    baseline);
+            return 1;
+        }
+        fprintf(stderr, "no regressions against %s\n", baseline);
+    }
+    return 0;
+}
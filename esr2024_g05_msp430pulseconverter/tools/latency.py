@@ -0,0 +1,52 @@
+#!/usr/bin/env python3
+# Reads the ISR latency histograms of the firmware (irq_priority.h, built with
+# IRQ_LATENCY_ENABLE 1) over the command interface and prints them per source. Needs
+# pyserial. --clear resets the histograms after reading, so a second run after some
+# load (e.g. a CMD_GET_TRACE dump keeping the UART busy) shows only that stretch.
+#
+#   python3 tools/latency.py --port /dev/ttyUSB0 [--clear]
+
+import argparse
+import struct
+
+import serial
+
+from trace_export import transact
+
+CMD_GET_LATENCY = 0x0B
+CMD_CLEAR_LATENCY = 0x0C
+SOURCES = ["sample_timer", "adc", "tick", "pwm"]
+BINS = 6                            # Bin n: below 2^(n+1) us, the last one open
+BAR = 40
+
+
+def bin_label(n):
+    low = 0 if n == 0 else 1 << n
+    if n == BINS - 1:
+        return ">= %d us" % low
+    return "%d-%d us" % (low, (1 << (n + 1)) - 1)
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--port", required=True)
+    parser.add_argument("--clear", action="store_true",
+                        help="reset the histograms after reading")
+    args = parser.parse_args()
+
+    with serial.Serial(args.port, 9600, timeout=2) as port:
+        for source, name in enumerate(SOURCES):
+            payload = transact(port, CMD_GET_LATENCY, [source])
+            fields = struct.unpack_from("<%dH" % (BINS + 1), payload, 1)
+            peak, bins = fields[0], fields[1:]
+            total = sum(bins)
+            print("%s: %d interrupts, max %d us" % (name, total, peak))
+            for n, count in enumerate(bins):
+                width = (count * BAR + total - 1) // total if total else 0
+                print("  %-10s %6d %s" % (bin_label(n), count, "#" * width))
+        if args.clear:
+            transact(port, CMD_CLEAR_LATENCY, [])
+
+
+if __name__ == "__main__":
+    main()
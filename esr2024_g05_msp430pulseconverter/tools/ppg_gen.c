@@ -0,0 +1,181 @@
+//***************************************************************************************
+//  Kommandozeile zum Erzeugen synthetischer PPG-Aufzeichnungen (Host)
+//
+//  Beschreibung: Schreibt eine Aufzeichnung aus ppg_synth.c als CSV (ein ADC-Wert je
+//  Zeile) oder binaer (16 Bit little endian, Endung .bin/.raw), passend fuer
+//  tools/replay.c, und optional die Referenz-Schlagzeiten als CSV. Mit -B wird nur in
+//  den Speicher erzeugt und der Durchsatz gemessen.
+//
+//  Uebersetzen (Linux, im Projektverzeichnis):
+//    gcc -O2 -std=c99 -o ppg_gen tools/ppg_gen.c tools/ppg_synth.c -lm
+//***************************************************************************************
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ppg_synth.h"
+
+#define CHUNK_SAMPLES   65536
+#define CHUNK_BEATS     4096        // More than a chunk can hold at 250 BPM and 125 Hz
+
+static int endsWith(const char *s, const char *suffix) {
+    size_t n = strlen(s);
+    size_t m = strlen(suffix);
+
+    return n >= m && strcmp(s + n - m, suffix) == 0;
+}
+
+static void usage(void) {
+    fprintf(stderr,
+            "usage: ppg_gen [options] [-o out.csv|out.bin] [-g truth.csv]\n"
+            "  -r rate     sample rate in Hz (250)\n"
+            "  -d seconds  duration (60)\n"
+            "  -s seed     random seed (1)\n"
+            "  -b bpm      heart rate (72)\n"
+            "  -v ms       random beat to beat variation, standard deviation (20)\n"
+            "  -R ms       respiratory sinus arrhythmia (30)\n"
+            "  -p codes    pulse amplitude (1400)\n"
+            "  -k phase    dicrotic notch position 0..1 (0.35)\n"
+            "  -K ratio    diastolic wave relative to the systolic peak (0.4)\n"
+            "  -L codes    DC level (2200)\n"
+            "  -w codes    baseline wander amplitude (0), -W Hz frequency (0.2)\n"
+            "  -n codes    white noise standard deviation (0)\n"
+            "  -m codes    mains hum amplitude (0), -M Hz 50 or 60 (50)\n"
+            "  -a n        motion artifacts per minute (0), -A codes amplitude (0)\n"
+            "  -x n        dropouts per minute (0)\n"
+            "  -c lo,hi    clip limits in ADC codes (0,4095)\n"
+            "  -B          benchmark: generate into memory and report samples/s\n");
+    exit(2);
+}
+
+static double seconds(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv) {
+    PpgSynthParams params;
+    static PpgSynth gen;
+    static uint16_t samples[CHUNK_SAMPLES];
+    static PpgBeat beats[CHUNK_BEATS];
+    const char *outPath = NULL;
+    const char *truthPath = NULL;
+    FILE *out = stdout;
+    FILE *truth = NULL;
+    double duration = 60.0;
+    double start;
+    uint64_t total;
+    uint64_t done = 0;
+    size_t n;
+    size_t beatCount;
+    size_t i;
+    int binary = 0;
+    int benchmark = 0;
+    char *comma;
+    int opt;
+
+    ppgSynthDefaults(&params);
+    while ((opt = getopt(argc, argv, "r:d:s:b:v:R:p:k:K:L:w:W:n:m:M:a:A:x:c:o:g:Bh")) != -1) {
+        switch (opt) {
+        case 'r': params.sampleRateHz = (uint32_t)atoi(optarg); break;
+        case 'd': duration = atof(optarg); break;
+        case 's': params.seed = strtoull(optarg, NULL, 0); break;
+        case 'b': params.bpm = atof(optarg); break;
+        case 'v': params.hrvSdMs = atof(optarg); break;
+        case 'R': params.rsaMs = atof(optarg); break;
+        case 'p': params.pulseAmplitude = atof(optarg); break;
+        case 'k': params.notchPhase = atof(optarg); break;
+        case 'K': params.diastolicRatio = atof(optarg); break;
+        case 'L': params.dcLevel = atof(optarg); break;
+        case 'w': params.wanderAmplitude = atof(optarg); break;
+        case 'W': params.wanderHz = atof(optarg); break;
+        case 'n': params.noiseSd = atof(optarg); break;
+        case 'm': params.humAmplitude = atof(optarg); break;
+        case 'M': params.humHz = atof(optarg); break;
+        case 'a': params.artifactsPerMin = atof(optarg); break;
+        case 'A': params.artifactAmplitude = atof(optarg); break;
+        case 'x': params.dropoutsPerMin = atof(optarg); break;
+        case 'c':
+            params.clipLow = (uint16_t)atoi(optarg);
+            comma = strchr(optarg, ',');
+            if (comma != NULL) {
+                params.clipHigh = (uint16_t)atoi(comma + 1);
+            }
+            break;
+        case 'o': outPath = optarg; break;
+        case 'g': truthPath = optarg; break;
+        case 'B': benchmark = 1; break;
+        default: usage();
+        }
+    }
+    if (optind != argc || params.sampleRateHz == 0 || params.bpm <= 0.0 || duration <= 0.0) {
+        usage();
+    }
+
+    total = (uint64_t)(duration * params.sampleRateHz);
+    ppgSynthInit(&gen, &params);
+
+    if (benchmark) {
+        start = seconds();
+        while (done < total) {
+            n = (total - done < CHUNK_SAMPLES) ? (size_t)(total - done) : CHUNK_SAMPLES;
+            ppgSynthGenerate(&gen, samples, n, beats, CHUNK_BEATS);
+            done += n;
+        }
+        start = seconds() - start;
+        fprintf(stderr, "%llu samples in %.3f s, %.1f M samples/s\n", (unsigned long long)total,
+                start, total / start / 1e6);
+        return 0;
+    }
+
+    if (outPath != NULL) {
+        binary = endsWith(outPath, ".bin") || endsWith(outPath, ".raw");
+        out = fopen(outPath, binary ? "wb" : "w");
+        if (out == NULL) {
+            perror(outPath);
+            return 1;
+        }
+    }
+    if (truthPath != NULL) {
+        truth = fopen(truthPath, "w");
+        if (truth == NULL) {
+            perror(truthPath);
+            return 1;
+        }
+        fputs("time_s,sample,ibi_ms\n", truth);
+    }
+
+    while (done < total) {
+        n = (total - done < CHUNK_SAMPLES) ? (size_t)(total - done) : CHUNK_SAMPLES;
+        beatCount = ppgSynthGenerate(&gen, samples, n, beats, CHUNK_BEATS);
+        if (binary) {
+            for (i = 0; i < n; i++) {
+                fputc(samples[i] & 0xFF, out);
+                fputc(samples[i] >> 8, out);
+            }
+        } else {
+            for (i = 0; i < n; i++) {
+                fprintf(out, "%u\n", samples[i]);
+            }
+        }
+        for (i = 0; truth != NULL && i < beatCount; i++) {
+            fprintf(truth, "%.6f,%llu,%u\n", beats[i].timeS,
+                    (unsigned long long)beats[i].sample, beats[i].ibiMs);
+        }
+        done += n;
+    }
+    if (truth != NULL) {
+        fclose(truth);
+    }
+    if (out != stdout) {
+        fclose(out);
+    }
+    return 0;
+}
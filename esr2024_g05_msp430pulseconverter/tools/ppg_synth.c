@@ -0,0 +1,450 @@
+//***************************************************************************************
+//  Synthetische PPG-Signale fuer Tests und Benchmarks (Host)
+//***************************************************************************************
+
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "ppg_synth.h"
+
+#define TWO_PI          6.283185307179586
+#define TURN            4294967296.0        // 32 bit phase per turn
+#define SYSTOLE_PHASE   0.15                // Systolic peak within a beat
+#define SYSTOLE_WIDTH   0.05
+#define DIASTOLE_OFFSET 0.08                // Diastolic wave after the notch
+#define DIASTOLE_WIDTH  0.07
+#define SHAPE_POINTS    (1 << PPG_SHAPE_BITS)
+#define SINE_POINTS     (1 << PPG_SINE_BITS)
+#define NOISE_POINTS    (1 << PPG_NOISE_BITS)
+#define NOISE_PER_WORD  (64 / PPG_NOISE_BITS)
+#define MIN_BEAT_S      0.25
+#define MAX_BEAT_S      2.5
+
+static uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+static uint64_t nextRandom(PpgSynth *g) {
+    uint64_t *s = g->rng;
+    uint64_t result = s[0] + s[3];
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return result;
+}
+
+static double uniform(PpgSynth *g) {
+    return (double)(nextRandom(g) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static double gaussian(PpgSynth *g) {
+    double u1 = uniform(g);
+    double u2 = uniform(g);
+
+    return sqrt(-2.0 * log(1.0 - u1)) * cos(TWO_PI * u2);
+}
+
+// Samples until the next event of a Poisson process, "never" for a rate of 0
+static uint64_t eventGap(PpgSynth *g, double perMin) {
+    double s;
+
+    if (perMin <= 0.0) {
+        return UINT64_MAX;
+    }
+    s = -log(1.0 - uniform(g)) * 60.0 / perMin;
+    return 1 + (uint64_t)(s * g->p.sampleRateHz);
+}
+
+static uint32_t phaseStep(double hz, uint32_t sampleRateHz) {
+    return (uint32_t)(hz / sampleRateHz * TURN);
+}
+
+static double gauss(double x, double centre, double width) {
+    double d = (x - centre) / width;
+
+    return exp(-0.5 * d * d);
+}
+
+// One beat: systolic peak, dicrotic notch and diastolic wave, 0 at both ends, peak 1
+static void buildShape(PpgSynth *g) {
+    static double raw[SHAPE_POINTS + 1];
+    double first, last, peak = 0.0;
+    double x;
+    size_t i;
+
+    for (i = 0; i <= SHAPE_POINTS; i++) {
+        x = (double)i / SHAPE_POINTS;
+        raw[i] = gauss(x, SYSTOLE_PHASE, SYSTOLE_WIDTH) +
+                 g->p.diastolicRatio * gauss(x, g->p.notchPhase + DIASTOLE_OFFSET, DIASTOLE_WIDTH);
+    }
+    first = raw[0];
+    last = raw[SHAPE_POINTS];
+    for (i = 0; i < SHAPE_POINTS; i++) {
+        x = (double)i / SHAPE_POINTS;
+        raw[i] -= first + (last - first) * x;
+        if (raw[i] > peak) {
+            peak = raw[i];
+            g->peakPhase = (uint32_t)(x * TURN);
+        }
+    }
+    for (i = 0; i < SHAPE_POINTS; i++) {
+        g->shape[i] = (float)(raw[i] / peak);
+    }
+}
+
+// Inverse normal CDF (Acklam's rational approximation, about 1e-9 relative)
+static double normalQuantile(double p) {
+    static const double a[] = { -39.69683028665376, 220.9460984245205, -275.9285104469687,
+                                138.3577518672690, -30.66479806614716, 2.506628277459239 };
+    static const double b[] = { -54.47609879822406, 161.5858368580409, -155.6989798598866,
+                                66.80131188771972, -13.28068155288572 };
+    static const double c[] = { -0.007784894002430293, -0.3223964580411365, -2.400758277161838,
+                                -2.549732539343734, 4.374664141464968, 2.938163982698783 };
+    static const double d[] = { 0.007784695709041462, 0.3224671290700398, 2.445134137142996,
+                                3.754408661907416 };
+    double q, r;
+
+    if (p < 0.02425) {
+        q = sqrt(-2.0 * log(p));
+        return (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+               ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+    }
+    if (p > 1.0 - 0.02425) {
+        return -normalQuantile(1.0 - p);
+    }
+    q = p - 0.5;
+    r = q * q;
+    return (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q /
+           (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1.0);
+}
+
+// Equally likely values of a normal distribution, the table index is a uniform random
+static void buildNoise(PpgSynth *g) {
+    size_t i;
+
+    for (i = 0; i < NOISE_POINTS; i++) {
+        g->noise[i] = (float)(g->p.noiseSd * normalQuantile((i + 0.5) / NOISE_POINTS));
+    }
+}
+
+// Length of the next beat from the mean rate, RSA and random variation
+static void startBeat(PpgSynth *g) {
+    double length = 60.0 / g->p.bpm;
+
+    length += g->p.rsaMs * 1e-3 * sin(g->respPhase);
+    length += g->p.hrvSdMs * 1e-3 * gaussian(g);
+    if (length < MIN_BEAT_S) {
+        length = MIN_BEAT_S;
+    } else if (length > MAX_BEAT_S) {
+        length = MAX_BEAT_S;
+    }
+    g->respPhase = fmod(g->respPhase + TWO_PI * g->p.respRateHz * length, TWO_PI);
+    g->beatLengthS = length;
+    g->beatStep = (uint32_t)(TURN / (length * g->p.sampleRateHz));
+    g->peakPending = 1;
+}
+
+void ppgSynthDefaults(PpgSynthParams *p) {
+    memset(p, 0, sizeof(*p));
+    p->sampleRateHz = 250;
+    p->seed = 1;
+    p->bpm = 72.0;
+    p->hrvSdMs = 20.0;
+    p->rsaMs = 30.0;
+    p->respRateHz = 0.25;
+    p->pulseAmplitude = 1400.0;
+    p->notchPhase = 0.35;
+    p->diastolicRatio = 0.4;
+    p->dcLevel = 2200.0;
+    p->wanderHz = 0.2;
+    p->humHz = 50.0;
+    p->artifactMaxS = 1.0;
+    p->dropoutMaxS = 2.0;
+    p->dropoutLevel = 0;
+    p->clipLow = 0;
+    p->clipHigh = 4095;
+}
+
+static const struct {
+    const char *name;
+    size_t      offset;
+} doubleParams[] = {
+    { "bpm",                offsetof(PpgSynthParams, bpm) },
+    { "hrv",                offsetof(PpgSynthParams, hrvSdMs) },
+    { "rsa",                offsetof(PpgSynthParams, rsaMs) },
+    { "resp_hz",            offsetof(PpgSynthParams, respRateHz) },
+    { "amplitude",          offsetof(PpgSynthParams, pulseAmplitude) },
+    { "notch",              offsetof(PpgSynthParams, notchPhase) },
+    { "diastolic",          offsetof(PpgSynthParams, diastolicRatio) },
+    { "dc",                 offsetof(PpgSynthParams, dcLevel) },
+    { "wander",             offsetof(PpgSynthParams, wanderAmplitude) },
+    { "wander_hz",          offsetof(PpgSynthParams, wanderHz) },
+    { "noise",              offsetof(PpgSynthParams, noiseSd) },
+    { "hum",                offsetof(PpgSynthParams, humAmplitude) },
+    { "hum_hz",             offsetof(PpgSynthParams, humHz) },
+    { "artifacts",          offsetof(PpgSynthParams, artifactsPerMin) },
+    { "artifact_amplitude", offsetof(PpgSynthParams, artifactAmplitude) },
+    { "artifact_max",       offsetof(PpgSynthParams, artifactMaxS) },
+    { "dropouts",           offsetof(PpgSynthParams, dropoutsPerMin) },
+    { "dropout_max",        offsetof(PpgSynthParams, dropoutMaxS) },
+};
+
+int ppgSynthSetParam(PpgSynthParams *p, const char *name, double value) {
+    size_t i;
+
+    for (i = 0; i < sizeof(doubleParams) / sizeof(doubleParams[0]); i++) {
+        if (strcmp(name, doubleParams[i].name) == 0) {
+            *(double *)((char *)p + doubleParams[i].offset) = value;
+            return 1;
+        }
+    }
+    if (strcmp(name, "rate") == 0) {
+        p->sampleRateHz = (uint32_t)value;
+    } else if (strcmp(name, "seed") == 0) {
+        p->seed = (uint64_t)value;
+    } else if (strcmp(name, "dropout_level") == 0) {
+        p->dropoutLevel = (uint16_t)value;
+    } else if (strcmp(name, "clip_low") == 0) {
+        p->clipLow = (uint16_t)value;
+    } else if (strcmp(name, "clip_high") == 0) {
+        p->clipHigh = (uint16_t)value;
+    } else {
+        return 0;
+    }
+    return 1;
+}
+
+void ppgSynthInit(PpgSynth *g, const PpgSynthParams *p) {
+    uint64_t z = p->seed;
+    size_t i;
+
+    memset(g, 0, sizeof(*g));
+    g->p = *p;
+
+    // splitmix64 spreads the seed over the generator state
+    for (i = 0; i < 4; i++) {
+        z += 0x9E3779B97F4A7C15ULL;
+        g->rng[i] = z;
+        g->rng[i] = (g->rng[i] ^ (g->rng[i] >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        g->rng[i] = (g->rng[i] ^ (g->rng[i] >> 27)) * 0x94D049BB133111EBULL;
+        g->rng[i] ^= g->rng[i] >> 31;
+    }
+
+    buildShape(g);
+    buildNoise(g);
+    for (i = 0; i < SINE_POINTS; i++) {
+        g->sine[i] = (float)sin(TWO_PI * i / SINE_POINTS);
+    }
+    g->wanderStep = phaseStep(p->wanderHz, p->sampleRateHz);
+    g->humStep = phaseStep(p->humHz, p->sampleRateHz);
+    g->lastPeakS = -1.0;
+    startBeat(g);
+    g->untilArtifact = eventGap(g, p->artifactsPerMin);
+    g->untilDropout = eventGap(g, p->dropoutsPerMin);
+}
+
+static void startArtifact(PpgSynth *g) {
+    double length = 0.1 + uniform(g) * (g->p.artifactMaxS - 0.1);
+    double gain = g->p.artifactAmplitude * (0.5 + 0.5 * uniform(g));
+
+    g->artifactLength = 1 + (uint32_t)(length * g->p.sampleRateHz);
+    g->artifactLeft = g->artifactLength;
+    g->artifactPhase = 0;
+    g->artifactStep = (uint32_t)(TURN / 2.0 / g->artifactLength);    // Half sine
+    g->artifactGain = (float)((nextRandom(g) >> 63) ? gain : -gain);
+}
+
+static void startDropout(PpgSynth *g) {
+    double length = 0.2 + uniform(g) * (g->p.dropoutMaxS - 0.2);
+
+    g->dropoutLeft = 1 + (uint32_t)(length * g->p.sampleRateHz);
+}
+
+static float nextNoise(PpgSynth *g) {
+    float n;
+
+    if (g->noiseLeft == 0) {
+        g->noiseBits = nextRandom(g);
+        g->noiseLeft = NOISE_PER_WORD;
+    }
+    n = g->noise[g->noiseBits & (NOISE_POINTS - 1)];
+    g->noiseBits >>= PPG_NOISE_BITS;
+    g->noiseLeft--;
+    return n;
+}
+
+// Samples from now on in which no beat starts, no peak is passed and no artifact or
+// dropout starts or ends
+static uint64_t quietSamples(const PpgSynth *g) {
+    uint64_t n = (UINT32_MAX - g->beatPhase) / g->beatStep;
+    uint64_t m;
+
+    if (g->peakPending) {
+        m = (g->beatPhase < g->peakPhase) ? (g->peakPhase - g->beatPhase - 1) / g->beatStep : 0;
+        n = (m < n) ? m : n;
+    }
+    m = ((g->artifactLeft != 0) ? g->artifactLeft : g->untilArtifact) - 1;
+    n = (m < n) ? m : n;
+    m = ((g->dropoutLeft != 0) ? g->dropoutLeft : g->untilDropout) - 1;
+    return (m < n) ? m : n;
+}
+
+// Quiet samples: only table lookups and additions, an inactive artifact adds 0. Phases
+// and counters are kept in locals so nothing goes through memory from one sample to the
+// next. The arithmetic matches eventSample() so both give identical values.
+static void renderQuiet(PpgSynth *g, uint16_t *out, size_t n) {
+    const float amplitude = (float)g->p.pulseAmplitude;
+    const float dc = (float)g->p.dcLevel;
+    const float wander = (float)g->p.wanderAmplitude;
+    const float hum = (float)g->p.humAmplitude;
+    const float low = (float)g->p.clipLow;
+    const float high = (float)g->p.clipHigh;
+    const float artifactGain = (g->artifactLeft != 0) ? g->artifactGain : 0.0f;
+    const uint32_t artifactStep = (g->artifactLeft != 0) ? g->artifactStep : 0;
+    const uint32_t beatStep = g->beatStep;
+    const uint32_t wanderStep = g->wanderStep;
+    const uint32_t humStep = g->humStep;
+    uint32_t beatPhase = g->beatPhase;
+    uint32_t wanderPhase = g->wanderPhase;
+    uint32_t humPhase = g->humPhase;
+    uint32_t artifactPhase = g->artifactPhase;
+    uint64_t noiseBits = g->noiseBits;
+    unsigned noiseLeft = g->noiseLeft;
+    size_t i;
+    float v;
+
+    for (i = 0; i < n; i++) {
+        beatPhase += beatStep;
+        wanderPhase += wanderStep;
+        humPhase += humStep;
+        v = dc + amplitude * g->shape[beatPhase >> (32 - PPG_SHAPE_BITS)];
+        v += wander * g->sine[wanderPhase >> (32 - PPG_SINE_BITS)] +
+             hum * g->sine[humPhase >> (32 - PPG_SINE_BITS)];
+        if (noiseLeft == 0) {
+            noiseBits = nextRandom(g);
+            noiseLeft = NOISE_PER_WORD;
+        }
+        v += g->noise[noiseBits & (NOISE_POINTS - 1)];
+        noiseBits >>= PPG_NOISE_BITS;
+        noiseLeft--;
+        v += artifactGain * g->sine[artifactPhase >> (32 - PPG_SINE_BITS)];
+        artifactPhase += artifactStep;
+        v = (v < low) ? low : v;
+        v = (v > high) ? high : v;
+        out[i] = (uint16_t)(v + 0.5f);
+    }
+
+    g->beatPhase = beatPhase;
+    g->wanderPhase = wanderPhase;
+    g->humPhase = humPhase;
+    g->artifactPhase = artifactPhase;
+    g->noiseBits = noiseBits;
+    g->noiseLeft = (uint8_t)noiseLeft;
+    g->sample += n;
+    if (g->artifactLeft != 0) {
+        g->artifactLeft -= (uint32_t)n;
+    } else {
+        g->untilArtifact -= n;
+    }
+    if (g->dropoutLeft != 0) {
+        g->dropoutLeft -= (uint32_t)n;
+        for (i = 0; i < n; i++) {
+            out[i] = g->p.dropoutLevel;
+        }
+    } else {
+        g->untilDropout -= n;
+    }
+}
+
+// One sample with everything that can happen in it; returns 1 if a beat was reported
+static uint8_t eventSample(PpgSynth *g, uint16_t *out, PpgBeat *beat) {
+    const float low = (float)g->p.clipLow;
+    const float high = (float)g->p.clipHigh;
+    uint8_t reported = 0;
+    uint32_t previous = g->beatPhase;
+    float artifact = 0.0f;
+    float v;
+    double peakS;
+
+    g->beatPhase += g->beatStep;
+    if (g->beatPhase < previous) {
+        startBeat(g);
+    }
+    if (g->peakPending && g->beatPhase >= g->peakPhase) {
+        // Exact peak time between this and the previous sample
+        g->peakPending = 0;
+        peakS = ((double)g->sample -
+                 (double)(g->beatPhase - g->peakPhase) / g->beatStep) / g->p.sampleRateHz;
+        if (beat != 0) {
+            beat->timeS = peakS;
+            beat->sample = g->sample;
+            beat->ibiMs = (g->lastPeakS < 0.0) ? 0 :
+                          (uint32_t)((peakS - g->lastPeakS) * 1000.0 + 0.5);
+            reported = 1;
+        }
+        g->lastPeakS = peakS;
+    }
+    g->wanderPhase += g->wanderStep;
+    g->humPhase += g->humStep;
+
+    v = (float)g->p.dcLevel + (float)g->p.pulseAmplitude *
+                              g->shape[g->beatPhase >> (32 - PPG_SHAPE_BITS)];
+    v += (float)g->p.wanderAmplitude * g->sine[g->wanderPhase >> (32 - PPG_SINE_BITS)] +
+         (float)g->p.humAmplitude * g->sine[g->humPhase >> (32 - PPG_SINE_BITS)];
+    v += nextNoise(g);
+
+    if (g->artifactLeft != 0) {
+        artifact = g->artifactGain;
+        v += artifact * g->sine[g->artifactPhase >> (32 - PPG_SINE_BITS)];
+        g->artifactPhase += g->artifactStep;
+        if (--g->artifactLeft == 0) {
+            g->untilArtifact = eventGap(g, g->p.artifactsPerMin);
+        }
+    } else {
+        v += artifact * g->sine[g->artifactPhase >> (32 - PPG_SINE_BITS)];
+        if (--g->untilArtifact == 0) {
+            startArtifact(g);
+        }
+    }
+
+    v = (v < low) ? low : v;
+    v = (v > high) ? high : v;
+    *out = (uint16_t)(v + 0.5f);
+
+    if (g->dropoutLeft != 0) {
+        *out = g->p.dropoutLevel;
+        if (--g->dropoutLeft == 0) {
+            g->untilDropout = eventGap(g, g->p.dropoutsPerMin);
+        }
+    } else if (--g->untilDropout == 0) {
+        startDropout(g);
+    }
+    g->sample++;
+    return reported;
+}
+
+size_t ppgSynthGenerate(PpgSynth *g, uint16_t *out, size_t count, PpgBeat *beats,
+                        size_t maxBeats) {
+    size_t beatCount = 0;
+    size_t done = 0;
+    uint64_t quiet;
+    size_t n;
+
+    while (done < count) {
+        quiet = quietSamples(g);
+        n = (quiet < count - done) ? (size_t)quiet : count - done;
+        renderQuiet(g, out + done, n);
+        done += n;
+        if (done < count) {
+            beatCount += eventSample(g, out + done, (beatCount < maxBeats) ? &beats[beatCount] : 0);
+            done++;
+        }
+    }
+    return beatCount;
+}
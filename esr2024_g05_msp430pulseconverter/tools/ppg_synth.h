@@ -0,0 +1,107 @@
+//***************************************************************************************
+//  Synthetische PPG-Signale fuer Tests und Benchmarks (Host)
+//
+//  Beschreibung: Erzeugt pulsartige Kurven als 12-Bit-ADC-Werte mit einstellbarem Puls,
+//  HRV (Zufallsanteil und respiratorische Sinusarrhythmie), Form der dikrotischen Kerbe,
+//  Grundlinienschwankung, weissem Rauschen, 50/60-Hz-Brummen, Bewegungsartefakten,
+//  Begrenzung und Aussetzern. Alle Zufallswerte kommen aus einem einzigen Generator mit
+//  festem Startwert, die Ausgabe ist damit vollstaendig reproduzierbar und haengt nicht
+//  davon ab, in wie vielen Stuecken sie angefordert wird. Zu jedem Schlag wird der
+//  Zeitpunkt der systolischen Spitze als Referenz geliefert.
+//  Pro Abtastwert fallen nur Tabellenzugriffe und Additionen an, das Rauschen kommt aus
+//  einer Tabelle von Quantilen der Normalverteilung (fuenf Werte je Zufallszahl). Die
+//  Tabellen passen zusammen in den L1-Cache.
+//***************************************************************************************
+
+#ifndef PPG_SYNTH_H_
+#define PPG_SYNTH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define PPG_SHAPE_BITS      11      // One beat in 2048 points
+#define PPG_SINE_BITS       10
+#define PPG_NOISE_BITS      12      // Gaussian quantiles, five per random number
+
+typedef struct {
+    uint32_t sampleRateHz;
+    uint64_t seed;
+    // Heart
+    double   bpm;
+    double   hrvSdMs;               // Random beat to beat variation (standard deviation)
+    double   rsaMs;                 // Respiratory sinus arrhythmia, peak deviation
+    double   respRateHz;
+    double   pulseAmplitude;        // ADC codes, systolic peak above the foot
+    double   notchPhase;            // Dicrotic notch position as fraction of the beat
+    double   diastolicRatio;        // Diastolic wave relative to the systolic peak
+    // Disturbances, ADC codes
+    double   dcLevel;
+    double   wanderAmplitude;
+    double   wanderHz;
+    double   noiseSd;
+    double   humAmplitude;
+    double   humHz;                 // 50 or 60
+    double   artifactsPerMin;
+    double   artifactAmplitude;     // Peak, random sign and 50..100 % of it
+    double   artifactMaxS;          // Duration 0.1 s .. artifactMaxS
+    double   dropoutsPerMin;
+    double   dropoutMaxS;           // Duration 0.2 s .. dropoutMaxS
+    uint16_t dropoutLevel;          // Output while the sensor is lost
+    uint16_t clipLow;               // Output limits, e.g. a saturating front end
+    uint16_t clipHigh;
+} PpgSynthParams;
+
+typedef struct {
+    double   timeS;                 // Systolic peak
+    uint64_t sample;                // Sample at or just after the peak
+    uint32_t ibiMs;                 // Interval to the previous beat, 0 for the first
+} PpgBeat;
+
+typedef struct {
+    PpgSynthParams p;
+    uint64_t rng[4];                // xoshiro256+
+    uint64_t sample;                // Samples generated so far
+    float    shape[1 << PPG_SHAPE_BITS];
+    float    sine[1 << PPG_SINE_BITS];
+    float    noise[1 << PPG_NOISE_BITS];     // Scaled to noiseSd
+    uint64_t noiseBits;             // Unused indices of the last random number
+    uint8_t  noiseLeft;
+    // Beat phase, 32 bit fraction of a beat
+    uint32_t beatPhase;
+    uint32_t beatStep;
+    double   beatLengthS;
+    uint32_t peakPhase;             // Phase of the systolic peak within a beat
+    uint8_t  peakPending;           // Peak of the current beat not reported yet
+    double   lastPeakS;
+    double   respPhase;             // Radians, advanced per beat
+    // Slow oscillators, 32 bit fraction of a turn
+    uint32_t wanderPhase;
+    uint32_t wanderStep;
+    uint32_t humPhase;
+    uint32_t humStep;
+    // Events, counted down in samples
+    uint64_t untilArtifact;
+    uint32_t artifactLeft;
+    uint32_t artifactLength;
+    uint32_t artifactPhase;
+    uint32_t artifactStep;
+    float    artifactGain;
+    uint64_t untilDropout;
+    uint32_t dropoutLeft;
+} PpgSynth;
+
+// Default parameters: 250 Hz, 72 BPM, mild HRV, clean signal
+void ppgSynthDefaults(PpgSynthParams *p);
+
+// Set one parameter by name, e.g. "bpm" or "noise" (names in ppg_synth.c), for
+// parameter lists in text files. Returns 0 for an unknown name.
+int ppgSynthSetParam(PpgSynthParams *p, const char *name, double value);
+
+void ppgSynthInit(PpgSynth *g, const PpgSynthParams *p);
+
+// Generate the next 'count' samples. Beats whose peak falls into them are written to
+// 'beats' (up to 'maxBeats'); returns the number of beats, further ones are dropped.
+size_t ppgSynthGenerate(PpgSynth *g, uint16_t *out, size_t count, PpgBeat *beats,
+                        size_t maxBeats);
+
+#endif /* PPG_SYNTH_H_ */
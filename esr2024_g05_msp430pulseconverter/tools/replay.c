@@ -0,0 +1,390 @@
+//***************************************************************************************
+//  Wiedergabe aufgezeichneter Pulskurven durch die Verarbeitungskette der Firmware
+//
+//  Beschreibung: Liest PPG-Aufzeichnungen (CSV mit einem ADC-Wert je Zeile, bei mehreren
+//  Spalten zaehlt die letzte, oder binaer als 16-Bit-Werte little endian) und schickt sie
+//  durch pipeline.c, also genau den Code der Firmware. Je Datei entstehen eine Liste der
+//  Schlaege und ein BPM-Verlauf im Sekundentakt. Verzeichnisse werden rekursiv
+//  durchsucht, die Dateien verteilt ein Thread-Pool mit Work-Stealing auf alle Kerne.
+//  Am Ende steht eine Durchsatz-Zusammenfassung (Vielfaches der Echtzeit je Kern).
+//
+//  Uebersetzen (Linux, im Projektverzeichnis):
+//    gcc -O2 -std=c99 -pthread -I. -o replay tools/replay.c tools/trace_io.c pipeline.c
+//        biquad.c pulse.c median.c signal_quality.c spectral.c brightness.c hrv.c
+//        filter_tables.c
+//
+//  Aufruf:
+//    replay [-r rate] [-t on[,off]] [-q quality] [-j threads] [-o dir] datei|verzeichnis...
+//***************************************************************************************
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <dirent.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "config.h"
+#include "filter_tables.h"
+#include "pipeline.h"
+#include "trace_io.h"
+
+#define MAX_THREADS     256
+
+typedef struct {
+    char    *path;
+    TraceFormat format;
+    // Results
+    int      ok;
+    uint64_t samples;
+    uint32_t beats;             // Candidates that passed the quality check
+    uint32_t intervals;         // Intervals used for BPM
+    uint64_t bpmSum;
+} Job;
+
+typedef struct {
+    pthread_mutex_t lock;
+    size_t   head;              // Owner takes from the head, thieves from the tail
+    size_t   tail;
+} WorkQueue;
+
+typedef struct {
+    pthread_t thread;
+    unsigned index;
+    double   cpuSeconds;        // Thread CPU time spent on jobs
+    unsigned steals;
+} Worker;
+
+static Job *jobs;
+static size_t jobCount;
+static size_t jobCapacity;
+static WorkQueue queues[MAX_THREADS];
+static Worker workers[MAX_THREADS];
+static unsigned threadCount;
+
+static uint16_t sampleRateHz = DEFAULT_SAMPLE_RATE_HZ;
+static int16_t thresholdOn = DEFAULT_THRESHOLD_ON;
+static int16_t thresholdOff = DEFAULT_THRESHOLD_OFF;
+static uint8_t qualityMin = DEFAULT_QUALITY_MIN;
+static const char *outputDir;
+
+static double seconds(clockid_t clock) {
+    struct timespec ts;
+
+    clock_gettime(clock, &ts);
+    return (double)ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void addJob(const char *path, TraceFormat format) {
+    if (jobCount == jobCapacity) {
+        jobCapacity = jobCapacity ? 2 * jobCapacity : 256;
+        jobs = realloc(jobs, jobCapacity * sizeof(Job));
+        if (jobs == NULL) {
+            perror("realloc");
+            exit(1);
+        }
+    }
+    memset(&jobs[jobCount], 0, sizeof(Job));
+    jobs[jobCount].path = strdup(path);
+    jobs[jobCount].format = format;
+    jobCount++;
+}
+
+static int compareJobs(const void *a, const void *b) {
+    return strcmp(((const Job *)a)->path, ((const Job *)b)->path);
+}
+
+static void collect(const char *path, int explicit) {
+    struct stat st;
+    struct dirent *entry;
+    DIR *dir;
+    char *child;
+    int format;
+
+    if (stat(path, &st) != 0) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return;
+    }
+    if (S_ISDIR(st.st_mode)) {
+        dir = opendir(path);
+        if (dir == NULL) {
+            fprintf(stderr, "%s: %s\n", path, strerror(errno));
+            return;
+        }
+        while ((entry = readdir(dir)) != NULL) {
+            if (entry->d_name[0] == '.') {
+                continue;
+            }
+            child = malloc(strlen(path) + strlen(entry->d_name) + 2);
+            sprintf(child, "%s/%s", path, entry->d_name);
+            collect(child, 0);
+            free(child);
+        }
+        closedir(dir);
+        return;
+    }
+    format = traceFormatOf(path);
+    if (format < 0) {
+        if (!explicit) {
+            return;
+        }
+        format = TRACE_CSV;
+    }
+    addJob(path, (TraceFormat)format);
+}
+
+static FILE *openOutput(const char *path, const char *suffix) {
+    const char *base = strrchr(path, '/');
+    char *name;
+    FILE *f;
+
+    base = (base != NULL) ? base + 1 : path;
+    name = malloc(strlen(outputDir) + strlen(base) + strlen(suffix) + 2);
+    sprintf(name, "%s/%s%s", outputDir, base, suffix);
+    f = fopen(name, "w");
+    if (f == NULL) {
+        fprintf(stderr, "%s: %s\n", name, strerror(errno));
+    }
+    free(name);
+    return f;
+}
+
+static void runJob(Job *job) {
+    Pipeline pp;
+    const FilterTable *table = filterTableForRate(sampleRateHz);
+    FILE *beatsOut = NULL;
+    FILE *bpmOut = NULL;
+    uint16_t *samples = NULL;
+    size_t count = 0;
+    size_t i;
+    uint8_t events;
+    uint64_t timeMs;
+
+    if (!traceLoad(job->path, job->format, &samples, &count)) {
+        fprintf(stderr, "%s: %s\n", job->path, strerror(errno));
+        return;
+    }
+
+    if (outputDir != NULL) {
+        beatsOut = openOutput(job->path, ".beats.csv");
+        bpmOut = openOutput(job->path, ".bpm.csv");
+        if (beatsOut != NULL) {
+            fputs("sample,time_ms,used,ibi_ms,bpm,quality\n", beatsOut);
+        }
+        if (bpmOut != NULL) {
+            fputs("time_s,bpm,valid,confidence,spectral_bpm\n", bpmOut);
+        }
+    }
+
+    memset(&pp, 0, sizeof(pp));
+    pipelineInit(&pp, sampleRateHz, table->coeffs);
+    for (i = 0; i < count; i++) {
+        events = pipelineStep(&pp, samples[i], thresholdOn, thresholdOff, qualityMin);
+        if (events & PIPELINE_BEAT) {
+            job->beats++;
+            if (events & PIPELINE_IBI) {
+                job->intervals++;
+                job->bpmSum += pp.pulse.bpm;
+            }
+            if (beatsOut != NULL) {
+                timeMs = (uint64_t)i * 1000 / sampleRateHz;
+                fprintf(beatsOut, "%zu,%llu,%d,%u,%u,%u\n", i, (unsigned long long)timeMs,
+                        (events & PIPELINE_IBI) ? 1 : 0, pp.pulse.ibiMs, pp.pulse.bpm,
+                        pp.quality.quality);
+            }
+        }
+        if (bpmOut != NULL && (i + 1) % sampleRateHz == 0) {
+            fprintf(bpmOut, "%zu,%u,%u,%u,%u\n", (i + 1) / sampleRateHz, pp.pulse.bpm,
+                    pp.pulse.valid, pp.pulse.confidence, pp.spectral.bpm);
+        }
+    }
+    if (beatsOut != NULL) {
+        fclose(beatsOut);
+    }
+    if (bpmOut != NULL) {
+        fclose(bpmOut);
+    }
+    free(samples);
+    job->samples = count;
+    job->ok = 1;
+}
+
+// Next job of 'self': its own queue first, then half of the first non-empty other queue.
+// Queues never refill once empty, so a pass without work means all jobs are taken.
+static int nextJob(Worker *self, size_t *index) {
+    WorkQueue *own = &queues[self->index];
+    WorkQueue *victim;
+    size_t take;
+    unsigned i;
+
+    pthread_mutex_lock(&own->lock);
+    if (own->head < own->tail) {
+        *index = own->head++;
+        pthread_mutex_unlock(&own->lock);
+        return 1;
+    }
+    pthread_mutex_unlock(&own->lock);
+
+    for (i = 1; i < threadCount; i++) {
+        victim = &queues[(self->index + i) % threadCount];
+        pthread_mutex_lock(&victim->lock);
+        if (victim->head < victim->tail) {
+            // Take the back half, the first of it is run right away
+            take = (victim->tail - victim->head + 1) / 2;
+            victim->tail -= take;
+            *index = victim->tail;
+            pthread_mutex_lock(&own->lock);
+            own->head = victim->tail + 1;
+            own->tail = victim->tail + take;
+            pthread_mutex_unlock(&own->lock);
+            pthread_mutex_unlock(&victim->lock);
+            self->steals++;
+            return 1;
+        }
+        pthread_mutex_unlock(&victim->lock);
+    }
+    return 0;
+}
+
+static void *workerMain(void *arg) {
+    Worker *self = arg;
+    size_t index;
+    double start;
+
+    while (nextJob(self, &index)) {
+        start = seconds(CLOCK_THREAD_CPUTIME_ID);
+        runJob(&jobs[index]);
+        self->cpuSeconds += seconds(CLOCK_THREAD_CPUTIME_ID) - start;
+    }
+    return NULL;
+}
+
+static void usage(void) {
+    fprintf(stderr,
+            "usage: replay [-r rate] [-t on[,off]] [-q quality] [-j threads] [-o dir] "
+            "file|dir...\n"
+            "  -r  sample rate of the recordings in Hz (125, 250, 500, 1000), default %d\n"
+            "  -t  beat thresholds in ADC codes, default %d,%d\n"
+            "  -q  minimum signal quality 0..100, default %d\n"
+            "  -j  worker threads, default: all cores\n"
+            "  -o  write <name>.beats.csv and <name>.bpm.csv per recording to dir\n",
+            DEFAULT_SAMPLE_RATE_HZ, DEFAULT_THRESHOLD_ON, DEFAULT_THRESHOLD_OFF,
+            DEFAULT_QUALITY_MIN);
+    exit(2);
+}
+
+int main(int argc, char **argv) {
+    uint64_t totalSamples = 0;
+    uint64_t totalIntervals = 0;
+    double cpuSeconds = 0.0;
+    double wallSeconds;
+    double recordedSeconds;
+    unsigned steals = 0;
+    unsigned failed = 0;
+    long cores;
+    char *comma;
+    size_t i;
+    unsigned t;
+    int opt;
+
+    cores = sysconf(_SC_NPROCESSORS_ONLN);
+    threadCount = (cores > 0) ? (unsigned)cores : 1;
+
+    while ((opt = getopt(argc, argv, "r:t:q:j:o:h")) != -1) {
+        switch (opt) {
+        case 'r':
+            sampleRateHz = (uint16_t)atoi(optarg);
+            if (filterTableForRate(sampleRateHz) == NULL) {
+                fprintf(stderr, "no filter table for %s Hz\n", optarg);
+                return 2;
+            }
+            break;
+        case 't':
+            thresholdOn = (int16_t)atoi(optarg);
+            comma = strchr(optarg, ',');
+            thresholdOff = (comma != NULL) ? (int16_t)atoi(comma + 1) : thresholdOn;
+            break;
+        case 'q':
+            qualityMin = (uint8_t)atoi(optarg);
+            break;
+        case 'j':
+            threadCount = (unsigned)atoi(optarg);
+            break;
+        case 'o':
+            outputDir = optarg;
+            break;
+        default:
+            usage();
+        }
+    }
+    if (optind >= argc || threadCount == 0) {
+        usage();
+    }
+    if (threadCount > MAX_THREADS) {
+        threadCount = MAX_THREADS;
+    }
+
+    for (; optind < argc; optind++) {
+        collect(argv[optind], 1);
+    }
+    if (jobCount == 0) {
+        fprintf(stderr, "no recordings found\n");
+        return 1;
+    }
+    qsort(jobs, jobCount, sizeof(Job), compareJobs);
+    if (threadCount > jobCount) {
+        threadCount = (unsigned)jobCount;
+    }
+
+    // Contiguous blocks per worker, stealing evens out files of different length
+    for (t = 0; t < threadCount; t++) {
+        pthread_mutex_init(&queues[t].lock, NULL);
+        queues[t].head = jobCount * t / threadCount;
+        queues[t].tail = jobCount * (t + 1) / threadCount;
+        workers[t].index = t;
+    }
+
+    wallSeconds = seconds(CLOCK_MONOTONIC);
+    for (t = 0; t < threadCount; t++) {
+        pthread_create(&workers[t].thread, NULL, workerMain, &workers[t]);
+    }
+    for (t = 0; t < threadCount; t++) {
+        pthread_join(workers[t].thread, NULL);
+        cpuSeconds += workers[t].cpuSeconds;
+        steals += workers[t].steals;
+    }
+    wallSeconds = seconds(CLOCK_MONOTONIC) - wallSeconds;
+
+    // Per recording results in name order
+    printf("file,samples,beats,intervals,mean_bpm\n");
+    for (i = 0; i < jobCount; i++) {
+        if (!jobs[i].ok) {
+            failed++;
+            continue;
+        }
+        printf("%s,%llu,%u,%u,%llu\n", jobs[i].path, (unsigned long long)jobs[i].samples,
+               jobs[i].beats, jobs[i].intervals,
+               jobs[i].intervals ? (unsigned long long)(jobs[i].bpmSum / jobs[i].intervals) : 0ULL);
+        totalSamples += jobs[i].samples;
+        totalIntervals += jobs[i].intervals;
+    }
+
+    recordedSeconds = (double)totalSamples / sampleRateHz;
+    fprintf(stderr, "%zu recordings (%u failed), %llu samples, %.1f h recorded, %llu intervals\n",
+            jobCount, failed, (unsigned long long)totalSamples, recordedSeconds / 3600.0,
+            (unsigned long long)totalIntervals);
+    fprintf(stderr, "%u threads, %u steals, %.3f s wall, %.3f s cpu\n", threadCount, steals,
+            wallSeconds, cpuSeconds);
+    if (cpuSeconds > 0.0 && wallSeconds > 0.0) {
+        fprintf(stderr, "%.1f M samples/s per core, %.0fx real time per core, %.0fx in total\n",
+                totalSamples / cpuSeconds / 1e6, recordedSeconds / cpuSeconds,
+                recordedSeconds / wallSeconds);
+    }
+    return failed ? 1 : 0;
+}
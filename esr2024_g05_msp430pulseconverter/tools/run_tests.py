@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+# Builds and runs the host tests tools/test_*.c. The gcc line of each test is taken from
+# the "Uebersetzen" block in its header comment, so the header stays the only place it
+# is written down. Exits with status 1 if a test fails to build or reports a failure.
+#
+#   python3 tools/run_tests.py [--cc gcc] [name ...]
+#
+# Run from the project directory.
+
+import argparse
+import glob
+import os
+import re
+import shlex
+import subprocess
+import sys
+import tempfile
+
+
+def build_command(path):
+    lines = []
+    with open(path) as f:
+        for line in f:
+            if not line.startswith("//"):
+                break
+            text = line[2:].strip()
+            if text.startswith("gcc "):
+                lines = [text]
+            elif lines and line.startswith("//        "):
+                lines.append(text)
+            elif lines:
+                break
+    if not lines:
+        sys.exit("%s: no gcc line in the header" % path)
+    return shlex.split(" ".join(lines))
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--cc", default="gcc")
+    parser.add_argument("names", nargs="*", help="tests to run, e.g. test_alarm (default all)")
+    args = parser.parse_args()
+
+    tests = sorted(glob.glob("tools/test_*.c"))
+    if args.names:
+        tests = [t for t in tests if os.path.basename(t)[:-2] in args.names]
+    failed = []
+    with tempfile.TemporaryDirectory() as tmp:
+        for test in tests:
+            name = os.path.basename(test)[:-2]
+            cmd = build_command(test)
+            cmd[0] = args.cc
+            exe = os.path.join(tmp, name)
+            cmd[cmd.index("-o") + 1] = exe
+            if subprocess.run(cmd).returncode != 0:
+                print("%s: build failed" % name)
+                failed.append(name)
+                continue
+            if subprocess.run([exe]).returncode != 0:
+                failed.append(name)
+    print()
+    print("%d tests, %d failed%s" % (len(tests), len(failed),
+                                     (": " + ", ".join(failed)) if failed else ""))
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,129 @@
+//***************************************************************************************
+//  Ersatz fuer <msp430.h> in den Host-Tests der Treiber (tools/test_i2c_async.c,
+//  tools/test_i2c_target.c, tools/test_uart_cmd.c)
+//
+//  Beschreibung: Nur die Register und Bits, die i2c_async.c, uart_cmd.c, config.c und
+//  die eingebundenen Header brauchen, mit den Werten des MSP430FR2355. Jeder Zugriff auf
+//  ein eUSCI_B0-Register geht ueber eine Funktion des Tests: sie laesst die simulierte
+//  Zeit um die Kosten des Zugriffs weiterlaufen und das Busmodell nachziehen, damit
+//  Warteschleifen auf UCTXSTT enden. UCB0IV und UCB0RXBUF sind Lesefunktionen, weil das
+//  Lesen Flags loescht. Beim eUSCI_A0 laeuft jeder Zugriff auf UCA0IE ueber
+//  simUartAccess(), damit der Test dort die TX-ISR ausfuehren kann, die auf dem Geraet
+//  die Sendeschleife leert; die uebrigen Register sind einfache Variablen des Tests. Das
+//  eUSCI_B1 des I2C-Targets greift nur ueber driverlib zu, UCB1IV setzt der Test vor
+//  jedem Aufruf der ISR.
+//***************************************************************************************
+
+#ifndef SIM_MSP430_H_
+#define SIM_MSP430_H_
+
+#include <stdint.h>
+
+#define __AUTOGENERATED__               // No msp430fr2xx_4xxgeneric.h in hw_memmap.h
+#define __MSP430_HAS_EUSCI_Bx__
+#define __MSP430_HAS_EUSCI_Ax__
+#define __MSP430_HAS_CRC__
+#define __MSP430_HAS_SYS__
+#define EUSCI_B0_BASE           0x0540
+#define EUSCI_B1_BASE           0x0580
+#define EUSCI_A0_BASE           0x0500
+#define CRC_BASE                0x01C0
+
+#define __interrupt
+#define __even_in_range(x, y)   (x)
+#define __get_interrupt_state() ((unsigned short)0)
+#define __set_interrupt_state(s) ((void)(s))
+#define __disable_interrupt()   ((void)0)
+#define __bic_SR_register_on_exit(bits) simWake(bits)
+
+#define CPUOFF                  0x0010
+#define LPM0_bits               CPUOFF
+
+// UCBxCTLW0
+#define UCSWRST                 0x0001
+#define UCTXSTT                 0x0002
+#define UCTXSTP                 0x0004
+#define UCTXNACK                0x0008
+#define UCTR                    0x0010
+#define UCSSEL__SMCLK           0x00C0
+#define UCMST                   0x0800
+
+// UCBxCTLW1
+#define UCASTP_0                0x0000
+#define UCCLTO_1                0x0040
+
+// UCBxI2COA0
+#define UCOAEN                  0x0400
+
+// UCBxIE, the UCBxIFG bits are in the same places
+#define UCRXIE0                 0x0001
+#define UCTXIE0                 0x0002
+#define UCSTTIE                 0x0004
+#define UCSTPIE                 0x0008
+#define UCALIE                  0x0010
+#define UCNACKIE                0x0020
+#define UCCLTOIE                0x0080
+#define UCRXIFG0                UCRXIE0
+#define UCTXIFG0                UCTXIE0
+#define UCSTPIFG                UCSTPIE
+#define UCALIFG                 UCALIE
+#define UCNACKIFG               UCNACKIE
+#define UCCLTOIFG               UCCLTOIE
+
+// UCBxIV
+#define USCI_I2C_UCALIFG        0x0002
+#define USCI_I2C_UCNACKIFG      0x0004
+#define USCI_I2C_UCSTTIFG       0x0006
+#define USCI_I2C_UCSTPIFG       0x0008
+#define USCI_I2C_UCRXIFG0       0x0016
+#define USCI_I2C_UCTXIFG0       0x0018
+#define USCI_I2C_UCCLTOIFG      0x001C
+#define USCI_I2C_UCBIT9IFG      0x001E
+
+#define EUSCI_B0_VECTOR         0
+#define EUSCI_A0_VECTOR         1
+#define EUSCI_B1_VECTOR         2
+
+// eUSCI_A0 as UART
+#define UCMODE_0                0x0000
+#define UCRXIE                  0x0001
+#define UCTXIE                  0x0002
+#define UCRXIFG                 UCRXIE
+#define UCTXIFG                 UCTXIE
+#define USCI_UART_UCRXIFG       0x0002
+#define USCI_UART_UCTXIFG       0x0004
+#define USCI_UART_UCSTTIFG      0x0006
+#define USCI_UART_UCTXCPTIFG    0x0008
+
+#define BIT6                    0x0040
+#define BIT7                    0x0080
+
+extern volatile uint16_t simCtlw0;
+extern volatile uint16_t simI2csa;
+extern volatile uint16_t simIe;
+extern volatile uint16_t simTxbuf;
+extern volatile uint16_t TB1R;          // trace.h, not used with TRACE_ENABLE 0
+extern volatile uint16_t simUca0Ie;
+extern volatile uint16_t UCA0IV;
+extern volatile uint16_t UCA0RXBUF;
+extern volatile uint16_t UCA0TXBUF;
+extern volatile uint16_t P1SEL0;
+extern volatile uint16_t P4SEL0;
+extern volatile uint16_t UCB1IV;
+extern volatile uint16_t RTCCNT;
+
+volatile uint16_t *simAccess(volatile uint16_t *reg);
+uint16_t simReadRxbuf(void);
+uint16_t simReadIv(void);
+void simWake(uint16_t bits);
+volatile uint16_t *simUartAccess(volatile uint16_t *reg);
+
+#define UCB0CTLW0               (*simAccess(&simCtlw0))
+#define UCB0I2CSA               (*simAccess(&simI2csa))
+#define UCB0IE                  (*simAccess(&simIe))
+#define UCB0TXBUF               (*simAccess(&simTxbuf))
+#define UCB0RXBUF               simReadRxbuf()
+#define UCB0IV                  simReadIv()
+#define UCA0IE                  (*simUartAccess(&simUca0Ie))
+
+#endif /* SIM_MSP430_H_ */
@@ -0,0 +1,247 @@
+//***************************************************************************************
+//  Spektrale Pulsschaetzung mit einer Festkomma-FFT (Vergleich zu spectral.c)
+//***************************************************************************************
+
+#include "tools/spectral_fft.h"
+
+#define DC_SHIFT            5           // As spectral.c
+#define INPUT_SHIFT         2           // 12 to 14 bit, one bit left for the butterflies
+#define INPUT_LIMIT         16383
+#define LOG2_HALF           7
+
+// cos(2 pi k / FFT_SIZE) for k = 0..FFT_SIZE / 4 in Q15
+static const int16_t cosQuarter[FFT_SIZE / 4 + 1] = {
+    32767, 32758, 32729, 32679, 32610, 32522, 32413, 32286,
+    32138, 31972, 31786, 31581, 31357, 31114, 30853, 30572,
+    30274, 29957, 29622, 29269, 28899, 28511, 28106, 27684,
+    27246, 26791, 26320, 25833, 25330, 24812, 24279, 23732,
+    23170, 22595, 22006, 21403, 20788, 20160, 19520, 18868,
+    18205, 17531, 16846, 16151, 15447, 14733, 14010, 13279,
+    12540, 11793, 11039, 10279, 9512, 8740, 7962, 7180,
+    6393, 5602, 4808, 4011, 3212, 2411, 1608, 804,
+    0,
+};
+
+static int16_t cosQ15(uint16_t k) {
+    k &= FFT_SIZE - 1;
+    if (k <= FFT_SIZE / 4) {
+        return cosQuarter[k];
+    }
+    if (k <= FFT_SIZE / 2) {
+        return -cosQuarter[FFT_SIZE / 2 - k];
+    }
+    if (k <= 3 * FFT_SIZE / 4) {
+        return -cosQuarter[k - FFT_SIZE / 2];
+    }
+    return cosQuarter[FFT_SIZE - k];
+}
+
+static int16_t sinQ15(uint16_t k) {
+    return cosQ15(k + 3 * FFT_SIZE / 4);
+}
+
+static uint8_t reverseBits(uint8_t m) {
+    uint8_t r = 0;
+    uint8_t b;
+
+    for (b = 0; b < LOG2_HALF; b++) {
+        r = (uint8_t)((r << 1) | (m & 1));
+        m >>= 1;
+    }
+    return r;
+}
+
+void fftEstimatorInit(FftEstimator *e, uint16_t sampleRateHz) {
+    e->step = (sampleRateHz > SPECTRAL_RATE_HZ) ? (uint8_t)(sampleRateHz / SPECTRAL_RATE_HZ) : 1;
+    e->stepCount = e->step;
+    e->sum = 0;
+    e->dcQ8 = 0;
+    e->dcValid = 0;
+    e->head = 0;
+    e->filled = 0;
+    e->count = 0;
+    e->valid = 0;
+    e->bpm = 0;
+    e->updates = 0;
+
+    // Bin k is at k * 60 * rate / FFT_SIZE BPM, one bin beyond the range on both sides
+    e->rate = sampleRateHz / e->step;
+    e->binMin = (uint8_t)((uint32_t)SPECTRAL_BPM_MIN * FFT_SIZE / (60UL * e->rate));
+    e->binMax = (uint8_t)(((uint32_t)SPECTRAL_BPM_MAX * FFT_SIZE + 60UL * e->rate - 1) /
+                          (60UL * e->rate));
+    if (e->binMax - e->binMin >= FFT_MAX_BINS) {
+        e->binMax = (uint8_t)(e->binMin + FFT_MAX_BINS - 1);
+    }
+}
+
+// Window in time order, packed as re = even, im = odd value, in bit reversed order
+static void load(FftEstimator *e) {
+    uint16_t n;
+    uint8_t index = e->head;
+    uint8_t m;
+
+    for (m = 0; m < FFT_HALF; m++) {
+        e->re[m] = 0;
+        e->im[m] = 0;
+    }
+    for (n = 0; n < SPECTRAL_WINDOW; n++) {
+        m = reverseBits((uint8_t)(n >> 1));
+        if (n & 1) {
+            e->im[m] = e->ring[index];
+        } else {
+            e->re[m] = e->ring[index];
+        }
+        if (++index == SPECTRAL_WINDOW) {
+            index = 0;
+        }
+    }
+}
+
+// Radix-2 decimation in time, halved in every stage so the magnitudes cannot grow
+static void transform(FftEstimator *e) {
+    uint16_t size, half, i, j, b;
+    int16_t c, s;
+    int32_t tr, ti;
+
+    for (size = 2; size <= FFT_HALF; size <<= 1) {
+        half = size / 2;
+        for (j = 0; j < half; j++) {
+            c = cosQ15((uint16_t)(j * (FFT_SIZE / size)));
+            s = sinQ15((uint16_t)(j * (FFT_SIZE / size)));
+            for (i = j; i < FFT_HALF; i += size) {
+                b = i + half;
+                tr = ((int32_t)e->re[b] * c + (int32_t)e->im[b] * s) >> 15;
+                ti = ((int32_t)e->im[b] * c - (int32_t)e->re[b] * s) >> 15;
+                e->re[b] = (int16_t)((e->re[i] - tr) >> 1);
+                e->im[b] = (int16_t)((e->im[i] - ti) >> 1);
+                e->re[i] = (int16_t)((e->re[i] + tr) >> 1);
+                e->im[i] = (int16_t)((e->im[i] + ti) >> 1);
+            }
+        }
+    }
+}
+
+// Bin k of the real input from the packed transform: even part plus odd part turned by
+// the twiddle of the full length
+static int32_t binPower(const FftEstimator *e, uint8_t k) {
+    int32_t evenRe = ((int32_t)e->re[k] + e->re[FFT_HALF - k]) >> 1;
+    int32_t evenIm = ((int32_t)e->im[k] - e->im[FFT_HALF - k]) >> 1;
+    int32_t oddRe = ((int32_t)e->im[k] + e->im[FFT_HALF - k]) >> 1;
+    int32_t oddIm = ((int32_t)e->re[FFT_HALF - k] - e->re[k]) >> 1;
+    int16_t c = cosQ15(k);
+    int16_t s = sinQ15(k);
+    int32_t re = (evenRe + ((oddRe * c + oddIm * s) >> 15)) >> 1;
+    int32_t im = (evenIm + ((oddIm * c - oddRe * s) >> 15)) >> 1;
+
+    return re * re + im * im;
+}
+
+static int32_t power(const FftEstimator *e, uint8_t k) {
+    return e->power[k - e->binMin];
+}
+
+// Same decisions as evaluate() in spectral.c, on the FFT bins
+static void evaluate(FftEstimator *e) {
+    int64_t total = 0;
+    int64_t num, den;
+    int32_t peakPower = 0;
+    int32_t p, left, right;
+    uint8_t bins = (uint8_t)(e->binMax - e->binMin + 1);
+    uint8_t peak = e->binMin;
+    uint8_t k;
+    int32_t bpm10;
+
+    for (k = e->binMin; k <= e->binMax; k++) {
+        p = binPower(e, k);
+        e->power[k - e->binMin] = p;
+        total += p;
+        if (p > peakPower) {
+            peakPower = p;
+            peak = k;
+        }
+    }
+
+    // Second harmonic check, the bin nearest to half the peak frequency
+    k = (uint8_t)((peak + 1) / 2);
+    if (k > e->binMin && k < e->binMax) {
+        left = power(e, k - 1);
+        p = power(e, k);
+        right = power(e, k + 1);
+        if (left > p && left > right && k - 1 > e->binMin) {
+            k--;
+            right = p;
+            p = left;
+            left = power(e, k - 1);
+        } else if (right > p && right > left && k + 1 < e->binMax) {
+            k++;
+            left = p;
+            p = right;
+            right = power(e, k + 1);
+        }
+        if ((int64_t)p * 2 >= peakPower && p >= left && p >= right) {
+            peak = k;
+            peakPower = p;
+        }
+    }
+
+    e->updates++;
+    if ((int64_t)peakPower * bins < total * SPECTRAL_PEAK_RATIO || peak == e->binMin ||
+        peak == e->binMax) {
+        e->valid = 0;
+        e->bpm = 0;
+        return;
+    }
+
+    left = power(e, peak - 1);
+    right = power(e, peak + 1);
+    num = (int64_t)left - right;
+    den = 2 * ((int64_t)left - 2 * (int64_t)peakPower + right);
+    bpm10 = (int32_t)((uint32_t)peak * 600 * e->rate / FFT_SIZE);
+    if (den != 0) {
+        bpm10 += (int32_t)((num * 600 * e->rate) / (den * FFT_SIZE));
+    }
+    e->bpm = (uint16_t)((bpm10 + 5) / 10);
+    e->valid = 1;
+}
+
+uint8_t fftEstimatorProcess(FftEstimator *e, int16_t value) {
+    int32_t x;
+
+    e->sum += value;
+    if (--e->stepCount != 0) {
+        return 0;
+    }
+    e->stepCount = e->step;
+    x = e->sum / e->step;
+    e->sum = 0;
+
+    if (!e->dcValid) {
+        e->dcQ8 = x << 8;
+        e->dcValid = 1;
+    }
+    e->dcQ8 += ((x << 8) - e->dcQ8) >> DC_SHIFT;
+    x = (x - (e->dcQ8 >> 8)) * (1 << INPUT_SHIFT);
+    if (x > INPUT_LIMIT) {
+        x = INPUT_LIMIT;
+    } else if (x < -INPUT_LIMIT) {
+        x = -INPUT_LIMIT;
+    }
+
+    e->ring[e->head] = (int16_t)x;
+    if (++e->head == SPECTRAL_WINDOW) {
+        e->head = 0;
+        e->filled = 1;
+    }
+    // Every half window once the ring is full, at the same values as the Goertzel banks
+    if (++e->count < SPECTRAL_WINDOW / 2) {
+        return 0;
+    }
+    e->count = 0;
+    if (!e->filled) {
+        return 0;
+    }
+    load(e);
+    transform(e);
+    evaluate(e);
+    return 1;
+}
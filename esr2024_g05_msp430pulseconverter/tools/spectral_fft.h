@@ -0,0 +1,52 @@
+//***************************************************************************************
+//  Spektrale Pulsschaetzung mit einer Festkomma-FFT (Vergleich zu spectral.c)
+//
+//  Beschreibung: Dieselbe Vorverarbeitung wie spectral.c (Mittelung auf ca. 25 Hz,
+//  Gleichanteil entfernt), die Werte kommen in einen Ring ueber SPECTRAL_WINDOW Werte.
+//  Alle SPECTRAL_WINDOW / 2 Werte wird das Fenster, mit Nullen auf FFT_SIZE Werte
+//  aufgefuellt, als reelle FFT gerechnet: die Werte werden paarweise in FFT_HALF komplexe
+//  Werte gepackt, radix-2 transformiert (16-Bit-Daten, Q15-Drehfaktoren, je Stufe durch
+//  2 geteilt) und die Bins von 30..220 BPM aus beiden Haelften zurueckgewonnen. Auswahl
+//  des Spitzenbins, Pruefung der halben Frequenz und Interpolation wie in spectral.c.
+//  Nur fuer tools/bench_spectral.c und tools/cycles, nicht Teil der Firmware.
+//  Frei von Hardwarezugriffen.
+//***************************************************************************************
+
+#ifndef SPECTRAL_FFT_H_
+#define SPECTRAL_FFT_H_
+
+#include <stdint.h>
+
+#include "spectral.h"
+
+#define FFT_SIZE            256     // Real values, SPECTRAL_WINDOW zero padded
+#define FFT_HALF            (FFT_SIZE / 2)
+#define FFT_MAX_BINS        40      // Bins of 30..220 BPM at the lowest averaged rate
+
+typedef struct {
+    int16_t  ring[SPECTRAL_WINDOW];
+    uint8_t  head;
+    uint8_t  filled;            // Ring holds a whole window
+    uint8_t  count;             // Values since the last transform
+    int16_t  re[FFT_HALF];
+    int16_t  im[FFT_HALF];
+    int32_t  power[FFT_MAX_BINS];
+    uint8_t  binMin;            // First and last bin inside 30..220 BPM
+    uint8_t  binMax;
+    uint16_t rate;              // Averaged rate in Hz
+    uint8_t  step;              // Input samples per averaged value
+    uint8_t  stepCount;
+    int32_t  sum;
+    int32_t  dcQ8;
+    uint8_t  dcValid;
+    uint8_t  valid;
+    uint16_t bpm;               // Last estimate, 0 if not valid
+    uint16_t updates;
+} FftEstimator;
+
+void fftEstimatorInit(FftEstimator *e, uint16_t sampleRateHz);
+
+// Feed every filtered sample, returns 1 if the window was transformed and 'bpm' updated
+uint8_t fftEstimatorProcess(FftEstimator *e, int16_t value);
+
+#endif /* SPECTRAL_FFT_H_ */
@@ -0,0 +1,48 @@
+//***************************************************************************************
+//  Pruefmakros der Host-Tests (tools/test_*.c)
+//
+//  Beschreibung: Die Tests uebersetzen die Module der Firmware, die frei von
+//  Hardwarezugriffen sind, unveraendert fuer den PC; i2c_async.c laeuft gegen das
+//  Registermodell in tools/sim/msp430.h. CHECK() zaehlt jede Pruefung und
+//  meldet fehlgeschlagene mit Datei und Zeile, CHECK_EQ() zusaetzlich beide Werte;
+//  testSummary() gibt die Bilanz aus und liefert den Exit-Status. Die Zeile zum
+//  Uebersetzen steht im Kopf jedes Tests, tools/run_tests.py baut und startet alle.
+//***************************************************************************************
+
+#ifndef TEST_H_
+#define TEST_H_
+
+#include <stdio.h>
+
+static int testChecks;
+static int testFailures;
+
+static inline int testCheck(int ok, const char *what, const char *file, int line) {
+    testChecks++;
+    if (!ok) {
+        testFailures++;
+        printf("%s:%d: %s failed\n", file, line, what);
+    }
+    return ok;
+}
+
+static inline int testCheckEq(long actual, long expected, const char *what, const char *file,
+                              int line) {
+    testChecks++;
+    if (actual != expected) {
+        testFailures++;
+        printf("%s:%d: %s: %ld, expected %ld\n", file, line, what, actual, expected);
+    }
+    return actual == expected;
+}
+
+#define CHECK(cond)                 testCheck((cond) != 0, #cond, __FILE__, __LINE__)
+#define CHECK_EQ(actual, expected)  testCheckEq((long)(actual), (long)(expected), #actual, \
+                                                __FILE__, __LINE__)
+
+static inline int testSummary(const char *name) {
+    printf("%s: %d checks, %d failed\n", name, testChecks, testFailures);
+    return testFailures != 0;
+}
+
+#endif /* TEST_H_ */
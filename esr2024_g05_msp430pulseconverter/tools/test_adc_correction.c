@@ -0,0 +1,141 @@
+//***************************************************************************************
+//  Host-Test der ADC-Korrektur (adc_correction.c)
+//
+//  Beschreibung: Vergleicht adcCorrect() und adcCorrectBlock() fuer jeden 12-Bit-Wert
+//  mit der Formel aus adc_correction.h, round(roh * gain / 2^15) + offset (halbe LSB
+//  aufgerundet) begrenzt auf 0..4095:
+//    - ohne Versorgungsfaktor bitgenau, fuer jeden Gain von 0 bis unter 2,0 bei Offset 0
+//      und fuer jeden siebten plausiblen Gain der TLV (tlv_index.h) bei Offsets -128..128
+//    - mit Versorgungsfaktoren von 1,7 bis 3,7 V bezogen auf 3,3 V auf 1 LSB genau gegen
+//      (roh * gain / 2^15 + offset) * supply / 2^15 in double
+//
+//  Uebersetzen (Linux, im Projektverzeichnis):
+//    gcc -O2 -std=c99 -Wall -I. -o test_adc_correction tools/test_adc_correction.c
+//        adc_correction.c -lm
+//***************************************************************************************
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "adc_correction.h"
+#include "tlv_index.h"
+#include "tools/test.h"
+
+#define CODES               (ADC_CORRECTION_MAX + 1)
+#define SUPPLY_MIN          0x41F0      // 1.7 V / 3.3 V in Q15
+#define SUPPLY_MAX          0x8F80      // 3.7 V / 3.3 V
+
+static long clamp(long value) {
+    if (value < 0) {
+        return 0;
+    }
+    return (value > ADC_CORRECTION_MAX) ? ADC_CORRECTION_MAX : value;
+}
+
+// The definition in adc_correction.h, written out without the combined bias
+static long expected(uint16_t raw, uint16_t gain, int16_t offset) {
+    return clamp((long)(((uint32_t)raw * gain + 0x4000) >> 15) + offset);
+}
+
+// Mismatches of one gain and offset over all codes, the first one is printed
+static unsigned compareAll(uint16_t gain, int16_t offset) {
+    static uint16_t block[CODES];
+    AdcCorrection c;
+    unsigned mismatches = 0;
+    uint16_t raw;
+
+    adcCorrectionInit(&c, gain, offset, ADC_CORRECTION_ONE);
+    for (raw = 0; raw < CODES; raw++) {
+        block[raw] = raw;
+    }
+    adcCorrectBlock(&c, block, CODES);
+    for (raw = 0; raw < CODES; raw++) {
+        long want = expected(raw, gain, offset);
+
+        if (adcCorrect(&c, raw) != want || block[raw] != want) {
+            if (mismatches++ == 0) {
+                printf("gain 0x%04X offset %d raw %u: %u / block %u, expected %ld\n", gain,
+                       offset, raw, adcCorrect(&c, raw), block[raw], want);
+            }
+        }
+    }
+    return mismatches;
+}
+
+// Every gain the Q15 factor can hold below 2.0, no offset
+static void testAllGains(void) {
+    unsigned mismatches = 0;
+    uint32_t gain;
+
+    for (gain = 0; gain <= 0xFFFF; gain++) {
+        mismatches += compareAll((uint16_t)gain, 0);
+    }
+    CHECK_EQ(mismatches, 0);
+}
+
+// The plausible range of the TLV, with offsets that push results into both limits
+static void testOffsets(void) {
+    unsigned mismatches;
+    uint32_t gain;
+    int16_t offset;
+
+    for (offset = -TLV_OFFSET_MAX; offset <= TLV_OFFSET_MAX; offset++) {
+        mismatches = 0;
+        for (gain = TLV_FACTOR_ONE - TLV_FACTOR_SPAN; gain <= TLV_FACTOR_ONE + TLV_FACTOR_SPAN;
+             gain += 7) {
+            mismatches += compareAll((uint16_t)gain, offset);
+        }
+        CHECK_EQ(mismatches, 0);
+    }
+}
+
+// Neutral values leave every code unchanged
+static void testIdentity(void) {
+    AdcCorrection c;
+    unsigned changed = 0;
+    uint16_t raw;
+
+    adcCorrectionInit(&c, ADC_CORRECTION_ONE, 0, ADC_CORRECTION_ONE);
+    for (raw = 0; raw < CODES; raw++) {
+        changed += (adcCorrect(&c, raw) != raw);
+    }
+    CHECK_EQ(changed, 0);
+}
+
+// The supply factor and the gain are multiplied ahead, which costs at most one LSB
+static void testSupply(void) {
+    AdcCorrection c;
+    uint32_t supply, gain;
+    int16_t offset;
+    uint16_t raw;
+    long got, want, worst = 0;
+
+    for (supply = SUPPLY_MIN; supply <= SUPPLY_MAX; supply += 0x100) {
+        for (gain = TLV_FACTOR_ONE - TLV_FACTOR_SPAN; gain <= TLV_FACTOR_ONE + TLV_FACTOR_SPAN;
+             gain += 0x80) {
+            for (offset = -TLV_OFFSET_MAX; offset <= TLV_OFFSET_MAX; offset += 64) {
+                adcCorrectionInit(&c, (uint16_t)gain, offset, (uint16_t)supply);
+                for (raw = 0; raw < CODES; raw++) {
+                    got = adcCorrect(&c, raw);
+                    want = clamp(lround((raw * (double)gain / 32768.0 + offset) *
+                                        supply / 32768.0));
+                    if (labs(got - want) > worst) {
+                        worst = labs(got - want);
+                    }
+                }
+            }
+        }
+    }
+    printf("supply: largest difference %ld LSB\n", worst);
+    CHECK(worst <= 1);
+}
+
+int main(void) {
+    testIdentity();
+    testAllGains();
+    testOffsets();
+    testSupply();
+    return testSummary("adc_correction");
+}
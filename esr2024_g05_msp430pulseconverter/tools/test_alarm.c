@@ -0,0 +1,307 @@
+//***************************************************************************************
+//  Host-Test der Alarmzonen (alarm.c) an vorgegebenen Pulsverlaeufen
+//
+//  Beschreibung: Ein Verlauf besteht aus Abschnitten mit Dauer, gueltig/ungueltig und
+//  linear von einem Puls zum naechsten. Er wird wie in der Hauptschleife alle
+//  OUTPUT_WAKE_MS an alarmUpdate() gegeben; jeder Zonenwechsel wird mit Zeitpunkt
+//  festgehalten und mit den erwarteten Wechseln verglichen. Geprueft werden die
+//  Hysterese an beiden Grenzen, die Mindestdauer (auch wenn sie von kurzen Rueckfaellen
+//  unterbrochen wird), der Weg ueber "kein Signal", direkte Spruenge zwischen den
+//  Alarmzonen, eine langsame Rampe, der Ueberlauf des ms-Zaehlers sowie die Muster.
+//  Grenzen wie ab Werk: 50 und 120 BPM, Hysterese 5 BPM, Verzoegerung 5 s.
+//
+//  Uebersetzen (Linux, im Projektverzeichnis):
+//    gcc -O2 -std=c99 -Wall -I. -o test_alarm tools/test_alarm.c alarm.c
+//***************************************************************************************
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "alarm.h"
+#include "config.h"
+#include "output.h"
+#include "tools/test.h"
+
+#define STEP_MS             OUTPUT_WAKE_MS
+#define DELAY_MS            ((uint32_t)DEFAULT_ALARM_DELAY_S * 1000)
+#define MAX_CHANGES         16
+
+typedef struct {
+    uint32_t durationMs;
+    uint8_t  valid;
+    uint16_t fromBpm;
+    uint16_t toBpm;                     // Reached at the end of the segment
+} Segment;
+
+typedef struct {
+    uint32_t timeMs;                    // Relative to the start of the script
+    uint8_t  zone;
+} Change;
+
+typedef struct {
+    Change change[MAX_CHANGES];
+    uint8_t count;
+} Log;
+
+static const char *const zoneNames[ALARM_ZONES] = {"no signal", "brady", "normal", "tachy"};
+
+// Runs the segments from 'startMs' on, the state keeps its zone from before
+static void play(AlarmState *a, const Segment *segments, uint8_t segmentCount,
+                 uint32_t startMs, Log *log) {
+    uint32_t offset = 0;
+    uint32_t t;
+    uint16_t bpm;
+    uint8_t s;
+
+    log->count = 0;
+    for (s = 0; s < segmentCount; s++) {
+        const Segment *seg = &segments[s];
+
+        for (t = 0; t < seg->durationMs; t += STEP_MS) {
+            bpm = (uint16_t)(seg->fromBpm +
+                             ((int32_t)seg->toBpm - seg->fromBpm) * (int32_t)t /
+                             (int32_t)seg->durationMs);
+            if (alarmUpdate(a, seg->valid, bpm, startMs + offset + t) &&
+                log->count < MAX_CHANGES) {
+                log->change[log->count].timeMs = offset + t;
+                log->change[log->count].zone = a->zone;
+                log->count++;
+            }
+        }
+        offset += seg->durationMs;
+    }
+}
+
+static void expectChanges(const char *name, const Log *log, const Change *expected,
+                          uint8_t count) {
+    uint8_t i;
+
+    CHECK_EQ(log->count, count);
+    for (i = 0; i < log->count && i < count; i++) {
+        CHECK_EQ(log->change[i].zone, expected[i].zone);
+        CHECK_EQ(log->change[i].timeMs, expected[i].timeMs);
+    }
+    printf("%-14s", name);
+    for (i = 0; i < log->count; i++) {
+        printf(" %s@%lu", zoneNames[log->change[i].zone],
+               (unsigned long)log->change[i].timeMs);
+    }
+    printf("\n");
+}
+
+static void configure(AlarmState *a) {
+    alarmConfigure(a, DEFAULT_BRADY_BPM, DEFAULT_TACHY_BPM, DEFAULT_ALARM_HYSTERESIS,
+                   DEFAULT_ALARM_DELAY_S);
+}
+
+// From no signal to normal after ALARM_CLEAR_MS, and the alarm zones off no signal
+// directly, without passing normal
+static void testStart(void) {
+    static const Segment normal[] = {{10000, 1, 72, 72}};
+    static const Segment fast[] = {{10000, 1, 140, 140}};
+    static const Segment slow[] = {{10000, 1, 40, 40}};
+    static const Change normalChanges[] = {{ALARM_CLEAR_MS, ALARM_ZONE_NORMAL}};
+    static const Change fastChanges[] = {{DELAY_MS, ALARM_ZONE_TACHY}};
+    static const Change slowChanges[] = {{DELAY_MS, ALARM_ZONE_BRADY}};
+    AlarmState a;
+    Log log;
+
+    configure(&a);
+    CHECK_EQ(a.zone, ALARM_ZONE_NO_SIGNAL);
+    play(&a, normal, 1, 0, &log);
+    expectChanges("start normal", &log, normalChanges, 1);
+
+    configure(&a);
+    play(&a, fast, 1, 0, &log);
+    expectChanges("start tachy", &log, fastChanges, 1);
+
+    configure(&a);
+    play(&a, slow, 1, 0, &log);
+    expectChanges("start brady", &log, slowChanges, 1);
+}
+
+// Entering needs the limit plus the hysteresis, leaving the limit minus it
+static void testHysteresisTachy(void) {
+    static const Segment script[] = {
+        {5000,  1, 72,  72},            // Settle in normal
+        {20000, 1, 125, 125},           // Inside normal widened by 5
+        {10000, 1, 126, 126},           // Tachy after the delay
+        {20000, 1, 116, 116},           // Inside tachy widened by 5
+        {10000, 1, 115, 115},           // Normal after ALARM_CLEAR_MS
+    };
+    static const Change expected[] = {
+        {ALARM_CLEAR_MS, ALARM_ZONE_NORMAL},
+        {25000 + DELAY_MS, ALARM_ZONE_TACHY},
+        {55000 + ALARM_CLEAR_MS, ALARM_ZONE_NORMAL},
+    };
+    AlarmState a;
+    Log log;
+
+    configure(&a);
+    play(&a, script, 5, 0, &log);
+    expectChanges("tachy limit", &log, expected, 3);
+}
+
+static void testHysteresisBrady(void) {
+    static const Segment script[] = {
+        {5000,  1, 72, 72},
+        {20000, 1, 45, 45},             // Normal down to 50 - 5
+        {10000, 1, 44, 44},
+        {20000, 1, 54, 54},             // Brady up to 49 + 5
+        {10000, 1, 55, 55},
+    };
+    static const Change expected[] = {
+        {ALARM_CLEAR_MS, ALARM_ZONE_NORMAL},
+        {25000 + DELAY_MS, ALARM_ZONE_BRADY},
+        {55000 + ALARM_CLEAR_MS, ALARM_ZONE_NORMAL},
+    };
+    AlarmState a;
+    Log log;
+
+    configure(&a);
+    play(&a, script, 5, 0, &log);
+    expectChanges("brady limit", &log, expected, 3);
+}
+
+// Excursions shorter than the delay do not alarm, and a short return to normal restarts
+// the delay
+static void testMinimumDuration(void) {
+    static const Segment script[] = {
+        {5000, 1, 72,  72},
+        {DELAY_MS - STEP_MS, 1, 140, 140},      // One step short
+        {2000, 1, 72,  72},
+        {4000, 1, 140, 140},
+        {200,  1, 100, 100},                    // Interruption, restarts the delay
+        {4000, 1, 140, 140},
+        {200,  1, 100, 100},
+        {10000, 1, 140, 140},                   // 20300: uninterrupted
+    };
+    static const Change expected[] = {
+        {ALARM_CLEAR_MS, ALARM_ZONE_NORMAL},
+        {20300 + DELAY_MS, ALARM_ZONE_TACHY},
+    };
+    AlarmState a;
+    Log log;
+
+    configure(&a);
+    play(&a, script, 8, 0, &log);
+    expectChanges("min duration", &log, expected, 2);
+}
+
+// Signal loss shorter than ALARM_NO_SIGNAL_MS is bridged, a longer one leaves any zone.
+// With a call every STEP_MS the last invalid call of a gap of n ms is at n - STEP_MS.
+static void testNoSignal(void) {
+    static const Segment script[] = {
+        {5000,  1, 72,  72},
+        {ALARM_NO_SIGNAL_MS, 0, 0, 0},                  // 5000: bridged
+        {5000,  1, 72,  72},                            // 7000
+        {ALARM_NO_SIGNAL_MS + STEP_MS, 0, 0, 0},        // 12000: lost
+        {10000, 1, 150, 150},                           // 14100: straight into tachy
+        {5000,  0, 0,   0},                             // 24100
+    };
+    static const Change expected[] = {
+        {ALARM_CLEAR_MS, ALARM_ZONE_NORMAL},
+        {12000 + ALARM_NO_SIGNAL_MS, ALARM_ZONE_NO_SIGNAL},
+        {14100 + DELAY_MS, ALARM_ZONE_TACHY},
+        {24100 + ALARM_NO_SIGNAL_MS, ALARM_ZONE_NO_SIGNAL},
+    };
+    AlarmState a;
+    Log log;
+
+    configure(&a);
+    play(&a, script, 6, 0, &log);
+    expectChanges("no signal", &log, expected, 4);
+}
+
+// From one alarm zone into the other without a stop in normal
+static void testDirectJump(void) {
+    static const Segment script[] = {
+        {10000, 1, 40,  40},
+        {10000, 1, 160, 160},
+        {10000, 1, 40,  40},
+    };
+    static const Change expected[] = {
+        {DELAY_MS, ALARM_ZONE_BRADY},
+        {10000 + DELAY_MS, ALARM_ZONE_TACHY},
+        {20000 + DELAY_MS, ALARM_ZONE_BRADY},
+    };
+    AlarmState a;
+    Log log;
+
+    configure(&a);
+    play(&a, script, 3, 0, &log);
+    expectChanges("brady<>tachy", &log, expected, 3);
+}
+
+// 60 -> 160 -> 60 BPM over two minutes: tachy is entered DELAY_MS after the pulse first
+// reaches 126, and left ALARM_CLEAR_MS after it first falls to 115
+static void testRamp(void) {
+    static const Segment script[] = {
+        {5000,  1, 60,  60},
+        {60000, 1, 60,  160},
+        {60000, 1, 160, 60},
+    };
+    static const Change expected[] = {
+        {ALARM_CLEAR_MS, ALARM_ZONE_NORMAL},
+        {5000 + 39600 + DELAY_MS, ALARM_ZONE_TACHY},        // 60 + 100 * t / 60 s = 126
+        {65000 + 27000 + ALARM_CLEAR_MS, ALARM_ZONE_NORMAL},  // 160 - 100 * t / 60 s = 115
+    };
+    AlarmState a;
+    Log log;
+
+    configure(&a);
+    play(&a, script, 3, 0, &log);
+    expectChanges("ramp", &log, expected, 3);
+}
+
+// The ms counter of the main loop wraps after 49 days
+static void testCounterWrap(void) {
+    static const Segment script[] = {
+        {10000, 1, 72,  72},
+        {10000, 1, 140, 140},
+    };
+    static const Change expected[] = {
+        {ALARM_CLEAR_MS, ALARM_ZONE_NORMAL},
+        {10000 + DELAY_MS, ALARM_ZONE_TACHY},
+    };
+    AlarmState a;
+    Log log;
+
+    configure(&a);
+    play(&a, script, 2, 0xFFFFFFFFUL - 12000, &log);
+    expectChanges("counter wrap", &log, expected, 2);
+}
+
+static void testPatterns(void) {
+    AlarmState a;
+    uint8_t zone;
+
+    configure(&a);
+    for (zone = 0; zone < ALARM_ZONES; zone++) {
+        const AlarmPattern *p = alarmPattern(zone);
+        uint8_t alarm = (zone == ALARM_ZONE_BRADY || zone == ALARM_ZONE_TACHY);
+
+        a.zone = zone;
+        CHECK_EQ(alarmIsActive(&a) != 0, alarm);
+        CHECK_EQ(p->tone != 0, alarm);
+        CHECK_EQ((p->onLeds & ALARM_LED_RED) != 0, alarm);
+        CHECK(p->onMs <= p->periodMs);
+        CHECK(p->periodMs != 0);
+    }
+    // The faster the pulse, the faster the alarm
+    CHECK(alarmPattern(ALARM_ZONE_TACHY)->periodMs <
+          alarmPattern(ALARM_ZONE_BRADY)->periodMs);
+}
+
+int main(void) {
+    testStart();
+    testHysteresisTachy();
+    testHysteresisBrady();
+    testMinimumDuration();
+    testNoSignal();
+    testDirectJump();
+    testRamp();
+    testCounterWrap();
+    testPatterns();
+    return testSummary("alarm");
+}
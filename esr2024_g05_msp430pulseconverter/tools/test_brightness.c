@@ -0,0 +1,150 @@
+//***************************************************************************************
+//  Host-Test der LED-Helligkeit (brightness.c)
+//
+//  Beschreibung: Prueft brightnessDuty() an den Eckpunkten 0, BRIGHTNESS_LEVEL_MIN und
+//  255, auf Monotonie und fuer jeden Pegel gegen die lineare Interpolation zwischen den
+//  Stuetzstellen BRIGHTNESS_FULL * (i / 64)^2,2 (gerundet) der Gammatabelle.
+//  brightnessPush() muss den Pegel mit etwa BRIGHTNESS_RATE_HZ fortschreiben, bei
+//  flachem Signal 255 liefern und einer Pulskurve von BRIGHTNESS_LEVEL_MIN im Tal bis
+//  255 auf der Spitze folgen, auch nachdem die Amplitude auf ein Zehntel gefallen ist.
+//
+//  Uebersetzen (Linux, im Projektverzeichnis):
+//    gcc -O2 -std=c99 -Wall -I. -o test_brightness tools/test_brightness.c brightness.c -lm
+//***************************************************************************************
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "brightness.h"
+#include "tools/test.h"
+
+#define TWO_PI              6.283185307179586
+#define GAMMA               2.2
+#define PULSE_HZ            1.2
+#define ADAPT_S             10          // Envelope settles well within this
+
+// Gamma table entry i as brightness.c defines it
+static long node(unsigned i) {
+    return lround(BRIGHTNESS_FULL * pow(i / 64.0, GAMMA));
+}
+
+static void testDutyEnds(void) {
+    CHECK_EQ(brightnessDuty(0), 0);
+    CHECK_EQ(brightnessDuty(255), BRIGHTNESS_FULL);
+    // The trough of the pulse: 48 / 255 of the way, 2.2 power, between entries 12 and 13
+    CHECK_EQ(brightnessDuty(BRIGHTNESS_LEVEL_MIN), 101);
+    CHECK(brightnessDuty(BRIGHTNESS_LEVEL_MIN) > 0);
+}
+
+static void testDutyCurve(void) {
+    unsigned level, i, frac;
+    unsigned mismatches = 0, falls = 0;
+    uint16_t duty, last = 0;
+    long want;
+
+    for (level = 0; level <= 255; level++) {
+        i = level * 64 / 255;
+        frac = level * 64 % 255;
+        want = node(i);
+        if (frac != 0) {
+            want += (node(i + 1) - node(i)) * frac / 255;
+        }
+        duty = brightnessDuty((uint8_t)level);
+        if (duty != want && mismatches++ == 0) {
+            printf("level %u: %u, expected %ld\n", level, duty, want);
+        }
+        falls += (duty < last);
+        last = duty;
+    }
+    CHECK_EQ(mismatches, 0);
+    CHECK_EQ(falls, 0);
+}
+
+// One level update per step of 'rate / BRIGHTNESS_RATE_HZ' samples, at least every sample
+static void checkUpdateRate(uint16_t rateHz, unsigned expected) {
+    BrightnessTracker b;
+    unsigned n, updates = 0;
+
+    brightnessInit(&b, rateHz);
+    for (n = 0; n < 1000; n++) {
+        updates += brightnessPush(&b, 0);
+    }
+    CHECK_EQ(updates, expected);
+}
+
+static void testUpdateRate(void) {
+    checkUpdateRate(25, 1000);
+    checkUpdateRate(50, 1000);
+    checkUpdateRate(250, 200);
+    checkUpdateRate(1000, 50);
+}
+
+static void testFlat(void) {
+    BrightnessTracker b;
+    unsigned n, other = 0;
+
+    brightnessInit(&b, 250);
+    CHECK_EQ(b.level, 255);
+    for (n = 0; n < 250 * ADAPT_S; n++) {
+        if (brightnessPush(&b, (int16_t)(300 + (n & 7))) && b.level != 255) {
+            other++;
+        }
+    }
+    CHECK_EQ(other, 0);
+}
+
+// Lowest and highest level over the last 'countS' of 'seconds' of a sine, returns the
+// updates below BRIGHTNESS_LEVEL_MIN over the whole time
+static unsigned followPulse(BrightnessTracker *b, uint16_t rateHz, double amplitude,
+                            unsigned seconds, unsigned countS, uint8_t *low,
+                            uint8_t *high) {
+    unsigned n, below = 0;
+    int16_t value;
+
+    *low = 255;
+    *high = 0;
+    for (n = 0; n < seconds * rateHz; n++) {
+        value = (int16_t)lround(amplitude * sin(TWO_PI * PULSE_HZ * n / rateHz));
+        if (!brightnessPush(b, value)) {
+            continue;
+        }
+        below += (b->level < BRIGHTNESS_LEVEL_MIN);
+        if (n >= (seconds - countS) * rateHz) {
+            if (b->level < *low) {
+                *low = b->level;
+            }
+            if (b->level > *high) {
+                *high = b->level;
+            }
+        }
+    }
+    return below;
+}
+
+static void testPulse(uint16_t rateHz) {
+    BrightnessTracker b;
+    uint8_t low, high;
+
+    brightnessInit(&b, rateHz);
+    CHECK_EQ(followPulse(&b, rateHz, 1000.0, ADAPT_S, ADAPT_S / 2, &low, &high), 0);
+    printf("%4u Hz, amplitude 1000: level %u..%u\n", rateHz, low, high);
+    CHECK_EQ(low, BRIGHTNESS_LEVEL_MIN);
+    CHECK_EQ(high, 255);
+
+    // The envelope creeps in on a weaker signal, the LED keeps its full swing
+    CHECK_EQ(followPulse(&b, rateHz, 100.0, ADAPT_S, ADAPT_S / 2, &low, &high), 0);
+    printf("%4u Hz, amplitude  100: level %u..%u\n", rateHz, low, high);
+    CHECK_EQ(low, BRIGHTNESS_LEVEL_MIN);
+    CHECK_EQ(high, 255);
+}
+
+int main(void) {
+    testDutyEnds();
+    testDutyCurve();
+    testUpdateRate();
+    testFlat();
+    testPulse(250);
+    testPulse(1000);
+    return testSummary("brightness");
+}
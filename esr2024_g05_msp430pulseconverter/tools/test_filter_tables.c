@@ -0,0 +1,133 @@
+//***************************************************************************************
+//  Host-Test der Filtertabelle (filter_tables.c)
+//
+//  Beschreibung: Prueft jeden ausgelieferten Koeffizientensatz gegen die Vorgaben von
+//  tools/gen_filter_tables.py, damit eine von Hand geaenderte oder veraltete Tabelle
+//  auffaellt:
+//    - Gleichanteil genau 1 (Summe der b gleich 1 + a1 + a2 in Q14)
+//    - Betrag bei 10 Hz -3 dB +-CUTOFF_TOLERANCE_DB, bei 50 Hz unter STOPBAND_MAX_DB
+//    - beide Pole im Einheitskreis mit Radius unter MAX_POLE_RADIUS
+//    - biquadStep() erreicht dieselben Betraege im Festkomma auf 0,5 dB und laesst einen
+//      konstanten Wert nach dem Einschwingen unveraendert durch
+//  Dazu liefert filterTableForRate() jeden Satz und 0 fuer andere Raten.
+//
+//  Uebersetzen (Linux, im Projektverzeichnis):
+//    gcc -O2 -std=c99 -Wall -I. -o test_filter_tables tools/test_filter_tables.c
+//        filter_tables.c biquad.c -lm
+//***************************************************************************************
+
+#include <complex.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "biquad.h"
+#include "filter_tables.h"
+#include "tools/test.h"
+
+#define TWO_PI              6.283185307179586
+#define Q14                 16384.0
+#define CUTOFF_HZ           10.0
+#define CUTOFF_TOLERANCE_DB 0.5         // About 5 % of the cutoff frequency
+#define STOPBAND_HZ         50.0        // Mains hum
+#define STOPBAND_MAX_DB     -25.0
+#define MAX_POLE_RADIUS     0.999
+#define FIXED_TOLERANCE_DB  0.5
+#define AMPLITUDE           8000.0      // Test sine in ADC codes, well inside int16_t
+
+// Gain of the Q14 set at 'freqHz' in dB, from the transfer function
+static double gainDb(const int16_t *c, uint16_t rateHz, double freqHz) {
+    double complex z1 = cexp(-I * TWO_PI * freqHz / rateHz);    // z^-1
+    double complex num = (c[0] + c[1] * z1 + c[2] * z1 * z1) / Q14;
+    double complex den = 1.0 + (c[3] * z1 + c[4] * z1 * z1) / Q14;
+
+    return 20.0 * log10(cabs(num / den));
+}
+
+// Larger pole radius of z^2 + a1 z + a2
+static double poleRadius(const int16_t *c) {
+    double a1 = c[3] / Q14, a2 = c[4] / Q14;
+    double complex root = csqrt(a1 * a1 - 4.0 * a2 + 0.0 * I);
+    double r1 = cabs((-a1 + root) / 2.0), r2 = cabs((-a1 - root) / 2.0);
+
+    return (r1 > r2) ? r1 : r2;
+}
+
+// Gain of biquadStep() at 'freqHz' in dB, from the last second after two seconds to settle
+static double fixedGainDb(const int16_t *c, uint16_t rateHz, double freqHz) {
+    BiquadState state;
+    unsigned n;
+    double in, out, inPower = 0.0, outPower = 0.0;
+
+    biquadReset(&state, 0);
+    for (n = 0; n < 3u * rateHz; n++) {
+        in = AMPLITUDE * sin(TWO_PI * freqHz * n / rateHz);
+        out = biquadStep(&state, c, (int16_t)lround(in));
+        if (n >= 2u * rateHz) {
+            inPower += in * in;
+            outPower += out * out;
+        }
+    }
+    return 10.0 * log10(outPower / inPower);
+}
+
+static void checkTable(const FilterTable *t) {
+    const int16_t *c = t->coeffs;
+    double dc, cutoff, stop, radius, fixedCutoff, fixedStop;
+    BiquadState state;
+    unsigned n;
+    int16_t out = 0;
+
+    dc = gainDb(c, t->sampleRateHz, 0.0);
+    cutoff = gainDb(c, t->sampleRateHz, CUTOFF_HZ);
+    stop = gainDb(c, t->sampleRateHz, STOPBAND_HZ);
+    radius = poleRadius(c);
+    fixedCutoff = fixedGainDb(c, t->sampleRateHz, CUTOFF_HZ);
+    fixedStop = fixedGainDb(c, t->sampleRateHz, STOPBAND_HZ);
+    printf("%4u Hz: DC %+.2f dB, 10 Hz %+.2f dB (fixed %+.2f), 50 Hz %+.1f dB "
+           "(fixed %+.1f), pole radius %.4f\n", t->sampleRateHz, dc, cutoff, fixedCutoff,
+           stop, fixedStop, radius);
+
+    CHECK_EQ(c[0] + c[1] + c[2], (long)Q14 + c[3] + c[4]);
+    CHECK(fabs(dc) < 1e-9);
+    CHECK(fabs(cutoff + 3.0103) <= CUTOFF_TOLERANCE_DB);
+    CHECK(stop < STOPBAND_MAX_DB);
+    CHECK(radius < MAX_POLE_RADIUS);
+    CHECK(fabs(fixedCutoff - cutoff) <= FIXED_TOLERANCE_DB);
+    CHECK(fixedStop < STOPBAND_MAX_DB + FIXED_TOLERANCE_DB);
+
+    // A step settles on the new value exactly
+    biquadReset(&state, 1000);
+    for (n = 0; n < t->sampleRateHz; n++) {
+        out = biquadStep(&state, c, 3000);
+    }
+    CHECK_EQ(out, 3000);
+}
+
+static void testTables(void) {
+    uint8_t i;
+
+    for (i = 0; i < FILTER_TABLE_COUNT; i++) {
+        checkTable(&filterTables[i]);
+        if (i > 0) {
+            CHECK(filterTables[i].sampleRateHz > filterTables[i - 1].sampleRateHz);
+        }
+    }
+}
+
+static void testLookup(void) {
+    uint8_t i;
+
+    for (i = 0; i < FILTER_TABLE_COUNT; i++) {
+        CHECK(filterTableForRate(filterTables[i].sampleRateHz) == &filterTables[i]);
+    }
+    CHECK(filterTableForRate(0) == 0);
+    CHECK(filterTableForRate(100) == 0);
+    CHECK(filterTableForRate(2000) == 0);
+}
+
+int main(void) {
+    testTables();
+    testLookup();
+    return testSummary("filter_tables");
+}
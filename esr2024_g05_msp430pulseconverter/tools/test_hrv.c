@@ -0,0 +1,222 @@
+//***************************************************************************************
+//  Host-Test der HRV-Fenster (hrv.c) gegen eine Rechnung in double
+//
+//  Beschreibung: Die Schlagabstaende kommen aus ppg_synth.c (Puls, Zufallsanteil und
+//  respiratorische Sinusarrhythmie je Fall verschieden), dazu Unterbrechungen wie nach
+//  ungueltigen Schlaegen. Dieselbe Folge laeuft durch hrvAddIbi() und eine Referenz, die
+//  alle Abstaende eines Fensters speichert und Mittelwert, SDNN (n - 1), RMSSD und
+//  pNN50 in double berechnet. Mittelwert, SDNN und RMSSD duerfen um hoechstens
+//  MAX_ERROR_MS abweichen (Rundung auf ganze ms und Festkommafehler), pNN50 muss gleich
+//  sein. Dazu kommen ein konstanter
+//  Abstand (SDNN 0) und Fenster mit sehr grosser Streuung. Die Zyklen je Schlag auf dem
+//  MSP430 misst tools/cycles (KERNEL_HRV).
+//
+//  Uebersetzen (Linux, im Projektverzeichnis):
+//    gcc -O2 -std=c99 -Wall -I. -Itools -o test_hrv tools/test_hrv.c hrv.c
+//        tools/ppg_synth.c -lm
+//***************************************************************************************
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "hrv.h"
+#include "ppg_synth.h"
+#include "tools/test.h"
+
+#define MAX_WINDOW_BEATS    1024        // 5 min at 200 BPM
+#define CHUNK_SAMPLES       1000
+#define BREAK_EVERY         37          // Beats between two invalid ones
+#define MAX_ERROR_MS        0.6
+
+// Stores the intervals of a window, the same window rule as hrv.c
+typedef struct {
+    uint32_t lengthMs;
+    uint32_t elapsedMs;
+    uint16_t ibi[MAX_WINDOW_BEATS];
+    uint8_t follows[MAX_WINDOW_BEATS];  // Interval follows a valid one
+    uint16_t count;
+    uint16_t lastIbiMs;
+    double mean, sdnn, rmssd, pnn50;
+    uint8_t valid;
+} Reference;
+
+static double maxMeanError, maxSdnnError, maxRmssdError;
+static unsigned windows;
+
+static void referenceInit(Reference *r, uint16_t lengthS) {
+    r->lengthMs = (uint32_t)lengthS * 1000;
+    r->elapsedMs = 0;
+    r->count = 0;
+    r->lastIbiMs = 0;
+    r->valid = 0;
+}
+
+static void referenceFinish(Reference *r) {
+    double sum = 0.0, squares = 0.0, diffSquares = 0.0;
+    unsigned diffs = 0, nn50 = 0;
+    uint16_t i;
+
+    for (i = 0; i < r->count; i++) {
+        sum += r->ibi[i];
+    }
+    r->mean = sum / r->count;
+    for (i = 0; i < r->count; i++) {
+        squares += (r->ibi[i] - r->mean) * (r->ibi[i] - r->mean);
+        if (r->follows[i]) {
+            // The first interval of a window follows the last one of the previous
+            double diff = (double)r->ibi[i] - (i == 0 ? r->lastIbiMs : r->ibi[i - 1]);
+
+            diffSquares += diff * diff;
+            diffs++;
+            if (fabs(diff) > HRV_NN50_MS) {
+                nn50++;
+            }
+        }
+    }
+    r->sdnn = sqrt(squares / (r->count - 1));
+    r->rmssd = diffs ? sqrt(diffSquares / diffs) : 0.0;
+    r->pnn50 = diffs ? floor(100.0 * nn50 / diffs + 0.5) : 0.0;
+    r->valid = 1;
+}
+
+// Returns 1 if a window was completed, like hrvAddIbi()
+static uint8_t referenceAdd(Reference *r, uint16_t ibiMs, uint16_t previousMs) {
+    uint8_t done = 0;
+
+    r->ibi[r->count] = ibiMs;
+    r->follows[r->count] = (previousMs != 0);
+    if (r->count == 0) {
+        r->lastIbiMs = previousMs;
+    }
+    r->count++;
+    r->elapsedMs += ibiMs;
+    if (r->elapsedMs >= r->lengthMs) {
+        if (r->count >= 2) {
+            referenceFinish(r);
+        }
+        r->elapsedMs = 0;
+        r->count = 0;
+        done = 1;
+    }
+    return done;
+}
+
+static void compare(const HrvWindow *w, const Reference *r) {
+    double meanError = fabs(w->result.meanIbiMs - r->mean);
+    double sdnnError = fabs(w->result.sdnnMs - r->sdnn);
+    double rmssdError = fabs(w->result.rmssdMs - r->rmssd);
+
+    CHECK(w->result.valid);
+    CHECK(meanError <= MAX_ERROR_MS);
+    CHECK(sdnnError <= MAX_ERROR_MS);
+    CHECK(rmssdError <= MAX_ERROR_MS);
+    CHECK_EQ(w->result.pnn50, (long)r->pnn50);
+    if (meanError > maxMeanError) {
+        maxMeanError = meanError;
+    }
+    if (sdnnError > maxSdnnError) {
+        maxSdnnError = sdnnError;
+    }
+    if (rmssdError > maxRmssdError) {
+        maxRmssdError = rmssdError;
+    }
+    windows++;
+}
+
+// Both sides get the same interval, or the same break
+static void feed(HrvWindow *w, Reference *r, uint16_t ibiMs, uint16_t *previousMs) {
+    uint8_t done = hrvAddIbi(w, ibiMs);
+
+    CHECK_EQ(referenceAdd(r, ibiMs, *previousMs), done);
+    if (done && r->valid) {
+        compare(w, r);
+        r->valid = 0;
+    }
+    *previousMs = ibiMs;
+}
+
+static void runSynth(const char *name, double bpm, double hrvSdMs, double rsaMs,
+                     uint16_t windowS, unsigned minutes) {
+    static PpgSynth synth;
+    static uint16_t samples[CHUNK_SAMPLES];
+    static HrvWindow w;
+    static Reference r;
+    PpgSynthParams p;
+    PpgBeat beats[16];
+    uint64_t total;
+    uint16_t previousMs = 0;
+    unsigned beatCount = 0, before = windows;
+    size_t n, i;
+
+    ppgSynthDefaults(&p);
+    p.bpm = bpm;
+    p.hrvSdMs = hrvSdMs;
+    p.rsaMs = rsaMs;
+    ppgSynthInit(&synth, &p);
+    hrvInit(&w, windowS);
+    referenceInit(&r, windowS);
+
+    for (total = 0; total < (uint64_t)minutes * 60 * p.sampleRateHz; total += CHUNK_SAMPLES) {
+        n = ppgSynthGenerate(&synth, samples, CHUNK_SAMPLES, beats, 16);
+        for (i = 0; i < n; i++) {
+            if (beats[i].ibiMs == 0) {
+                continue;
+            }
+            if (++beatCount % BREAK_EVERY == 0) {
+                hrvBreak(&w);
+                previousMs = 0;
+                continue;
+            }
+            feed(&w, &r, (uint16_t)beats[i].ibiMs, &previousMs);
+        }
+    }
+    printf("%-12s %3u s windows: %3u compared, last SDNN %3u ms, RMSSD %3u ms, pNN50 %3u %%\n",
+           name, windowS, windows - before, w.result.sdnnMs, w.result.rmssdMs, w.result.pnn50);
+    CHECK(windows - before >= minutes * 60 / windowS * 9 / 10);     // Breaks cost time
+}
+
+static void testConstant(void) {
+    HrvWindow w;
+    uint16_t i;
+
+    hrvInit(&w, HRV_SHORT_WINDOW_S);
+    for (i = 0; i < 60; i++) {
+        hrvAddIbi(&w, 1000);
+    }
+    CHECK(w.result.valid);
+    CHECK_EQ(w.result.meanIbiMs, 1000);
+    CHECK_EQ(w.result.sdnnMs, 0);
+    CHECK_EQ(w.result.rmssdMs, 0);
+    CHECK_EQ(w.result.pnn50, 0);
+}
+
+// Alternating 300 and 1800 ms for 5 minutes: the widest spread the accumulators see
+static void testWideSpread(void) {
+    static HrvWindow w;
+    static Reference r;
+    uint16_t previousMs = 0;
+    uint16_t i;
+
+    hrvInit(&w, HRV_LONG_WINDOW_S);
+    referenceInit(&r, HRV_LONG_WINDOW_S);
+    for (i = 0; i < 600 && windows == 0; i++) {
+        feed(&w, &r, (i & 1) ? 1800 : 300, &previousMs);
+    }
+    CHECK_EQ(windows, 1);
+    CHECK_EQ(w.result.pnn50, 100);
+}
+
+int main(void) {
+    testConstant();
+    testWideSpread();
+    runSynth("resting", 60.0, 40.0, 50.0, HRV_SHORT_WINDOW_S, 30);
+    runSynth("resting", 60.0, 40.0, 50.0, HRV_LONG_WINDOW_S, 60);
+    runSynth("default", 72.0, 20.0, 30.0, HRV_SHORT_WINDOW_S, 30);
+    runSynth("exercise", 160.0, 3.0, 2.0, HRV_SHORT_WINDOW_S, 30);
+    runSynth("exercise", 160.0, 3.0, 2.0, HRV_LONG_WINDOW_S, 60);
+    runSynth("bradycardia", 42.0, 80.0, 120.0, HRV_LONG_WINDOW_S, 60);
+    printf("max error: mean %.2f ms, SDNN %.2f ms, RMSSD %.2f ms over %u windows\n",
+           maxMeanError, maxSdnnError, maxRmssdError, windows);
+    return testSummary("hrv");
+}
@@ -0,0 +1,556 @@
+//***************************************************************************************
+//  Host-Test des I2C-Treibers (i2c_async.c) an einem simulierten eUSCI_B0
+//
+//  Beschreibung: i2c_async.c wird unveraendert gegen tools/sim/msp430.h uebersetzt. Ein
+//  Modell des Busmasters (START, Adresse, Datenbytes mit ACK/NACK, Repeated Start,
+//  STOP, Clock Stretching bei vollem RXBUF, Flags und UCB0IV in der Prioritaet des
+//  eUSCI_B) laeuft mit 400 kHz in CPU-Takten bei 8 MHz. Am Bus haengen der Pulssensor
+//  (0x57), ein Baustein, der das zweite geschriebene Datenbyte nicht bestaetigt (0x3C),
+//  und unter 0x50 keiner. Geprueft wird, dass Ergebnisse und NACKs bei der Transaktion
+//  landen, der das Byte gehoert, auch bei Ketten mit Repeated Start.
+//
+//  Der Durchsatztest misst Transaktionen pro Sekunde und den Anteil der CPU-Zeit
+//  ausserhalb der ISR fuer die Zeigerlesungen des Sensors (je mit STOP) und fuer eine
+//  Kette von Registerschreibungen. Eine ISR kostet ENTRY_CYCLES und ISR_CYCLES plus
+//  ACCESS_CYCLES je Registerzugriff, das ist eine Schaetzung, keine Messung am
+//  Zielsystem.
+//
+//  Uebersetzen (Linux, im Projektverzeichnis):
+//    gcc -O2 -std=c99 -Wall -Wno-unknown-pragmas -DTRACE_ENABLE=0 -Itools/sim -I.
+//        -o test_i2c_async tools/test_i2c_async.c i2c_async.c
+//***************************************************************************************
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <msp430.h>
+#include "driverlib/MSP430FR2xx_4xx/eusci_b_i2c.h"
+#include "i2c_async.h"
+#include "system.h"
+#include "tools/test.h"
+
+#define BUS_HZ              400000UL
+#define CYCLES_PER_BIT      (SMCLK_HZ / BUS_HZ)
+#define ACCESS_CYCLES       4       // One register access with its address arithmetic
+#define ENTRY_CYCLES        6       // Interrupt acceptance up to the first instruction
+#define ISR_CYCLES          34      // Register saves, UCB0IV dispatch, bookkeeping, RETI
+
+#define TXBUF_EMPTY         0xFFFF  // Written bytes are 0..255
+
+#define SENSOR_ADDRESS      0x57
+#define PICKY_ADDRESS       0x3C    // NACKs the second data byte of a write
+#define ABSENT_ADDRESS      0x50
+
+void USCI_B0_ISR(void);
+
+volatile uint16_t simCtlw0;
+volatile uint16_t simI2csa;
+volatile uint16_t simIe;
+volatile uint16_t simTxbuf = TXBUF_EMPTY;
+volatile uint16_t TB1R;
+
+typedef enum {
+    BUS_IDLE,                       // Waits for UCTXSTT
+    BUS_ADDRESS,                    // (Repeated) start and address with ACK
+    BUS_WRITE_WAIT,                 // Byte done, waits for TXBUF, STOP or restart
+    BUS_WRITE,                      // Data byte with ACK from the target
+    BUS_READ,                       // 8 data bits, waits for a free RXBUF at the end
+    BUS_READ_ACK,                   // ACK or NACK from the master
+    BUS_HOLD,                       // After a NACK, waits for STOP or restart
+    BUS_STOP
+} BusState;
+
+static struct {
+    BusState state;
+    uint8_t waiting;                // Next phase starts when the CPU acts, not at phaseEnd
+    uint64_t phaseEnd;
+    uint16_t ifg;
+    uint16_t rxbuf;
+    uint8_t transmit;
+    uint8_t address;
+    uint8_t shift;                  // Byte on the bus
+    uint8_t count;                  // Data bytes of this addressing
+    uint8_t nack;                   // Master NACKs the byte being read
+    uint16_t stops;
+} bus;
+
+static uint64_t now;
+static uint64_t busyCycles;
+static uint8_t inIsr;
+static I2cStats before;             // Driver counters when the test started
+
+static uint8_t written[64];         // Data bytes seen by the targets, in order
+static uint8_t writtenCount;
+
+//---------------------------------------------------------------------------------------
+// Bus model
+//---------------------------------------------------------------------------------------
+
+static uint8_t targetAcksAddress(uint8_t address) {
+    return address == SENSOR_ADDRESS || address == PICKY_ADDRESS;
+}
+
+static uint8_t targetAcksData(uint8_t address, uint8_t count) {
+    return !(address == PICKY_ADDRESS && count == 2);
+}
+
+static void startPhase(BusState state, unsigned bits) {
+    uint64_t start = bus.waiting ? now : bus.phaseEnd;
+
+    bus.state = state;
+    bus.waiting = 0;
+    bus.phaseEnd = start + bits * CYCLES_PER_BIT;
+}
+
+// START or repeated start with the address in UCB0I2CSA
+static void startAddress(void) {
+    bus.transmit = (simCtlw0 & UCTR) != 0;
+    bus.address = (uint8_t)simI2csa;
+    bus.count = 0;
+    if (bus.transmit) {
+        bus.ifg |= UCTXIFG0;
+    }
+    startPhase(BUS_ADDRESS, 10);
+}
+
+static void startStop(void) {
+    simCtlw0 &= ~(UCTXSTT | UCTXSTP);
+    startPhase(BUS_STOP, 1);
+}
+
+// Leave a waiting state, returns 0 while the bus still waits for the CPU
+static uint8_t busContinue(void) {
+    switch (bus.state) {
+    case BUS_IDLE:
+        if (simCtlw0 & UCTXSTT) {
+            startAddress();
+            return 1;
+        }
+        return 0;
+    case BUS_WRITE_WAIT:
+        if (simTxbuf != TXBUF_EMPTY) {
+            bus.shift = (uint8_t)simTxbuf;
+            simTxbuf = TXBUF_EMPTY;
+            bus.ifg |= UCTXIFG0;
+            startPhase(BUS_WRITE, 9);
+            return 1;
+        }
+        // Fall through, STOP and restart are handled as after a NACK
+    case BUS_HOLD:
+        if (bus.state == BUS_HOLD && (inIsr || (bus.ifg & UCNACKIFG))) {
+            return 0;               // The CPU answers a NACK with STOP or restart
+        }
+        if (simCtlw0 & UCTXSTP) {
+            startStop();
+            return 1;
+        }
+        if (simCtlw0 & UCTXSTT) {
+            startAddress();
+            return 1;
+        }
+        return 0;
+    case BUS_READ:
+        if (bus.ifg & UCRXIFG0) {
+            return 0;               // SCL held low until RXBUF is read
+        }
+        bus.rxbuf = (uint8_t)(0xA0 + bus.count++);
+        bus.ifg |= UCRXIFG0;
+        bus.nack = (simCtlw0 & (UCTXSTP | UCTXSTT)) != 0;
+        startPhase(BUS_READ_ACK, 1);
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+// The phase in progress has ended at bus.phaseEnd, returns 1 if the next one started
+static uint8_t busPhaseDone(void) {
+    switch (bus.state) {
+    case BUS_ADDRESS:
+        simCtlw0 &= ~UCTXSTT;
+        if (!targetAcksAddress(bus.address)) {
+            bus.ifg = (bus.ifg & ~UCTXIFG0) | UCNACKIFG;
+            simTxbuf = TXBUF_EMPTY;
+            bus.state = BUS_HOLD;
+        } else if (bus.transmit) {
+            bus.state = BUS_WRITE_WAIT;
+        } else {
+            startPhase(BUS_READ, 8);
+            return 1;
+        }
+        break;
+    case BUS_WRITE:
+        written[writtenCount++ & 63] = bus.shift;
+        if (!targetAcksData(bus.address, ++bus.count)) {
+            bus.ifg = (bus.ifg & ~UCTXIFG0) | UCNACKIFG;
+            simTxbuf = TXBUF_EMPTY;
+            bus.state = BUS_HOLD;
+        } else {
+            bus.state = BUS_WRITE_WAIT;
+        }
+        break;
+    case BUS_READ_ACK:
+        if (!bus.nack) {
+            startPhase(BUS_READ, 8);
+            return 1;
+        }
+        bus.state = BUS_HOLD;
+        break;
+    case BUS_STOP:
+        bus.ifg |= UCSTPIFG;
+        bus.stops++;
+        bus.state = BUS_IDLE;
+        break;
+    default:
+        break;
+    }
+    return 0;
+}
+
+// Bring the bus up to 'now'
+static void busRun(void) {
+    for (;;) {
+        if (!bus.waiting) {
+            if (bus.phaseEnd > now) {
+                return;
+            }
+            if (bus.state != BUS_READ && busPhaseDone()) {
+                continue;
+            }
+        }
+        if (!busContinue()) {
+            bus.waiting = 1;
+            return;
+        }
+    }
+}
+
+static void busReset(void) {
+    memset(&bus, 0, sizeof(bus));
+    bus.waiting = 1;
+    simTxbuf = TXBUF_EMPTY;
+}
+
+//---------------------------------------------------------------------------------------
+// Register access
+//---------------------------------------------------------------------------------------
+
+volatile uint16_t *simAccess(volatile uint16_t *reg) {
+    now += ACCESS_CYCLES;
+    busRun();
+    return reg;
+}
+
+uint16_t simReadRxbuf(void) {
+    now += ACCESS_CYCLES;
+    busRun();
+    bus.ifg &= ~UCRXIFG0;
+    return bus.rxbuf;
+}
+
+// Highest priority pending and enabled flag, cleared by the read
+uint16_t simReadIv(void) {
+    static const struct {
+        uint16_t flag;
+        uint16_t vector;
+    } order[] = {
+        { UCALIFG, USCI_I2C_UCALIFG },
+        { UCNACKIFG, USCI_I2C_UCNACKIFG },
+        { UCSTPIFG, USCI_I2C_UCSTPIFG },
+        { UCRXIFG0, USCI_I2C_UCRXIFG0 },
+        { UCTXIFG0, USCI_I2C_UCTXIFG0 },
+        { UCCLTOIFG, USCI_I2C_UCCLTOIFG }
+    };
+    unsigned i;
+
+    now += ACCESS_CYCLES;
+    busRun();
+    for (i = 0; i < sizeof(order) / sizeof(order[0]); i++) {
+        if (bus.ifg & simIe & order[i].flag) {
+            bus.ifg &= ~order[i].flag;
+            return order[i].vector;
+        }
+    }
+    return 0;
+}
+
+void simWake(uint16_t bits) {
+    (void)bits;
+}
+
+void EUSCI_B_I2C_initMaster(uint16_t baseAddress, EUSCI_B_I2C_initMasterParam *param) {
+    (void)baseAddress;
+    (void)param;
+    simCtlw0 = UCMST | UCSSEL__SMCLK | UCSWRST;
+}
+
+void EUSCI_B_I2C_setTimeout(uint16_t baseAddress, uint16_t timeout) {
+    (void)baseAddress;
+    (void)timeout;
+}
+
+void EUSCI_B_I2C_enable(uint16_t baseAddress) {
+    (void)baseAddress;
+    simCtlw0 &= ~UCSWRST;
+}
+
+void EUSCI_B_I2C_clearInterrupt(uint16_t baseAddress, uint16_t mask) {
+    (void)baseAddress;
+    bus.ifg &= ~mask;
+}
+
+void EUSCI_B_I2C_enableInterrupt(uint16_t baseAddress, uint16_t mask) {
+    (void)baseAddress;
+    simIe |= mask;
+}
+
+//---------------------------------------------------------------------------------------
+// CPU: runs the ISR while a flag is pending, otherwise sleeps until the bus moves
+//---------------------------------------------------------------------------------------
+
+static void runUntil(uint64_t end) {
+    while (now < end) {
+        busRun();
+        if (bus.ifg & simIe) {
+            uint64_t start = now;
+
+            now += ENTRY_CYCLES;
+            inIsr = 1;
+            USCI_B0_ISR();
+            inIsr = 0;
+            now += ISR_CYCLES;
+            busyCycles += now - start;
+        } else if (!bus.waiting && bus.phaseEnd < end) {
+            now = bus.phaseEnd;
+        } else {
+            now = end;
+        }
+    }
+}
+
+static void runIdle(void) {
+    runUntil(now + SMCLK_HZ / 100);
+}
+
+//---------------------------------------------------------------------------------------
+// Tests
+//---------------------------------------------------------------------------------------
+
+static I2cTransaction *finished[16];
+static uint8_t finishedCount;
+static uint8_t resubmit;
+
+static uint8_t recordDone(I2cTransaction *xfer) {
+    finished[finishedCount++ & 15] = xfer;
+    if (resubmit) {
+        i2cAsyncSubmit(xfer);
+    }
+    return 1;
+}
+
+static void setup(I2cTransaction *xfer, uint8_t address, const uint8_t *tx, uint8_t txLength,
+                  uint8_t *rx, uint8_t rxLength, uint8_t flags) {
+    xfer->address = address;
+    xfer->flags = flags;
+    xfer->writeData = tx;
+    xfer->writeLength = txLength;
+    xfer->readData = rx;
+    xfer->readLength = rxLength;
+    xfer->callback = recordDone;
+}
+
+static void reset(void) {
+    runIdle();                      // Nothing left from the previous test
+    busReset();
+    i2cAsyncInit(BUS_HZ);
+    i2cAsyncGetStats(&before);
+    finishedCount = 0;
+    writtenCount = 0;
+    resubmit = 0;
+}
+
+static void checkReadData(const uint8_t *rx, uint8_t length) {
+    uint8_t i;
+
+    for (i = 0; i < length; i++) {
+        CHECK_EQ(rx[i], 0xA0 + i);
+    }
+}
+
+static void testWriteRead(void) {
+    static const uint8_t reg[] = { 0x04 };
+    uint8_t rx[3] = { 0 };
+    I2cTransaction xfer;
+
+    reset();
+    setup(&xfer, SENSOR_ADDRESS, reg, 1, rx, 3, 0);
+    CHECK(i2cAsyncSubmit(&xfer));
+    runIdle();
+    CHECK_EQ(xfer.status, I2C_XFER_OK);
+    CHECK_EQ(finishedCount, 1);
+    CHECK_EQ(bus.stops, 1);
+    CHECK_EQ(writtenCount, 1);
+    CHECK_EQ(written[0], 0x04);
+    checkReadData(rx, 3);
+    CHECK(!i2cAsyncBusy());
+}
+
+static void testChainedWrites(void) {
+    static const uint8_t data[3][2] = { { 0x08, 0x7F }, { 0x09, 0x02 }, { 0x0A, 0x35 } };
+    I2cTransaction xfer[3];
+    uint8_t i;
+
+    reset();
+    for (i = 0; i < 3; i++) {
+        setup(&xfer[i], SENSOR_ADDRESS, data[i], 2, 0, 0, i < 2 ? I2C_FLAG_REPEATED_START : 0);
+        CHECK(i2cAsyncSubmit(&xfer[i]));
+    }
+    runIdle();
+    CHECK_EQ(finishedCount, 3);
+    for (i = 0; i < 3; i++) {
+        CHECK_EQ(xfer[i].status, I2C_XFER_OK);
+        CHECK(finished[i] == &xfer[i]);
+    }
+    CHECK_EQ(bus.stops, 1);
+    CHECK_EQ(writtenCount, 6);
+    CHECK(memcmp(written, data, 6) == 0);
+}
+
+// The last byte of a chained write is refused: the write fails, the transaction chained
+// to it was not on the bus yet and runs after the stop
+static void testChainedWriteNack(void) {
+    static const uint8_t data[] = { 0x10, 0x55 };
+    static const uint8_t reg[] = { 0x00 };
+    uint8_t rx[3] = { 0 };
+    I2cTransaction write, read;
+    I2cStats stats;
+
+    reset();
+    setup(&write, PICKY_ADDRESS, data, 2, 0, 0, I2C_FLAG_REPEATED_START);
+    setup(&read, SENSOR_ADDRESS, reg, 1, rx, 3, 0);
+    CHECK(i2cAsyncSubmit(&write));
+    CHECK(i2cAsyncSubmit(&read));
+    runIdle();
+    CHECK_EQ(write.status, I2C_XFER_NACK);
+    CHECK_EQ(read.status, I2C_XFER_OK);
+    CHECK_EQ(finishedCount, 2);
+    CHECK(finished[0] == &write);
+    CHECK(finished[1] == &read);
+    checkReadData(rx, 3);
+    i2cAsyncGetStats(&stats);
+    CHECK_EQ((uint16_t)(stats.nacks - before.nacks), 1);
+    CHECK_EQ(bus.stops, 2);
+    CHECK(!i2cAsyncBusy());
+}
+
+// The write went through, the address of the chained transaction is refused
+static void testChainedAddressNack(void) {
+    static const uint8_t data[] = { 0x08, 0x7F };
+    static const uint8_t reg[] = { 0x00 };
+    uint8_t rx[3] = { 0 }, rx2[3] = { 0 };
+    I2cTransaction write, absent, read;
+
+    reset();
+    setup(&write, SENSOR_ADDRESS, data, 2, 0, 0, I2C_FLAG_REPEATED_START);
+    setup(&absent, ABSENT_ADDRESS, reg, 1, rx, 3, 0);
+    setup(&read, SENSOR_ADDRESS, reg, 1, rx2, 3, 0);
+    CHECK(i2cAsyncSubmit(&write));
+    CHECK(i2cAsyncSubmit(&absent));
+    CHECK(i2cAsyncSubmit(&read));
+    runIdle();
+    CHECK_EQ(write.status, I2C_XFER_OK);
+    CHECK_EQ(absent.status, I2C_XFER_NACK);
+    CHECK_EQ(read.status, I2C_XFER_OK);
+    CHECK_EQ(finishedCount, 3);
+    CHECK(finished[0] == &write);
+    CHECK(finished[1] == &absent);
+    CHECK(finished[2] == &read);
+    checkReadData(rx2, 3);
+}
+
+// A one byte read chained to a write waits for its start in the ISR
+static void testChainedSingleByteRead(void) {
+    static const uint8_t data[] = { 0x08, 0x7F };
+    uint8_t rx[1] = { 0 };
+    I2cTransaction write, read;
+
+    reset();
+    setup(&write, SENSOR_ADDRESS, data, 2, 0, 0, I2C_FLAG_REPEATED_START);
+    setup(&read, SENSOR_ADDRESS, 0, 0, rx, 1, 0);
+    CHECK(i2cAsyncSubmit(&write));
+    CHECK(i2cAsyncSubmit(&read));
+    runIdle();
+    CHECK_EQ(write.status, I2C_XFER_OK);
+    CHECK_EQ(read.status, I2C_XFER_OK);
+    CHECK_EQ(rx[0], 0xA0);
+    CHECK_EQ(bus.stops, 1);
+}
+
+// Bus bits of one transaction: start, address and data bytes with ACK, repeated start
+// before a read phase, stop
+static unsigned transactionBits(const I2cTransaction *xfer, uint8_t withStop) {
+    unsigned bits = 10 + 9 * (xfer->writeLength + xfer->readLength);
+
+    if (xfer->writeLength != 0 && xfer->readLength != 0) {
+        bits += 10;
+    }
+    return bits + (withStop ? 1 : 0);
+}
+
+// Keep 'inFlight' copies of 'xfer' queued for one second, each resubmitted on completion
+static void measure(const char *name, const I2cTransaction *xfer, uint8_t inFlight,
+                    uint8_t withStop, double minBusShare, double minIdle) {
+    I2cTransaction copies[4];
+    I2cStats stats;
+    uint16_t completed;
+    double busShare, idle;
+    uint64_t start;
+    uint8_t i;
+
+    reset();
+    resubmit = 1;
+    start = now;
+    busyCycles = 0;
+    for (i = 0; i < inFlight; i++) {
+        copies[i] = *xfer;
+        i2cAsyncSubmit(&copies[i]);
+    }
+    runUntil(start + SMCLK_HZ);
+    resubmit = 0;
+    i2cAsyncGetStats(&stats);
+
+    completed = stats.completed - before.completed;
+    busShare = (double)completed * transactionBits(xfer, withStop) / BUS_HZ;
+    idle = 1.0 - (double)busyCycles / SMCLK_HZ;
+    printf("%-22s %6u tx/s, %5.1f %% of the bus limit, CPU idle %5.1f %%\n", name,
+           completed, 100.0 * busShare, 100.0 * idle);
+    CHECK_EQ(stats.nacks, before.nacks);
+    CHECK(busShare >= minBusShare);
+    CHECK(idle >= minIdle);
+}
+
+static void testThroughput(void) {
+    static const uint8_t pointerRegister[] = { 0x00 };
+    static const uint8_t config[] = { 0x08, 0x7F };
+    uint8_t pointers[3], unused[1];
+    I2cTransaction xfer;
+
+    // Sensor pointer burst as ppg_sensor.c reads it, one transaction at a time
+    setup(&xfer, SENSOR_ADDRESS, pointerRegister, 1, pointers, 3, 0);
+    measure("pointer reads:", &xfer, 1, 1, 0.90, 0.50);
+
+    // Register writes chained with repeated starts, several queued
+    setup(&xfer, SENSOR_ADDRESS, config, 2, unused, 0, I2C_FLAG_REPEATED_START);
+    measure("chained writes:", &xfer, 4, 0, 0.90, 0.50);
+}
+
+int main(void) {
+    testWriteRead();
+    testChainedWrites();
+    testChainedWriteNack();
+    testChainedAddressNack();
+    testChainedSingleByteRead();
+    testThroughput();
+    return testSummary("i2c_async");
+}
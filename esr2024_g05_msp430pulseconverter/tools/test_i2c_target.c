@@ -0,0 +1,444 @@
+//***************************************************************************************
+//  Host-Test des I2C-Targets (i2c_target.c) an einem simulierten eUSCI_B1
+//
+//  Beschreibung: i2c_target.c wird unveraendert gegen tools/sim/msp430.h uebersetzt. Ein
+//  Modell des Busmasters schreibt die Registeradresse und liest mit Repeated Start, wie
+//  es der eUSCI als Target sieht: UCSTTIFG beim (Repeated) Start, UCRXIFG0 je
+//  geschriebenem Byte, UCTXIFG0 nach der Adresse und jedes Mal, wenn TXBUF ins
+//  Schieberegister wandert. Das letzte geladene Byte eines Lesezugriffs wird deshalb nie
+//  gesendet, der Master beendet mit NACK und STOP. Geprueft werden die Registerkarte,
+//  das automatische Inkrement, das konsistente Abbild waehrend einer Aktualisierung,
+//  die FIFO mit dem zurueckgelegten Sample und das Ueberlaufbit, das ein nicht
+//  gesendetes STATUS-Byte nicht loeschen darf.
+//
+//  Der Durchsatztest laeuft eine Sekunde mit 1000 Samples/s und einem Host, der alle
+//  10 ms FIFO_COUNT und dann die Samples liest, mit 400 kHz in CPU-Takten bei 8 MHz.
+//  Samples kommen auch zwischen zwei Bytes dazu. Eine ISR kostet ENTRY_CYCLES und
+//  ISR_CYCLES, das ist eine Schaetzung, keine Messung am Zielsystem.
+//
+//  Uebersetzen (Linux, im Projektverzeichnis):
+//    gcc -O2 -std=c99 -Wall -Wno-unknown-pragmas -DTRACE_ENABLE=0 -Itools/sim -I.
+//        -o test_i2c_target tools/test_i2c_target.c i2c_target.c spectral.c
+//***************************************************************************************
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <msp430.h>
+#include "driverlib/MSP430FR2xx_4xx/eusci_b_i2c.h"
+#include "i2c_target.h"
+#include "system.h"
+#include "tools/test.h"
+
+#define BUS_HZ              400000UL
+#define CYCLES_PER_BIT      (SMCLK_HZ / BUS_HZ)
+#define ENTRY_CYCLES        6       // Interrupt acceptance up to the first instruction
+#define ISR_CYCLES          50      // Register saves, UCB1IV dispatch, register read, RETI
+
+#define TXBUF_EMPTY         0xFFFF  // Loaded bytes are 0..255
+#define FIFO_CAPACITY       32      // FIFO_SIZE in i2c_target.c
+
+#define SAMPLE_HZ           1000    // Highest rate of PARAM_SAMPLE_RATE
+#define POLL_MS             10
+
+void USCI_B1_ISR(void);
+
+volatile uint16_t UCB1IV;
+volatile uint16_t P4SEL0;
+volatile uint16_t TB1R;
+
+static uint16_t txbuf = TXBUF_EMPTY;
+static uint8_t rxbuf;
+static uint32_t isrCalls;
+static uint64_t busBits;            // Bus clocks of all transfers
+static uint64_t now;                // CPU cycles
+
+// Sample source of the throughput test, pushed as time passes
+static uint8_t streaming;
+static uint64_t nextSampleAt;
+static uint16_t nextSample;
+
+static PulseDetector pulse;
+static SignalQuality quality;
+static SpectralEstimator spectral;
+static HrvResult hrvShort, hrvLong;
+
+void EUSCI_B_I2C_initSlave(uint16_t baseAddress, EUSCI_B_I2C_initSlaveParam *param) {
+    CHECK_EQ(baseAddress, EUSCI_B1_BASE);
+    CHECK_EQ(param->slaveAddress, I2C_TARGET_ADDRESS);
+}
+
+void EUSCI_B_I2C_enable(uint16_t baseAddress) {
+    (void)baseAddress;
+}
+
+void EUSCI_B_I2C_clearInterrupt(uint16_t baseAddress, uint16_t mask) {
+    (void)baseAddress;
+    (void)mask;
+}
+
+void EUSCI_B_I2C_enableInterrupt(uint16_t baseAddress, uint16_t mask) {
+    (void)baseAddress;
+    (void)mask;
+}
+
+uint8_t EUSCI_B_I2C_slaveGetData(uint16_t baseAddress) {
+    (void)baseAddress;
+    return rxbuf;
+}
+
+// The ISR loads exactly one byte per UCTXIFG0
+void EUSCI_B_I2C_slavePutData(uint16_t baseAddress, uint8_t data) {
+    (void)baseAddress;
+    CHECK_EQ(txbuf, TXBUF_EMPTY);
+    txbuf = data;
+}
+
+static void interrupt(uint16_t vector) {
+    UCB1IV = vector;
+    USCI_B1_ISR();
+    isrCalls++;
+    now += ENTRY_CYCLES + ISR_CYCLES;
+}
+
+// The main loop pushes the samples that become due
+static void advance(uint64_t cycles) {
+    now += cycles;
+    while (streaming && nextSampleAt <= now) {
+        i2cTargetPushSample(nextSample++);
+        nextSampleAt += SMCLK_HZ / SAMPLE_HZ;
+    }
+}
+
+static void clock(unsigned bits) {
+    busBits += bits;
+    advance((uint64_t)bits * CYCLES_PER_BIT);
+}
+
+// A repeated start drops the byte loaded for the NACKed position as well
+static void masterStart(uint8_t read) {
+    clock(1 + 9);
+    txbuf = TXBUF_EMPTY;
+    interrupt(USCI_I2C_UCSTTIFG);
+    if (read) {
+        interrupt(USCI_I2C_UCTXIFG0);
+    }
+}
+
+static void masterWrite(uint8_t data) {
+    rxbuf = data;
+    clock(9);
+    interrupt(USCI_I2C_UCRXIFG0);
+}
+
+// TXBUF moves to the shift register, which requests the next byte at once
+static uint8_t masterRead(void) {
+    uint16_t shift = txbuf;
+
+    CHECK(shift != TXBUF_EMPTY);
+    txbuf = TXBUF_EMPTY;
+    interrupt(USCI_I2C_UCTXIFG0);
+    clock(9);
+    return (uint8_t)shift;
+}
+
+// The byte loaded for the NACKed position stays in TXBUF and is dropped
+static void masterStop(void) {
+    clock(1);
+    interrupt(USCI_I2C_UCSTPIFG);
+    txbuf = TXBUF_EMPTY;
+}
+
+static void readFrom(uint8_t reg, uint8_t *data, uint8_t length) {
+    uint8_t i;
+
+    masterStart(0);
+    masterWrite(reg);
+    masterStart(1);
+    for (i = 0; i < length; i++) {
+        data[i] = masterRead();
+    }
+    masterStop();
+}
+
+// Continues at the register pointer, without writing it
+static void readOn(uint8_t *data, uint8_t length) {
+    uint8_t i;
+
+    masterStart(1);
+    for (i = 0; i < length; i++) {
+        data[i] = masterRead();
+    }
+    masterStop();
+}
+
+static uint8_t readByte(uint8_t reg) {
+    uint8_t value;
+
+    readFrom(reg, &value, 1);
+    return value;
+}
+
+static uint16_t readFifoSample(void) {
+    uint8_t data[2];
+
+    readFrom(I2C_REG_FIFO_DATA, data, 2);
+    return data[0] | (data[1] << 8);
+}
+
+static void drainFifo(void) {
+    while (readByte(I2C_REG_FIFO_COUNT) != 0) {
+        (void)readFifoSample();
+    }
+}
+
+static void setResults(uint16_t bpm, uint16_t beatCount) {
+    pulse.valid = 1;
+    pulse.bpm = bpm;
+    pulse.confidence = 93;
+    pulse.ibiMs = (uint16_t)(60000U / bpm);
+    pulse.beatCount = beatCount;
+    quality.quality = 88;
+    quality.rejected = 0x0304;
+    spectral.valid = 1;
+    spectral.bpm = bpm - 1;
+    spectral.updates++;
+    hrvShort = (HrvResult){ 1, 12, 840, 45, 38 };
+    hrvLong = (HrvResult){ 1, 9, 0x0361, 0x0152, 0x0123 };
+}
+
+static void put16(uint8_t *regs, uint8_t at, uint16_t value) {
+    regs[at] = (uint8_t)value;
+    regs[at + 1] = (uint8_t)(value >> 8);
+}
+
+static void putHrv(uint8_t *regs, uint8_t at, const HrvResult *hrv) {
+    put16(regs, at + I2C_HRV_MEAN_IBI, hrv->meanIbiMs);
+    put16(regs, at + I2C_HRV_SDNN, hrv->sdnnMs);
+    put16(regs, at + I2C_HRV_RMSSD, hrv->rmssdMs);
+    regs[at + I2C_HRV_PNN50] = hrv->pnn50;
+}
+
+// The register image the header of i2c_target.h describes, FIFO registers excluded
+static void expectedMap(uint8_t *regs, uint8_t alarm) {
+    memset(regs, 0, 0x20);
+    regs[I2C_REG_STATUS] = I2C_STATUS_VALID | (alarm ? I2C_STATUS_ALARM : 0) |
+                           I2C_STATUS_HRV_SHORT | I2C_STATUS_HRV_LONG |
+                           I2C_STATUS_SPECTRAL | I2C_STATUS_BPM_AGREE;
+    put16(regs, I2C_REG_BPM, pulse.bpm);
+    regs[I2C_REG_CONFIDENCE] = pulse.confidence;
+    put16(regs, I2C_REG_IBI_MS, pulse.ibiMs);
+    put16(regs, I2C_REG_BEAT_COUNT, pulse.beatCount);
+    regs[I2C_REG_QUALITY] = quality.quality;
+    put16(regs, I2C_REG_REJECTED, quality.rejected);
+    put16(regs, I2C_REG_SPECTRAL_BPM, spectral.bpm);
+    regs[I2C_REG_WHO_AM_I] = I2C_WHO_AM_I_VALUE;
+    putHrv(regs, I2C_REG_HRV_SHORT, &hrvShort);
+    putHrv(regs, I2C_REG_HRV_LONG, &hrvLong);
+}
+
+static void testRegisterMap(void) {
+    uint8_t want[0x20], got[0x20];
+    uint8_t i;
+
+    i2cTargetInit();
+    CHECK_EQ(P4SEL0, BIT6 | BIT7);
+    CHECK_EQ(readByte(I2C_REG_WHO_AM_I), I2C_WHO_AM_I_VALUE);
+
+    setResults(72, 0x0102);
+    i2cTargetUpdate(&pulse, &quality, &spectral, &hrvShort, &hrvLong, 1);
+    expectedMap(want, 1);
+
+    // FIFO_DATA does not increment, so the map is read around it
+    readFrom(I2C_REG_STATUS, got, I2C_REG_FIFO_DATA);
+    readFrom(I2C_REG_QUALITY, &got[I2C_REG_QUALITY], 0x20 - I2C_REG_QUALITY);
+    for (i = 0; i < 0x20; i++) {
+        if (i != I2C_REG_FIFO_COUNT && i != I2C_REG_FIFO_DATA) {
+            CHECK_EQ(got[i], want[i]);
+        }
+    }
+    CHECK_EQ(got[I2C_REG_FIFO_COUNT], 0);
+
+    // Past the snapshot the map reads as zero
+    CHECK_EQ(readByte(0x20), 0x00);
+    CHECK_EQ(readByte(0xFE), 0x00);
+
+    // Without a change the snapshot stays, an alarm alone republishes it
+    i2cTargetUpdate(&pulse, &quality, &spectral, &hrvShort, &hrvLong, 0);
+    CHECK_EQ(readByte(I2C_REG_STATUS) & I2C_STATUS_ALARM, 0);
+}
+
+static void testAutoIncrement(void) {
+    uint8_t data[5];
+
+    setResults(65, 7);
+    i2cTargetUpdate(&pulse, &quality, &spectral, &hrvShort, &hrvLong, 0);
+
+    // BPM, CONFIDENCE and IBI_MS in one burst
+    readFrom(I2C_REG_BPM, data, 5);
+    CHECK_EQ(data[0] | (data[1] << 8), 65);
+    CHECK_EQ(data[2], 93);
+    CHECK_EQ(data[3] | (data[4] << 8), 60000U / 65);
+
+    // A read without a new address continues after the last byte sent, the prefetched
+    // byte the host NACKed is served again
+    readFrom(I2C_REG_BPM, data, 2);
+    readOn(data, 3);
+    CHECK_EQ(data[0], 93);
+    CHECK_EQ(data[1] | (data[2] << 8), 60000U / 65);
+}
+
+// An update in the middle of a transfer must not tear the bytes the host reads
+static void testSnapshot(void) {
+    uint8_t data[4];
+
+    setResults(60, 100);
+    i2cTargetUpdate(&pulse, &quality, &spectral, &hrvShort, &hrvLong, 0);
+
+    masterStart(0);
+    masterWrite(I2C_REG_BPM);
+    masterStart(1);
+    data[0] = masterRead();
+
+    // The first update fills the idle buffer, the second would overwrite the one in
+    // use and waits for the stop condition
+    setResults(120, 101);
+    i2cTargetUpdate(&pulse, &quality, &spectral, &hrvShort, &hrvLong, 0);
+    setResults(150, 102);
+    i2cTargetUpdate(&pulse, &quality, &spectral, &hrvShort, &hrvLong, 0);
+
+    data[1] = masterRead();
+    data[2] = masterRead();
+    data[3] = masterRead();
+    masterStop();
+    CHECK_EQ(data[0] | (data[1] << 8), 60);
+    CHECK_EQ(data[3], 60000U / 60 & 0xFF);
+
+    // The next transfer latches the first update, the deferred one follows
+    readFrom(I2C_REG_BPM, data, 2);
+    CHECK_EQ(data[0] | (data[1] << 8), 120);
+    i2cTargetUpdate(&pulse, &quality, &spectral, &hrvShort, &hrvLong, 0);
+    readFrom(I2C_REG_BEAT_COUNT, data, 2);
+    CHECK_EQ(data[0] | (data[1] << 8), 102);
+}
+
+static void testFifo(void) {
+    uint8_t data[6];
+    uint16_t i;
+
+    drainFifo();
+    for (i = 0; i < 5; i++) {
+        i2cTargetPushSample(0x0A00 + i);
+    }
+    CHECK_EQ(readByte(I2C_REG_FIFO_COUNT), 5);
+
+    // Two samples, the low byte of the third was prefetched and goes back
+    readFrom(I2C_REG_FIFO_DATA, data, 4);
+    CHECK_EQ(data[0] | (data[1] << 8), 0x0A00);
+    CHECK_EQ(data[2] | (data[3] << 8), 0x0A01);
+    CHECK_EQ(readByte(I2C_REG_FIFO_COUNT), 3);
+
+    readFrom(I2C_REG_FIFO_DATA, data, 6);
+    CHECK_EQ(data[0] | (data[1] << 8), 0x0A02);
+    CHECK_EQ(data[2] | (data[3] << 8), 0x0A03);
+    CHECK_EQ(data[4] | (data[5] << 8), 0x0A04);
+    CHECK_EQ(readByte(I2C_REG_FIFO_COUNT), 0);
+    CHECK_EQ(readFifoSample(), 0xFFFF);
+    CHECK_EQ(readByte(I2C_REG_FIFO_COUNT), 0);
+}
+
+static void testOverflow(void) {
+    uint8_t data[16];
+    uint16_t i;
+
+    // BPM low byte 0x48, so a read that misses STATUS cannot show the bit by chance
+    setResults(72, 200);
+    i2cTargetUpdate(&pulse, &quality, &spectral, &hrvShort, &hrvLong, 0);
+    drainFifo();
+    CHECK_EQ(readByte(I2C_REG_STATUS) & I2C_STATUS_FIFO_OVERFLOW, 0);
+    for (i = 0; i <= FIFO_CAPACITY; i++) {
+        i2cTargetPushSample(i);
+    }
+    CHECK_EQ(readByte(I2C_REG_FIFO_COUNT), FIFO_CAPACITY);
+
+    // Reported once, the byte after STATUS confirmed that it was sent
+    CHECK(readByte(I2C_REG_STATUS) & I2C_STATUS_FIFO_OVERFLOW);
+    CHECK_EQ(readByte(I2C_REG_STATUS) & I2C_STATUS_FIFO_OVERFLOW, 0);
+
+    // A burst up to 0xFF prefetches STATUS after the wrap, the host NACKs it
+    i2cTargetPushSample(0);
+    readFrom(0xF0, data, 16);
+    CHECK(readByte(I2C_REG_STATUS) & I2C_STATUS_FIFO_OVERFLOW);
+    CHECK_EQ(readByte(I2C_REG_STATUS) & I2C_STATUS_FIFO_OVERFLOW, 0);
+
+    // A repeated start right after the prefetch keeps it as well
+    i2cTargetPushSample(0);
+    masterStart(0);
+    masterWrite(0xFF);
+    masterStart(1);
+    data[0] = masterRead();
+    masterStart(1);
+    data[1] = masterRead();
+    masterStop();
+    CHECK(data[1] & I2C_STATUS_FIFO_OVERFLOW);
+    CHECK_EQ(readByte(I2C_REG_STATUS) & I2C_STATUS_FIFO_OVERFLOW, 0);
+    drainFifo();
+}
+
+// The host polls FIFO_COUNT every POLL_MS and reads that many samples in one burst
+static void testThroughput(void) {
+    uint64_t end, pollAt, start, bitsStart;
+    uint32_t received = 0, gaps = 0, callsStart;
+    uint16_t expect = 0, sample;
+    uint8_t data[2 * FIFO_CAPACITY];
+    uint8_t count, i;
+    double busShare, cpuShare;
+
+    drainFifo();
+    (void)readByte(I2C_REG_STATUS);
+    streaming = 1;
+    nextSample = 0;
+    nextSampleAt = now;
+    start = now;
+    bitsStart = busBits;
+    callsStart = isrCalls;
+    end = now + SMCLK_HZ;
+    for (pollAt = now; pollAt < end; pollAt += SMCLK_HZ / 1000 * POLL_MS) {
+        if (now < pollAt) {
+            advance(pollAt - now);
+        }
+        count = readByte(I2C_REG_FIFO_COUNT);
+        if (count == 0) {
+            continue;
+        }
+        readFrom(I2C_REG_FIFO_DATA, data, (uint8_t)(2 * count));
+        for (i = 0; i < count; i++) {
+            sample = data[2 * i] | (data[2 * i + 1] << 8);
+            gaps += (sample != expect);
+            expect = sample + 1;
+            received++;
+        }
+    }
+    streaming = 0;
+
+    busShare = (double)(busBits - bitsStart) * CYCLES_PER_BIT / (double)(now - start);
+    cpuShare = (double)(isrCalls - callsStart) * (ENTRY_CYCLES + ISR_CYCLES) /
+               (double)(now - start);
+    printf("fifo drain: %u samples/s, %u out of order, bus %.1f %%, ISR CPU %.1f %%\n",
+           (unsigned)received, (unsigned)gaps, 100.0 * busShare, 100.0 * cpuShare);
+    CHECK_EQ(gaps, 0);
+    CHECK(received >= SAMPLE_HZ - SAMPLE_HZ * POLL_MS / 1000);
+    CHECK_EQ(readByte(I2C_REG_STATUS) & I2C_STATUS_FIFO_OVERFLOW, 0);
+    CHECK(cpuShare < 0.10);
+}
+
+int main(void) {
+    testRegisterMap();
+    testAutoIncrement();
+    testSnapshot();
+    testFifo();
+    testOverflow();
+    testThroughput();
+    return testSummary("i2c_target");
+}
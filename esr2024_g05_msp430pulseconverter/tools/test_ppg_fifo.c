@@ -0,0 +1,182 @@
+//***************************************************************************************
+//  Host-Test der FIFO-Auswertung des digitalen Pulssensors (ppg_fifo.c)
+//
+//  Beschreibung: Ein Registermodell des Sensors (32 Eintraege, Schreib- und Lesezeiger,
+//  Overflow-Zaehler bis 31, rollover, A_FULL bei 17 Samples, geloescht beim Lesen von
+//  INT_STATUS1) wird wie vom Treiber gelesen: erst der Zeiger-Burst, dann so viele
+//  Samples, wie ppgFifoCount() meldet. Geprueft werden leere, teilweise, genau volle und
+//  uebergelaufene FIFOs, der Umlauf der Zeiger und dass gelieferte und verlorene Samples
+//  zusammen alle erzeugten ergeben, in der richtigen Reihenfolge.
+//
+//  Uebersetzen (Linux, im Projektverzeichnis):
+//    gcc -O2 -std=c99 -Wall -I. -o test_ppg_fifo tools/test_ppg_fifo.c ppg_fifo.c
+//***************************************************************************************
+
+#include <stdint.h>
+
+#include "ppg_fifo.h"
+#include "tools/test.h"
+
+#define A_FULL_LEVEL    17              // FIFO_CONFIG 0x7F: 15 free entries left
+
+typedef struct {
+    uint8_t data[PPG_FIFO_DEPTH][PPG_BYTES_PER_SAMPLE];
+    uint8_t wrPtr;
+    uint8_t rdPtr;
+    uint8_t ovf;
+    uint8_t level;                      // Samples held, the registers do not show it
+    uint8_t status;
+    uint16_t produced;
+} SensorModel;
+
+static void modelReset(SensorModel *m) {
+    m->wrPtr = m->rdPtr = m->ovf = m->level = m->status = 0;
+    m->produced = 0;
+}
+
+// One new sample, value = sequence number in the upper 12 of 18 bits
+static void modelProduce(SensorModel *m) {
+    uint32_t raw = (uint32_t)(m->produced++ & 0x0FFF) << 6;
+
+    m->data[m->wrPtr][0] = (uint8_t)(raw >> 16);
+    m->data[m->wrPtr][1] = (uint8_t)(raw >> 8);
+    m->data[m->wrPtr][2] = (uint8_t)raw;
+    m->wrPtr = (m->wrPtr + 1) & (PPG_FIFO_DEPTH - 1);
+    if (m->level == PPG_FIFO_DEPTH) {
+        // Rollover: the oldest sample is overwritten
+        m->rdPtr = (m->rdPtr + 1) & (PPG_FIFO_DEPTH - 1);
+        if (m->ovf < 0x1F) {
+            m->ovf++;
+        }
+    } else {
+        m->level++;
+    }
+    if (m->level == A_FULL_LEVEL) {
+        m->status |= PPG_INT_A_FULL;
+    }
+}
+
+// Burst read INT_STATUS1..FIFO_RD_PTR, the status clears on read
+static void modelReadPointers(SensorModel *m, uint8_t *burst) {
+    uint8_t i;
+
+    for (i = 0; i < PPG_POINTER_BURST; i++) {
+        burst[i] = 0;
+    }
+    burst[PPG_REG_INT_STATUS1] = m->status;
+    burst[PPG_REG_FIFO_WR_PTR] = m->wrPtr;
+    burst[PPG_REG_OVF_COUNTER] = m->ovf;
+    burst[PPG_REG_FIFO_RD_PTR] = m->rdPtr;
+    m->status = 0;
+}
+
+// Pop one sample through FIFO_DATA, popping clears the overflow counter
+static const uint8_t *modelPop(SensorModel *m) {
+    const uint8_t *p = m->data[m->rdPtr];
+
+    m->rdPtr = (m->rdPtr + 1) & (PPG_FIFO_DEPTH - 1);
+    m->level--;
+    m->ovf = 0;
+    return p;
+}
+
+// One driver pass. Returns the samples read, checks they continue at '*next'.
+static uint8_t driverRead(SensorModel *m, uint16_t *next, uint16_t *lostTotal,
+                          uint8_t produceBetween) {
+    uint8_t burst[PPG_POINTER_BURST];
+    uint8_t count;
+    uint8_t lost;
+    uint8_t i;
+
+    modelReadPointers(m, burst);
+    count = ppgFifoCount(burst, &lost);
+    for (i = 0; i < produceBetween && m->level < PPG_FIFO_DEPTH; i++) {
+        modelProduce(m);                // New samples while the FIFO read is queued
+    }
+    *lostTotal += lost;
+    *next += lost;
+    for (i = 0; i < count; i++) {
+        CHECK_EQ(ppgFifoSample(modelPop(m)), *next & 0x0FFF);
+        (*next)++;
+    }
+    return count;
+}
+
+static void testLevels(void) {
+    static SensorModel m;
+    uint16_t next;
+    uint16_t lost;
+    uint8_t fill[] = { 0, 1, 16, 17, 20, 31, 32, 33, 40, 63 };
+    uint8_t i;
+    uint8_t n;
+
+    for (i = 0; i < sizeof fill; i++) {
+        modelReset(&m);
+        next = lost = 0;
+        for (n = 0; n < fill[i]; n++) {
+            modelProduce(&m);
+        }
+        n = driverRead(&m, &next, &lost, 0);
+        CHECK_EQ(n, fill[i] > PPG_FIFO_DEPTH ? PPG_FIFO_DEPTH : fill[i]);
+        CHECK_EQ(lost, fill[i] > PPG_FIFO_DEPTH ? fill[i] - PPG_FIFO_DEPTH : 0);
+        CHECK_EQ(m.level, 0);
+    }
+}
+
+// Exactly full with the pointers wrapped somewhere in the middle
+static void testFullAfterWrap(void) {
+    static SensorModel m;
+    uint16_t next = 0;
+    uint16_t lost = 0;
+    uint8_t n;
+
+    modelReset(&m);
+    for (n = 0; n < 13; n++) {
+        modelProduce(&m);
+    }
+    driverRead(&m, &next, &lost, 0);
+    for (n = 0; n < PPG_FIFO_DEPTH; n++) {
+        modelProduce(&m);
+    }
+    CHECK_EQ(m.wrPtr, m.rdPtr);
+    CHECK_EQ(driverRead(&m, &next, &lost, 0), PPG_FIFO_DEPTH);
+    CHECK_EQ(lost, 0);
+    CHECK_EQ(next, m.produced);
+}
+
+// Random bus hold-offs: samples arrive in bursts of 0..50, a few more while the FIFO read
+// is queued (not into a full FIFO: the pop clears the overflow counter, such a loss is
+// invisible to any driver). Delivered and lost samples must add up to all produced, in
+// sequence.
+static void testRandomTraffic(void) {
+    static SensorModel m;
+    uint32_t lcg = 7;
+    uint16_t next = 0;
+    uint16_t lost = 0;
+    uint32_t delivered = 0;
+    uint8_t burst;
+    uint8_t between;
+    int pass;
+
+    modelReset(&m);
+    for (pass = 0; pass < 2000; pass++) {
+        lcg = lcg * 1103515245u + 12345u;
+        burst = (uint8_t)((lcg >> 16) % 51);
+        between = (uint8_t)((lcg >> 8) % 4);
+        while (burst--) {
+            modelProduce(&m);
+        }
+        delivered += driverRead(&m, &next, &lost, between);
+    }
+    delivered += driverRead(&m, &next, &lost, 0);
+    CHECK_EQ(m.level, 0);
+    CHECK_EQ((uint16_t)(delivered + lost), m.produced);
+    CHECK(lost > 0);
+}
+
+int main(void) {
+    testLevels();
+    testFullAfterWrap();
+    testRandomTraffic();
+    return testSummary("ppg_fifo");
+}
@@ -0,0 +1,198 @@
+//***************************************************************************************
+//  Host-Test der Signalqualitaet (signal_quality.c) in der Verarbeitungskette
+//
+//  Beschreibung: Kurven aus ppg_synth.c laufen durch pipeline.c und die Alarmzonen
+//  (alarm.c, Standardgrenzen, Puls aus pipelineAlarmBpm()) wie in der Firmware, einmal
+//  ohne Qualitaetspruefung (Schwelle 0) und einmal mit DEFAULT_QUALITY_MIN. Der Puls
+//  der Kurven ist normal, nach SETTLE_S zaehlt deshalb jede Sekunde, in der
+//    - eine Alarmzone (Brady-/Tachykardie) aktiv ist, als Fehlalarm
+//    - die Zone "kein Signal" anliegt, als falsche Anzeige
+//    - der Puls ungueltig ist oder um mehr als BPM_TOLERANCE vom eingestellten abweicht,
+//      als falscher Puls
+//  Die Artefaktsammlung kombiniert ARTIFACT_RATES und ARTIFACT_LENGTHS mit SEEDS
+//  Startwerten (Amplitude 1500 Codes, Rauschen 15). Mit der Pruefung muss der falsche
+//  Puls hoechstens MAX_WRONG_SHARE so lange anliegen wie ohne, Fehlalarme und "kein
+//  Signal" duerfen nicht zunehmen. Saubere Kurven, Grundlinienschwankung und eine spaete
+//  dikrote Kerbe (Spektralspitze auf der Oberwelle) duerfen mit der Pruefung keinen
+//  Schlag und keine Sekunde verlieren.
+//
+//  Uebersetzen (Linux, im Projektverzeichnis):
+//    gcc -O2 -std=c99 -Wall -I. -Itools -o test_signal_quality tools/test_signal_quality.c
+//        tools/ppg_synth.c pipeline.c biquad.c pulse.c median.c signal_quality.c
+//        spectral.c brightness.c hrv.c filter_tables.c alarm.c -lm
+//***************************************************************************************
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "alarm.h"
+#include "config.h"
+#include "filter_tables.h"
+#include "pipeline.h"
+#include "ppg_synth.h"
+#include "tools/test.h"
+
+#define RATE_HZ             250
+#define TRACE_S             300
+#define SETTLE_S            20          // Start up and template, not counted
+#define BPM_TOLERANCE       0.10
+#define MAX_WRONG_SHARE     0.6
+#define SEEDS               4
+#define MAX_BEATS           1024
+
+static const double ARTIFACT_RATES[] = { 4.0, 8.0, 12.0, 20.0, 30.0 };     // Per minute
+static const double ARTIFACT_LENGTHS[] = { 0.2, 0.5, 1.0 };               // Longest, s
+
+typedef struct {
+    double falseAlarmS;
+    double noSignalS;
+    double wrongBpmS;
+    unsigned beats;                     // Candidates that passed
+    unsigned rejected;
+} Outcome;
+
+static void run(const PpgSynthParams *p, uint8_t qualityMin, Outcome *o) {
+    static PpgSynth synth;
+    static Pipeline pp;
+    static uint16_t samples[TRACE_S * RATE_HZ];
+    static PpgBeat beats[MAX_BEATS];
+    AlarmState alarm;
+    uint32_t i;
+    uint16_t bpm;
+
+    ppgSynthInit(&synth, p);
+    (void)ppgSynthGenerate(&synth, samples, TRACE_S * RATE_HZ, beats, MAX_BEATS);
+    memset(&pp, 0, sizeof(pp));
+    pipelineInit(&pp, RATE_HZ, filterTableForRate(RATE_HZ)->coeffs);
+    alarmConfigure(&alarm, DEFAULT_BRADY_BPM, DEFAULT_TACHY_BPM, DEFAULT_ALARM_HYSTERESIS,
+                   DEFAULT_ALARM_DELAY_S);
+
+    for (i = 0; i < TRACE_S * RATE_HZ; i++) {
+        if (pipelineStep(&pp, samples[i], DEFAULT_THRESHOLD_ON, DEFAULT_THRESHOLD_OFF,
+                         qualityMin) & PIPELINE_BEAT) {
+            o->beats++;
+        }
+        bpm = pipelineAlarmBpm(&pp);
+        alarmUpdate(&alarm, bpm != 0, bpm, i * 1000UL / RATE_HZ);
+        if (i < SETTLE_S * RATE_HZ) {
+            continue;
+        }
+        if (alarmIsActive(&alarm)) {
+            o->falseAlarmS += 1.0 / RATE_HZ;
+        }
+        if (alarm.zone == ALARM_ZONE_NO_SIGNAL) {
+            o->noSignalS += 1.0 / RATE_HZ;
+        }
+        if (!pp.pulse.valid || fabs(pp.pulse.bpm - p->bpm) > p->bpm * BPM_TOLERANCE) {
+            o->wrongBpmS += 1.0 / RATE_HZ;
+        }
+    }
+    o->rejected += pp.quality.rejected;
+}
+
+static void print(const char *name, const char *check, const Outcome *o) {
+    printf("%-10s %-8s false alarm %6.1f s, no signal %6.1f s, wrong BPM %7.1f s, "
+           "%5u beats, %4u rejected\n", name, check, o->falseAlarmS, o->noSignalS,
+           o->wrongBpmS, o->beats, o->rejected);
+}
+
+// The whole trace with and without the check
+static void compare(const char *name, const PpgSynthParams *p, Outcome *off, Outcome *on) {
+    memset(off, 0, sizeof(*off));
+    memset(on, 0, sizeof(*on));
+    run(p, 0, off);
+    run(p, DEFAULT_QUALITY_MIN, on);
+    print(name, "off", off);
+    print(name, "on", on);
+}
+
+// Disturbances without artifacts: the check must not cost anything
+static void checkHarmless(const char *name, const PpgSynthParams *p) {
+    Outcome off, on;
+
+    compare(name, p, &off, &on);
+    CHECK_EQ(on.beats, off.beats);
+    CHECK_EQ(on.rejected, 0);
+    CHECK(on.falseAlarmS == 0.0);
+    CHECK(on.noSignalS == 0.0);
+    CHECK(on.wrongBpmS <= off.wrongBpmS);
+}
+
+static void testClean(void) {
+    PpgSynthParams p;
+
+    ppgSynthDefaults(&p);
+    checkHarmless("clean", &p);
+}
+
+static void testWander(void) {
+    PpgSynthParams p;
+
+    ppgSynthDefaults(&p);
+    p.wanderAmplitude = 150.0;
+    p.wanderHz = 0.3;
+    checkHarmless("wander", &p);
+}
+
+// The spectral peak can sit on the second harmonic, the alarm must stay on the intervals
+static void testNotchLate(void) {
+    PpgSynthParams p;
+
+    ppgSynthDefaults(&p);
+    p.notchPhase = 0.5;
+    p.diastolicRatio = 0.6;
+    checkHarmless("notch_late", &p);
+}
+
+static void add(Outcome *sum, const Outcome *o) {
+    sum->falseAlarmS += o->falseAlarmS;
+    sum->noSignalS += o->noSignalS;
+    sum->wrongBpmS += o->wrongBpmS;
+    sum->beats += o->beats;
+    sum->rejected += o->rejected;
+}
+
+static void testArtifacts(void) {
+    Outcome offSum = {0}, onSum = {0}, off, on;
+    PpgSynthParams p;
+    char name[16];
+    unsigned r, l, seed;
+
+    for (r = 0; r < sizeof(ARTIFACT_RATES) / sizeof(ARTIFACT_RATES[0]); r++) {
+        for (l = 0; l < sizeof(ARTIFACT_LENGTHS) / sizeof(ARTIFACT_LENGTHS[0]); l++) {
+            memset(&off, 0, sizeof(off));
+            memset(&on, 0, sizeof(on));
+            for (seed = 1; seed <= SEEDS; seed++) {
+                ppgSynthDefaults(&p);
+                p.seed = seed;
+                p.noiseSd = 15.0;
+                p.artifactsPerMin = ARTIFACT_RATES[r];
+                p.artifactAmplitude = 1500.0;
+                p.artifactMaxS = ARTIFACT_LENGTHS[l];
+                run(&p, 0, &off);
+                run(&p, DEFAULT_QUALITY_MIN, &on);
+            }
+            snprintf(name, sizeof(name), "%2.0f/min %.1f", ARTIFACT_RATES[r],
+                     ARTIFACT_LENGTHS[l]);
+            print(name, "off", &off);
+            print(name, "on", &on);
+            add(&offSum, &off);
+            add(&onSum, &on);
+        }
+    }
+    print("artifacts", "off", &offSum);
+    print("artifacts", "on", &onSum);
+    CHECK(onSum.wrongBpmS <= offSum.wrongBpmS * MAX_WRONG_SHARE);
+    CHECK(onSum.falseAlarmS <= offSum.falseAlarmS);
+    CHECK(onSum.noSignalS <= offSum.noSignalS);
+}
+
+int main(void) {
+    testClean();
+    testWander();
+    testNotchLate();
+    testArtifacts();
+    return testSummary("signal_quality");
+}
@@ -0,0 +1,136 @@
+//***************************************************************************************
+//  Host-Test der SPI-Stream-Bloecke (stream_block.c)
+//
+//  Beschreibung: Prueft Rahmen, Sequenznummern, Ping-Pong-Wechsel und das Verwerfen
+//  voller Bloecke bei belegtem Sender: Ein Empfaenger, der nur die gesendeten Bloecke
+//  sieht, muss aus Sequenznummer und Overrun-Zaehler jede Luecke erkennen und alle
+//  gesendeten Samples in der richtigen Reihenfolge erhalten.
+//
+//  Uebersetzen (Linux, im Projektverzeichnis):
+//    gcc -O2 -std=c99 -Wall -I. -o test_stream_block tools/test_stream_block.c
+//        stream_block.c
+//***************************************************************************************
+
+#include <stdint.h>
+#include <string.h>
+
+#include "stream_block.h"
+#include "tools/test.h"
+
+#define BLOCKS          200
+#define CHANNEL         2
+
+static uint16_t word(const uint8_t *b, int offset) {
+    return (uint16_t)(b[offset] | (b[offset + 1] << 8));
+}
+
+// The receiver side: checks every block that went out
+static void checkBlock(const uint8_t *b, uint16_t expectSeq, uint16_t expectOverruns,
+                       uint16_t firstSample) {
+    int i;
+
+    CHECK_EQ(b[0], STREAM_SYNC0);
+    CHECK_EQ(b[1], STREAM_SYNC1);
+    CHECK_EQ(word(b, 2), expectSeq);
+    CHECK_EQ(word(b, 4), expectOverruns);
+    CHECK_EQ(b[6], STREAM_BLOCK_SAMPLES);
+    CHECK_EQ(b[7], CHANNEL);
+    for (i = 0; i < STREAM_BLOCK_SAMPLES; i++) {
+        if (!CHECK_EQ(word(b, STREAM_HEADER_BYTES + 2 * i), (firstSample + i) & 0x0FFF)) {
+            break;
+        }
+    }
+}
+
+// Blocks complete only on the last sample, at no other point
+static void testFraming(void) {
+    static StreamBlocks s;
+    const uint8_t *b;
+    uint16_t sample = 0;
+    int n;
+    int i;
+
+    streamBlockStart(&s, CHANNEL);
+    for (n = 0; n < 4; n++) {
+        for (i = 0; i < STREAM_BLOCK_SAMPLES - 1; i++) {
+            CHECK(streamBlockPut(&s, sample++ & 0x0FFF, 0) == 0);
+        }
+        b = streamBlockPut(&s, sample++ & 0x0FFF, 0);
+        CHECK(b != 0);
+        if (b) {
+            CHECK(b == s.block[n & 1]);     // Halves alternate
+            checkBlock(b, (uint16_t)n, 0, (uint16_t)(n * STREAM_BLOCK_SAMPLES));
+        }
+    }
+}
+
+// A pseudo random sender: while busy, completed blocks are dropped and the receiver sees
+// the sequence jump by the number of overruns
+static void testOverrun(void) {
+    static StreamBlocks s;
+    uint8_t sent[STREAM_BLOCK_BYTES];
+    const uint8_t *b;
+    uint32_t lcg = 12345;
+    uint16_t sample = 0;
+    uint16_t expectSeq = 0;
+    uint16_t dropped = 0;
+    uint16_t received = 0;
+    uint8_t busy;
+    int n;
+    int i;
+
+    streamBlockStart(&s, CHANNEL);
+    for (n = 0; n < BLOCKS; n++) {
+        lcg = lcg * 1103515245u + 12345u;
+        busy = (lcg >> 16) % 3 == 0;
+        for (i = 0; i < STREAM_BLOCK_SAMPLES; i++) {
+            b = streamBlockPut(&s, sample++ & 0x0FFF, busy);
+            CHECK(b == 0 || i == STREAM_BLOCK_SAMPLES - 1);
+        }
+        if (busy) {
+            CHECK(b == 0);
+            dropped++;
+            expectSeq++;
+            continue;
+        }
+        CHECK(b != 0);
+        if (b == 0) {
+            continue;
+        }
+        memcpy(sent, b, sizeof sent);
+        checkBlock(sent, expectSeq, dropped, (uint16_t)(n * STREAM_BLOCK_SAMPLES));
+        expectSeq++;
+        received++;
+    }
+    CHECK_EQ(s.overruns, dropped);
+    CHECK_EQ(received + dropped, BLOCKS);
+    CHECK(dropped > 0 && received > 0);
+}
+
+// A restart clears sequence and overruns and keeps the header
+static void testRestart(void) {
+    static StreamBlocks s;
+    const uint8_t *b = 0;
+    int i;
+
+    streamBlockStart(&s, CHANNEL);
+    for (i = 0; i < 3 * STREAM_BLOCK_SAMPLES; i++) {
+        streamBlockPut(&s, (uint16_t)i, 1);
+    }
+    CHECK_EQ(s.overruns, 3);
+    streamBlockStart(&s, CHANNEL);
+    for (i = 0; i < STREAM_BLOCK_SAMPLES; i++) {
+        b = streamBlockPut(&s, (uint16_t)i, 0);
+    }
+    CHECK(b != 0);
+    if (b) {
+        checkBlock(b, 0, 0, 0);
+    }
+}
+
+int main(void) {
+    testFraming();
+    testOverrun();
+    testRestart();
+    return testSummary("stream_block");
+}
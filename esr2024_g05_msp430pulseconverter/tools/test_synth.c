@@ -0,0 +1,213 @@
+//***************************************************************************************
+//  Host-Test der Tonsynthese (synth.c)
+//
+//  Beschreibung: Laesst synthNext() mit SYNTH_RATE_HZ einen gehaltenen Ton bei
+//  DEFAULT_TONE_HZ und TONE_MAX_HZ erzeugen und zerlegt eine Sekunde davon per DFT:
+//  Grundwelle mit voller Amplitude auf der eingestellten Frequenz, jede Oberwelle
+//  (auch die ueber Nyquist gespiegelten) unter MAX_HARMONIC_DB und der Rest aus
+//  Oberwellen und Rauschen (THD+N) unter MAX_THD_DB. Die Huellkurve muss nahe der Mitte
+//  beginnen, nach der Anstiegszeit voll sein, nach der Abklingzeit genau auf
+//  SYNTH_MIDSCALE enden (beide Rampen bis 1 % laenger, weil die Schrittweite abgerundet
+//  wird) und jeden Wert auf den aktuellen Pegel begrenzen; ein Klick klingt ohne
+//  synthNoteOff() aus, ein neuer Ton setzt beim aktuellen Pegel an.
+//
+//  Uebersetzen (Linux, im Projektverzeichnis):
+//    gcc -O2 -std=c99 -Wall -I. -o test_synth tools/test_synth.c synth.c -lm
+//***************************************************************************************
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "config.h"
+#include "output.h"
+#include "synth.h"
+#include "tools/test.h"
+
+#define TWO_PI              6.283185307179586
+#define FULL_AMPLITUDE      2047.0      // quarterSine peak
+#define MAX_HARMONIC_DB     -60.0
+#define MAX_THD_DB          -60.0
+#define MAX_SAMPLES         SYNTH_RATE_HZ       // One second, 1 Hz bins
+
+// Amplitude of the component at 'freqHz' in x[0..n), n samples at SYNTH_RATE_HZ
+static double dftAmplitude(const double *x, unsigned n, double freqHz) {
+    double re = 0.0, im = 0.0;
+    unsigned i;
+
+    for (i = 0; i < n; i++) {
+        re += x[i] * cos(TWO_PI * freqHz * i / SYNTH_RATE_HZ);
+        im -= x[i] * sin(TWO_PI * freqHz * i / SYNTH_RATE_HZ);
+    }
+    return 2.0 * sqrt(re * re + im * im) / n;
+}
+
+// Where a harmonic lands after sampling, 0..SYNTH_RATE_HZ / 2
+static double alias(double freqHz) {
+    freqHz = fmod(freqHz, SYNTH_RATE_HZ);
+    return (freqHz > SYNTH_RATE_HZ / 2) ? SYNTH_RATE_HZ - freqHz : freqHz;
+}
+
+static double db(double ratio) {
+    return 20.0 * log10(ratio);
+}
+
+static void testTone(uint16_t freqHz) {
+    static double x[MAX_SAMPLES];
+    Synth s;
+    unsigned i, k;
+    double mean = 0.0, power = 0.0, fundamental, harmonic, worst = 0.0, residual;
+    double worstHz = 0.0;
+
+    synthInit(&s, SYNTH_RATE_HZ);
+    synthNoteOn(&s, freqHz, TONE_ATTACK_MS);
+    for (i = 0; i < SYNTH_RATE_HZ / 10; i++) {          // Past the attack
+        (void)synthNext(&s);
+    }
+    CHECK_EQ(s.stage, SYNTH_SUSTAIN);
+
+    for (i = 0; i < MAX_SAMPLES; i++) {
+        x[i] = synthNext(&s);
+        mean += x[i];
+    }
+    mean /= MAX_SAMPLES;
+    for (i = 0; i < MAX_SAMPLES; i++) {
+        x[i] -= mean;
+        power += x[i] * x[i];
+    }
+    power /= MAX_SAMPLES;
+
+    fundamental = dftAmplitude(x, MAX_SAMPLES, freqHz);
+    for (k = 2; k <= 10; k++) {
+        double f = alias((double)k * freqHz);
+
+        if (f == 0.0 || f == freqHz) {
+            continue;                                   // Lands on DC or the fundamental
+        }
+        harmonic = dftAmplitude(x, MAX_SAMPLES, f);
+        if (harmonic > worst) {
+            worst = harmonic;
+            worstHz = f;
+        }
+    }
+    // Everything but DC and the fundamental
+    residual = sqrt(fmax(power - fundamental * fundamental / 2.0, 0.0) * 2.0);
+    printf("%4u Hz: fundamental %.1f, mean %.1f, worst harmonic %.1f dB at %.0f Hz, "
+           "THD+N %.1f dB\n", freqHz, fundamental, mean, db(worst / fundamental), worstHz,
+           db(residual / fundamental));
+
+    CHECK(fabs(fundamental - FULL_AMPLITUDE) < FULL_AMPLITUDE * 0.01);
+    CHECK(fabs(mean - SYNTH_MIDSCALE) < 1.0);
+    CHECK(db(worst / fundamental) < MAX_HARMONIC_DB);
+    CHECK(db(residual / fundamental) < MAX_THD_DB);
+}
+
+// Largest deviation from the middle the level allows, one code for rounding
+static int levelBound(const Synth *s) {
+    return (int)(((uint32_t)FULL_AMPLITUDE * s->level) >> 16) + 1;
+}
+
+// An envelope step is rounded down, which stretches a ramp by up to 1 %
+static int rampLength(unsigned n, unsigned samples) {
+    return n >= samples && n <= samples + samples / 100 + 1;
+}
+
+// Samples until 'stage' is left, counting bound violations on the way
+static unsigned runStage(Synth *s, uint8_t stage, unsigned limit, unsigned *outside) {
+    unsigned n = 0;
+    int out;
+
+    while (s->stage == stage && n < limit) {
+        out = synthNext(s);
+        if (abs(out - SYNTH_MIDSCALE) > levelBound(s)) {
+            (*outside)++;
+        }
+        n++;
+    }
+    return n;
+}
+
+static void testEnvelope(void) {
+    Synth s;
+    unsigned n, outside = 0;
+    unsigned attack = TONE_ATTACK_MS * SYNTH_RATE_HZ / 1000;
+    unsigned release = TONE_RELEASE_MS * SYNTH_RATE_HZ / 1000;
+    int first;
+
+    synthInit(&s, SYNTH_RATE_HZ);
+    CHECK_EQ(synthNext(&s), SYNTH_MIDSCALE);
+    CHECK(!synthActive(&s));
+
+    // Starts next to the middle, full after the attack time
+    synthNoteOn(&s, DEFAULT_TONE_HZ, TONE_ATTACK_MS);
+    first = synthNext(&s);
+    CHECK(abs(first - SYNTH_MIDSCALE) <= levelBound(&s));
+    CHECK(abs(first - SYNTH_MIDSCALE) <= FULL_AMPLITUDE / attack + 1);
+    n = 1 + runStage(&s, SYNTH_ATTACK, 10 * attack, &outside);
+    printf("attack %u samples (%u), ", n, attack);
+    CHECK(rampLength(n, attack));
+    CHECK_EQ(s.stage, SYNTH_SUSTAIN);
+    CHECK_EQ(s.level, SYNTH_LEVEL_FULL);
+
+    // Held until released, then back to the middle exactly
+    CHECK_EQ(runStage(&s, SYNTH_SUSTAIN, 1000, &outside), 1000);
+    synthNoteOff(&s, TONE_RELEASE_MS);
+    n = runStage(&s, SYNTH_RELEASE, 10 * release, &outside);
+    printf("release %u samples (%u)\n", n, release);
+    CHECK(rampLength(n, release));
+    CHECK_EQ(s.level, 0);
+    CHECK(!synthActive(&s));
+    CHECK_EQ(synthNext(&s), SYNTH_MIDSCALE);
+    CHECK_EQ(outside, 0);
+}
+
+static void testClick(void) {
+    Synth s;
+    unsigned n, outside = 0;
+    unsigned attack = CLICK_ATTACK_MS * SYNTH_RATE_HZ / 1000;
+    unsigned decay = CLICK_DECAY_MS * SYNTH_RATE_HZ / 1000;
+
+    synthInit(&s, SYNTH_RATE_HZ);
+    synthClick(&s, DEFAULT_TONE_HZ, CLICK_ATTACK_MS, CLICK_DECAY_MS);
+    n = runStage(&s, SYNTH_ATTACK, 10 * attack, &outside);
+    CHECK(rampLength(n, attack));
+    CHECK_EQ(s.stage, SYNTH_RELEASE);               // No sustain
+    n = runStage(&s, SYNTH_RELEASE, 10 * decay, &outside);
+    CHECK(rampLength(n, decay));
+    CHECK(!synthActive(&s));
+    CHECK_EQ(synthNext(&s), SYNTH_MIDSCALE);
+    CHECK_EQ(outside, 0);
+}
+
+// A new note during the release rises from the current level instead of jumping
+static void testRetrigger(void) {
+    Synth s;
+    unsigned i;
+    uint16_t before;
+
+    synthInit(&s, SYNTH_RATE_HZ);
+    synthNoteOn(&s, DEFAULT_TONE_HZ, TONE_ATTACK_MS);
+    for (i = 0; i < SYNTH_RATE_HZ / 100; i++) {
+        (void)synthNext(&s);
+    }
+    synthNoteOff(&s, TONE_RELEASE_MS);
+    for (i = 0; i < TONE_RELEASE_MS * SYNTH_RATE_HZ / 2000; i++) {
+        (void)synthNext(&s);
+    }
+    before = s.level;
+    CHECK(before > 0 && before < SYNTH_LEVEL_FULL);
+    synthNoteOn(&s, TONE_MAX_HZ, TONE_ATTACK_MS);
+    (void)synthNext(&s);
+    CHECK(s.level > before);
+    CHECK(s.level - before <= s.attackStep);
+}
+
+int main(void) {
+    testTone(DEFAULT_TONE_HZ);
+    testTone(TONE_MAX_HZ);
+    testEnvelope();
+    testClick();
+    testRetrigger();
+    return testSummary("synth");
+}
@@ -0,0 +1,273 @@
+//***************************************************************************************
+//  Host-Test des TLV-Index und der Kalibrierwerte (tlv_index.c)
+//
+//  Beschreibung: Baut Abbilder der Geraetebeschreibung im RAM und prueft den Index und
+//  die daraus geholten Kalibrierwerte:
+//    - gueltiges Abbild wie beim FR2355: alle Eintraege, Suche nach Kennung und Instanz
+//    - Eintrag ueber das Ende hinaus (auch nur Kennung ohne Laenge): TLV_INDEX_OVERRUN,
+//      der Eintrag wird nicht aufgenommen, die davor bleiben nutzbar
+//    - kein Endekennzeichen: TLV_INDEX_NO_END
+//    - mehr Eintraege als TLV_INDEX_SIZE: TLV_INDEX_FULL, die ersten bleiben
+//    - unplausible Faktoren und Offsets, zu kurze oder fehlende Eintraege: neutrale Werte
+//      und geloeschtes Bit in 'present'; die Grenzen selbst gelten noch als plausibel
+//
+//  Uebersetzen (Linux, im Projektverzeichnis):
+//    gcc -O2 -std=c99 -Wall -I. -o test_tlv_index tools/test_tlv_index.c tlv_index.c
+//***************************************************************************************
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "tlv_index.h"
+#include "tools/test.h"
+
+#define IMAGE_MAX           64
+
+typedef struct {
+    uint8_t data[IMAGE_MAX];
+    uint16_t length;
+} Image;
+
+static void add(Image *im, uint8_t tag, const uint8_t *data, uint8_t length) {
+    im->data[im->length++] = tag;
+    im->data[im->length++] = length;
+    memcpy(&im->data[im->length], data, length);
+    im->length += length;
+}
+
+static void addEnd(Image *im) {
+    im->data[im->length++] = TLV_INDEX_TAG_END;
+}
+
+static void putWord(uint8_t *data, uint8_t index, uint16_t value) {
+    data[2 * index] = (uint8_t)value;
+    data[2 * index + 1] = (uint8_t)(value >> 8);
+}
+
+// Die record, ADC calibration (gain, offset, 30 C, 105 C) and reference factor
+static void buildDevice(Image *im, uint16_t gain, int16_t offset, uint16_t ref) {
+    static const uint8_t die[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    uint8_t adc[8];
+    uint8_t refcal[2];
+
+    putWord(adc, 0, gain);
+    putWord(adc, 1, (uint16_t)offset);
+    putWord(adc, 2, 2340);
+    putWord(adc, 3, 2810);
+    putWord(refcal, 0, ref);
+    im->length = 0;
+    add(im, TLV_INDEX_TAG_DIE, die, sizeof(die));
+    add(im, TLV_INDEX_TAG_ADCCAL, adc, sizeof(adc));
+    add(im, TLV_INDEX_TAG_REFCAL, refcal, sizeof(refcal));
+    addEnd(im);
+}
+
+static void testValid(void) {
+    Image im;
+    TlvIndex ix;
+    TlvCalibration cal;
+    const uint8_t *data;
+    uint8_t length;
+
+    buildDevice(&im, 0x8123, -7, 0x7F80);
+    CHECK_EQ(tlvIndexBuild(&ix, im.data, im.length), 0);
+    CHECK_EQ(ix.count, 3);
+
+    data = tlvIndexFind(&ix, TLV_INDEX_TAG_DIE, 0, &length);
+    CHECK(data == &im.data[2]);
+    CHECK_EQ(length, 8);
+    data = tlvIndexFind(&ix, TLV_INDEX_TAG_REFCAL, 0, &length);
+    CHECK(data == &im.data[2 + 8 + 2 + 8 + 2]);
+    CHECK_EQ(length, 2);
+    CHECK(tlvIndexFind(&ix, TLV_INDEX_TAG_DIE, 1, &length) == 0);
+    CHECK_EQ(length, 0);
+    CHECK(tlvIndexFind(&ix, 0x42, 0, &length) == 0);
+
+    tlvResolveCalibration(&ix, &cal);
+    CHECK_EQ(cal.present, TLV_CAL_ADC | TLV_CAL_TEMP | TLV_CAL_REF);
+    CHECK_EQ(cal.adcGain, 0x8123);
+    CHECK_EQ(cal.adcOffset, -7);
+    CHECK_EQ(cal.tempCode30, 2340);
+    CHECK_EQ(cal.tempCode105, 2810);
+    CHECK_EQ(cal.ref15Factor, 0x7F80);
+}
+
+// A repeated tag is found by its instance, in image order
+static void testInstances(void) {
+    static const uint8_t first[2] = {0x11, 0x22};
+    static const uint8_t second[3] = {0x33, 0x44, 0x55};
+    Image im = {{0}, 0};
+    TlvIndex ix;
+    const uint8_t *data;
+    uint8_t length;
+
+    add(&im, 0x20, first, sizeof(first));
+    add(&im, TLV_INDEX_TAG_DIE, first, sizeof(first));
+    add(&im, 0x20, second, sizeof(second));
+    addEnd(&im);
+    CHECK_EQ(tlvIndexBuild(&ix, im.data, im.length), 0);
+    data = tlvIndexFind(&ix, 0x20, 1, &length);
+    CHECK_EQ(length, 3);
+    CHECK(data != 0 && data[0] == 0x33);
+    data = tlvIndexFind(&ix, 0x20, 0, &length);
+    CHECK_EQ(length, 2);
+    CHECK(data != 0 && data[0] == 0x11);
+}
+
+static void testOverrun(void) {
+    Image im;
+    TlvIndex ix;
+    TlvCalibration cal;
+
+    // The reference entry claims one byte more than the image holds
+    buildDevice(&im, TLV_FACTOR_ONE, 0, TLV_FACTOR_ONE);
+    im.length -= 1 + 2;                     // Drop the end tag and the two data bytes
+    im.data[im.length - 1] = 3;
+    im.length += 2;
+    CHECK_EQ(tlvIndexBuild(&ix, im.data, im.length), TLV_INDEX_OVERRUN);
+    CHECK_EQ(ix.count, 2);
+    tlvResolveCalibration(&ix, &cal);
+    CHECK_EQ(cal.present, TLV_CAL_ADC | TLV_CAL_TEMP);
+    CHECK_EQ(cal.ref15Factor, TLV_FACTOR_ONE);
+
+    // Only the tag of the last entry fits, its length byte is past the end
+    buildDevice(&im, TLV_FACTOR_ONE, 0, TLV_FACTOR_ONE);
+    im.length = 2 + 8 + 2 + 8 + 1;
+    CHECK_EQ(tlvIndexBuild(&ix, im.data, im.length), TLV_INDEX_OVERRUN);
+    CHECK_EQ(ix.count, 2);
+
+    // Length 255 in the first entry: nothing is indexed
+    buildDevice(&im, TLV_FACTOR_ONE, 0, TLV_FACTOR_ONE);
+    im.data[1] = 255;
+    CHECK_EQ(tlvIndexBuild(&ix, im.data, im.length), TLV_INDEX_OVERRUN);
+    CHECK_EQ(ix.count, 0);
+    tlvResolveCalibration(&ix, &cal);
+    CHECK_EQ(cal.present, 0);
+}
+
+static void testNoEnd(void) {
+    Image im;
+    TlvIndex ix;
+
+    buildDevice(&im, TLV_FACTOR_ONE, 0, TLV_FACTOR_ONE);
+    im.length--;                            // Last entry ends exactly at the image end
+    CHECK_EQ(tlvIndexBuild(&ix, im.data, im.length), TLV_INDEX_NO_END);
+    CHECK_EQ(ix.count, 3);
+
+    CHECK_EQ(tlvIndexBuild(&ix, im.data, 0), TLV_INDEX_NO_END);
+    CHECK_EQ(ix.count, 0);
+}
+
+static void testFull(void) {
+    static const uint8_t one[1] = {0};
+    Image im = {{0}, 0};
+    TlvIndex ix;
+    const uint8_t *data;
+    uint8_t length;
+    uint8_t i;
+
+    for (i = 0; i < TLV_INDEX_SIZE + 1; i++) {
+        add(&im, (uint8_t)(0x30 + i), one, sizeof(one));
+    }
+    addEnd(&im);
+    CHECK_EQ(tlvIndexBuild(&ix, im.data, im.length), TLV_INDEX_FULL);
+    CHECK_EQ(ix.count, TLV_INDEX_SIZE);
+    data = tlvIndexFind(&ix, 0x30 + TLV_INDEX_SIZE - 1, 0, &length);
+    CHECK(data != 0);
+    CHECK(tlvIndexFind(&ix, 0x30 + TLV_INDEX_SIZE, 0, &length) == 0);
+
+    // Exactly TLV_INDEX_SIZE entries fit without the flag
+    im.length = 0;
+    for (i = 0; i < TLV_INDEX_SIZE; i++) {
+        add(&im, (uint8_t)(0x30 + i), one, sizeof(one));
+    }
+    addEnd(&im);
+    CHECK_EQ(tlvIndexBuild(&ix, im.data, im.length), 0);
+    CHECK_EQ(ix.count, TLV_INDEX_SIZE);
+}
+
+// Resolves the calibration of a device image and returns it in 'cal'
+static void resolve(uint16_t gain, int16_t offset, uint16_t ref, TlvCalibration *cal) {
+    Image im;
+    TlvIndex ix;
+
+    buildDevice(&im, gain, offset, ref);
+    CHECK_EQ(tlvIndexBuild(&ix, im.data, im.length), 0);
+    tlvResolveCalibration(&ix, cal);
+}
+
+static void testImplausible(void) {
+    TlvCalibration cal;
+
+    // Limits of the plausible range are taken over
+    resolve(TLV_FACTOR_ONE - TLV_FACTOR_SPAN, -TLV_OFFSET_MAX,
+            TLV_FACTOR_ONE + TLV_FACTOR_SPAN, &cal);
+    CHECK_EQ(cal.present, TLV_CAL_ADC | TLV_CAL_TEMP | TLV_CAL_REF);
+    CHECK_EQ(cal.adcGain, TLV_FACTOR_ONE - TLV_FACTOR_SPAN);
+    CHECK_EQ(cal.adcOffset, -TLV_OFFSET_MAX);
+    CHECK_EQ(cal.ref15Factor, TLV_FACTOR_ONE + TLV_FACTOR_SPAN);
+
+    // One step beyond: neutral values, the temperature codes are kept
+    resolve(TLV_FACTOR_ONE + TLV_FACTOR_SPAN + 1, 0, TLV_FACTOR_ONE - TLV_FACTOR_SPAN - 1,
+            &cal);
+    CHECK_EQ(cal.present, TLV_CAL_TEMP);
+    CHECK_EQ(cal.adcGain, TLV_FACTOR_ONE);
+    CHECK_EQ(cal.adcOffset, 0);
+    CHECK_EQ(cal.ref15Factor, TLV_FACTOR_ONE);
+    CHECK_EQ(cal.tempCode30, 2340);
+
+    // A plausible gain does not save an implausible offset, or the other way round
+    resolve(TLV_FACTOR_ONE, TLV_OFFSET_MAX + 1, TLV_FACTOR_ONE, &cal);
+    CHECK_EQ(cal.present, TLV_CAL_TEMP | TLV_CAL_REF);
+    CHECK_EQ(cal.adcGain, TLV_FACTOR_ONE);
+    CHECK_EQ(cal.adcOffset, 0);
+    resolve(0xFFFF, 0, 0x0000, &cal);       // Erased or zeroed words
+    CHECK_EQ(cal.present, TLV_CAL_TEMP);
+    CHECK_EQ(cal.adcGain, TLV_FACTOR_ONE);
+    CHECK_EQ(cal.ref15Factor, TLV_FACTOR_ONE);
+}
+
+// Entries too short for their words, and a descriptor without calibration entries
+static void testShort(void) {
+    static const uint8_t die[8] = {0};
+    uint8_t adc[4];
+    uint8_t ref[1] = {0x80};
+    Image im = {{0}, 0};
+    TlvIndex ix;
+    TlvCalibration cal;
+
+    putWord(adc, 0, 0x8010);
+    putWord(adc, 1, 3);
+    add(&im, TLV_INDEX_TAG_ADCCAL, adc, sizeof(adc));
+    add(&im, TLV_INDEX_TAG_REFCAL, ref, sizeof(ref));
+    addEnd(&im);
+    CHECK_EQ(tlvIndexBuild(&ix, im.data, im.length), 0);
+    tlvResolveCalibration(&ix, &cal);
+    CHECK_EQ(cal.present, TLV_CAL_ADC);
+    CHECK_EQ(cal.adcGain, 0x8010);
+    CHECK_EQ(cal.adcOffset, 3);
+    CHECK_EQ(cal.tempCode30, 0);
+    CHECK_EQ(cal.ref15Factor, TLV_FACTOR_ONE);
+
+    im.length = 0;
+    add(&im, TLV_INDEX_TAG_DIE, die, sizeof(die));
+    addEnd(&im);
+    CHECK_EQ(tlvIndexBuild(&ix, im.data, im.length), 0);
+    tlvResolveCalibration(&ix, &cal);
+    CHECK_EQ(cal.present, 0);
+    CHECK_EQ(cal.adcGain, TLV_FACTOR_ONE);
+    CHECK_EQ(cal.adcOffset, 0);
+    CHECK_EQ(cal.ref15Factor, TLV_FACTOR_ONE);
+}
+
+int main(void) {
+    testValid();
+    testInstances();
+    testOverrun();
+    testNoEnd();
+    testFull();
+    testImplausible();
+    testShort();
+    return testSummary("tlv_index");
+}
@@ -0,0 +1,509 @@
+//***************************************************************************************
+//  Host-Test des Kommandointerfaces (uart_cmd.c) mit der Konfiguration (config.c)
+//
+//  Beschreibung: uart_cmd.c und config.c werden unveraendert gegen tools/sim/msp430.h
+//  uebersetzt. Empfangene Bytes gehen wie auf dem Geraet einzeln durch die RX-ISR in den
+//  Ring, uartCmdProcess() laeuft wie in der Hauptschleife dazwischen. Jedes Setzen von
+//  UCTXIE laesst die TX-ISR den Sendering sofort leeren, die gesendeten Bytes werden
+//  wieder in Rahmen zerlegt und ihre CRC geprueft. Geprueft werden:
+//    - Antworten auf GET/SET, NAKs fuer unbekannte Kommandos, Laengen und Parameter
+//    - mehrere Rahmen in einem Stueck, in der Reihenfolge beantwortet
+//    - Wiederaufsetzen nach Muell, falschem Laengenbyte und falscher CRC
+//    - Rahmen, die Byte fuer Byte eintreffen, und Rahmen ueber das Ringende hinweg
+//    - Ueberlauf des RX-Rings
+//    - ein abgelehntes SET oeffnet keinen Entwurf (config.c), der gesicherte Block
+//      bleibt die gueltige Konfiguration
+//  Die uebrigen Module (Trace, Stream, Sensor, Energie, Latenzen) sind Attrappen.
+//
+//  Uebersetzen (Linux, im Projektverzeichnis):
+//    gcc -O2 -std=c99 -Wall -Wno-unknown-pragmas -DTRACE_ENABLE=0 -Itools/sim -I.
+//        -o test_uart_cmd tools/test_uart_cmd.c uart_cmd.c config.c filter_tables.c
+//***************************************************************************************
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <msp430.h>
+#include "driverlib/MSP430FR2xx_4xx/crc.h"
+#include "driverlib/MSP430FR2xx_4xx/eusci_a_uart.h"
+#include "driverlib/MSP430FR2xx_4xx/sysctl.h"
+#include "boot.h"
+#include "config.h"
+#include "irq_priority.h"
+#include "power.h"
+#include "ppg_sensor.h"
+#include "spi_stream.h"
+#include "trace.h"
+#include "uart_cmd.h"
+#include "tools/test.h"
+
+#define TXBUF_EMPTY         0xFFFF
+#define MAX_TX              1024
+#define MAX_RESPONSES       64
+#define RX_RING_SIZE        64          // As uart_cmd.c
+
+void USCI_A0_ISR(void);
+
+volatile uint16_t simUca0Ie;
+volatile uint16_t UCA0IV;
+volatile uint16_t UCA0RXBUF;
+volatile uint16_t UCA0TXBUF = TXBUF_EMPTY;
+volatile uint16_t P1SEL0;
+volatile uint16_t RTCCNT;
+volatile uint16_t TB1R;
+uint16_t bootTicks[BOOT_STAGES];
+
+typedef struct {
+    uint8_t cmd;
+    uint8_t length;
+    uint8_t payload[UART_CMD_MAX_PAYLOAD];
+} Frame;
+
+static uint8_t txBytes[MAX_TX];
+static unsigned txCount;
+static uint8_t inIsr;
+
+// ---- Hardware and module stand-ins ----------------------------------------------------
+
+// The TX ISR runs as soon as the main loop enables it, so the TX ring never blocks
+volatile uint16_t *simUartAccess(volatile uint16_t *reg) {
+    if (!inIsr && (simUca0Ie & UCTXIE)) {
+        inIsr = 1;
+        while (simUca0Ie & UCTXIE) {
+            UCA0TXBUF = TXBUF_EMPTY;
+            UCA0IV = USCI_UART_UCTXIFG;
+            USCI_A0_ISR();
+            if (UCA0TXBUF != TXBUF_EMPTY && txCount < MAX_TX) {
+                txBytes[txCount++] = (uint8_t)UCA0TXBUF;
+            }
+        }
+        inIsr = 0;
+    }
+    return reg;
+}
+
+void simWake(uint16_t bits) {
+    (void)bits;
+}
+
+bool EUSCI_A_UART_init(uint16_t baseAddress, EUSCI_A_UART_initParam *param) {
+    (void)baseAddress;
+    (void)param;
+    return true;
+}
+
+void EUSCI_A_UART_enable(uint16_t baseAddress) {
+    (void)baseAddress;
+}
+
+void EUSCI_A_UART_clearInterrupt(uint16_t baseAddress, uint16_t mask) {
+    (void)baseAddress;
+    (void)mask;
+}
+
+void EUSCI_A_UART_enableInterrupt(uint16_t baseAddress, uint8_t mask) {
+    (void)baseAddress;
+    simUca0Ie |= mask;
+}
+
+// CRC16-CCITT like the CRC module, low byte first
+static uint16_t crcState;
+
+void CRC_setSeed(uint16_t baseAddress, uint16_t seed) {
+    (void)baseAddress;
+    crcState = seed;
+}
+
+void CRC_set16BitData(uint16_t baseAddress, uint16_t dataIn) {
+    uint8_t byte, bit;
+
+    (void)baseAddress;
+    for (byte = 0; byte < 2; byte++) {
+        crcState ^= (uint16_t)((dataIn >> (8 * byte)) & 0xFF) << 8;
+        for (bit = 0; bit < 8; bit++) {
+            crcState = (crcState & 0x8000) ? (uint16_t)((crcState << 1) ^ 0x1021)
+                                           : (uint16_t)(crcState << 1);
+        }
+    }
+}
+
+uint16_t CRC_getResult(uint16_t baseAddress) {
+    (void)baseAddress;
+    return crcState;
+}
+
+void SysCtl_enableFRAMWrite(uint8_t writeEnable) {
+    (void)writeEnable;
+}
+
+void SysCtl_protectFRAMWrite(uint8_t writeProtect) {
+    (void)writeProtect;
+}
+
+void spiStreamGetStatus(uint16_t *sent, uint16_t *dropped) {
+    *sent = 0;
+    *dropped = 0;
+}
+
+void ppgSensorGetStatus(uint16_t *samples, uint16_t *fifoOverflows, uint16_t *busErrors) {
+    *samples = 0;
+    *fifoOverflows = 0;
+    *busErrors = 0;
+}
+
+uint8_t powerGetItem(uint8_t item, uint32_t *value) {
+    (void)item;
+    *value = 0;
+    return 0;
+}
+
+void traceStop(void) {
+}
+
+void traceStart(void) {
+}
+
+uint8_t traceStopped(void) {
+    return 0;
+}
+
+uint8_t traceRead(uint16_t index, TraceRecord *record) {
+    (void)index;
+    (void)record;
+    return 0;
+}
+
+uint8_t irqLatencyGet(uint8_t source, IrqLatency *latency) {
+    (void)source;
+    (void)latency;
+    return 0;
+}
+
+void irqLatencyClear(void) {
+}
+
+// ---- Host side of the link ------------------------------------------------------------
+
+static uint8_t crc8(uint8_t crc, const uint8_t *data, uint8_t length) {
+    uint8_t bit;
+
+    while (length--) {
+        crc ^= *data++;
+        for (bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+// Frame into 'out', returns its length
+static uint8_t buildFrame(uint8_t *out, uint8_t cmd, const uint8_t *payload, uint8_t length) {
+    out[0] = UART_CMD_SYNC;
+    out[1] = cmd;
+    out[2] = length;
+    if (length != 0) {
+        memcpy(&out[3], payload, length);
+    }
+    out[3 + length] = crc8(0, &out[1], (uint8_t)(length + 2));
+    return (uint8_t)(length + UART_CMD_OVERHEAD);
+}
+
+// Bytes through the RX ISR, one at a time as the eUSCI delivers them
+static void receive(const uint8_t *bytes, unsigned count) {
+    unsigned i;
+
+    for (i = 0; i < count; i++) {
+        UCA0RXBUF = bytes[i];
+        UCA0IV = USCI_UART_UCRXIFG;
+        USCI_A0_ISR();
+    }
+}
+
+static void send(uint8_t cmd, const uint8_t *payload, uint8_t length) {
+    uint8_t frame[UART_CMD_MAX_PAYLOAD + UART_CMD_OVERHEAD];
+
+    receive(frame, buildFrame(frame, cmd, payload, length));
+}
+
+// Splits everything sent since the last call into frames, checks sync and CRC
+static unsigned responses(Frame *frames) {
+    unsigned count = 0, pos = 0;
+    uint8_t length;
+
+    while (pos < txCount) {
+        CHECK_EQ(txBytes[pos], UART_CMD_SYNC);
+        length = txBytes[pos + 2];
+        CHECK(length <= UART_CMD_MAX_PAYLOAD);
+        if (length > UART_CMD_MAX_PAYLOAD || pos + length + UART_CMD_OVERHEAD > txCount) {
+            break;
+        }
+        CHECK_EQ(crc8(0, &txBytes[pos + 1], (uint8_t)(length + 2)), txBytes[pos + 3 + length]);
+        if (count < MAX_RESPONSES) {
+            frames[count].cmd = txBytes[pos + 1];
+            frames[count].length = length;
+            memcpy(frames[count].payload, &txBytes[pos + 3], length);
+            count++;
+        }
+        pos += length + UART_CMD_OVERHEAD;
+    }
+    txCount = 0;
+    return count;
+}
+
+static uint16_t word(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+// One GET_PARAM round trip, returns the 16 bit value
+static uint16_t getParam16(uint8_t id) {
+    Frame r[MAX_RESPONSES];
+
+    send(CMD_GET_PARAM, &id, 1);
+    uartCmdProcess();
+    if (!CHECK_EQ(responses(r), 1) || !CHECK_EQ(r[0].cmd, CMD_GET_PARAM | CMD_RESPONSE) ||
+        !CHECK_EQ(r[0].length, 3)) {
+        return 0;
+    }
+    return word(&r[0].payload[1]);
+}
+
+static uint16_t crcErrorCount(void) {
+    Frame r[MAX_RESPONSES];
+
+    send(CMD_GET_STATUS, 0, 0);
+    uartCmdProcess();
+    if (!CHECK_EQ(responses(r), 1) || !CHECK_EQ(r[0].length, 4)) {
+        return 0;
+    }
+    return word(&r[0].payload[2]);
+}
+
+static void expectNak(uint8_t cmd, uint8_t error) {
+    Frame r[MAX_RESPONSES];
+
+    uartCmdProcess();
+    if (CHECK_EQ(responses(r), 1)) {
+        CHECK_EQ(r[0].cmd, CMD_NAK);
+        CHECK_EQ(r[0].length, 2);
+        CHECK_EQ(r[0].payload[0], cmd);
+        CHECK_EQ(r[0].payload[1], error);
+    }
+}
+
+// ---- Tests ----------------------------------------------------------------------------
+
+static void testGetSet(void) {
+    uint8_t set[3] = {PARAM_TONE, 0xC4, 0x09};      // 2500 Hz
+    Frame r[MAX_RESPONSES];
+
+    CHECK_EQ(getParam16(PARAM_THRESHOLD_ON), DEFAULT_THRESHOLD_ON);
+    CHECK_EQ(getParam16(PARAM_SAMPLE_RATE), DEFAULT_SAMPLE_RATE_HZ);
+
+    send(CMD_SET_PARAM, set, 3);
+    uartCmdProcess();
+    if (CHECK_EQ(responses(r), 1)) {
+        CHECK_EQ(r[0].cmd, CMD_SET_PARAM | CMD_RESPONSE);
+        CHECK_EQ(r[0].length, 3);
+        CHECK_EQ(word(&r[0].payload[1]), 2500);
+    }
+    CHECK_EQ(config->toneHz, 2500);
+}
+
+static void testNaks(void) {
+    uint8_t two[2] = {PARAM_TONE, 0};
+    uint8_t unknown = 0x60;
+
+    send(0x55, 0, 0);
+    expectNak(0x55, NAK_UNKNOWN_CMD);
+    send(CMD_GET_PARAM, two, 2);
+    expectNak(CMD_GET_PARAM, NAK_BAD_LENGTH);
+    send(CMD_GET_PARAM, &unknown, 1);
+    expectNak(CMD_GET_PARAM, CONFIG_ERR_PARAM);
+    send(CMD_SET_PARAM, two, 1);
+    expectNak(CMD_SET_PARAM, NAK_BAD_LENGTH);
+}
+
+// Several frames in one burst are all answered, in order, by one parser run
+static void testBackToBack(void) {
+    static const uint8_t ids[4] = {PARAM_SAMPLE_RATE, PARAM_THRESHOLD_ON, PARAM_TONE,
+                                   PARAM_OUTPUT_MODE};
+    uint8_t burst[64];
+    uint8_t set[3] = {PARAM_THRESHOLD_ON, 0x10, 0x0A};      // 2576
+    unsigned n = 0, count, i;
+    Frame r[MAX_RESPONSES];
+
+    for (i = 0; i < 4; i++) {
+        n += buildFrame(&burst[n], CMD_GET_PARAM, &ids[i], 1);
+    }
+    n += buildFrame(&burst[n], CMD_SET_PARAM, set, 3);
+    n += buildFrame(&burst[n], CMD_GET_PARAM, &ids[1], 1);
+    CHECK(n <= RX_RING_SIZE);
+    receive(burst, n);
+    uartCmdProcess();
+
+    count = responses(r);
+    CHECK_EQ(count, 6);
+    for (i = 0; i < 4 && i < count; i++) {
+        CHECK_EQ(r[i].cmd, CMD_GET_PARAM | CMD_RESPONSE);
+        CHECK_EQ(r[i].payload[0], ids[i]);
+    }
+    if (count == 6) {
+        CHECK_EQ(word(&r[1].payload[1]), DEFAULT_THRESHOLD_ON);
+        CHECK_EQ(r[4].cmd, CMD_SET_PARAM | CMD_RESPONSE);
+        CHECK_EQ(word(&r[5].payload[1]), 2576);         // The SET took effect in between
+    }
+}
+
+// Noise, a stray sync with an impossible length, a stray sync that swallows the next
+// frame and a frame with a wrong CRC: the parser finds every valid frame again
+static void testResync(void) {
+    static const uint8_t noise[] = {0x00, 0x13, 0xFF, 0x7E, 0xA5, 0x01, 0x40, 0x33};
+    static const uint8_t stray[] = {0xA5, 0x01, 0x02};
+    uint8_t id = PARAM_THRESHOLD_ON;
+    uint8_t frame[8];
+    uint16_t errors = crcErrorCount();
+    unsigned n;
+    Frame r[MAX_RESPONSES];
+
+    receive(noise, sizeof(noise));
+    send(CMD_GET_PARAM, &id, 1);
+    uartCmdProcess();
+    CHECK_EQ(responses(r), 1);
+    CHECK_EQ(crcErrorCount(), errors);
+
+    // The stray header claims two payload bytes, its CRC check fails on the real frame
+    receive(stray, sizeof(stray));
+    send(CMD_GET_PARAM, &id, 1);
+    uartCmdProcess();
+    if (CHECK_EQ(responses(r), 1)) {
+        CHECK_EQ(r[0].cmd, CMD_GET_PARAM | CMD_RESPONSE);
+    }
+    CHECK_EQ(crcErrorCount(), errors + 1);
+
+    n = buildFrame(frame, CMD_GET_PARAM, &id, 1);
+    frame[n - 1] ^= 0x5A;
+    receive(frame, n);
+    send(CMD_GET_PARAM, &id, 1);
+    uartCmdProcess();
+    CHECK_EQ(responses(r), 1);
+    CHECK_EQ(crcErrorCount(), errors + 2);
+}
+
+// A frame arriving byte by byte is executed once, when its last byte is in
+static void testSplit(void) {
+    uint8_t id = PARAM_TONE;
+    uint8_t frame[8];
+    unsigned n, i, answered = 0;
+    Frame r[MAX_RESPONSES];
+
+    n = buildFrame(frame, CMD_GET_PARAM, &id, 1);
+    for (i = 0; i < n; i++) {
+        receive(&frame[i], 1);
+        uartCmdProcess();
+        if (responses(r) != 0) {
+            answered++;
+            CHECK_EQ(i, n - 1);
+        }
+    }
+    CHECK_EQ(answered, 1);
+}
+
+// Frames of every offset cross the end of the ring; the largest one too
+static void testRingWrap(void) {
+    int16_t coeffs[BIQUAD_NUM_COEFFS] = {1200, 2400, 1200, -20000, 9000};
+    uint8_t set[1 + 2 * BIQUAD_NUM_COEFFS];
+    uint8_t id = PARAM_FILTER_COEFFS;
+    unsigned i, round, count;
+    Frame r[MAX_RESPONSES];
+
+    set[0] = PARAM_FILTER_COEFFS;
+    for (i = 0; i < BIQUAD_NUM_COEFFS; i++) {
+        set[1 + 2 * i] = (uint8_t)coeffs[i];
+        set[2 + 2 * i] = (uint8_t)((uint16_t)coeffs[i] >> 8);
+    }
+    // 25 bytes per round, coprime to the ring size: the frames start at every offset
+    for (round = 0; round < RX_RING_SIZE; round++) {
+        CHECK_EQ(getParam16(PARAM_THRESHOLD_ON), 2576);
+        send(CMD_SET_PARAM, set, sizeof(set));
+        send(CMD_GET_PARAM, &id, 1);
+        uartCmdProcess();
+        count = responses(r);
+        if (!CHECK_EQ(count, 2)) {
+            break;
+        }
+        CHECK_EQ(r[1].length, 1 + 2 * BIQUAD_NUM_COEFFS);
+        CHECK_EQ(memcmp(&r[1].payload[1], &set[1], 2 * BIQUAD_NUM_COEFFS), 0);
+    }
+}
+
+static void testOverflow(void) {
+    uint8_t junk[RX_RING_SIZE + 6];
+    Frame r[MAX_RESPONSES];
+
+    memset(junk, 0x00, sizeof(junk));
+    receive(junk, sizeof(junk));
+    uartCmdProcess();                       // Drops the junk
+    CHECK_EQ(responses(r), 0);
+    send(CMD_GET_STATUS, 0, 0);
+    uartCmdProcess();
+    if (CHECK_EQ(responses(r), 1)) {
+        CHECK_EQ(word(&r[0].payload[0]), 6);
+    }
+}
+
+// A rejected SET leaves the saved slot as the config, an accepted one opens the draft
+static void testRejectedSet(void) {
+    uint8_t good[3] = {PARAM_THRESHOLD_ON, 0xD0, 0x07};     // 2000
+    uint8_t high[3] = {PARAM_THRESHOLD_ON, 0x00, 0x10};     // 4096, out of range
+    uint8_t brady[3] = {PARAM_BRADY_BPM, 0xC8, 0x00};       // 200, above tachy
+    uint8_t unknown[2] = {0x60, 0x01};
+    uint8_t shortTone[2] = {PARAM_TONE, 0x01};
+    const PulseConfig *saved;
+    Frame r[MAX_RESPONSES];
+
+    send(CMD_SET_PARAM, good, 3);
+    send(CMD_SAVE_CONFIG, 0, 0);
+    uartCmdProcess();
+    CHECK_EQ(responses(r), 2);
+    saved = config;
+
+    send(CMD_SET_PARAM, high, 3);
+    expectNak(CMD_SET_PARAM, CONFIG_ERR_RANGE);
+    send(CMD_SET_PARAM, brady, 3);
+    expectNak(CMD_SET_PARAM, CONFIG_ERR_RANGE);
+    send(CMD_SET_PARAM, unknown, 2);
+    expectNak(CMD_SET_PARAM, CONFIG_ERR_PARAM);
+    send(CMD_SET_PARAM, shortTone, 2);
+    expectNak(CMD_SET_PARAM, CONFIG_ERR_LENGTH);
+    CHECK(config == saved);
+    CHECK_EQ(getParam16(PARAM_THRESHOLD_ON), 2000);
+
+    // After a reset the saved value is still there
+    configLoad();
+    CHECK(config == saved);
+    CHECK_EQ(config->thresholdOn, 2000);
+
+    good[1] = 0xB8;                                          // 3000
+    send(CMD_SET_PARAM, good, 3);
+    uartCmdProcess();
+    CHECK_EQ(responses(r), 1);
+    CHECK(config != saved);
+    CHECK_EQ(saved->thresholdOn, 2000);
+    configLoad();                                            // Reset without a save
+    CHECK(config == saved);
+}
+
+int main(void) {
+    configLoad();
+    uartCmdInit();
+    testGetSet();
+    testNaks();
+    testBackToBack();
+    testResync();
+    testSplit();
+    testRingWrap();
+    testOverflow();
+    testRejectedSet();
+    return testSummary("uart_cmd");
+}
@@ -0,0 +1,232 @@
+#!/usr/bin/env python3
+# Converts the event trace of the firmware (trace.h) into a Chrome trace file, which
+# chrome://tracing and ui.perfetto.dev display as a timeline with ISRs nested into the
+# main loop tasks they interrupted. Also prints per source counts, durations and the
+# spread of the intervals between starts (jitter of the periodic ISRs).
+#
+#   python3 tools/trace_export.py --port /dev/ttyUSB0 [--save dump.bin] -o trace.json
+#   python3 tools/trace_export.py dump.bin -o trace.json
+#   python3 tools/trace_export.py --head 0x1F4 ring.bin -o trace.json
+#
+# With --port the trace is stopped and read over the command interface (uart_cmd.h,
+# needs pyserial), --restart clears and starts it again afterwards. A file holds 4-byte
+# records (event word, timestamp, little endian), oldest first. A JTAG dump of traceRing
+# is in ring order; --head takes traceHead from the same halt and rotates it.
+
+import argparse
+import json
+import os
+import re
+import struct
+import sys
+
+HEADER = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "trace.h")
+
+KIND_BEGIN, KIND_END, KIND_INSTANT, KIND_WRAP = range(4)
+RECORD = struct.Struct("<HH")
+COUNTER = 65536                     # Timer_B1 counts 1 us, wraps every 65.5 ms
+
+UART_SYNC = 0xA5
+CMD_TRACE_CONTROL = 0x08
+CMD_GET_TRACE = 0x09
+CMD_RESPONSE = 0x80
+CMD_NAK = 0x7F
+TRACE_STOP = 0x00
+TRACE_START = 0x01
+
+
+def load_names(path):
+    names = {}
+    with open(path) as f:
+        for line in f:
+            match = re.match(r"#define TRACE_(ISR|TASK|EVENT)_(\w+)\s+(\d+)", line)
+            if match:
+                kind, name, value = match.groups()
+                names[int(value)] = (kind.lower(), name.lower())
+    return names
+
+
+def crc8(data):
+    crc = 0
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def transact(port, cmd, payload):
+    body = bytes([cmd, len(payload)]) + bytes(payload)
+    port.write(bytes([UART_SYNC]) + body + bytes([crc8(body)]))
+    while True:
+        byte = port.read(1)
+        if not byte:
+            sys.exit("no response to command 0x%02x" % cmd)
+        if byte[0] != UART_SYNC:
+            continue
+        head = port.read(2)
+        if len(head) < 2:
+            sys.exit("truncated response to command 0x%02x" % cmd)
+        rest = port.read(head[1] + 1)
+        if len(rest) < head[1] + 1 or crc8(head + rest[:-1]) != rest[-1]:
+            continue                # Not a frame start after all, keep hunting
+        if head[0] == CMD_NAK:
+            sys.exit("command 0x%02x rejected, error 0x%02x" % (rest[0], rest[1]))
+        if head[0] == cmd | CMD_RESPONSE:
+            return rest[:-1]
+
+
+def read_port(args):
+    import serial
+
+    records = bytearray()
+    with serial.Serial(args.port, 9600, timeout=2) as port:
+        transact(port, CMD_TRACE_CONTROL, [TRACE_STOP])
+        index = 0
+        while True:
+            payload = transact(port, CMD_GET_TRACE, [index & 0xFF, index >> 8])
+            chunk = payload[2:]
+            records += chunk
+            index += len(chunk) // RECORD.size
+            if len(chunk) < 3 * RECORD.size:
+                break
+        if args.restart:
+            transact(port, CMD_TRACE_CONTROL, [TRACE_START])
+    return bytes(records)
+
+
+def decode(data, head):
+    records = [RECORD.unpack_from(data, i) for i in range(0, len(data) - 3, RECORD.size)]
+    if head is not None and records:
+        oldest = (head // RECORD.size + 1) % len(records)
+        records = records[oldest:] + records[:oldest]
+    return [r for r in records if r[0] != 0]
+
+
+# Absolute microseconds from the 16-bit timestamps. The wrap markers carry an overflow
+# count, so the time stays right across stretches without other events. Records taken
+# after the counter wrapped but before the marker came in are moved into the new period.
+def unwrap(records):
+    base = 0                        # Absolute time of the current counter period
+    marker_base = 0
+    last = None
+    last_wrap = None
+    early = False                   # Wrapped before the marker was written
+    events = []
+    for word, stamp in records:
+        kind, source, arg = word >> 14, (word >> 8) & 0x3F, word & 0xFF
+        if kind == KIND_WRAP:
+            if last_wrap is not None:
+                base = marker_base + ((arg - last_wrap) & 0xFF) * COUNTER
+            elif last is not None and not early:
+                base += COUNTER
+            marker_base = base
+            last_wrap = arg
+            early = False
+            last = base + stamp
+            continue
+        time = base + stamp
+        if last is not None and time < last - COUNTER // 2:
+            base += COUNTER
+            time += COUNTER
+            early = True
+        last = time
+        events.append((time, kind, source, arg))
+    return events
+
+
+def name_of(names, source):
+    return names.get(source, ("source", str(source)))
+
+
+def export(events, names):
+    trace = [
+        {"name": "process_name", "ph": "M", "pid": 1, "args": {"name": "MSP430FR2355"}},
+        {"name": "thread_name", "ph": "M", "pid": 1, "tid": 1, "args": {"name": "CPU"}},
+    ]
+    stats = {}
+    starts = {}
+    stack = []
+    for time, kind, source, arg in events:
+        category, name = name_of(names, source)
+        if kind == KIND_BEGIN:
+            stack.append((source, time))
+            trace.append({"name": name, "cat": category, "ph": "B", "ts": time, "pid": 1,
+                          "tid": 1})
+        elif kind == KIND_END:
+            if not any(s == source for s, _ in stack):
+                continue            # Began before the oldest record
+            # ISRs nest strictly, anything still open above ended unseen
+            while True:
+                open_source, begin = stack.pop()
+                trace.append({"name": name_of(names, open_source)[1], "ph": "E", "ts": time,
+                              "pid": 1, "tid": 1})
+                if open_source == source:
+                    break
+            entry = stats.setdefault(source, {"durations": [], "intervals": []})
+            entry["durations"].append(time - begin)
+            if source in starts:
+                entry["intervals"].append(begin - starts[source])
+            starts[source] = begin
+        else:
+            trace.append({"name": name, "cat": category, "ph": "i", "s": "t", "ts": time,
+                          "pid": 1, "tid": 1, "args": {"arg": arg}})
+            stats.setdefault(source, {"durations": [], "intervals": []})["durations"].append(0)
+    end = events[-1][0] if events else 0
+    while stack:
+        open_source, _ = stack.pop()
+        trace.append({"name": name_of(names, open_source)[1], "ph": "E", "ts": end, "pid": 1,
+                      "tid": 1})
+    return {"traceEvents": trace, "displayTimeUnit": "ns"}, stats
+
+
+def summary(events, stats, names, out):
+    if events:
+        out.write("%d events over %.1f ms\n" % (len(events),
+                                                 (events[-1][0] - events[0][0]) / 1000.0))
+    out.write("%-18s %6s %8s %8s %8s %10s %10s\n" % ("source", "count", "min us", "mean us",
+                                                     "max us", "min gap", "max gap"))
+    for source in sorted(stats):
+        durations = stats[source]["durations"]
+        intervals = stats[source]["intervals"]
+        line = "%-18s %6d %8d %8.1f %8d" % (name_of(names, source)[1], len(durations),
+                                            min(durations),
+                                            sum(durations) / len(durations), max(durations))
+        if intervals:
+            line += " %10d %10d" % (min(intervals), max(intervals))
+        out.write(line + "\n")
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("dump", nargs="?", help="binary records, oldest first")
+    parser.add_argument("--port", help="read the trace over the command interface")
+    parser.add_argument("--restart", action="store_true",
+                        help="start recording again after reading over --port")
+    parser.add_argument("--save", help="write the records read over --port to this file")
+    parser.add_argument("--head", type=lambda s: int(s, 0),
+                        help="traceHead for a dump of traceRing in memory order")
+    parser.add_argument("-o", "--output", default="trace.json")
+    args = parser.parse_args()
+
+    if args.port:
+        data = read_port(args)
+        if args.save:
+            with open(args.save, "wb") as f:
+                f.write(data)
+    elif args.dump:
+        with open(args.dump, "rb") as f:
+            data = f.read()
+    else:
+        parser.error("either a dump file or --port is needed")
+
+    names = load_names(HEADER)
+    events = unwrap(decode(data, args.head))
+    trace, stats = export(events, names)
+    with open(args.output, "w") as f:
+        json.dump(trace, f, separators=(",", ":"))
+    summary(events, stats, names, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,138 @@
+//***************************************************************************************
+//  Laden von PPG-Aufzeichnungen fuer die Host-Werkzeuge
+//***************************************************************************************
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "trace_io.h"
+
+static int endsWith(const char *s, const char *suffix) {
+    size_t n = strlen(s);
+    size_t m = strlen(suffix);
+
+    return n >= m && strcmp(s + n - m, suffix) == 0;
+}
+
+int traceFormatOf(const char *path) {
+    if (endsWith(path, ".csv") || endsWith(path, ".txt")) {
+        return TRACE_CSV;
+    }
+    if (endsWith(path, ".bin") || endsWith(path, ".raw")) {
+        return TRACE_RAW;
+    }
+    return -1;
+}
+
+static uint8_t *readFile(const char *path, size_t *length) {
+    FILE *f = fopen(path, "rb");
+    uint8_t *data = NULL;
+    uint8_t *grown;
+    size_t capacity = 0;
+    size_t n = 0;
+    size_t got;
+
+    if (f == NULL) {
+        return NULL;
+    }
+    do {
+        if (n == capacity) {
+            capacity = capacity ? 2 * capacity : 1 << 16;
+            grown = realloc(data, capacity + 1);
+            if (grown == NULL) {
+                free(data);
+                fclose(f);
+                errno = ENOMEM;
+                return NULL;
+            }
+            data = grown;
+        }
+        got = fread(data + n, 1, capacity - n, f);
+        n += got;
+    } while (got > 0);
+    fclose(f);
+    data[n] = '\0';             // Terminator for the CSV parser
+    *length = n;
+    return data;
+}
+
+static int parseCsv(char *text, uint16_t **result, size_t *count) {
+    uint16_t *samples = NULL;
+    uint16_t *grown;
+    size_t capacity = 0;
+    size_t n = 0;
+    char *line = text;
+    char *end;
+    char *field;
+    long value;
+
+    while (*line != '\0') {
+        end = strchr(line, '\n');
+        if (end != NULL) {
+            *end = '\0';
+        }
+        field = strrchr(line, ',');
+        field = (field != NULL) ? field + 1 : line;
+        while (*field == ' ' || *field == '\t') {
+            field++;
+        }
+        if ((*field >= '0' && *field <= '9') || *field == '-') {
+            value = strtol(field, NULL, 10);
+            if (n == capacity) {
+                capacity = capacity ? 2 * capacity : 1 << 14;
+                grown = realloc(samples, capacity * sizeof(uint16_t));
+                if (grown == NULL) {
+                    free(samples);
+                    return 0;
+                }
+                samples = grown;
+            }
+            samples[n++] = (uint16_t)(value < 0 ? 0 : (value > 0xFFFF ? 0xFFFF : value));
+        }
+        if (end == NULL) {
+            break;
+        }
+        line = end + 1;
+    }
+    *result = samples;
+    *count = n;
+    return 1;
+}
+
+static int parseRaw(const uint8_t *data, size_t length, uint16_t **result, size_t *count) {
+    uint16_t *samples = malloc((length / 2 + 1) * sizeof(uint16_t));
+    size_t i;
+
+    if (samples == NULL) {
+        return 0;
+    }
+    for (i = 0; i < length / 2; i++) {
+        samples[i] = (uint16_t)(data[2 * i] | (data[2 * i + 1] << 8));
+    }
+    *result = samples;
+    *count = length / 2;
+    return 1;
+}
+
+int traceLoad(const char *path, TraceFormat format, uint16_t **samples, size_t *count) {
+    uint8_t *data;
+    size_t length;
+    int parsed;
+
+    data = readFile(path, &length);
+    if (data == NULL) {
+        return 0;
+    }
+    if (format == TRACE_CSV) {
+        parsed = parseCsv((char *)data, samples, count);
+    } else {
+        parsed = parseRaw(data, length, samples, count);
+    }
+    free(data);
+    if (!parsed) {
+        errno = ENOMEM;
+    }
+    return parsed;
+}
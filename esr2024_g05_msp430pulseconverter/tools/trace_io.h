@@ -0,0 +1,27 @@
+//***************************************************************************************
+//  Laden von PPG-Aufzeichnungen fuer die Host-Werkzeuge
+//
+//  Beschreibung: Aufzeichnungen sind CSV mit einem ADC-Wert je Zeile (bei mehreren
+//  Spalten zaehlt die letzte, Zeilen ohne Zahl wie Kopfzeilen werden uebersprungen) oder
+//  binaer als 16-Bit-Werte little endian. Das Format folgt aus der Dateiendung.
+//***************************************************************************************
+
+#ifndef TRACE_IO_H_
+#define TRACE_IO_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+    TRACE_CSV = 0,
+    TRACE_RAW
+} TraceFormat;
+
+// Format from the file name (.csv/.txt or .bin/.raw), -1 for files that are not recordings
+int traceFormatOf(const char *path);
+
+// Load a whole recording into a malloc'ed array. Returns 1 on success, 0 with errno set
+// otherwise.
+int traceLoad(const char *path, TraceFormat format, uint16_t **samples, size_t *count);
+
+#endif /* TRACE_IO_H_ */
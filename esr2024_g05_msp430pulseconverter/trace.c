@@ -0,0 +1,67 @@
+//***************************************************************************************
+//  Ereignis-Tracer im RAM
+//***************************************************************************************
+
+#include "trace.h"
+
+#pragma NOINIT(traceRing)
+TraceRecord traceRing[TRACE_RECORDS];       // Not cleared by cinit, traceInit() does that
+volatile uint16_t traceHead = TRACE_MASK;   // First record goes to offset 0
+volatile uint16_t traceMask = TRACE_MASK;
+
+static TraceRecord saved;                   // Record 0 at the time of traceStop()
+static uint16_t stoppedHead;
+static uint8_t wraps;
+
+void traceInit(void) {
+    traceStart();                           // Drops what was written before Timer_B1 ran
+#if TRACE_ENABLE
+    TB1CTL |= TBIE;
+#endif
+}
+
+void traceWrap(void) {
+    traceWrite(TRACE_WORD(TRACE_KIND_WRAP, 0, ++wraps));
+}
+
+void traceStop(void) {
+    unsigned short state = __get_interrupt_state();
+
+    __disable_interrupt();
+    if (traceMask != 0) {
+        stoppedHead = traceHead;
+        saved = traceRing[0];
+        traceMask = 0;
+    }
+    __set_interrupt_state(state);
+}
+
+void traceStart(void) {
+    unsigned short state;
+    uint16_t i;
+
+    traceStop();
+    for (i = 0; i < TRACE_RECORDS; i++) {
+        traceRing[i].event = 0;
+    }
+    state = __get_interrupt_state();
+    __disable_interrupt();
+    traceHead = TRACE_MASK;
+    traceMask = TRACE_MASK;
+    __set_interrupt_state(state);
+}
+
+uint8_t traceStopped(void) {
+    return traceMask == 0;
+}
+
+uint8_t traceRead(uint16_t index, TraceRecord *record) {
+    uint16_t slot;
+
+    if (index >= TRACE_RECORDS) {
+        return 0;
+    }
+    slot = ((stoppedHead >> 2) + 1 + index) & (TRACE_RECORDS - 1);
+    *record = (slot == 0) ? saved : traceRing[slot];
+    return 1;
+}
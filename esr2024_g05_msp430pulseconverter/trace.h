@@ -0,0 +1,130 @@
+//***************************************************************************************
+//  Ereignis-Tracer im RAM (ISR-Eintritte, Aufgaben der Hauptschleife, Moduswechsel)
+//
+//  Beschreibung: Jedes Ereignis ist ein Datensatz aus 4 Byte: Ereigniswort (Art, Quelle,
+//  Argument) und der 16-Bit-Zaehlerstand von Timer_B1 (1 MHz, 1 us Aufloesung). Die
+//  Datensaetze laufen in einen Ringpuffer, der die juengsten TRACE_RECORDS Ereignisse
+//  haelt. Bei jedem Ueberlauf von Timer_B1 (alle 65,5 ms) wird eine Ueberlaufmarke mit
+//  fortlaufendem Zaehler eingetragen, daraus setzt der Host die absolute Zeit zusammen.
+//  Schreiben ist aus jedem Kontext erlaubt, es gibt keine Sperre und kein Warten: der
+//  Platz wird in einem Fenster von wenigen Befehlen mit gesperrten Interrupts belegt
+//  und beschrieben. traceStop() friert den Ring fuer das Auslesen ein (uart_cmd.h:
+//  CMD_TRACE_CONTROL, CMD_GET_TRACE), ueber JTAG lassen sich traceRing und traceHead
+//  direkt lesen. tools/trace_export.py erzeugt daraus eine Chrome-Trace-Datei (Perfetto).
+//
+//  Kosten pro Ereignis: etwa 20 Zyklen in einer ISR (TRACE_ISR_BEGIN/END), etwa 24
+//  Zyklen aus der Hauptschleife. Mit TRACE_ENABLE 0 entfallen alle Aufrufe.
+//***************************************************************************************
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <msp430.h>
+#include <stdint.h>
+
+#ifndef TRACE_ENABLE
+#define TRACE_ENABLE        1
+#endif
+
+#if TRACE_ENABLE
+#define TRACE_RECORDS       128     // Power of two, 4 byte each
+#else
+#define TRACE_RECORDS       1       // Commands still work on an empty ring
+#endif
+#define TRACE_MASK          ((TRACE_RECORDS - 1) * 4)   // Byte offset of the last record
+
+// Event word: kind in bits 15..14, source in bits 13..8, argument in bits 7..0. A zero
+// word marks an unused record, so source 0 is not used.
+#define TRACE_KIND_BEGIN    0x0000
+#define TRACE_KIND_END      0x4000
+#define TRACE_KIND_INSTANT  0x8000
+#define TRACE_KIND_WRAP     0xC000  // Timer_B1 overflow, argument counts overflows
+
+// Sources, tools/trace_export.py takes the names from these lines
+#define TRACE_ISR_SAMPLE_TIMER  1   // Timer_B0 CCR0, starts an ADC conversion
+#define TRACE_ISR_ADC           2
+#define TRACE_ISR_TICK          3   // Timer_B1 CCR1, 10 ms output tick
+#define TRACE_ISR_PWM           4   // Timer_B3 CCR0, LED PWM period
+#define TRACE_ISR_PWM_OFF       5   // Timer_B3 CCR1/2
+#define TRACE_ISR_UART          6
+#define TRACE_ISR_I2C           7   // eUSCI_B0, sensor bus
+#define TRACE_ISR_I2C_TARGET    8   // eUSCI_B1
+#define TRACE_ISR_SENSOR        9   // Port 2, sensor data ready
+#define TRACE_TASK_SLEEP        16  // LPM0 in the main loop
+#define TRACE_TASK_COMMANDS     17
+#define TRACE_TASK_CONFIG       18
+#define TRACE_TASK_SAMPLE       19  // takeSample()
+#define TRACE_TASK_PUBLISH      20  // Alarm update and I2C registers
+#define TRACE_EVENT_CONFIG      32  // Argument: CONFIG_CHANGED_* flags being applied
+#define TRACE_EVENT_ZONE        33  // Argument: new AlarmZone
+#define TRACE_EVENT_QUEUE_FULL  34  // Sample dropped
+#define TRACE_EVENT_BEAT        35  // Argument: BPM, saturated at 255
+// Not traced: the tone ISR (Timer_B2, 16 kHz) and the SPI stream ISR (one per byte)
+// would fill the ring within a few milliseconds
+
+#define TRACE_WORD(kind, source, arg)   ((uint16_t)((kind) | ((source) << 8) | (uint8_t)(arg)))
+
+typedef struct {
+    uint16_t event;
+    uint16_t time;                  // TB1R
+} TraceRecord;
+
+extern TraceRecord traceRing[TRACE_RECORDS];
+extern volatile uint16_t traceHead;     // Byte offset of the newest record
+extern volatile uint16_t traceMask;     // TRACE_MASK while recording, 0 when stopped
+
+// Caller runs with interrupts disabled. Stopped, every write lands in record 0, whose
+// content traceStop() has saved.
+static inline void traceWrite(uint16_t event) {
+    uint16_t offset = (traceHead + 4) & traceMask;
+
+    traceHead = offset;
+    ((TraceRecord *)((uint8_t *)traceRing + offset))->time = TB1R;
+    ((TraceRecord *)((uint8_t *)traceRing + offset))->event = event;
+}
+
+// Any context
+static inline void traceRecord(uint16_t event) {
+    unsigned short state = __get_interrupt_state();
+
+    __disable_interrupt();
+    traceWrite(event);
+    __set_interrupt_state(state);
+}
+
+#if TRACE_ENABLE
+// ISRs do not nest here (no ISR re-enables GIE), so they write without the lock
+#define TRACE_ISR_BEGIN(source)     traceWrite(TRACE_WORD(TRACE_KIND_BEGIN, source, 0))
+#define TRACE_ISR_END(source)       traceWrite(TRACE_WORD(TRACE_KIND_END, source, 0))
+#define TRACE_BEGIN(source)         traceRecord(TRACE_WORD(TRACE_KIND_BEGIN, source, 0))
+#define TRACE_END(source)           traceRecord(TRACE_WORD(TRACE_KIND_END, source, 0))
+#define TRACE_EVENT(source, arg)    traceRecord(TRACE_WORD(TRACE_KIND_INSTANT, source, arg))
+#define TRACE_WRAP()                traceWrap()
+#else
+#define TRACE_ISR_BEGIN(source)     ((void)0)
+#define TRACE_ISR_END(source)       ((void)0)
+#define TRACE_BEGIN(source)         ((void)0)
+#define TRACE_END(source)           ((void)0)
+#define TRACE_EVENT(source, arg)    ((void)0)
+#define TRACE_WRAP()                ((void)0)
+#endif
+
+// Clear the ring and enable the Timer_B1 overflow interrupt for the wrap markers, call
+// after outputInit()
+void traceInit(void);
+
+// Timer_B1 overflow, ISR context
+void traceWrap(void);
+
+// Freeze the ring for reading, recording continues into a scratch record
+void traceStop(void);
+
+// Clear the ring and record again
+void traceStart(void);
+
+uint8_t traceStopped(void);
+
+// Record 'index' counted from the oldest, only valid while stopped. Returns 0 past the end
+uint8_t traceRead(uint16_t index, TraceRecord *record);
+
+#endif /* TRACE_H_ */
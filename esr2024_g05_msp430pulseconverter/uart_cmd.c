@@ -0,0 +1,351 @@
+//***************************************************************************************
+//  Binaeres Kommandointerface ueber eUSCI_A0
+//***************************************************************************************
+
+#include <msp430.h>
+#include "driverlib/MSP430FR2xx_4xx/eusci_a_uart.h"
+#include "uart_cmd.h"
+#include "config.h"
+#include "spi_stream.h"
+#include "ppg_sensor.h"
+#include "power.h"
+#include "trace.h"
+#include "irq_priority.h"
+#include "boot.h"
+
+#define RX_RING_SIZE    64      // Must be a power of two and hold at least one full frame
+#define RX_RING_MASK    (RX_RING_SIZE - 1)
+#define TX_RING_SIZE    64
+#define TX_RING_MASK    (TX_RING_SIZE - 1)
+
+// The RX ring is stored twice in a row: every byte is also written RX_RING_SIZE bytes
+// further on. A frame starting anywhere in the ring is therefore always contiguous in
+// memory and the parser can hand out pointers into the ring instead of copying.
+#pragma NOINIT(rxRing)
+static uint8_t rxRing[2 * RX_RING_SIZE];
+static volatile uint8_t rxHead;         // Written by the ISR only (free running)
+static volatile uint8_t rxTail;         // Written by the main loop only (free running)
+static uint8_t rxSeen;                  // rxHead at the last parser run
+
+#pragma NOINIT(txRing)
+static uint8_t txRing[TX_RING_SIZE];
+static volatile uint8_t txHead;         // Written by the main loop only
+static volatile uint8_t txTail;         // Written by the ISR only
+
+static volatile uint16_t rxOverflows;
+static uint16_t crcErrors;
+
+static uint8_t crc8(uint8_t crc, const uint8_t *data, uint8_t length) {
+    uint8_t bit;
+
+    while (length--) {
+        crc ^= *data++;
+        for (bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static void txPut(uint8_t c) {
+    // Wait for the TX ISR to make room, reception keeps running meanwhile
+    while ((uint8_t)(txHead - txTail) >= TX_RING_SIZE);
+    txRing[txHead & TX_RING_MASK] = c;
+    txHead++;
+    UCA0IE |= UCTXIE;               // TX ISR drains the ring
+}
+
+static void sendFrame(uint8_t cmd, const uint8_t *payload, uint8_t length) {
+    uint8_t crc;
+    uint8_t i;
+
+    crc = crc8(0, &cmd, 1);
+    crc = crc8(crc, &length, 1);
+    crc = crc8(crc, payload, length);
+
+    txPut(UART_CMD_SYNC);
+    txPut(cmd);
+    txPut(length);
+    for (i = 0; i < length; i++) {
+        txPut(payload[i]);
+    }
+    txPut(crc);
+}
+
+static void sendNak(uint8_t cmd, uint8_t error) {
+    uint8_t payload[2];
+
+    payload[0] = cmd;
+    payload[1] = error;
+    sendFrame(CMD_NAK, payload, 2);
+}
+
+static void execute(uint8_t cmd, const uint8_t *payload, uint8_t length) {
+    uint8_t response[UART_CMD_MAX_PAYLOAD];
+    uint16_t sent, dropped, errors;
+    TraceRecord record;
+    IrqLatency latency;
+    uint32_t value;
+    uint16_t index;
+    uint8_t result;
+    uint8_t n;
+
+    switch (cmd) {
+    case CMD_GET_PARAM:
+        if (length != 1) {
+            sendNak(cmd, NAK_BAD_LENGTH);
+            return;
+        }
+        n = configGetParam(payload[0], &response[1]);
+        if (n == 0) {
+            sendNak(cmd, CONFIG_ERR_PARAM);
+            return;
+        }
+        response[0] = payload[0];
+        sendFrame(cmd | CMD_RESPONSE, response, n + 1);
+        break;
+
+    case CMD_SET_PARAM:
+        if (length < 2) {
+            sendNak(cmd, NAK_BAD_LENGTH);
+            return;
+        }
+        // The value is read straight out of the RX ring
+        result = configSetParam(payload[0], &payload[1], length - 1);
+        if (result != CONFIG_OK) {
+            sendNak(cmd, result);
+            return;
+        }
+        response[0] = payload[0];
+        n = configGetParam(payload[0], &response[1]);
+        sendFrame(cmd | CMD_RESPONSE, response, n + 1);
+        break;
+
+    case CMD_SAVE_CONFIG:
+        configSave();
+        sendFrame(cmd | CMD_RESPONSE, response, 0);
+        break;
+
+    case CMD_LOAD_DEFAULTS:
+        configLoadDefaults();
+        sendFrame(cmd | CMD_RESPONSE, response, 0);
+        break;
+
+    case CMD_GET_STATUS:
+        response[0] = (uint8_t)rxOverflows;
+        response[1] = (uint8_t)(rxOverflows >> 8);
+        response[2] = (uint8_t)crcErrors;
+        response[3] = (uint8_t)(crcErrors >> 8);
+        sendFrame(cmd | CMD_RESPONSE, response, 4);
+        break;
+
+    case CMD_GET_STREAM_STATUS:
+        spiStreamGetStatus(&sent, &dropped);
+        response[0] = (uint8_t)sent;
+        response[1] = (uint8_t)(sent >> 8);
+        response[2] = (uint8_t)dropped;
+        response[3] = (uint8_t)(dropped >> 8);
+        sendFrame(cmd | CMD_RESPONSE, response, 4);
+        break;
+
+    case CMD_GET_SENSOR_STATUS:
+        ppgSensorGetStatus(&sent, &dropped, &errors);
+        response[0] = (uint8_t)sent;
+        response[1] = (uint8_t)(sent >> 8);
+        response[2] = (uint8_t)dropped;
+        response[3] = (uint8_t)(dropped >> 8);
+        response[4] = (uint8_t)errors;
+        response[5] = (uint8_t)(errors >> 8);
+        sendFrame(cmd | CMD_RESPONSE, response, 6);
+        break;
+
+    case CMD_TRACE_CONTROL:
+        if (length != 1) {
+            sendNak(cmd, NAK_BAD_LENGTH);
+            return;
+        }
+        if (payload[0] == TRACE_STOP) {
+            traceStop();
+        } else if (payload[0] == TRACE_START) {
+            traceStart();
+        } else {
+            sendNak(cmd, CONFIG_ERR_RANGE);
+            return;
+        }
+        response[0] = payload[0];
+        sendFrame(cmd | CMD_RESPONSE, response, 1);
+        break;
+
+    case CMD_GET_TRACE:
+        if (length != 2) {
+            sendNak(cmd, NAK_BAD_LENGTH);
+            return;
+        }
+        if (!traceStopped()) {
+            sendNak(cmd, NAK_TRACE_RUNNING);
+            return;
+        }
+        index = payload[0] | ((uint16_t)payload[1] << 8);
+        response[0] = payload[0];
+        response[1] = payload[1];
+        n = 2;
+        while (n < 2 + 4 * TRACE_RECORDS_PER_FRAME && traceRead(index++, &record)) {
+            response[n++] = (uint8_t)record.event;
+            response[n++] = (uint8_t)(record.event >> 8);
+            response[n++] = (uint8_t)record.time;
+            response[n++] = (uint8_t)(record.time >> 8);
+        }
+        sendFrame(cmd | CMD_RESPONSE, response, n);
+        break;
+
+    case CMD_GET_ENERGY:
+        if (length != 1) {
+            sendNak(cmd, NAK_BAD_LENGTH);
+            return;
+        }
+        if (!powerGetItem(payload[0], &value)) {
+            sendNak(cmd, CONFIG_ERR_PARAM);
+            return;
+        }
+        response[0] = payload[0];
+        response[1] = (uint8_t)value;
+        response[2] = (uint8_t)(value >> 8);
+        response[3] = (uint8_t)(value >> 16);
+        response[4] = (uint8_t)(value >> 24);
+        sendFrame(cmd | CMD_RESPONSE, response, 5);
+        break;
+
+    case CMD_GET_LATENCY:
+        if (length != 1) {
+            sendNak(cmd, NAK_BAD_LENGTH);
+            return;
+        }
+        if (!irqLatencyGet(payload[0], &latency)) {
+            sendNak(cmd, CONFIG_ERR_PARAM);
+            return;
+        }
+        response[0] = payload[0];
+        response[1] = (uint8_t)latency.max;
+        response[2] = (uint8_t)(latency.max >> 8);
+        n = 3;
+        for (index = 0; index < IRQ_LATENCY_BINS; index++) {
+            response[n++] = (uint8_t)latency.bins[index];
+            response[n++] = (uint8_t)(latency.bins[index] >> 8);
+        }
+        sendFrame(cmd | CMD_RESPONSE, response, n);
+        break;
+
+    case CMD_CLEAR_LATENCY:
+        irqLatencyClear();
+        sendFrame(cmd | CMD_RESPONSE, response, 0);
+        break;
+
+    case CMD_GET_BOOT:
+        n = 0;
+        for (index = 0; index < BOOT_STAGES; index++) {
+            response[n++] = (uint8_t)bootTicks[index];
+            response[n++] = (uint8_t)(bootTicks[index] >> 8);
+        }
+        sendFrame(cmd | CMD_RESPONSE, response, n);
+        break;
+
+    default:
+        sendNak(cmd, NAK_UNKNOWN_CMD);
+        break;
+    }
+}
+
+void uartCmdInit(void) {
+    EUSCI_A_UART_initParam param = {0};
+
+    // Configure UART pins (P1.6 RXD, P1.7 TXD)
+    P1SEL0 |= BIT6 | BIT7;
+
+    // 9600 baud from SMCLK = 8 MHz (UCOS16 = 1, UCBRx = 52, UCBRFx = 1, UCBRSx = 0x49)
+    param.selectClockSource = EUSCI_A_UART_CLOCKSOURCE_SMCLK;
+    param.clockPrescalar = 52;
+    param.firstModReg = 1;
+    param.secondModReg = 0x49;
+    param.parity = EUSCI_A_UART_NO_PARITY;
+    param.msborLsbFirst = EUSCI_A_UART_LSB_FIRST;
+    param.numberofStopBits = EUSCI_A_UART_ONE_STOP_BIT;
+    param.uartMode = EUSCI_A_UART_MODE;
+    param.overSampling = EUSCI_A_UART_OVERSAMPLING_BAUDRATE_GENERATION;
+    EUSCI_A_UART_init(EUSCI_A0_BASE, &param);
+    EUSCI_A_UART_enable(EUSCI_A0_BASE);
+
+    EUSCI_A_UART_clearInterrupt(EUSCI_A0_BASE, EUSCI_A_UART_RECEIVE_INTERRUPT_FLAG);
+    EUSCI_A_UART_enableInterrupt(EUSCI_A0_BASE, EUSCI_A_UART_RECEIVE_INTERRUPT);
+}
+
+uint8_t uartCmdPending(void) {
+    return rxHead != rxSeen;
+}
+
+void uartCmdProcess(void) {
+    const uint8_t *frame;
+    uint8_t available;
+    uint8_t length;
+
+    rxSeen = rxHead;
+    while ((available = (uint8_t)(rxHead - rxTail)) != 0) {
+        frame = &rxRing[rxTail & RX_RING_MASK];
+
+        // Hunt for the start of a frame
+        if (frame[0] != UART_CMD_SYNC) {
+            rxTail++;
+            continue;
+        }
+        if (available < 3) {
+            return;
+        }
+        length = frame[2];
+        if (length > UART_CMD_MAX_PAYLOAD) {
+            rxTail++;               // Not a real header, resynchronise
+            continue;
+        }
+        if (available < length + UART_CMD_OVERHEAD) {
+            return;                 // Rest of the frame still on the wire
+        }
+        if (crc8(0, &frame[1], length + 2) != frame[length + 3]) {
+            crcErrors++;
+            rxTail++;
+            continue;
+        }
+
+        // The frame stays in the ring until it has been executed
+        execute(frame[1], &frame[3], length);
+        rxTail += length + UART_CMD_OVERHEAD;
+    }
+}
+
+#pragma vector=EUSCI_A0_VECTOR
+__interrupt void USCI_A0_ISR(void) {
+    uint8_t c;
+
+    TRACE_ISR_BEGIN(TRACE_ISR_UART);
+    switch (__even_in_range(UCA0IV, USCI_UART_UCTXCPTIFG)) {
+    case USCI_UART_UCRXIFG:
+        c = UCA0RXBUF;
+        if ((uint8_t)(rxHead - rxTail) < RX_RING_SIZE) {
+            rxRing[rxHead & RX_RING_MASK] = c;
+            rxRing[(rxHead & RX_RING_MASK) + RX_RING_SIZE] = c;
+            rxHead++;
+        } else {
+            rxOverflows++;
+        }
+        __bic_SR_register_on_exit(LPM0_bits);   // Wake the main loop to parse
+        break;
+    case USCI_UART_UCTXIFG:
+        if (txHead != txTail) {
+            UCA0TXBUF = txRing[txTail & TX_RING_MASK];
+            txTail++;
+        } else {
+            UCA0IE &= ~UCTXIE;
+        }
+        break;
+    default:
+        break;
+    }
+    TRACE_ISR_END(TRACE_ISR_UART);
+}
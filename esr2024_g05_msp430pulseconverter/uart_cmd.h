@@ -0,0 +1,64 @@
+//***************************************************************************************
+//  Binaeres Kommandointerface ueber eUSCI_A0 (UART, 9600 Baud, P1.6 RXD / P1.7 TXD)
+//
+//  Beschreibung: Empfangene Bytes werden in der RX-ISR in einen Ringpuffer geschrieben.
+//  Der Parser arbeitet direkt auf dem Ringpuffer (ohne Kopie) und ruft die Kommandos
+//  auf, Antworten werden ueber einen TX-Ringpuffer per Interrupt gesendet.
+//
+//  Rahmenformat (Anfrage und Antwort):
+//
+//      SYNC (0xA5) | CMD | LEN | PAYLOAD[LEN] | CRC8
+//
+//  CRC8 (Polynom 0x07, Startwert 0x00) ueber CMD, LEN und PAYLOAD. Antworten tragen
+//  CMD | 0x80, Fehler werden mit CMD_NAK und [CMD, Fehlercode] beantwortet.
+//***************************************************************************************
+
+#ifndef UART_CMD_H_
+#define UART_CMD_H_
+
+#include <stdint.h>
+
+#define UART_CMD_SYNC           0xA5
+#define UART_CMD_MAX_PAYLOAD    16
+#define UART_CMD_OVERHEAD       4       // SYNC, CMD, LEN, CRC8
+
+// Commands
+#define CMD_GET_PARAM           0x01    // [id]          -> [id, value...]
+#define CMD_SET_PARAM           0x02    // [id, value...] -> [id, value...]
+#define CMD_SAVE_CONFIG         0x03    // []            -> []
+#define CMD_LOAD_DEFAULTS       0x04    // []            -> []
+#define CMD_GET_STATUS          0x05    // []            -> [rxOverflows, crcErrors]
+#define CMD_GET_STREAM_STATUS   0x06    // []            -> [blocksSent, overruns]
+#define CMD_GET_SENSOR_STATUS   0x07    // []            -> [samples, fifoOverflows, busErrors]
+#define CMD_TRACE_CONTROL       0x08    // [action]      -> [action], TRACE_STOP or TRACE_START
+#define CMD_GET_TRACE           0x09    // [index]       -> [index, record...], up to 3 records
+#define CMD_GET_ENERGY          0x0A    // [item]        -> [item, value], ENERGY_ITEM_* (energy.h)
+#define CMD_GET_LATENCY         0x0B    // [source]      -> [source, max, bins...], irq_priority.h
+#define CMD_CLEAR_LATENCY       0x0C    // []            -> []
+#define CMD_GET_BOOT            0x0D    // []            -> [ticks...], BOOT_STAGE_* (boot.h)
+#define CMD_NAK                 0x7F
+#define CMD_RESPONSE            0x80
+
+// NAK error codes (config errors are passed through unchanged)
+#define NAK_UNKNOWN_CMD         0x10
+#define NAK_BAD_LENGTH          0x11
+#define NAK_TRACE_RUNNING       0x12    // CMD_GET_TRACE needs a stopped trace
+
+// CMD_TRACE_CONTROL actions
+#define TRACE_STOP              0x00    // Freeze the ring for reading
+#define TRACE_START             0x01    // Clear the ring and record again
+
+// CMD_GET_TRACE: index (uint16_t) counts from the oldest record, each record is the
+// event word and the timestamp (trace.h). Fewer than 3 records mark the end of the ring.
+#define TRACE_RECORDS_PER_FRAME 3
+
+// Configure eUSCI_A0 and its pins, enables the RX interrupt
+void uartCmdInit(void);
+
+// Returns non-zero if bytes arrived since the last uartCmdProcess() call
+uint8_t uartCmdPending(void);
+
+// Parse and execute all complete frames in the RX ring, call from the main loop
+void uartCmdProcess(void);
+
+#endif /* UART_CMD_H_ */